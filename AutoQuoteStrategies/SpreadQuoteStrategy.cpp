@@ -0,0 +1,108 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "SpreadQuoteStrategy.h"
+
+#include <cmath>
+
+namespace {
+   // bs::network::Asset::PrivateMarket
+   const int kAssetTypeCC = 3;
+
+   // random quote is sent if nothing was sent this close to expiration
+   const double kRandomQuoteExpirationSec = 7;
+}
+
+
+SpreadQuoteStrategy::SpreadQuoteStrategy(bs::aq::Context *context)
+   : context_(context)
+   , random_(std::random_device{}())
+{}
+
+bs::aq::Reply SpreadQuoteStrategy::onEvent(bs::aq::Event event
+   , const bs::aq::QuoteRequest &qr, const bs::aq::MarketSnapshot &md)
+{
+   auto &prevSendPrice = prevSendPrices_[qr.reqId];
+
+   switch (event) {
+      case bs::aq::Event::ExpirationChanged :
+         if ((prevSendPrice == 0) && (md.expirationInSec < kRandomQuoteExpirationSec)) {
+            std::uniform_real_distribution<double> dist(0.1, 10.0);
+            prevSendPrice = std::round(dist(random_) * 10.0) / 10.0;
+            if (context_) {
+               context_->log("No quotes sent - sending random one with price " + std::to_string(prevSendPrice));
+            }
+            return bs::aq::Reply::send(prevSendPrice);
+         }
+         break;
+
+      case bs::aq::Event::BestPriceChanged : {
+         if (qr.assetType == kAssetTypeCC) {
+            break;
+         }
+         const double price = qr.isBuy ? md.bestPrice * 0.999 : md.bestPrice * 1.001;
+         prevSendPrice = price;
+         return bs::aq::Reply::send(price);
+      }
+
+      case bs::aq::Event::IndicBidChanged : {
+         if ((qr.assetType == kAssetTypeCC) || qr.isBuy) {
+            break;
+         }
+         double price = 0;
+         if ((prevSendPrice == 0) || ((md.indicBid - prevSendPrice) < md.indicBid * 0.01)) {
+            price = md.indicBid * 0.99;
+         }
+         if ((price > 0) && checkBalance(qr.quantity * price, qr.contraProduct)) {
+            prevSendPrice = price;
+            return bs::aq::Reply::send(price);
+         }
+         break;
+      }
+
+      case bs::aq::Event::IndicAskChanged : {
+         if ((qr.assetType == kAssetTypeCC) || !qr.isBuy) {
+            break;
+         }
+         double price = 0;
+         if ((prevSendPrice == 0) || ((prevSendPrice - md.indicAsk) < md.indicAsk * 0.01)) {
+            price = md.indicAsk * 1.01;
+         }
+         if ((price > 0) && checkBalance(qr.quantity, qr.product)) {
+            prevSendPrice = price;
+            return bs::aq::Reply::send(price);
+         }
+         break;
+      }
+
+      default :
+         break;
+   }
+   return bs::aq::Reply::none();
+}
+
+void SpreadQuoteStrategy::onFinished(const std::string &reqId)
+{
+   prevSendPrices_.erase(reqId);
+}
+
+bool SpreadQuoteStrategy::checkBalance(double value, const std::string &product)
+{
+   if (!context_) {
+      return true;
+   }
+   const double balance = context_->accountBalance(product);
+   if (value > balance) {
+      context_->log("Not enough balance for " + product + ": " + std::to_string(value)
+         + " > " + std::to_string(balance));
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,44 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef SPREAD_QUOTE_STRATEGY_H
+#define SPREAD_QUOTE_STRATEGY_H
+
+#include "AutoQuoteStrategy.h"
+
+#include <random>
+#include <unordered_map>
+
+// Reference native strategy doing the same as Scripts/DealerAutoQuote.qml:
+// quotes 1% off indicative price on the dealer's side, 0.1% better than
+// the current best quote, and a random price if nothing was sent shortly
+// before expiration. CC requests are not quoted.
+class SpreadQuoteStrategy : public bs::aq::Strategy
+{
+public:
+   explicit SpreadQuoteStrategy(bs::aq::Context *context);
+   ~SpreadQuoteStrategy() override = default;
+
+   bs::aq::Reply onEvent(bs::aq::Event, const bs::aq::QuoteRequest &
+      , const bs::aq::MarketSnapshot &) override;
+   void onFinished(const std::string &reqId) override;
+
+   std::size_t activeCount() const { return prevSendPrices_.size(); }
+
+private:
+   bool checkBalance(double value, const std::string &product);
+
+private:
+   bs::aq::Context   *context_;
+   std::unordered_map<std::string, double>   prevSendPrices_;
+   std::mt19937      random_;
+};
+
+#endif // SPREAD_QUOTE_STRATEGY_H
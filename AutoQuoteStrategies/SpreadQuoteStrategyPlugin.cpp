@@ -0,0 +1,13 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "SpreadQuoteStrategy.h"
+
+BS_AQ_STRATEGY_PLUGIN(SpreadQuoteStrategy)
@@ -0,0 +1,164 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "AQNativeStrategy.h"
+
+#include <QLibrary>
+#include <spdlog/logger.h>
+
+#include "AssetManager.h"
+#include "UserScript.h"
+#include "UtxoReservationManager.h"
+
+
+AQStrategyContext::AQStrategyContext(const std::shared_ptr<spdlog::logger> &logger
+   , const std::shared_ptr<AssetManager> &assetManager)
+   : logger_(logger)
+   , assetManager_(assetManager)
+{}
+
+double AQStrategyContext::accountBalance(const std::string &product) const
+{
+   if (!assetManager_) {
+      return 0;
+   }
+   return assetManager_->getBalance(product, bs::UTXOReservationManager::kIncludeZcRequestor, nullptr);
+}
+
+void AQStrategyContext::log(const std::string &message)
+{
+   logger_->info("[AQStrategy] {}", message);
+}
+
+
+bool AQStrategyLibrary::isStrategyLibrary(const QString &fileName)
+{
+   return QLibrary::isLibrary(fileName);
+}
+
+std::shared_ptr<bs::aq::Strategy> AQStrategyLibrary::load(const QString &fileName
+   , bs::aq::Context *context, QString &error)
+{
+   using ApiVersionFunc = int (*)();
+   using CreateFunc = bs::aq::Strategy *(*)(bs::aq::Context *);
+   using DestroyFunc = void (*)(bs::aq::Strategy *);
+
+   // library is never unloaded explicitly - it's not safe while any code
+   // or data from it may be still referenced
+   QLibrary library(fileName);
+   if (!library.load()) {
+      error = library.errorString();
+      return nullptr;
+   }
+
+   const auto apiVersion = reinterpret_cast<ApiVersionFunc>(library.resolve(BS_AQ_STRATEGY_API_VERSION_FUNC));
+   const auto createFunc = reinterpret_cast<CreateFunc>(library.resolve(BS_AQ_STRATEGY_CREATE_FUNC));
+   const auto destroyFunc = reinterpret_cast<DestroyFunc>(library.resolve(BS_AQ_STRATEGY_DESTROY_FUNC));
+   if (!apiVersion || !createFunc || !destroyFunc) {
+      error = QObject::tr("%1 is not an auto-quoting strategy library").arg(fileName);
+      return nullptr;
+   }
+   if (apiVersion() != bs::aq::kStrategyApiVersion) {
+      error = QObject::tr("Strategy API version %1 is not supported (expected %2)")
+         .arg(apiVersion()).arg(bs::aq::kStrategyApiVersion);
+      return nullptr;
+   }
+
+   auto strategy = createFunc(context);
+   if (!strategy) {
+      error = QObject::tr("Failed to create strategy from %1").arg(fileName);
+      return nullptr;
+   }
+   // object must be destroyed by the library which allocated it
+   return std::shared_ptr<bs::aq::Strategy>(strategy, destroyFunc);
+}
+
+
+AQStrategyBinding::AQStrategyBinding(const std::shared_ptr<bs::aq::Strategy> &strategy
+   , BSQuoteReqReply *parent)
+   : QObject(parent)
+   , strategy_(strategy)
+   , reply_(parent)
+{
+   connect(reply_, &BSQuoteReqReply::started, this, &AQStrategyBinding::onStarted);
+   connect(reply_, &BSQuoteReqReply::expirationInSecChanged, this, [this] {
+      onEvent(bs::aq::Event::ExpirationChanged);
+   });
+   connect(reply_, &BSQuoteReqReply::indicBidChanged, this, [this] {
+      onEvent(bs::aq::Event::IndicBidChanged);
+   });
+   connect(reply_, &BSQuoteReqReply::indicAskChanged, this, [this] {
+      onEvent(bs::aq::Event::IndicAskChanged);
+   });
+   connect(reply_, &BSQuoteReqReply::lastPriceChanged, this, [this] {
+      onEvent(bs::aq::Event::LastPriceChanged);
+   });
+   connect(reply_, &BSQuoteReqReply::bestPriceChanged, this, [this] {
+      onEvent(bs::aq::Event::BestPriceChanged);
+   });
+   connect(reply_, &BSQuoteReqReply::settled, this, &AQStrategyBinding::onFinished);
+   connect(reply_, &BSQuoteReqReply::cancelled, this, &AQStrategyBinding::onFinished);
+   connect(reply_, &BSQuoteReqReply::recycled, this, &AQStrategyBinding::onFinished);
+}
+
+void AQStrategyBinding::onStarted()
+{
+   const auto qr = reply_->quoteReq();
+   if (!qr) {
+      return;
+   }
+   // request data doesn't change while RFQ is live, so it's converted only once
+   request_.reqId = qr->requestId().toStdString();
+   request_.security = reply_->security().toStdString();
+   request_.product = qr->product().toStdString();
+   request_.contraProduct = reply_->product().toStdString();
+   request_.isBuy = qr->isBuy();
+   request_.quantity = qr->quantity();
+   request_.assetType = qr->assetType();
+   active_ = true;
+
+   onEvent(bs::aq::Event::Started);
+}
+
+void AQStrategyBinding::onEvent(bs::aq::Event event)
+{
+   if (!active_) {
+      return;
+   }
+
+   bs::aq::MarketSnapshot md;
+   md.indicBid = reply_->indicBid();
+   md.indicAsk = reply_->indicAsk();
+   md.lastPrice = reply_->lastPrice();
+   md.bestPrice = reply_->bestPrice();
+   md.isOwnBestPrice = reply_->isOwnBestPrice();
+   md.expirationInSec = reply_->expiration();
+
+   const auto reply = strategy_->onEvent(event, request_, md);
+   switch (reply.action) {
+      case bs::aq::Reply::Action::Send :
+         reply_->sendQuoteReply(reply.price);
+         break;
+      case bs::aq::Reply::Action::Pull :
+         reply_->pullQuoteReply();
+         break;
+      default :
+         break;
+   }
+}
+
+void AQStrategyBinding::onFinished()
+{
+   if (!active_) {
+      return;
+   }
+   active_ = false;
+   strategy_->onFinished(request_.reqId);
+}
@@ -0,0 +1,77 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef AQ_NATIVE_STRATEGY_H
+#define AQ_NATIVE_STRATEGY_H
+
+#include <QObject>
+#include <memory>
+
+#include "AutoQuoteStrategy.h"
+
+namespace spdlog {
+   class logger;
+}
+class AssetManager;
+class BSQuoteReqReply;
+
+
+//! Terminal services for native strategies.
+class AQStrategyContext : public bs::aq::Context
+{
+public:
+   AQStrategyContext(const std::shared_ptr<spdlog::logger> &
+      , const std::shared_ptr<AssetManager> &);
+   ~AQStrategyContext() override = default;
+
+   double accountBalance(const std::string &product) const override;
+   void log(const std::string &message) override;
+
+private:
+   std::shared_ptr<spdlog::logger>  logger_;
+   std::shared_ptr<AssetManager>    assetManager_;
+};
+
+
+//! Loads strategy from shared library. The library is never unloaded and
+//! stays in the process until exit.
+class AQStrategyLibrary
+{
+public:
+   static bool isStrategyLibrary(const QString &fileName);
+
+   static std::shared_ptr<bs::aq::Strategy> load(const QString &fileName
+      , bs::aq::Context *, QString &error);
+};
+
+
+//! Feeds events of C++ created BSQuoteReqReply to the strategy and applies
+//! its replies. Lives as a child of the reply object.
+class AQStrategyBinding : public QObject
+{
+   Q_OBJECT
+
+public:
+   AQStrategyBinding(const std::shared_ptr<bs::aq::Strategy> &, BSQuoteReqReply *parent);
+   ~AQStrategyBinding() noexcept override = default;
+
+private:
+   void onStarted();
+   void onEvent(bs::aq::Event);
+   void onFinished();
+
+private:
+   std::shared_ptr<bs::aq::Strategy>   strategy_;
+   BSQuoteReqReply      *reply_;
+   bs::aq::QuoteRequest request_;
+   bool                 active_ = false;
+};
+
+#endif // AQ_NATIVE_STRATEGY_H
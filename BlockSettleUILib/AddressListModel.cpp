@@ -13,9 +13,17 @@
 #include <QApplication>
 #include <QColor>
 
+#include "RowDiff.h"
 #include "Wallets/SyncWalletsManager.h"
 #include "UiUtils.h"
 
+namespace {
+   std::pair<const bs::sync::Wallet *, QString> rowKey(const AddressListModel::AddressRow &row)
+   {
+      return { row.wallet.get(), row.displayedAddress };
+   }
+}
+
 bool AddressListModel::AddressRow::isMultiLineComment() const
 {
    const auto commentLines = comment.split(QLatin1Char('\n'));
@@ -66,7 +74,7 @@ AddressListModel::AddressListModel(const std::shared_ptr<bs::sync::WalletsManage
       connect(walletsMgr_.get(), &bs::sync::WalletsManager::walletsReady, this
          , &AddressListModel::updateWallets);
       connect(walletsMgr_.get(), &bs::sync::WalletsManager::walletChanged, this
-         , &AddressListModel::updateWallets);
+         , &AddressListModel::onWalletChanged);
       connect(walletsMgr_.get(), &bs::sync::WalletsManager::blockchainEvent, this
          , &AddressListModel::updateWallets);
       connect(walletsMgr_.get(), &bs::sync::WalletsManager::walletBalanceUpdated
@@ -77,6 +85,9 @@ AddressListModel::AddressListModel(const std::shared_ptr<bs::sync::WalletsManage
 bool AddressListModel::setWallets(const Wallets &wallets, bool force, bool filterBtcOnly)
 {
    if ((wallets != wallets_) || (filterBtcOnly != filterBtcOnly_) || force) {
+      if (force) {
+         comments_.clear();
+      }
       wallets_ = wallets;
       filterBtcOnly_ = filterBtcOnly;
       updateWallets();
@@ -86,7 +97,7 @@ bool AddressListModel::setWallets(const Wallets &wallets, bool force, bool filte
 }
 
 AddressListModel::AddressRow AddressListModel::createRow(const bs::Address &addr
-   , const std::shared_ptr<bs::sync::Wallet> &wallet) const
+   , const std::shared_ptr<bs::sync::Wallet> &wallet)
 {
    AddressRow row;
 
@@ -102,8 +113,8 @@ AddressListModel::AddressRow AddressListModel::createRow(const bs::Address &addr
       row.isExternal = true;
    }
    else {
-      row.comment = QString::fromStdString(wallet->getAddressComment(addr));
       row.displayedAddress = QString::fromStdString(addr.display());
+      row.comment = addressComment(wallet, row.displayedAddress, addr);
       row.walletName = QString::fromStdString(wallet->shortName());
       row.walletId = QString::fromStdString(wallet->walletId());
       row.isExternal = wallet->isExternalAddress(addr);
@@ -112,11 +123,30 @@ AddressListModel::AddressRow AddressListModel::createRow(const bs::Address &addr
    return row;
 }
 
+QString AddressListModel::addressComment(const std::shared_ptr<bs::sync::Wallet> &wallet
+   , const QString &displayedAddress, const bs::Address &addr)
+{
+   auto &walletComments = comments_[wallet->walletId()];
+   const auto it = walletComments.find(displayedAddress);
+   if (it != walletComments.end()) {
+      return it->second;
+   }
+   const auto comment = QString::fromStdString(wallet->getAddressComment(addr));
+   walletComments.emplace(displayedAddress, comment);
+   return comment;
+}
+
 void AddressListModel::updateWallets()
 {
    updateData("");
 }
 
+void AddressListModel::onWalletChanged(const std::string &walletId)
+{
+   comments_.erase(walletId);
+   updateWallets();
+}
+
 void AddressListModel::updateData(const std::string &walletId)
 {
    bool expected = false;
@@ -130,14 +160,48 @@ void AddressListModel::updateData(const std::string &walletId)
       updateWallet(wallet, newAddresses);
    }
 
-   if (addressRows_.size() != newAddresses.size() || 
-      !std::equal(addressRows_.begin(), addressRows_.end(), newAddresses.begin())) {
-      
+   // balances and TX counts are kept until updated by updateWalletData()
+   std::map<std::pair<const bs::sync::Wallet *, QString>, size_t> oldRows;
+   for (size_t i = 0; i < addressRows_.size(); ++i) {
+      oldRows.emplace(rowKey(addressRows_[i]), i);
+   }
+   for (auto &row : newAddresses) {
+      const auto it = oldRows.find(rowKey(row));
+      if (it != oldRows.end()) {
+         row.transactionCount = addressRows_[it->second].transactionCount;
+         row.balance = addressRows_[it->second].balance;
+      }
+   }
+
+   const auto diff = RowDiff::compute(addressRows_, newAddresses, rowKey);
+   if (diff.reordered) {
       beginResetModel();
       addressRows_ = std::move(newAddresses);
       endResetModel();
-      updateWalletData();
+      ++rowsGeneration_;
    }
+   else {
+      for (const auto &range : diff.removed) {
+         beginRemoveRows(QModelIndex(), range.first, range.second);
+         addressRows_.erase(addressRows_.begin() + range.first, addressRows_.begin() + range.second + 1);
+         endRemoveRows();
+      }
+      for (const auto &range : diff.inserted) {
+         beginInsertRows(QModelIndex(), range.first, range.second);
+         addressRows_.insert(addressRows_.begin() + range.first, newAddresses.begin() + range.first
+            , newAddresses.begin() + range.second + 1);
+         endInsertRows();
+      }
+      if (!diff.removed.empty() || !diff.inserted.empty()) {
+         ++rowsGeneration_;
+      }
+      for (const auto &range : diff.changed) {
+         std::copy(newAddresses.begin() + range.first, newAddresses.begin() + range.second + 1
+            , addressRows_.begin() + range.first);
+         emit dataChanged(index(range.first, 0), index(range.second, ColumnsNbMultiple - 1));
+      }
+   }
+   updateWalletData();
 
    processing_.store(false);
 }
@@ -178,7 +242,6 @@ void AddressListModel::updateWallet(const std::shared_ptr<bs::sync::Wallet> &wal
 
          auto row = createRow(addr, wallet);
          row.addrIndex = i;
-         row.comment = QString::fromStdString(wallet->getAddressComment(addr));
 
          addresses.emplace_back(std::move(row));
       }
@@ -187,77 +250,76 @@ void AddressListModel::updateWallet(const std::shared_ptr<bs::sync::Wallet> &wal
 
 void AddressListModel::updateWalletData()
 {
-   auto nbTxNs = std::make_shared<int>((int)addressRows_.size());
-   auto nbBalances = std::make_shared<int>((int)addressRows_.size());
-
-   auto addrTxNs = std::make_shared<std::vector<uint32_t>>();
-   addrTxNs->resize(addressRows_.size());
-   auto addrBalances = std::make_shared<std::vector<uint64_t>>();
-   addrBalances->resize(addressRows_.size());
-
+   // one request per wallet for all its addresses
+   struct WalletRows
+   {
+      std::shared_ptr<bs::sync::Wallet>   wallet;
+      std::vector<int>           rows;
+      std::vector<bs::Address>   addresses;
+   };
+   std::vector<WalletRows> walletRows;
+   std::map<const bs::sync::Wallet *, size_t> walletIndices;
    for (size_t i = 0; i < addressRows_.size(); ++i) {
-      // Callback for address's # of TXs.
-      const auto &cbTxN = [this, addrTxNs, i, nbTxNs](uint64_t txn) {
-         QMetaObject::invokeMethod(qApp, [this, handle = validityFlag_.handle(), i, nbTxNs, addrTxNs, txn] {
-            --(*nbTxNs);
-            if (i >= addressRows_.size()) {
-               return;
-            }
-            (*addrTxNs)[i] = txn;
-
-            // On the final address, set the TX count for all addresses and emit
-            // any required signals.
-            if (*nbTxNs <= 0) {
-               for (size_t j = 0; j < std::min(addressRows_.size(), addrTxNs->size()); ++j) {
-                  addressRows_[j].transactionCount = (*addrTxNs)[j];
-               }
-               emit dataChanged(index(0, ColumnTxCount)
-                  , index(addressRows_.size() - 1, ColumnTxCount));
-            }
-         });
-      };
+      const auto &row = addressRows_[i];
+      if (!row.wallet) {
+         continue;
+      }
+      const auto it = walletIndices.emplace(row.wallet.get(), walletRows.size());
+      if (it.second) {
+         walletRows.push_back({ row.wallet, {}, {} });
+      }
+      auto &batch = walletRows[it.first->second];
+      batch.rows.push_back(static_cast<int>(i));
+      batch.addresses.push_back(row.address);
+   }
+
+   for (auto &batch : walletRows) {
+      const auto wallet = batch.wallet;
+      wallet->onBalanceAvailable([this, handle = validityFlag_.handle(), generation = rowsGeneration_
+         , wallet, rows = std::move(batch.rows), addresses = std::move(batch.addresses)]() mutable
+      {
+         std::vector<int> txCounts;
+         std::vector<uint64_t> balances;
+         txCounts.reserve(addresses.size());
+         balances.reserve(addresses.size());
+         for (const auto &address : addresses) {
+            txCounts.push_back(static_cast<int>(wallet->getAddrTxN(address)));
+            const auto addrBalances = wallet->getAddrBalance(address);
+            balances.push_back((addrBalances.size() == 3) ? addrBalances[0] : 0);
+         }
 
-      // Callback for address's balance.
-      const auto &cbBalance = [this, handle = validityFlag_.handle(), addrBalances, i, nbBalances](std::vector<uint64_t> balances) {
-         QMetaObject::invokeMethod(qApp, [this, handle, balances, addrBalances, i, nbBalances] {
+         QMetaObject::invokeMethod(qApp, [this, handle, generation, rows = std::move(rows)
+            , txCounts = std::move(txCounts), balances = std::move(balances)]
+         {
             if (!handle.isValid()) {
                return;
             }
-            --(*nbBalances);
-            if (i >= addressRows_.size()) {
-               return;
-            }
-            if (balances.size() == 3) {
-               (*addrBalances)[i] = balances[0];
-            }
-            else {
-               (*addrBalances)[i] = 0;
-            }
-
-            // On the final address, set the balance for all addresses and emit
-            // any required signals.
-            if (*nbBalances <= 0) {
-               for (size_t j = 0;
-                    j < std::min(addressRows_.size(), addrBalances->size());
-                    ++j) {
-                  addressRows_[j].balance = (*addrBalances)[j];
-               }
-               emit dataChanged(index(0, ColumnBalance)
-                  , index(static_cast<int>(addressRows_.size()) - 1, ColumnBalance));
-            }
+            applyWalletData(generation, rows, txCounts, balances);
          });
-      };
+      });
+   }
+}
 
-      // Get an address's balance & # of TXs from Armory via the wallet.
-      const auto &wallet = addressRows_[i].wallet;
-      const auto &address = addressRows_[i].address;
-      if (!wallet) {
-         return;
+void AddressListModel::applyWalletData(uint64_t generation, const std::vector<int> &rows
+   , const std::vector<int> &txCounts, const std::vector<uint64_t> &balances)
+{
+   if (generation != rowsGeneration_) {
+      return;  // rows were moved, results of newer request will follow
+   }
+   std::vector<int> changedRows;
+   for (size_t i = 0; i < rows.size(); ++i) {
+      if (rows[i] >= static_cast<int>(addressRows_.size())) {
+         continue;
       }
-      wallet->onBalanceAvailable([wallet, address, cbTxN, cbBalance] {
-         cbTxN(wallet->getAddrTxN(address));
-         cbBalance(wallet->getAddrBalance(address));
-      });
+      auto &row = addressRows_[rows[i]];
+      if ((row.transactionCount != txCounts[i]) || (row.balance != balances[i])) {
+         row.transactionCount = txCounts[i];
+         row.balance = balances[i];
+         changedRows.push_back(rows[i]);
+      }
+   }
+   for (const auto &range : RowDiff::ranges(changedRows)) {
+      emit dataChanged(index(range.first, ColumnTxCount), index(range.second, ColumnBalance));
    }
 }
 
@@ -287,6 +349,7 @@ void AddressListModel::removeEmptyIntAddresses()
       addressRows_.erase(addressRows_.begin() + idx);
       endRemoveRows();
       ++nbRemoved;
+      ++rowsGeneration_;
    }
    processing_.store(false);
 }
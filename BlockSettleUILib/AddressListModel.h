@@ -13,6 +13,7 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <QAbstractTableModel>
 #include "CoreWallet.h"
 #include "ValidityFlag.h"
@@ -95,6 +96,7 @@ public:
 
 private slots:
    void updateWallets();
+   void onWalletChanged(const std::string &walletId);
    void updateData(const std::string &walletId);
    void removeEmptyIntAddresses();
 
@@ -103,6 +105,10 @@ private:
    Wallets                    wallets_;
    std::vector<AddressRow>    addressRows_;
    const AddressType          addrType_;
+   // incremented when rows are inserted, removed or moved
+   uint64_t                   rowsGeneration_ = 0;
+   // by wallet ID and displayed address
+   std::unordered_map<std::string, std::map<QString, QString>> comments_;
 
    std::atomic_bool           processing_;
    bool filterBtcOnly_{false};
@@ -111,7 +117,11 @@ private:
 private:
    void updateWallet(const std::shared_ptr<bs::sync::Wallet> &wallet, std::vector<AddressRow> &addresses);
    void updateWalletData();
-   AddressRow createRow(const bs::Address &, const std::shared_ptr<bs::sync::Wallet> &) const;
+   void applyWalletData(uint64_t generation, const std::vector<int> &rows
+      , const std::vector<int> &txCounts, const std::vector<uint64_t> &balances);
+   AddressRow createRow(const bs::Address &, const std::shared_ptr<bs::sync::Wallet> &);
+   QString addressComment(const std::shared_ptr<bs::sync::Wallet> &, const QString &displayedAddress
+      , const bs::Address &);
    QVariant dataForRow(const AddressListModel::AddressRow &row, int column) const;
 };
 
@@ -0,0 +1,131 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef AUTO_QUOTE_STRATEGY_H
+#define AUTO_QUOTE_STRATEGY_H
+
+#include <string>
+
+// API of compiled auto-quoting strategies - an alternative to QML scripts
+// for dealer auto-quoting. Strategy is built as a shared library which uses
+// BS_AQ_STRATEGY_PLUGIN() to export its factory and is selected in the dealer
+// UI the same way as a QML script.
+// The library must be built with the same compiler and C++ runtime as the
+// terminal. All calls are made from the auto-quoting thread.
+
+namespace bs {
+   namespace aq {
+
+      // Bumped on any incompatible change of the classes below
+      const int kStrategyApiVersion = 1;
+
+      struct QuoteRequest
+      {
+         std::string reqId;
+         std::string security;
+         std::string product;
+         // Opposite product of the security, the one dealer pays with
+         std::string contraProduct;
+         bool        isBuy = false;
+         double      quantity = 0;
+         // bs::network::Asset::Type
+         int         assetType = 0;
+      };
+
+      // Latest known market data of RFQ's security and RFQ state
+      struct MarketSnapshot
+      {
+         double indicBid = 0;
+         double indicAsk = 0;
+         double lastPrice = 0;
+         double bestPrice = 0;
+         bool   isOwnBestPrice = false;
+         double expirationInSec = 0;
+      };
+
+      // Same events as the ones QML script handles
+      enum class Event
+      {
+         Started,
+         ExpirationChanged,
+         IndicBidChanged,
+         IndicAskChanged,
+         LastPriceChanged,
+         BestPriceChanged
+      };
+
+      struct Reply
+      {
+         enum class Action
+         {
+            None,
+            Send,
+            Pull
+         };
+
+         Action action = Action::None;
+         double price = 0;
+
+         static Reply none() { return {}; }
+         static Reply send(double price) { return { Action::Send, price }; }
+         static Reply pull() { return { Action::Pull, 0 }; }
+      };
+
+      // Services provided by terminal to the strategy
+      class Context
+      {
+      public:
+         virtual ~Context() = default;
+
+         virtual double accountBalance(const std::string &product) const = 0;
+         virtual void log(const std::string &message) = 0;
+      };
+
+      class Strategy
+      {
+      public:
+         virtual ~Strategy() = default;
+
+         // Called for every event of live RFQ, reply is applied immediately
+         virtual Reply onEvent(Event, const QuoteRequest &, const MarketSnapshot &) = 0;
+         // RFQ is settled, cancelled or expired - per-RFQ state can be dropped
+         virtual void onFinished(const std::string &reqId) = 0;
+      };
+
+   }  // namespace aq
+}  // namespace bs
+
+// Names of functions exported by strategy library
+#define BS_AQ_STRATEGY_API_VERSION_FUNC   "bsAQStrategyApiVersion"
+#define BS_AQ_STRATEGY_CREATE_FUNC        "bsAQStrategyCreate"
+#define BS_AQ_STRATEGY_DESTROY_FUNC       "bsAQStrategyDestroy"
+
+#if defined(_WIN32)
+#  define BS_AQ_STRATEGY_EXPORT extern "C" __declspec(dllexport)
+#else
+#  define BS_AQ_STRATEGY_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// Exports factory of StrategyClass, which should be constructible from bs::aq::Context*
+#define BS_AQ_STRATEGY_PLUGIN(StrategyClass) \
+   BS_AQ_STRATEGY_EXPORT int bsAQStrategyApiVersion() \
+   { \
+      return bs::aq::kStrategyApiVersion; \
+   } \
+   BS_AQ_STRATEGY_EXPORT bs::aq::Strategy *bsAQStrategyCreate(bs::aq::Context *context) \
+   { \
+      return new StrategyClass(context); \
+   } \
+   BS_AQ_STRATEGY_EXPORT void bsAQStrategyDestroy(bs::aq::Strategy *strategy) \
+   { \
+      delete strategy; \
+   }
+
+#endif // AUTO_QUOTE_STRATEGY_H
@@ -12,6 +12,7 @@
 
 #include <QApplication>
 #include <QCloseEvent>
+#include <QDir>
 #include <QGuiApplication>
 #include <QIcon>
 #include <QShortcut>
@@ -947,6 +948,12 @@ void BSTerminalMainWindow::CompleteUIOnlineView()
    if (!transactionsModel_) {
       transactionsModel_ = std::make_shared<TransactionsViewModel>(armory_
          , walletsMgr_, logMgr_->logger("ui"), this);
+      transactionsModel_->setLazyDetails(true);
+      const auto netType = applicationSettings_->get<NetworkType>(ApplicationSettings::netType);
+      const auto snapshotName = (netType == NetworkType::TestNet)
+         ? QStringLiteral("transactions_testnet.snapshot") : QStringLiteral("transactions.snapshot");
+      transactionsModel_->setSnapshot(std::make_shared<TransactionsSnapshot>(
+         QDir(applicationSettings_->GetHomeDir()).filePath(snapshotName), logMgr_->logger("ui")));
 
       InitTransactionsView();
       transactionsModel_->loadAllWallets();
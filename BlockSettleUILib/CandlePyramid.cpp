@@ -0,0 +1,235 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "CandlePyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+   bool keyLess(const CandlePyramid::Candle &candle, double key)
+   {
+      return candle.key < key;
+   }
+
+   std::vector<CandlePyramid::Candle>::iterator lowerBound(std::vector<CandlePyramid::Candle> &candles, double key)
+   {
+      return std::lower_bound(candles.begin(), candles.end(), key, keyLess);
+   }
+
+   std::vector<CandlePyramid::Candle>::const_iterator lowerBound(const std::vector<CandlePyramid::Candle> &candles
+      , double key)
+   {
+      return std::lower_bound(candles.begin(), candles.end(), key, keyLess);
+   }
+}
+
+CandlePyramid::CandlePyramid(double baseWidth, int factor, std::size_t maxLevels)
+   : factor_(std::max(factor, 2))
+   , levels_(std::max<std::size_t>(maxLevels, 1))
+{
+   reset(baseWidth);
+}
+
+void CandlePyramid::reset(double baseWidth)
+{
+   double width = baseWidth;
+   for (auto &level : levels_) {
+      level.width = width;
+      width *= factor_;
+   }
+   clear();
+}
+
+void CandlePyramid::clear()
+{
+   for (auto &level : levels_) {
+      level.candles.clear();
+      level.tree.clear();
+   }
+}
+
+void CandlePyramid::insert(std::vector<Candle> candles)
+{
+   if (candles.empty()) {
+      return;
+   }
+   std::stable_sort(candles.begin(), candles.end(), [](const Candle &a, const Candle &b) {
+      return a.key < b.key;
+   });
+   // the last of the same key wins
+   std::vector<Candle> unique;
+   unique.reserve(candles.size());
+   for (const auto &candle : candles) {
+      if (!unique.empty() && (unique.back().key == candle.key)) {
+         unique.back() = candle;
+      }
+      else {
+         unique.push_back(candle);
+      }
+   }
+
+   auto &base = levels_.front().candles;
+   std::vector<Candle> merged;
+   merged.reserve(base.size() + unique.size());
+   auto itOld = base.cbegin();
+   for (const auto &candle : unique) {
+      while ((itOld != base.cend()) && (itOld->key < candle.key)) {
+         merged.push_back(*itOld++);
+      }
+      if ((itOld != base.cend()) && (itOld->key == candle.key)) {
+         ++itOld;
+      }
+      merged.push_back(candle);
+   }
+   merged.insert(merged.end(), itOld, base.cend());
+   base.swap(merged);
+   rebuildTree(levels_.front());
+
+   for (std::size_t i = 1; i < levels_.size(); ++i) {
+      rebuildBuckets(i, unique.front().key, unique.back().key);
+   }
+}
+
+void CandlePyramid::update(const Candle &candle)
+{
+   auto &base = levels_.front();
+   const auto it = lowerBound(base.candles, candle.key);
+   const auto pos = static_cast<std::size_t>(it - base.candles.begin());
+   if ((it != base.candles.end()) && (it->key == candle.key)) {
+      *it = candle;
+      updateTree(base, pos);
+   }
+   else {
+      base.candles.insert(it, candle);
+      rebuildTree(base);
+   }
+
+   for (std::size_t i = 1; i < levels_.size(); ++i) {
+      rebuildBuckets(i, candle.key, candle.key);
+   }
+}
+
+std::size_t CandlePyramid::levelFor(double rangeSize, int pixelColumns) const
+{
+   std::size_t result = 0;
+   for (std::size_t i = 1; i < levels_.size(); ++i) {
+      if (rangeSize / levels_[i].width < pixelColumns) {
+         break;
+      }
+      result = i;
+   }
+   return result;
+}
+
+CandlePyramid::Range CandlePyramid::valueRange(std::size_t level, double from, double to) const
+{
+   Range result{ std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(), 0, false };
+   const auto &lvl = levels_[level];
+   const std::size_t n = lvl.candles.size();
+   std::size_t l = static_cast<std::size_t>(lowerBound(lvl.candles, from) - lvl.candles.begin());
+   std::size_t r = static_cast<std::size_t>(std::upper_bound(lvl.candles.begin(), lvl.candles.end(), to
+      , [](double key, const Candle &candle) { return key < candle.key; }) - lvl.candles.begin());
+   if (l >= r) {
+      return result;
+   }
+   result.found = true;
+   const auto apply = [&result](const Node &node) {
+      result.low = std::min(result.low, node.low);
+      result.high = std::max(result.high, node.high);
+      result.maxVolume = std::max(result.maxVolume, node.maxVolume);
+   };
+   for (l += n, r += n; l < r; l >>= 1, r >>= 1) {
+      if (l & 1) {
+         apply(lvl.tree[l++]);
+      }
+      if (r & 1) {
+         apply(lvl.tree[--r]);
+      }
+   }
+   return result;
+}
+
+void CandlePyramid::rebuildTree(Level &level)
+{
+   const std::size_t n = level.candles.size();
+   level.tree.resize(2 * n);
+   for (std::size_t i = 0; i < n; ++i) {
+      const auto &candle = level.candles[i];
+      level.tree[n + i] = { candle.low, candle.high, candle.volume };
+   }
+   for (std::size_t i = n; i-- > 1; ) {
+      const auto &left = level.tree[2 * i];
+      const auto &right = level.tree[2 * i + 1];
+      level.tree[i] = { std::min(left.low, right.low), std::max(left.high, right.high)
+         , std::max(left.maxVolume, right.maxVolume) };
+   }
+}
+
+void CandlePyramid::updateTree(Level &level, std::size_t pos)
+{
+   const std::size_t n = level.candles.size();
+   const auto &candle = level.candles[pos];
+   std::size_t i = pos + n;
+   level.tree[i] = { candle.low, candle.high, candle.volume };
+   for (i >>= 1; i > 0; i >>= 1) {
+      const auto &left = level.tree[2 * i];
+      const auto &right = level.tree[2 * i + 1];
+      level.tree[i] = { std::min(left.low, right.low), std::max(left.high, right.high)
+         , std::max(left.maxVolume, right.maxVolume) };
+   }
+}
+
+double CandlePyramid::bucketStart(std::size_t level, double key) const
+{
+   const double width = levels_[level].width;
+   return std::floor(key / width) * width;
+}
+
+void CandlePyramid::rebuildBuckets(std::size_t level, double from, double to)
+{
+   const auto &below = levels_[level - 1].candles;
+   auto &lvl = levels_[level];
+   const double width = lvl.width;
+   const double first = bucketStart(level, from);
+   const double end = bucketStart(level, to) + width;
+
+   std::vector<Candle> buckets;
+   for (auto it = lowerBound(below, first); (it != below.end()) && (it->key < end); ++it) {
+      const double start = bucketStart(level, it->key);
+      if (buckets.empty() || (buckets.back().key != start)) {
+         buckets.push_back({ start, it->open, it->high, it->low, it->close, it->volume });
+      }
+      else {
+         auto &bucket = buckets.back();
+         bucket.high = std::max(bucket.high, it->high);
+         bucket.low = std::min(bucket.low, it->low);
+         bucket.close = it->close;
+         bucket.volume += it->volume;
+      }
+   }
+
+   const auto itFrom = lowerBound(lvl.candles, first);
+   const auto itTo = lowerBound(lvl.candles, end);
+   const auto pos = static_cast<std::size_t>(itFrom - lvl.candles.begin());
+   if (static_cast<std::size_t>(itTo - itFrom) == buckets.size()) {
+      // usual case of updated candle - tree shape stays the same
+      std::copy(buckets.begin(), buckets.end(), itFrom);
+      for (std::size_t i = 0; i < buckets.size(); ++i) {
+         updateTree(lvl, pos + i);
+      }
+   }
+   else {
+      const auto itErased = lvl.candles.erase(itFrom, itTo);
+      lvl.candles.insert(itErased, buckets.begin(), buckets.end());
+      rebuildTree(lvl);
+   }
+}
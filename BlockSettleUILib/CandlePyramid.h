@@ -0,0 +1,102 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef CANDLE_PYRAMID_H
+#define CANDLE_PYRAMID_H
+
+#include <cstddef>
+#include <vector>
+
+// Candles of the chart with pre-aggregated coarser levels: level 0 holds the
+// candles as received, level k merges candles of level k-1 which fall into
+// the same time bucket of baseWidth * factor^k. Levels are updated
+// incrementally, only buckets touched by new or changed candles are rebuilt.
+// Each level has a segment tree answering min low, max high and max volume
+// of any key range.
+class CandlePyramid
+{
+public:
+   struct Candle
+   {
+      double key;    // start of the candle, seconds
+      double open;
+      double high;
+      double low;
+      double close;
+      double volume;
+   };
+
+   struct Range
+   {
+      double   low;
+      double   high;
+      double   maxVolume;
+      bool     found;
+   };
+
+   static constexpr int kDefaultFactor = 4;
+   static constexpr std::size_t kDefaultMaxLevels = 6;
+
+   explicit CandlePyramid(double baseWidth = 1, int factor = kDefaultFactor
+      , std::size_t maxLevels = kDefaultMaxLevels);
+
+   // Drops all candles and sets new base candle width
+   void reset(double baseWidth);
+   void clear();
+
+   // Adds candles in any order, replaces ones with the same key
+   void insert(std::vector<Candle> candles);
+   // Adds or replaces single candle
+   void update(const Candle &);
+
+   bool empty() const { return levels_.front().candles.empty(); }
+   std::size_t size() const { return levels_.front().candles.size(); }
+   const Candle &first() const { return levels_.front().candles.front(); }
+   const Candle &last() const { return levels_.front().candles.back(); }
+
+   std::size_t levelCount() const { return levels_.size(); }
+   const std::vector<Candle> &level(std::size_t level) const { return levels_[level].candles; }
+   double levelWidth(std::size_t level) const { return levels_[level].width; }
+
+   // Coarsest level which still has at least one candle per pixel column in
+   // a key range of given size
+   std::size_t levelFor(double rangeSize, int pixelColumns) const;
+
+   // Candles of the level with keys in [from, to]
+   Range valueRange(std::size_t level, double from, double to) const;
+
+private:
+   struct Node
+   {
+      double   low;
+      double   high;
+      double   maxVolume;
+   };
+
+   struct Level
+   {
+      double               width;
+      std::vector<Candle>  candles;
+      // iterative segment tree, leaves start at candles.size()
+      std::vector<Node>    tree;
+   };
+
+   void rebuildTree(Level &);
+   void updateTree(Level &, std::size_t pos);
+   // Re-aggregates buckets of level covering keys [from, to] from the level below
+   void rebuildBuckets(std::size_t level, double from, double to);
+   double bucketStart(std::size_t level, double key) const;
+
+private:
+   const int            factor_;
+   std::vector<Level>   levels_;
+};
+
+#endif // CANDLE_PYRAMID_H
@@ -10,14 +10,18 @@
 */
 #include "ChartWidget.h"
 
+#include <QDir>
 #include <spdlog/logger.h>
 
+#include <algorithm>
+
 #include "ApplicationSettings.h"
 #include "Colors.h"
 #include "MDCallbacksQt.h"
 #include "MarketDataProvider.h"
 #include "MdhsClient.h"
 #include "PubKeyLoader.h"
+#include "ReplotScheduler.h"
 #include "market_data_history.pb.h"
 
 #include "trade_history.pb.h"
@@ -65,12 +69,90 @@ QSize ComboBoxDelegate::sizeHint(const QStyleOptionViewItem& option, const QMode
    return QItemDelegate::sizeHint(option, index);
 }
 
+void CandleBatch::reserve(int size)
+{
+   candles_.reserve(size);
+   volumes_.reserve(size);
+}
+
+void CandleBatch::add(qreal open, qreal high, qreal low, qreal close, qreal timestamp, qreal volume)
+{
+   candles_.append(QCPFinancialData(timestamp / 1000, open, high, low, close));
+   volumes_.append(QCPBarsData(timestamp / 1000, volume));
+}
+
+void CandleBatch::commit(CandlePyramid &pyramid)
+{
+   if (candles_.isEmpty()) {
+      return;
+   }
+   std::vector<CandlePyramid::Candle> candles;
+   candles.reserve(static_cast<std::size_t>(candles_.size()));
+   for (int i = 0; i < candles_.size(); ++i) {
+      const auto &candle = candles_.at(i);
+      candles.push_back({ candle.key, candle.open, candle.high, candle.low, candle.close, volumes_.at(i).value });
+   }
+   pyramid.insert(std::move(candles));
+   candles_.clear();
+   volumes_.clear();
+}
+
+void CandleCharts::setLevel(const CandlePyramid &pyramid, std::size_t level
+   , QCPFinancial *candles, QCPBars *volumes)
+{
+   const auto &levelCandles = pyramid.level(level);
+   QVector<QCPFinancialData> candleData;
+   QVector<QCPBarsData> volumeData;
+   candleData.reserve(static_cast<int>(levelCandles.size()));
+   volumeData.reserve(static_cast<int>(levelCandles.size()));
+   for (const auto &candle : levelCandles) {
+      candleData.append(QCPFinancialData(candle.key, candle.open, candle.high, candle.low, candle.close));
+      volumeData.append(QCPBarsData(candle.key, candle.volume));
+   }
+   candles->data()->set(candleData, true);
+   volumes->data()->set(volumeData, true);
+
+   const qreal width = 0.8 * pyramid.levelWidth(level);
+   candles->setWidth(width);
+   volumes->setWidth(width);
+}
+
+void CandleCharts::refreshCandle(const CandlePyramid &pyramid, std::size_t level, double key
+   , QCPFinancial *candles, QCPBars *volumes)
+{
+   const auto &levelCandles = pyramid.level(level);
+   auto itLevel = std::upper_bound(levelCandles.cbegin(), levelCandles.cend(), key
+      , [](double key, const CandlePyramid::Candle &candle) { return key < candle.key; });
+   if (itLevel == levelCandles.cbegin()) {
+      return;
+   }
+   const auto &candle = *(--itLevel);
+
+   const auto candleData = candles->data();
+   const auto volumeData = volumes->data();
+   const auto itShown = candleData->findBegin(candle.key, false);
+   if ((itShown != candleData->constEnd()) && qFuzzyCompare(itShown->key, candle.key)) {
+      const auto pos = itShown - candleData->constBegin();
+      auto itCandle = candleData->begin() + pos;
+      itCandle->open = candle.open;
+      itCandle->high = candle.high;
+      itCandle->low = candle.low;
+      itCandle->close = candle.close;
+      (volumeData->begin() + pos)->value = candle.volume;
+   }
+   else {
+      candleData->add(QCPFinancialData(candle.key, candle.open, candle.high, candle.low, candle.close));
+      volumeData->add(QCPBarsData(candle.key, candle.volume));
+   }
+}
+
 ChartWidget::ChartWidget(QWidget* pParent)
    : QWidget(pParent)
      , ui_(new Ui::ChartWidget)
      , candlesticksChart_(nullptr)
      , volumeChart_(nullptr)
      , volumeAxisRect_(nullptr)
+     , replotScheduler_(nullptr)
      , lastHigh_(0.0)
      , lastLow_(0.0)
      , lastClose_(0.0)
@@ -80,6 +162,7 @@ ChartWidget::ChartWidget(QWidget* pParent)
      , isDraggingYAxis_(false)
 {
    ui_->setupUi(this);
+   replotScheduler_ = new ReplotScheduler(ui_->customPlot, this);
    horLine = new QCPItemLine(ui_->customPlot);
    vertLine = new QCPItemLine(ui_->customPlot);
    setAutoScaleBtnColor();
@@ -123,6 +206,8 @@ void ChartWidget::init(const std::shared_ptr<ApplicationSettings>& appSettings
    mdProvider_ = mdProvider;
    mdhsClient_ = std::make_shared<MdhsClient>(connectionManager, logger, mdhsHost, mdhsPort);
    logger_ = logger;
+   candleCache_ = std::make_unique<OhlcCandleCache>(
+      QDir(appSettings->GetHomeDir()).filePath(QStringLiteral("ohlc_cache")), OhlcCandleCache::kDefaultMaxSize, logger);
 
    connect(mdhsClient_.get(), &MdhsClient::DataReceived, this, &ChartWidget::OnDataReceived);
 
@@ -263,13 +348,38 @@ void ChartWidget::UpdateChart(const int& interval)
    }
    candlesticksChart_->data()->clear();
    volumeChart_->data()->clear();
+   pyramid_.reset(IntervalWidth(interval) / 1000);
+   lod_ = 0;
+   lastCandle_.Clear();
+   pageRequestStamp_ = -1;
+   showingCached_ = false;
    qreal width = 0.8 * IntervalWidth(interval) / 1000;
    candlesticksChart_->setWidth(width);
    volumeChart_->setWidth(width);
+
+   int count = requestLimit;
+   OhlcCandleCache::Coverage coverage;
+   std::vector<OhlcCandleCache::Candle> cached;
+   if (candleCache_) {
+      coverage = candleCache_->coverage(product.toStdString(), interval);
+      cached = candleCache_->newest(product.toStdString(), interval, requestLimit);
+      if (!cached.empty()) {
+         // show what we have and ask only for candles since then
+         count = OhlcCandleCache::headRequestCount(coverage, QDateTime::currentDateTimeUtc().toMSecsSinceEpoch()
+            , static_cast<int64_t>(IntervalWidth(interval)), requestLimit);
+      }
+   }
+   // set before cached candles are shown: range change must not request older pages
+   headRequestCount_ = count;
+   if (!cached.empty()) {
+      showingCached_ = true;
+      ProcessOhlcHistory(CachedResponse(product, interval, cached, coverage.firstInDb));
+   }
+
    OhlcRequest ohlcRequest;
    ohlcRequest.set_product(product.toStdString());
    ohlcRequest.set_interval(static_cast<Interval>(interval));
-   ohlcRequest.set_count(requestLimit);
+   ohlcRequest.set_count(count);
    ohlcRequest.set_lesser_then(-1);
 
    MarketDataHistoryRequest request;
@@ -371,16 +481,57 @@ void ChartWidget::ProcessOhlcHistoryResponse(const std::string& data)
       return;
    }
 
-   bool firstPortion = candlesticksChart_->data()->size() == 0;
-
    auto product = getCurrentProductName();
    auto interval = dateRange_.checkedId();
 
    if (product != QString::fromStdString(response.product()) || interval != response.interval())
       return;
 
+   const bool head = (headRequestCount_ > 0);
+   StoreInCache(response, head);
+   if (head) {
+      headRequestCount_ = 0;
+   }
+   else {
+      pageRequestStamp_ = -1;
+   }
+
+   if (head && showingCached_) {
+      // redraw cached candles together with the new ones
+      showingCached_ = false;
+      OhlcResponse merged = response;
+      if (candleCache_) {
+         const auto coverage = candleCache_->coverage(product.toStdString(), interval);
+         const auto oldest = response.candles_size()
+            ? static_cast<int64_t>(response.candles(response.candles_size() - 1).timestamp()) : coverage.to + 1;
+         const auto cached = candleCache_->before(product.toStdString(), interval, oldest
+            , static_cast<std::size_t>(std::max(requestLimit - response.candles_size(), 0)));
+         for (const auto &candle : CachedResponse(product, interval, cached, coverage.firstInDb).candles()) {
+            *merged.add_candles() = candle;
+         }
+         if (!merged.first_stamp_in_db()) {
+            merged.set_first_stamp_in_db(coverage.firstInDb);
+         }
+      }
+      candlesticksChart_->data()->clear();
+      volumeChart_->data()->clear();
+      lastCandle_.Clear();
+      ProcessOhlcHistory(merged);
+      return;
+   }
+
+   ProcessOhlcHistory(response);
+}
+
+void ChartWidget::ProcessOhlcHistory(const OhlcResponse& response)
+{
+   bool firstPortion = pyramid_.empty();
+   auto interval = dateRange_.checkedId();
+
    quint64 maxTimestamp = 0;
 
+   CandleBatch batch;
+   batch.reserve(response.candles_size());
    for (int i = 0; i < response.candles_size(); i++) {
       auto candle = response.candles(i);
       maxTimestamp = qMax(maxTimestamp, static_cast<quint64>(candle.timestamp()));
@@ -395,18 +546,19 @@ void ChartWidget::ProcessOhlcHistoryResponse(const std::string& data)
       }
       else {
          if (lastCandle_.timestamp() - candle.timestamp() != IntervalWidth(
-            interval, 1, QDateTime::fromMSecsSinceEpoch(candle.timestamp(), Qt::TimeSpec::UTC)) && candlesticksChart_->data()->size()) {
+            interval, 1, QDateTime::fromMSecsSinceEpoch(candle.timestamp(), Qt::TimeSpec::UTC))
+            && (!pyramid_.empty() || !batch.empty())) {
             for (int j = 0; j < (lastCandle_.timestamp() - candle.timestamp()) / IntervalWidth(
                     interval, 1, QDateTime::fromMSecsSinceEpoch(candle.timestamp(), Qt::TimeSpec::UTC)) - 1; j++) {
-               AddDataPoint(candle.close(), candle.close(), candle.close(), candle.close(),
-                            lastCandle_.timestamp() - IntervalWidth(interval) * (j + 1), 0);
+               batch.add(candle.close(), candle.close(), candle.close(), candle.close(),
+                         lastCandle_.timestamp() - IntervalWidth(interval) * (j + 1), 0);
             }
          }
       }
 
       lastCandle_ = candle;
 
-      AddDataPoint(candle.open(), candle.high(), candle.low(), candle.close(), candle.timestamp(), candle.volume());
+      batch.add(candle.open(), candle.high(), candle.low(), candle.close(), candle.timestamp(), candle.volume());
 #if 0
       qDebug("Added: %s, open: %f, high: %f, low: %f, close: %f, volume: %f"
              , QDateTime::fromMSecsSinceEpoch(candle.timestamp(), Qt::TimeSpec::UTC)
@@ -423,6 +575,8 @@ void ChartWidget::ProcessOhlcHistoryResponse(const std::string& data)
          lastClose_ = candle.close();
       }
    }
+   batch.commit(pyramid_);
+   RefreshCandles();
 
    if (firstPortion) {
       if (!qFuzzyIsNull(currentTimestamp_)) {
@@ -439,7 +593,7 @@ void ChartWidget::ProcessOhlcHistoryResponse(const std::string& data)
       }
       else {
          if (newestCandleTimestamp_ > maxTimestamp) {
-            auto lastCandle = *(candlesticksChart_->data()->at(candlesticksChart_->data()->size() - 1));
+            const auto lastCandle = pyramid_.last();
             for (quint64 i = 0; i < (newestCandleTimestamp_ - maxTimestamp) / IntervalWidth(interval); i++) {
                AddDataPoint(lastCandle.close, lastCandle.close, lastCandle.close, lastCandle.close,
                             newestCandleTimestamp_ - IntervalWidth(interval) * i, 0);
@@ -453,10 +607,63 @@ void ChartWidget::ProcessOhlcHistoryResponse(const std::string& data)
    else {
       LoadAdditionalPoints(volumeAxisRect_->axis(QCPAxis::atBottom)->range());
       rescalePlot();
-      ui_->customPlot->replot();
+      replotScheduler_->request();
    }
 }
 
+void ChartWidget::StoreInCache(const OhlcResponse& response, bool head)
+{
+   if (!candleCache_) {
+      return;
+   }
+   const auto interval = static_cast<Interval>(response.interval());
+
+   std::vector<OhlcCandleCache::Candle> candles;
+   candles.reserve(static_cast<std::size_t>(response.candles_size()));
+   for (const auto &candle : response.candles()) {
+      candles.push_back({ static_cast<int64_t>(candle.timestamp()), candle.open(), candle.high()
+         , candle.low(), candle.close(), candle.volume() });
+   }
+
+   int64_t to = 0;
+   int requested = requestLimit;
+   if (head) {
+      // the current candle is not final yet
+      const auto now = qFuzzyIsNull(currentTimestamp_)
+         ? QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() : static_cast<qint64>(currentTimestamp_);
+      to = static_cast<int64_t>(GetCandleTimestamp(static_cast<uint64_t>(now), interval)) - 1;
+      requested = headRequestCount_;
+   }
+   else if (pageRequestStamp_ >= 0) {
+      to = pageRequestStamp_ - 1;
+   }
+   else {
+      return;
+   }
+
+   candleCache_->storeResponse(response.product(), response.interval(), candles, requested, to
+      , static_cast<int64_t>(response.first_stamp_in_db()));
+}
+
+OhlcResponse ChartWidget::CachedResponse(const QString& product, int interval
+   , const std::vector<OhlcCandleCache::Candle>& candles, qint64 firstInDb) const
+{
+   OhlcResponse response;
+   response.set_product(product.toStdString());
+   response.set_interval(static_cast<Interval>(interval));
+   response.set_first_stamp_in_db(firstInDb);
+   for (const auto &candle : candles) {
+      auto ohlcCandle = response.add_candles();
+      ohlcCandle->set_timestamp(candle.timestamp);
+      ohlcCandle->set_open(candle.open);
+      ohlcCandle->set_high(candle.high);
+      ohlcCandle->set_low(candle.low);
+      ohlcCandle->set_close(candle.close);
+      ohlcCandle->set_volume(candle.volume);
+   }
+   return response;
+}
+
 void ChartWidget::ProcessEodResponse(const std::string& data)
 {
    eodRequestSent_ = false;
@@ -465,19 +672,22 @@ void ChartWidget::ProcessEodResponse(const std::string& data)
    if (getCurrentProductName().toStdString() != eodPrice.product()) {
       return;
    }
-   if (candlesticksChart_->data()->size() < 2) {
+   if (pyramid_.size() < 2) {
       return;
    }
    auto delta = dateRange_.checkedId() >= Interval::TwentyFourHours ? 2 : 1; //should we update last or pre-last candle
-   auto lastCandle = candlesticksChart_->data()->end() - delta;
-   lastCandle->high = qMax(lastCandle->high, eodPrice.price());
-   lastCandle->low = qMin(lastCandle->low, eodPrice.price());
-   if (!qFuzzyCompare(lastCandle->close, eodPrice.price())) {
-      lastCandle->close = eodPrice.price();
-      UpdateOHLCInfo(IntervalWidth(dateRange_.checkedId()) / 1000,
+   auto lastCandle = pyramid_.level(0)[pyramid_.size() - delta];
+   const bool closeChanged = !qFuzzyCompare(lastCandle.close, eodPrice.price());
+   lastCandle.high = qMax(lastCandle.high, eodPrice.price());
+   lastCandle.low = qMin(lastCandle.low, eodPrice.price());
+   lastCandle.close = eodPrice.price();
+   pyramid_.update(lastCandle);
+   RefreshCandle(lastCandle.key);
+   if (closeChanged) {
+      UpdateOHLCInfo(pyramid_.levelWidth(lod_),
                      ui_->customPlot->xAxis->pixelToCoord(ui_->customPlot->mapFromGlobal(QCursor::pos()).x()));
       rescalePlot();
-      ui_->customPlot->replot();
+      replotScheduler_->request();
    }
    eodUpdated_ = true;
 }
@@ -489,11 +699,11 @@ double ChartWidget::CountOffsetFromRightBorder()
 
 void ChartWidget::CheckToAddNewCandle(qint64 stamp)
 {
-   if (stamp <= newestCandleTimestamp_ + IntervalWidth(dateRange_.checkedId()) || !volumeChart_->data()->size()) {
+   if (stamp <= newestCandleTimestamp_ + IntervalWidth(dateRange_.checkedId()) || pyramid_.empty()) {
       return;
    }
    auto candleStamp = GetCandleTimestamp(stamp, static_cast<Interval>(dateRange_.checkedId()));
-   auto lastCandle = *(candlesticksChart_->data()->at(candlesticksChart_->data()->size() - 1));
+   const auto lastCandle = pyramid_.last();
    for (quint64 i = 0; i < (candleStamp - newestCandleTimestamp_) / IntervalWidth(dateRange_.checkedId()); i++) {
       AddDataPoint(lastCandle.close, lastCandle.close, lastCandle.close, lastCandle.close,
                    candleStamp - IntervalWidth(dateRange_.checkedId()) * i, 0);
@@ -504,7 +714,7 @@ void ChartWidget::CheckToAddNewCandle(qint64 stamp)
       ui_->customPlot->xAxis->moveRange(IntervalWidth(dateRange_.checkedId()) / 1000);
    }
    AddDataPoint(lastClose_, lastClose_, lastClose_, lastClose_, newestCandleTimestamp_, 0);
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 }
 
 void ChartWidget::setAutoScaleBtnColor() const
@@ -539,7 +749,7 @@ void ChartWidget::UpdatePrintFlag()
    auto prec = FractionSizeForProduct(productTypesMapper[getCurrentProductName().toStdString()]);
    lastPrintFlag_->setText(QStringLiteral("-  ") + QString::number(lastClose_, 'f', prec));
    lastPrintFlag_->position->setCoords(ui_->customPlot->yAxis2->axisRect()->rect().right() + 2, ui_->customPlot->yAxis2->coordToPixel(lastClose_));
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 }
 
 void ChartWidget::UpdatePlot(const int& interval, const qint64& timestamp)
@@ -554,32 +764,50 @@ void ChartWidget::UpdatePlot(const int& interval, const qint64& timestamp)
    rescaleCandlesYAxis();
    ui_->customPlot->yAxis2->setNumberPrecision(
       FractionSizeForProduct(productTypesMapper[getCurrentProductName().toStdString()]));
-   ui_->customPlot->replot();
+   replotScheduler_->request();
    UpdatePrintFlag();
 }
 
-bool ChartWidget::needLoadNewData(const QCPRange& range, const QSharedPointer<QCPFinancialDataContainer> data) const
+bool ChartWidget::needLoadNewData(const QCPRange& range) const
 {
-   return data->size() &&
-      (range.lower - data->constBegin()->key < IntervalWidth(dateRange_.checkedId()) / 1000 * loadDistance)
-      && firstTimestampInDb_ + IntervalWidth(OneHour) < data->constBegin()->key;
+   return !pyramid_.empty() &&
+      (range.lower - pyramid_.first().key < IntervalWidth(dateRange_.checkedId()) / 1000 * loadDistance)
+      && firstTimestampInDb_ + IntervalWidth(OneHour) < pyramid_.first().key;
 }
 
 void ChartWidget::LoadAdditionalPoints(const QCPRange& range)
 {
-   const auto data = candlesticksChart_->data();
-   if (needLoadNewData(range, data)) {
-      if (qFuzzyCompare(prevRequestStamp, data->constBegin()->key)) {
+   if (needLoadNewData(range)) {
+      const auto firstKey = pyramid_.first().key;
+      if (qFuzzyCompare(prevRequestStamp, firstKey)) {
          return;
       }
-      OhlcRequest ohlcRequest;
       auto product = getCurrentProductName();
+      const auto lesserThan = qRound64(firstKey * 1000);
+
+      if (candleCache_) {
+         const auto cached = candleCache_->before(product.toStdString(), dateRange_.checkedId()
+            , lesserThan, requestLimit);
+         if (!cached.empty()) {
+            prevRequestStamp = firstKey;
+            const auto coverage = candleCache_->coverage(product.toStdString(), dateRange_.checkedId());
+            ProcessOhlcHistory(CachedResponse(product, dateRange_.checkedId(), cached, coverage.firstInDb));
+            return;
+         }
+      }
+      // older candles are requested after the newest ones are received
+      if ((headRequestCount_ > 0) || (pageRequestStamp_ >= 0)) {
+         return;
+      }
+
+      OhlcRequest ohlcRequest;
       ohlcRequest.set_product(product.toStdString());
       ohlcRequest.set_interval(static_cast<Interval>(dateRange_.checkedId()));
       ohlcRequest.set_count(requestLimit);
-      ohlcRequest.set_lesser_then(data->constBegin()->key * 1000);
+      ohlcRequest.set_lesser_then(lesserThan);
 
-      prevRequestStamp = data->constBegin()->key;
+      prevRequestStamp = firstKey;
+      pageRequestStamp_ = lesserThan;
 
       MarketDataHistoryRequest request;
       request.set_request_type(MarketDataHistoryMessageType::OhlcHistoryType);
@@ -626,14 +854,41 @@ void ChartWidget::AddChildItem(QStandardItemModel* model, const QString& text)
 }
 
 void ChartWidget::AddDataPoint(const qreal& open, const qreal& high, const qreal& low, const qreal& close,
-                               const qreal& timestamp, const qreal& volume) const
+                               const qreal& timestamp, const qreal& volume)
+{
+   pyramid_.update({ timestamp / 1000, open, high, low, close, volume });
+   RefreshCandle(timestamp / 1000);
+}
+
+void ChartWidget::RefreshCandles()
 {
-   if (candlesticksChart_) {
-      candlesticksChart_->data()->add(QCPFinancialData(timestamp / 1000, open, high, low, close));
+   if (!candlesticksChart_ || !volumeChart_) {
+      return;
    }
-   if (volumeChart_) {
-      volumeChart_->data()->add(QCPBarsData(timestamp / 1000, volume));
+   CandleCharts::setLevel(pyramid_, lod_, candlesticksChart_, volumeChart_);
+}
+
+void ChartWidget::RefreshCandle(double key)
+{
+   if (!candlesticksChart_ || !volumeChart_) {
+      return;
    }
+   CandleCharts::refreshCandle(pyramid_, lod_, key, candlesticksChart_, volumeChart_);
+}
+
+void ChartWidget::UpdateLevelOfDetail()
+{
+   if (!volumeAxisRect_) {
+      return;
+   }
+   // coarsest level which still gives at least one candle per pixel column
+   const auto lod = pyramid_.levelFor(volumeAxisRect_->axis(QCPAxis::atBottom)->range().size()
+      , volumeAxisRect_->width());
+   if (lod == lod_) {
+      return;
+   }
+   lod_ = lod;
+   RefreshCandles();
 }
 
 quint64 ChartWidget::IntervalWidth(int interval, int count, const QDateTime& specialDate) const
@@ -744,7 +999,7 @@ void ChartWidget::OnPlotMouseMove(QMouseEvent* event)
    DrawCrossfire(event);
 
    double x = event->localPos().x();
-   double width = IntervalWidth(dateRange_.checkedId()) / 1000;
+   double width = pyramid_.levelWidth(lod_);
    double timestamp = ui_->customPlot->xAxis->pixelToCoord(x);
    if (!candlesticksChart_->data()->size() ||
       timestamp > candlesticksChart_->data()->at(candlesticksChart_->data()->size() - 1)->key + width / 2 ||
@@ -790,8 +1045,7 @@ void ChartWidget::OnPlotMouseMove(QMouseEvent* event)
       const double startPixel = dragStartPos_.x();
       const double currentPixel = event->pos().x();
       const double diff = axis->pixelToCoord(startPixel) - axis->pixelToCoord(currentPixel);
-      auto size = candlesticksChart_->data()->size();
-      double upper_bound = size ? candlesticksChart_->data()->at(size - 1)->key : QDateTime::currentSecsSinceEpoch();
+      double upper_bound = !pyramid_.empty() ? pyramid_.last().key : QDateTime::currentSecsSinceEpoch();
       upper_bound += IntervalWidth(dateRange_.checkedId()) / 1000 / 2 + CountOffsetFromRightBorder();
       double lower_bound = QDateTime(QDate(2009, 1, 3)).toSecsSinceEpoch();
       if (dragStartRangeX_.upper + diff > upper_bound && diff > 0) {
@@ -814,24 +1068,24 @@ void ChartWidget::OnPlotMouseMove(QMouseEvent* event)
       }
 
    }
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 }
 
 void ChartWidget::leaveEvent(QEvent* event)
 {
    vertLine->setVisible(false);
    horLine->setVisible(false);
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 }
 
 void ChartWidget::rescaleCandlesYAxis()
 {
-   bool foundRange = false;
    auto keyRange = candlesticksChart_->keyAxis()->range();
-   keyRange.upper += IntervalWidth(dateRange_.checkedId()) / 1000 / 2;
-   keyRange.lower -= IntervalWidth(dateRange_.checkedId()) / 1000 / 2;
-   auto newRange = candlesticksChart_->getValueRange(foundRange, QCP::sdBoth, keyRange);
-   if (foundRange) {
+   keyRange.upper += pyramid_.levelWidth(lod_) / 2;
+   keyRange.lower -= pyramid_.levelWidth(lod_) / 2;
+   const auto valueRange = pyramid_.valueRange(lod_, keyRange.lower, keyRange.upper);
+   if (valueRange.found) {
+      QCPRange newRange(valueRange.low, valueRange.high);
       const double margin = 0.15;
       if (!QCPRange::validRange(newRange)) // likely due to range being zero
       {
@@ -853,20 +1107,19 @@ void ChartWidget::rescaleCandlesYAxis()
 
 void ChartWidget::rescaleVolumesYAxis() const
 {
-   if (!volumeChart_->data()->size()) {
+   if (pyramid_.empty()) {
       return;
    }
    auto lower_bound = volumeAxisRect_->axis(QCPAxis::atBottom)->range().lower;
    auto upper_bound = volumeAxisRect_->axis(QCPAxis::atBottom)->range().upper;
-   double maxVolume = volumeChart_->data()->constBegin()->value;
-   for (const auto& it : *volumeChart_->data()) {
-      if (it.key >= lower_bound && it.key <= upper_bound) {
-         maxVolume = qMax(maxVolume, it.value);
-      }
+   double maxVolume = pyramid_.level(lod_).front().volume;
+   const auto valueRange = pyramid_.valueRange(lod_, lower_bound, upper_bound);
+   if (valueRange.found) {
+      maxVolume = qMax(maxVolume, valueRange.maxVolume);
    }
    if (!qFuzzyCompare(maxVolume, volumeAxisRect_->axis(QCPAxis::atBottom)->range().upper)) {
       volumeAxisRect_->axis(QCPAxis::atRight)->setRange(0, maxVolume);
-      ui_->customPlot->replot();
+      replotScheduler_->request();
    }
 }
 
@@ -932,7 +1185,7 @@ void ChartWidget::OnWheelScroll(QWheelEvent* event)
       return;
    }
    bottomAxis->setRange(lower_bound, upper_bound);
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 }
 
 void ChartWidget::OnAutoScaleBtnClick()
@@ -946,8 +1199,8 @@ void ChartWidget::OnAutoScaleBtnClick()
 
 void ChartWidget::OnResetBtnClick()
 {
-   if (candlesticksChart_->data()->size()) {
-      auto new_upper = candlesticksChart_->data()->at(candlesticksChart_->data()->size() - 1)->key + IntervalWidth(
+   if (!pyramid_.empty()) {
+      auto new_upper = pyramid_.last().key + IntervalWidth(
          dateRange_.checkedId()) / 1000 / 2;
       QCPRange defaultRange(new_upper - IntervalWidth(dateRange_.checkedId(), requestLimit) / 1000, new_upper);
       volumeAxisRect_->axis(QCPAxis::atBottom)->setRange(defaultRange);
@@ -965,6 +1218,10 @@ void ChartWidget::resizeEvent(QResizeEvent* event)
 {
    QWidget::resizeEvent(event);
    QMetaObject::invokeMethod(this, &ChartWidget::UpdatePrintFlag, Qt::QueuedConnection);//UpdatePrintFlag should be called after chart have resized, so we put this method to event loop's queue 
+   QMetaObject::invokeMethod(this, [this] {
+      UpdateLevelOfDetail();
+      rescalePlot();
+   }, Qt::QueuedConnection);
 }
 
 quint64 ChartWidget::GetCandleTimestamp(const uint64_t& timestamp, const Interval& interval) const
@@ -1058,6 +1315,7 @@ void ChartWidget::OnVolumeAxisRangeChanged(QCPRange newRange, QCPRange oldRange)
    if (!std::isinf(ui_->customPlot->xAxis->range().size() / (IntervalWidth(dateRange_.checkedId()) / 1000))) {
       appSettings_->set(ApplicationSettings::ChartCandleCount, int(ui_->customPlot->xAxis->range().size() / (IntervalWidth(dateRange_.checkedId()) / 1000)));
    }
+   UpdateLevelOfDetail();
    LoadAdditionalPoints(newRange);
    pickTicketDateFormat(newRange);
    rescalePlot();
@@ -1259,8 +1517,10 @@ void ChartWidget::OnMDDisconnecting()
    if (volumeChart_ != nullptr)
       volumeChart_->data()->clear();
 
+   pyramid_.clear();
+
    ui_->ohlcLbl->setText({});
-   ui_->customPlot->replot();
+   replotScheduler_->request();
 
    mdProvider_->UnsubscribeFromMD();
    mdProvider_->DisconnectFromMDSource();
@@ -1284,26 +1544,28 @@ void ChartWidget::ChangeMDSubscriptionState()
 
 void ChartWidget::OnNewTrade(const std::string& productName, uint64_t timestamp, double price, double amount)
 {
-   if (productName != getCurrentProductName().toStdString() ||
-      !candlesticksChart_->data()->size() ||
-      !volumeChart_->data()->size()) {
+   if (productName != getCurrentProductName().toStdString() || pyramid_.empty()) {
       return;
    }
 
-   auto lastVolume = volumeChart_->data()->end() - 1;
-   lastVolume->value += amount;
-   auto lastCandle = candlesticksChart_->data()->end() - 1;
-   lastCandle->high = qMax(lastCandle->high, price);
-   lastCandle->low = qMin(lastCandle->low, price);
-   if (!qFuzzyCompare(lastCandle->close, price) || !qFuzzyIsNull(amount)) {
+   auto lastCandle = pyramid_.last();
+   lastCandle.volume += amount;
+   lastCandle.high = qMax(lastCandle.high, price);
+   lastCandle.low = qMin(lastCandle.low, price);
+   const bool changed = !qFuzzyCompare(lastCandle.close, price) || !qFuzzyIsNull(amount);
+   if (changed) {
+      lastCandle.close = price;
+   }
+   pyramid_.update(lastCandle);
+   RefreshCandle(lastCandle.key);
+   if (changed) {
       isHigh_ = price > lastClose_;
       lastClose_ = price;
       UpdatePrintFlag();
-      lastCandle->close = price;
-      UpdateOHLCInfo(IntervalWidth(dateRange_.checkedId()) / 1000,
+      UpdateOHLCInfo(pyramid_.levelWidth(lod_),
                      ui_->customPlot->xAxis->pixelToCoord(ui_->customPlot->mapFromGlobal(QCursor::pos()).x()));
       rescalePlot();
-      ui_->customPlot->replot();
+      replotScheduler_->request();
    }
    CheckToAddNewCandle(timestamp);
 }
@@ -13,8 +13,10 @@
 
 #include <QWidget>
 #include <QButtonGroup>
+#include "CandlePyramid.h"
 #include "CommonTypes.h"
 #include "CustomControls/qcustomplot.h"
+#include "OhlcCandleCache.h"
 #include "market_data_history.pb.h"
 
 QT_BEGIN_NAMESPACE
@@ -32,6 +34,7 @@ class MDCallbacksQt;
 class ConnectionManager;
 namespace spdlog { class logger; }
 class MdhsClient;
+class ReplotScheduler;
 
 #include <QItemDelegate>
 #include <QPainter>
@@ -46,6 +49,33 @@ protected:
    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
 };
 
+// Collects candles and puts them to the charts at once instead of
+// inserting one by one into sorted containers
+class CandleBatch
+{
+public:
+   void reserve(int size);
+   void add(qreal open, qreal high, qreal low, qreal close, qreal timestamp, qreal volume);
+   // Adds collected candles to the pyramid and clears the batch
+   void commit(CandlePyramid &);
+
+   bool empty() const { return candles_.isEmpty(); }
+   int size() const { return candles_.size(); }
+
+private:
+   QVector<QCPFinancialData>  candles_;
+   QVector<QCPBarsData>       volumes_;
+};
+
+// Shows one level of the pyramid on the candle and volume charts
+namespace CandleCharts {
+   // Replaces shown candles with the level and sets candle width for it
+   void setLevel(const CandlePyramid &, std::size_t level, QCPFinancial *candles, QCPBars *volumes);
+   // Updates shown candle of the level covering key after change in pyramid
+   void refreshCandle(const CandlePyramid &, std::size_t level, double key
+      , QCPFinancial *candles, QCPBars *volumes);
+}
+
 class ChartWidget : public QWidget
 {
     Q_OBJECT
@@ -102,13 +132,22 @@ protected slots:
 protected:
    quint64 GetCandleTimestamp(const uint64_t& timestamp,
       const Blocksettle::Communication::MarketDataHistory::Interval& interval) const;
-   void AddDataPoint(const qreal& open, const qreal& high, const qreal& low, const qreal& close, const qreal& timestamp, const qreal& volume) const;
+   void AddDataPoint(const qreal& open, const qreal& high, const qreal& low, const qreal& close, const qreal& timestamp, const qreal& volume);
+   // Puts candles of current level of detail to the charts
+   void RefreshCandles();
+   // Updates shown candle covering key after change in pyramid
+   void RefreshCandle(double key);
+   void UpdateLevelOfDetail();
    void UpdateChart(const int& interval);
    void InitializeCustomPlot();
    quint64 IntervalWidth(int interval = -1, int count = 1, const QDateTime& specialDate = {}) const;
    static int FractionSizeForProduct(Blocksettle::Communication::TradeHistory::TradeHistoryTradeType type);
    void ProcessProductsListResponse(const std::string& data);
    void ProcessOhlcHistoryResponse(const std::string& data);
+   void ProcessOhlcHistory(const Blocksettle::Communication::MarketDataHistory::OhlcResponse& response);
+   void StoreInCache(const Blocksettle::Communication::MarketDataHistory::OhlcResponse& response, bool head);
+   Blocksettle::Communication::MarketDataHistory::OhlcResponse CachedResponse(const QString& product, int interval
+      , const std::vector<OhlcCandleCache::Candle>& candles, qint64 firstInDb) const;
    void ProcessEodResponse(const std::string& data);
    double CountOffsetFromRightBorder();
 
@@ -122,7 +161,7 @@ protected:
 
    void UpdatePlot(const int& interval, const qint64& timestamp);
 
-   bool needLoadNewData(const QCPRange& range, QSharedPointer<QCPFinancialDataContainer> data) const;
+   bool needLoadNewData(const QCPRange& range) const;
 
    void LoadAdditionalPoints(const QCPRange& range);
 
@@ -136,6 +175,7 @@ private:
    std::shared_ptr<ApplicationSettings>			appSettings_;
    std::shared_ptr<MarketDataProvider>				mdProvider_;
    std::shared_ptr<MdhsClient>						mdhsClient_;
+   std::unique_ptr<OhlcCandleCache>				candleCache_;
    std::shared_ptr<spdlog::logger>					logger_;
 
    bool                                         isProductListInitialized_{ false };
@@ -150,10 +190,14 @@ private:
 
    constexpr static int requestLimit{ 200 };
    constexpr static int candleViewLimit{ 150 };
-   constexpr static qint64 candleCountOnScreenLimit{ 1500 };
+   constexpr static qint64 candleCountOnScreenLimit{ 24000 };
 
    Blocksettle::Communication::MarketDataHistory::OhlcCandle lastCandle_;
 
+   // all loaded candles, charts show one level of it
+   CandlePyramid pyramid_;
+   std::size_t lod_{ 0 };
+
    double prevRequestStamp{ 0.0 };
 
    double zoomDiff_{ 0.0 };
@@ -164,6 +208,7 @@ private:
    QCPFinancial *candlesticksChart_;
    QCPBars *volumeChart_;
    QCPAxisRect *volumeAxisRect_;
+   ReplotScheduler *replotScheduler_;
 
    QCPItemText *   lastPrintFlag_{ nullptr };
    bool isHigh_ { true };
@@ -196,6 +241,13 @@ private:
    qreal startDragCoordX_{ 0.0 };
 
    quint64 firstTimestampInDb_{ 0 };
+
+   // count of candles in the outstanding request for the newest candles
+   int headRequestCount_{ 0 };
+   // lesser_then of the outstanding request for older candles
+   qint64 pageRequestStamp_{ -1 };
+   // chart shows cached candles until the head request is answered
+   bool showingCached_{ false };
    bool authorized_{ false };
 
    std::set<std::string>   pmProducts_;
@@ -0,0 +1,186 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "ChatMessageHeights.h"
+
+#include <algorithm>
+
+namespace {
+
+   size_t lowBit(size_t i)
+   {
+      return i & (~i + 1);
+   }
+
+} // namespace
+
+
+void ChatMessageHeights::setWidth(int width)
+{
+   if (width == width_) {
+      return;
+   }
+   width_ = width;
+   std::fill(measured_.begin() + static_cast<std::ptrdiff_t>(base_), measured_.end(), 0);
+   staleCount_ = size();
+   scanPos_ = size();
+}
+
+void ChatMessageHeights::append(int estimate)
+{
+   const auto total = totalHeight();
+   heights_.push_back(estimate);
+   measured_.push_back(0);
+   ++staleCount_;
+
+   // node i covers (i - lowBit(i), i]
+   const auto i = heights_.size();
+   tree_.push_back(total + estimate - prefix(i - lowBit(i)));
+   scanPos_ = size();
+}
+
+void ChatMessageHeights::erase(size_t index)
+{
+   const auto slot = base_ + index;
+   if (!measured_[slot]) {
+      --staleCount_;
+   }
+   if (index == 0) {
+      // the slot stays in the tree with zero height till compaction
+      add(slot, -heights_[slot]);
+      heights_[slot] = 0;
+      measured_[slot] = 1;
+      ++base_;
+      if (scanPos_ > 0) {
+         --scanPos_;
+      }
+      if (base_ * 2 >= heights_.size()) {
+         compact();
+      }
+      return;
+   }
+   heights_.erase(heights_.begin() + static_cast<std::ptrdiff_t>(slot));
+   measured_.erase(measured_.begin() + static_cast<std::ptrdiff_t>(slot));
+   scanPos_ = std::min(scanPos_, size());
+   compact();
+}
+
+void ChatMessageHeights::clear()
+{
+   heights_.clear();
+   measured_.clear();
+   tree_.clear();
+   base_ = 0;
+   staleCount_ = 0;
+   scanPos_ = 0;
+}
+
+void ChatMessageHeights::setHeight(size_t index, int height)
+{
+   const auto slot = base_ + index;
+   if (!measured_[slot]) {
+      measured_[slot] = 1;
+      --staleCount_;
+   }
+   add(slot, height - heights_[slot]);
+   heights_[slot] = height;
+}
+
+void ChatMessageHeights::invalidate(size_t index)
+{
+   const auto slot = base_ + index;
+   if (measured_[slot]) {
+      measured_[slot] = 0;
+      ++staleCount_;
+   }
+}
+
+int ChatMessageHeights::offset(size_t index) const
+{
+   // dropped slots don't add anything
+   return prefix(base_ + index);
+}
+
+int ChatMessageHeights::prefix(size_t count) const
+{
+   int result = 0;
+   for (auto i = count; i > 0; i -= lowBit(i)) {
+      result += tree_[i - 1];
+   }
+   return result;
+}
+
+size_t ChatMessageHeights::indexAt(int y) const
+{
+   if (y < 0) {
+      return 0;
+   }
+   // descend the tree to the last prefix not greater than y
+   size_t pos = 0;
+   size_t step = 1;
+   while ((step << 1) <= tree_.size()) {
+      step <<= 1;
+   }
+   for (; step > 0; step >>= 1) {
+      const auto next = pos + step;
+      if ((next <= tree_.size()) && (tree_[next - 1] <= y)) {
+         pos = next;
+         y -= tree_[next - 1];
+      }
+   }
+   return std::max(pos, base_) - base_;
+}
+
+std::vector<size_t> ChatMessageHeights::takeStale(size_t maxCount)
+{
+   std::vector<size_t> result;
+   while ((result.size() < maxCount) && (staleCount_ > result.size())) {
+      if (scanPos_ == 0) {
+         // some were invalidated behind the scan position
+         scanPos_ = size();
+      }
+      --scanPos_;
+      if (!measured_[base_ + scanPos_]) {
+         result.push_back(scanPos_);
+      }
+   }
+   return result;
+}
+
+void ChatMessageHeights::add(size_t slot, int delta)
+{
+   if (delta == 0) {
+      return;
+   }
+   for (auto i = slot + 1; i <= tree_.size(); i += lowBit(i)) {
+      tree_[i - 1] += delta;
+   }
+}
+
+void ChatMessageHeights::compact()
+{
+   if (base_ > 0) {
+      heights_.erase(heights_.begin(), heights_.begin() + static_cast<std::ptrdiff_t>(base_));
+      measured_.erase(measured_.begin(), measured_.begin() + static_cast<std::ptrdiff_t>(base_));
+      base_ = 0;
+   }
+   rebuild();
+}
+
+void ChatMessageHeights::rebuild()
+{
+   tree_.assign(heights_.begin(), heights_.end());
+   for (size_t i = 1; i <= tree_.size(); ++i) {
+      const auto parent = i + lowBit(i);
+      if (parent <= tree_.size()) {
+         tree_[parent - 1] += tree_[i - 1];
+      }
+   }
+}
@@ -0,0 +1,75 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef CHAT_MESSAGE_HEIGHTS_H
+#define CHAT_MESSAGE_HEIGHTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Heights of chat messages laid out for some width and their offsets from
+// the top, kept in a Fenwick tree: offset lookup, message at position and
+// height update are O(log n). Heights which are not measured for the current
+// width yet are estimates, they are measured when shown or in background.
+// Like the message ring buffer, the tree drops the first message by moving
+// its base, so a full history window still takes new messages in O(log n).
+class ChatMessageHeights
+{
+public:
+   // Keeps current heights as estimates for the new width
+   void setWidth(int width);
+   int width() const { return width_; }
+
+   void append(int estimate);
+   // O(log n) amortized for the first message, O(n) for others
+   void erase(size_t index);
+   void clear();
+
+   void setHeight(size_t index, int height);
+   // Content of the message has changed, current height is an estimate now
+   void invalidate(size_t index);
+   bool isMeasured(size_t index) const { return measured_[base_ + index] != 0; }
+   int height(size_t index) const { return heights_[base_ + index]; }
+
+   // Sum of heights of all messages before the given one
+   int offset(size_t index) const;
+   // Message containing the given position, size() if it's below the last one
+   size_t indexAt(int y) const;
+   int totalHeight() const { return prefix(heights_.size()); }
+   size_t size() const { return heights_.size() - base_; }
+   bool empty() const { return size() == 0; }
+
+   // Up to maxCount messages not measured for the current width, going from
+   // the last message to the first one over subsequent calls
+   std::vector<size_t> takeStale(size_t maxCount);
+   size_t staleCount() const { return staleCount_; }
+
+private:
+   // Sum of the first count slots, dropped ones are zero
+   int prefix(size_t count) const;
+   void add(size_t slot, int delta);
+   // Removes dropped slots and rebuilds the tree
+   void compact();
+   void rebuild();
+
+   int width_ = 0;
+   // slots of messages, the first base_ ones are dropped already
+   std::vector<int>     heights_;
+   std::vector<uint8_t> measured_;
+   size_t base_ = 0;
+   // 1-based Fenwick tree of heights
+   std::vector<int>     tree_;
+   size_t staleCount_ = 0;
+   // takeStale() goes on from here downwards, index of message
+   size_t scanPos_ = 0;
+};
+
+#endif // CHAT_MESSAGE_HEIGHTS_H
@@ -0,0 +1,267 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef CHAT_MESSAGE_STORE_H
+#define CHAT_MESSAGE_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Chat history of each party in order of arrival, with lookup by message id.
+// Every party keeps up to window last messages in a ring buffer, older ones
+// are dropped as new messages arrive. Messages of all parties are indexed
+// by id in one table, so that lookup and state update are a single hash
+// lookup.
+// MessagePtr is a pointer to a message with messageId(), partyId(),
+// timestamp() and setPartyMessageState() (Chat::MessagePtr, or a test double).
+template <typename MessagePtr>
+class ChatMessageStore
+{
+public:
+   static constexpr size_t kDefaultWindow = 10000;
+
+   class History
+   {
+   public:
+      size_t size() const { return slots_.size(); }
+      bool empty() const { return slots_.empty(); }
+      // Row 0 is the oldest message kept
+      const MessagePtr &at(size_t row) const { return slots_[(head_ + row) % slots_.size()]; }
+
+   private:
+      friend class ChatMessageStore;
+
+      MessagePtr &slot(uint64_t seq) { return slots_[(head_ + (seq - firstSeq_)) % slots_.size()]; }
+
+      // rotates the ring so that the oldest message is in the first slot
+      void linearize()
+      {
+         std::rotate(slots_.begin(), slots_.begin() + static_cast<std::ptrdiff_t>(head_), slots_.end());
+         head_ = 0;
+      }
+
+      std::vector<MessagePtr> slots_;
+      // slot of the oldest message once the ring is full
+      size_t   head_ = 0;
+      // arrival sequence number of the oldest message
+      uint64_t firstSeq_ = 0;
+   };
+
+   struct InsertResult
+   {
+      size_t     row;
+      // message with the same id was replaced in place
+      bool       replaced;
+      // the oldest message dropped to make room, or null
+      MessagePtr dropped;
+   };
+
+   explicit ChatMessageStore(size_t window = kDefaultWindow)
+      : window_(std::max<size_t>(window, 1))
+   {}
+
+   size_t window() const { return window_; }
+
+   // Drops oldest messages of the parties which have more than window
+   void setWindow(size_t window)
+   {
+      window_ = std::max<size_t>(window, 1);
+      for (auto &party : parties_) {
+         auto &history = party.second;
+         history.linearize();
+         if (history.size() > window_) {
+            const auto count = history.size() - window_;
+            for (size_t i = 0; i < count; ++i) {
+               unindex(history, history.firstSeq_ + i, history.slots_[i]);
+            }
+            history.slots_.erase(history.slots_.begin(), history.slots_.begin() + static_cast<std::ptrdiff_t>(count));
+            history.firstSeq_ += count;
+         }
+      }
+   }
+
+   InsertResult insert(const MessagePtr &message)
+   {
+      auto &history = parties_[message->partyId()];
+      const auto it = index_.find(message->messageId());
+      if (it != index_.end() && it->second.history == &history) {
+         history.slot(it->second.seq) = message;
+         return { static_cast<size_t>(it->second.seq - history.firstSeq_), true, nullptr };
+      }
+
+      const auto seq = history.firstSeq_ + history.size();
+      MessagePtr dropped = nullptr;
+      if (history.size() < window_) {
+         if (history.head_ != 0) {
+            history.linearize();
+         }
+         history.slots_.push_back(message);
+      }
+      else {
+         auto &oldest = history.slots_[history.head_];
+         unindex(history, history.firstSeq_, oldest);
+         dropped = std::move(oldest);
+         oldest = message;
+         history.head_ = (history.head_ + 1) % history.slots_.size();
+         ++history.firstSeq_;
+      }
+      // the same id in another party is shadowed by the latest message
+      index_[message->messageId()] = { &history, seq };
+      return { history.size() - 1, false, std::move(dropped) };
+   }
+
+   // Messages sorted by time can be inserted one by one if they are all new
+   // and not older than the last kept message of the party
+   bool isAppendable(const std::string &partyId, const std::vector<MessagePtr> &sorted) const
+   {
+      const auto history = this->history(partyId);
+      if (!history || history->empty() || sorted.empty()) {
+         return true;
+      }
+      if (sorted.front()->timestamp() < history->at(history->size() - 1)->timestamp()) {
+         return false;
+      }
+      for (const auto &message : sorted) {
+         if (find(partyId, message->messageId())) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // Puts messages of the party (kept and given ones) in order of time again,
+   // given messages replace kept ones with the same id. For history reloads
+   // which come after newer messages, O(n log n).
+   void merge(const std::string &partyId, const std::vector<MessagePtr> &messages)
+   {
+      std::unordered_set<std::string> ids;
+      for (const auto &message : messages) {
+         ids.insert(message->messageId());
+      }
+      std::vector<MessagePtr> merged;
+      const auto history = this->history(partyId);
+      if (history) {
+         for (size_t row = 0; row < history->size(); ++row) {
+            if (ids.find(history->at(row)->messageId()) == ids.end()) {
+               merged.push_back(history->at(row));
+            }
+         }
+      }
+      merged.insert(merged.end(), messages.begin(), messages.end());
+      std::stable_sort(merged.begin(), merged.end(), [](const MessagePtr &left, const MessagePtr &right) {
+         return left->timestamp() < right->timestamp();
+      });
+
+      clear(partyId);
+      const auto first = (merged.size() > window_) ? merged.size() - window_ : 0;
+      for (auto it = merged.begin() + static_cast<std::ptrdiff_t>(first); it != merged.end(); ++it) {
+         insert(*it);
+      }
+   }
+
+   // Returns -1 if there's no such message (or it was dropped already)
+   int row(const std::string &partyId, const std::string &messageId) const
+   {
+      const auto it = index_.find(messageId);
+      if (it == index_.end()) {
+         return -1;
+      }
+      const auto &location = it->second;
+      const auto row = static_cast<size_t>(location.seq - location.history->firstSeq_);
+      if (location.history->at(row)->partyId() != partyId) {
+         return -1;
+      }
+      return static_cast<int>(row);
+   }
+
+   MessagePtr find(const std::string &partyId, const std::string &messageId) const
+   {
+      const auto it = index_.find(messageId);
+      if (it == index_.end()) {
+         return nullptr;
+      }
+      const auto &location = it->second;
+      const auto &message = location.history->at(static_cast<size_t>(location.seq - location.history->firstSeq_));
+      return (message->partyId() == partyId) ? message : nullptr;
+   }
+
+   // Returns the updated message, or null if it's not in the store
+   template <typename State>
+   MessagePtr setState(const std::string &partyId, const std::string &messageId, State state)
+   {
+      auto message = find(partyId, messageId);
+      if (message) {
+         message->setPartyMessageState(state);
+      }
+      return message;
+   }
+
+   // Returns null if there were no messages of the party
+   const History *history(const std::string &partyId) const
+   {
+      const auto it = parties_.find(partyId);
+      return (it == parties_.end()) ? nullptr : &it->second;
+   }
+
+   size_t size(const std::string &partyId) const
+   {
+      const auto history = this->history(partyId);
+      return history ? history->size() : 0;
+   }
+
+   void clear()
+   {
+      index_.clear();
+      parties_.clear();
+   }
+
+   void clear(const std::string &partyId)
+   {
+      const auto it = parties_.find(partyId);
+      if (it == parties_.end()) {
+         return;
+      }
+      const auto &history = it->second;
+      for (size_t row = 0; row < history.size(); ++row) {
+         unindex(history, history.firstSeq_ + row, history.at(row));
+      }
+      parties_.erase(it);
+   }
+
+private:
+   struct Location
+   {
+      // node-based map keeps histories in place
+      History  *history;
+      uint64_t seq;
+   };
+
+   void unindex(const History &history, uint64_t seq, const MessagePtr &message)
+   {
+      const auto it = index_.find(message->messageId());
+      if (it != index_.end() && it->second.history == &history && it->second.seq == seq) {
+         index_.erase(it);
+      }
+   }
+
+   size_t window_;
+   std::unordered_map<std::string, History> parties_;
+   std::unordered_map<std::string, Location> index_;
+};
+
+template <typename MessagePtr>
+constexpr size_t ChatMessageStore<MessagePtr>::kDefaultWindow;
+
+#endif // CHAT_MESSAGE_STORE_H
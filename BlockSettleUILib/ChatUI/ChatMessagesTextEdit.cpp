@@ -14,11 +14,16 @@
 #include "RequestPartyBox.h"
 #include "chat.pb.h"
 
+#include <QAbstractTextDocumentLayout>
 #include <QApplication>
 #include <QClipboard>
 #include <QDesktopServices>
-#include <QMimeData>
+#include <QMouseEvent>
+#include <QPainter>
 #include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocumentFragment>
+#include <QtMath>
 
 #include <iterator>
 
@@ -32,22 +37,29 @@ namespace {
    const QString contextMenuAddUserMenuStatusTip = QObject::tr("Click to add user to contact list");
    const QString contextMenuRemoveUserMenu = QObject::tr("Remove from contacts");
    const QString contextMenuRemoveUserMenuStatusTip = QObject::tr("Click to remove user from contact list");
+
+   const QString userLinkScheme = QLatin1String("user:");
+
+   // messages laid out in background per event loop iteration
+   const size_t kRelayoutChunk = 50;
+   // layouts of visible messages are never dropped
+   const size_t kMaxCachedLayouts = 500;
 }
 
 ChatMessagesTextEdit::ChatMessagesTextEdit(QWidget* parent)
-   : QTextBrowser(parent)
+   : QAbstractScrollArea(parent)
    , internalStyle_(this)
 {
-   tableFormat_.setBorder(0);
-   tableFormat_.setCellPadding(0);
-   tableFormat_.setCellSpacing(0);
-
    setupHighlightPalette();
+   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+   viewport()->setMouseTracking(true);
 
-   connect(this, &QTextBrowser::anchorClicked, this, &ChatMessagesTextEdit::onUrlActivated);
-   connect(this, &QTextBrowser::textChanged, this, &ChatMessagesTextEdit::onTextChanged);
+   relayoutTimer_.setInterval(0);
+   connect(&relayoutTimer_, &QTimer::timeout, this, &ChatMessagesTextEdit::onRelayoutTimer);
 }
 
+ChatMessagesTextEdit::~ChatMessagesTextEdit() noexcept = default;
+
 void ChatMessagesTextEdit::setupHighlightPalette()
 {
    auto highlightPalette = palette();
@@ -58,102 +70,51 @@ void ChatMessagesTextEdit::setupHighlightPalette()
 
 int ChatMessagesTextEdit::messagesCount(const std::string& partyId) const
 {
-   return messages_[partyId].count();
+   return static_cast<int>(messages_.size(partyId));
 }
 
-Chat::MessagePtr ChatMessagesTextEdit::getMessage(const std::string& partyId, const std::string& messageId) const
+int ChatMessagesTextEdit::historyWindow() const
 {
-   const auto it = std::find_if(messages_[partyId].begin(), messages_[partyId].end(), [messageId](const Chat::MessagePtr& msg)->bool {
-      return msg->messageId() == messageId;
-   });
-
-   if (it != messages_[partyId].end()) {
-      return *it;
-   }
-
-   return nullptr;
+   return static_cast<int>(messages_.window());
 }
 
-QString ChatMessagesTextEdit::data(const std::string& partyId, const std::string& messageId, const Column &column)
+bool ChatMessagesTextEdit::hasSelection() const
 {
-   if (messages_[partyId].empty()) {
-       return QString();
-   }
-
-   return dataMessage(partyId, messageId, column);
+   return (selectionAnchor_ >= 0)
+      || ((textSelectionRow_ >= 0) && (textSelectionAnchor_ != textSelectionPosition_));
 }
 
-QString ChatMessagesTextEdit::dataMessage(const std::string& partyId, const std::string& messageId, const ChatMessagesTextEdit::Column &column) const
+void ChatMessagesTextEdit::clearSelection()
 {
-   const auto message = getMessage(partyId, messageId);
-
-   if (!message) {
-      return QString();
-   }
-
-   Chat::ClientPartyPtr previousClientPartyPtr = nullptr;
-
-   switch (column) {
-      case Column::Time:
-      {
-         const auto dateTime = message->timestamp().toLocalTime();
-         return toHtmlText(dateTime.toString(QString::fromUtf8("MM/dd/yy hh:mm:ss")));
-      }
-
-      case Column::User:
-      {
-         const auto& senderHash = message->senderHash();
-
-         if (senderHash == ownUserId_) {
-            return ownSenderUserName;
-         }
-
-         if (!previousClientPartyPtr || previousClientPartyPtr->id() != partyId) {
-            previousClientPartyPtr = partyModel_->getClientPartyById(message->partyId());
-         }
-
-         if (!previousClientPartyPtr->isGlobal()) {
-            return elideUserName(previousClientPartyPtr->displayName());
-         }
-         
-         const auto clientPartyPtr = partyModel_->getClientPartyById(partyId);
-
-         if (clientPartyPtr && clientPartyPtr->isPrivate()) {
-            return toHtmlUsername(clientPartyPtr->displayName(), clientPartyPtr->userHash());
-         }
-         return toHtmlUsername(senderHash, senderHash);
-      }
-      case Column::Status:{
-         return QString();
-      }
-      case Column::Message: {
-         //QString text = QLatin1String("[%1] %2");
-         //text = text.arg(QString::fromStdString(message->messageText()));
-
-         //if (ChatUtils::messageFlagRead(message, Chat::Data_Message_State_INVALID)) {
-         //   return toHtmlInvalid(text.arg(QLatin1String("INVALID MESSAGE!")));
-         //} else if (message.encryption() == Chat::Data_Message_Encryption_IES) {
-         //   return toHtmlInvalid(text.arg(QLatin1String("IES ENCRYPTED!")));
-         //} else if ( message.encryption() == Chat::Data_Message_Encryption_AEAD) {
-         //   return toHtmlInvalid(text.arg(QLatin1String("AEAD ENCRYPTED!")));
-         //}
-         return toHtmlText(QString::fromStdString(message->messageText()));
-      }
-      default:
-         break;
+   if (!hasSelection()) {
+      return;
    }
-
-   return QString();
+   selectionAnchor_ = -1;
+   selectionCurrent_ = -1;
+   textSelectionRow_ = -1;
+   viewport()->update();
 }
 
-QImage ChatMessagesTextEdit::statusImage(const std::string& partyId, const std::string& messageId) const
+void ChatMessagesTextEdit::selectRows(int anchor, int current)
 {
-   const auto message = getMessage(partyId, messageId);
+   selectionAnchor_ = anchor;
+   selectionCurrent_ = current;
+   textSelectionRow_ = -1;
+   viewport()->update();
+}
 
-   if (!message) {
-      return statusImageGreyUnsent_;
-   }
+void ChatMessagesTextEdit::selectText(int row, int anchor, int position)
+{
+   selectionAnchor_ = -1;
+   selectionCurrent_ = -1;
+   textSelectionRow_ = row;
+   textSelectionAnchor_ = anchor;
+   textSelectionPosition_ = position;
+   viewport()->update();
+}
 
+QImage ChatMessagesTextEdit::statusImage(const Chat::MessagePtr& message) const
+{
    if (message->senderHash() != ownUserId_) {
       return QImage();
    }
@@ -161,7 +122,7 @@ QImage ChatMessagesTextEdit::statusImage(const std::string& partyId, const std::
    auto statusImage = statusImageGreyUnsent_;
 
    const auto clientPartyPtr = partyModel_->getClientPartyById(message->partyId());
-   
+
    if (!clientPartyPtr) {
       return QImage();
    }
@@ -186,68 +147,495 @@ QImage ChatMessagesTextEdit::statusImage(const std::string& partyId, const std::
    return statusImage;
 }
 
-void ChatMessagesTextEdit::contextMenuEvent(QContextMenuEvent *e)
+void ChatMessagesTextEdit::userData(const Chat::MessagePtr& message, QString &user, QString &userLink) const
 {
-   textCursor_ = cursorForPosition(e->pos());
+   const auto& senderHash = message->senderHash();
 
-   // keep selection
-   if (textCursor().hasSelection()) {
-      textCursor_.setPosition(textCursor().selectionStart(), QTextCursor::MoveAnchor);
-      textCursor_.setPosition(textCursor().selectionEnd(), QTextCursor::KeepAnchor);
+   if (senderHash == ownUserId_) {
+      user = ownSenderUserName;
+      return;
    }
 
-   setTextCursor(textCursor_);
-   QString text = textCursor_.block().text();
+   const auto clientPartyPtr = partyModel_->getClientPartyById(message->partyId());
+   if (clientPartyPtr && !clientPartyPtr->isGlobal()) {
+      user = elideUserName(clientPartyPtr->displayName());
+      return;
+   }
 
-   //show contact context menu when username is right clicked in User column
-   if ((textCursor_.block().blockNumber() - 1) % 5 == static_cast<int>(Column::User)) {
-      if (text != ownSenderUserName) {
-         const QUrl link = anchorAt(e->pos());
-         if (!link.isEmpty()) {
-            text = link.path();
+   user = elideUserName(senderHash);
+   userLink = userLinkScheme + QString::fromStdString(senderHash);
+}
+
+std::unique_ptr<ChatMessagesTextEdit::MessageLayout> ChatMessagesTextEdit::createLayout(const Chat::MessagePtr& message) const
+{
+   auto result = std::make_unique<MessageLayout>();
+   result->time = message->timestamp().toLocalTime().toString(QString::fromUtf8("MM/dd/yy hh:mm:ss"));
+   result->status = statusImage(message);
+   userData(message, result->user, result->userLink);
+
+   result->text = std::make_unique<QTextDocument>();
+   result->text->setDefaultFont(font());
+   result->text->setDocumentMargin(0);
+   result->text->setHtml(toHtmlText(QString::fromStdString(message->messageText())));
+   result->text->setTextWidth(messageColumnWidth());
+   return result;
+}
+
+const Chat::MessagePtr &ChatMessagesTextEdit::messageAt(size_t row) const
+{
+   return messages_.history(currentPartyId_)->at(row);
+}
+
+ChatMessagesTextEdit::MessageLayout &ChatMessagesTextEdit::layout(size_t row)
+{
+   const auto &message = messageAt(row);
+   auto &result = layouts_[message->messageId()];
+   if (!result) {
+      result = createLayout(message);
+   }
+   return *result;
+}
+
+void ChatMessagesTextEdit::measure(size_t row)
+{
+   const auto &message = messageAt(row);
+   const auto width = messageColumnWidth();
+
+   // messages measured in background are not cached
+   std::unique_ptr<MessageLayout> temporary;
+   QTextDocument *text = nullptr;
+   const auto it = layouts_.find(message->messageId());
+   if (it != layouts_.end()) {
+      text = it->second->text.get();
+      if (!qFuzzyCompare(text->textWidth(), static_cast<qreal>(width))) {
+         text->setTextWidth(width);
+      }
+   }
+   else {
+      temporary = createLayout(message);
+      text = temporary->text.get();
+   }
+
+   heights(currentPartyId_).setHeight(row, std::max(lineHeight(), qCeil(text->size().height())));
+}
+
+ChatMessageHeights &ChatMessagesTextEdit::heights(const std::string& partyId)
+{
+   return heights_[partyId];
+}
+
+int ChatMessagesTextEdit::lineHeight() const
+{
+   return fontMetrics().height();
+}
+
+int ChatMessagesTextEdit::messageColumnX() const
+{
+   return timeColumnWidth_ + iconColumnWidth_ + userColumnWidth_;
+}
+
+int ChatMessagesTextEdit::messageColumnWidth() const
+{
+   return std::max(1, viewport()->width() - messageColumnX());
+}
+
+void ChatMessagesTextEdit::updateMessageWidth()
+{
+   auto &partyHeights = heights(currentPartyId_);
+   const auto width = messageColumnWidth();
+   if (partyHeights.width() == width) {
+      return;
+   }
+   // visible messages are measured on paint, the rest in background
+   partyHeights.setWidth(width);
+   startRelayout();
+   viewport()->update();
+}
+
+void ChatMessagesTextEdit::startRelayout()
+{
+   if (heights(currentPartyId_).staleCount() > 0 && !relayoutTimer_.isActive()) {
+      relayoutTimer_.start();
+   }
+}
+
+void ChatMessagesTextEdit::onRelayoutTimer()
+{
+   auto &partyHeights = heights(currentPartyId_);
+   const auto rows = partyHeights.takeStale(kRelayoutChunk);
+   if (rows.empty()) {
+      relayoutTimer_.stop();
+      return;
+   }
+
+   // keep the top visible message in place
+   auto *scrollBar = verticalScrollBar();
+   const bool atBottom = scrollBar->value() >= scrollBar->maximum();
+   const auto top = scrollBar->value();
+   const auto anchorRow = partyHeights.indexAt(top);
+   const auto delta = top - partyHeights.offset(anchorRow);
+
+   for (const auto row : rows) {
+      measure(row);
+   }
+
+   updateScrollBar();
+   if (!atBottom) {
+      scrollBar->setValue(partyHeights.offset(anchorRow) + delta);
+   }
+}
+
+void ChatMessagesTextEdit::measureVisible()
+{
+   auto &partyHeights = heights(currentPartyId_);
+   if (partyHeights.staleCount() == 0) {
+      return;
+   }
+
+   auto *scrollBar = verticalScrollBar();
+   const int viewHeight = viewport()->height();
+
+   if (scrollBar->value() >= scrollBar->maximum()) {
+      // stick to the bottom: lay out from the last message upwards
+      int filled = 0;
+      for (auto row = partyHeights.size(); row > 0 && filled < viewHeight; --row) {
+         if (!partyHeights.isMeasured(row - 1)) {
+            measure(row - 1);
          }
-         std::unique_ptr<QMenu> userMenuPtr = initUserContextMenu(text);
-         userMenuPtr->exec(QCursor::pos());
+         filled += partyHeights.height(row - 1);
+      }
+      updateScrollBar();
+      return;
+   }
+
+   const auto top = scrollBar->value();
+   const auto firstRow = partyHeights.indexAt(top);
+   const auto delta = top - partyHeights.offset(firstRow);
+   int filled = -delta;
+   for (auto row = firstRow; row < partyHeights.size() && filled < viewHeight; ++row) {
+      if (!partyHeights.isMeasured(row)) {
+         measure(row);
+      }
+      filled += partyHeights.height(row);
+   }
+   updateScrollBar();
+   scrollBar->setValue(partyHeights.offset(firstRow) + delta);
+}
+
+void ChatMessagesTextEdit::updateScrollBar()
+{
+   auto *scrollBar = verticalScrollBar();
+   const bool atBottom = scrollBar->value() >= scrollBar->maximum();
+   const int viewHeight = viewport()->height();
+
+   scrollBar->setSingleStep(lineHeight());
+   scrollBar->setPageStep(viewHeight);
+   scrollBar->setRange(0, std::max(0, heights(currentPartyId_).totalHeight() - viewHeight));
+   if (atBottom) {
+      scrollBar->setValue(scrollBar->maximum());
+   }
+}
+
+void ChatMessagesTextEdit::scrollToBottom()
+{
+   updateScrollBar();
+   verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+   viewport()->update();
+}
+
+void ChatMessagesTextEdit::evictLayouts(size_t firstRow, size_t endRow)
+{
+   if (layouts_.size() <= kMaxCachedLayouts) {
+      return;
+   }
+
+   std::unordered_map<std::string, std::unique_ptr<MessageLayout>> visible;
+   for (auto row = firstRow; row < endRow; ++row) {
+      const auto &id = messageAt(row)->messageId();
+      const auto it = layouts_.find(id);
+      if (it != layouts_.end()) {
+         visible.emplace(id, std::move(it->second));
+      }
+   }
+   layouts_.swap(visible);
+}
+
+void ChatMessagesTextEdit::paintEvent(QPaintEvent *)
+{
+   measureVisible();
+
+   auto &partyHeights = heights(currentPartyId_);
+   QPainter painter(viewport());
+
+   const int top = verticalScrollBar()->value();
+   const int viewWidth = viewport()->width();
+   const int viewHeight = viewport()->height();
+   const int rowLineHeight = lineHeight();
+   const int selectionFirst = std::min(selectionAnchor_, selectionCurrent_);
+   const int selectionLast = std::max(selectionAnchor_, selectionCurrent_);
+
+   const auto firstRow = partyHeights.indexAt(top);
+   auto row = firstRow;
+   for (int y = partyHeights.offset(firstRow) - top; row < partyHeights.size() && y < viewHeight; ++row) {
+      const int rowHeight = partyHeights.height(row);
+      auto &messageLayout = layout(row);
+
+      if (hasSelection() && static_cast<int>(row) >= selectionFirst && static_cast<int>(row) <= selectionLast) {
+         painter.fillRect(QRect(0, y, viewWidth, rowHeight), palette().brush(QPalette::Highlight));
+      }
+
+      painter.setPen(internalStyle_.colorWhite());
+      painter.drawText(QRect(0, y, timeColumnWidth_, rowLineHeight), Qt::AlignLeft | Qt::AlignVCenter, messageLayout.time);
+
+      if (!messageLayout.status.isNull()) {
+         painter.drawImage(QPoint(timeColumnWidth_, y + (rowLineHeight - messageLayout.status.height()) / 2), messageLayout.status);
+      }
+
+      painter.setPen(messageLayout.userLink.isEmpty() ? internalStyle_.colorWhite() : internalStyle_.colorHyperlink());
+      painter.drawText(QRect(timeColumnWidth_ + iconColumnWidth_, y, userColumnWidth_, rowLineHeight)
+         , Qt::AlignLeft | Qt::AlignVCenter, messageLayout.user);
+
+      QAbstractTextDocumentLayout::PaintContext context;
+      context.palette = palette();
+      context.palette.setColor(QPalette::Text, painter.pen().color());
+      context.clip = QRectF(0, 0, messageColumnWidth(), rowHeight);
+      if (static_cast<int>(row) == textSelectionRow_) {
+         const int last = messageLayout.text->characterCount() - 1;
+         QTextCursor cursor(messageLayout.text.get());
+         cursor.setPosition(std::min(textSelectionAnchor_, last));
+         cursor.setPosition(std::min(textSelectionPosition_, last), QTextCursor::KeepAnchor);
+
+         QAbstractTextDocumentLayout::Selection selection;
+         selection.cursor = cursor;
+         selection.format.setBackground(palette().brush(QPalette::Highlight));
+         selection.format.setForeground(palette().brush(QPalette::HighlightedText));
+         context.selections.append(selection);
+      }
+
+      painter.save();
+      painter.translate(messageColumnX(), y);
+      messageLayout.text->documentLayout()->draw(&painter, context);
+      painter.restore();
+
+      y += rowHeight;
+   }
+
+   evictLayouts(firstRow, row);
+}
+
+void ChatMessagesTextEdit::resizeEvent(QResizeEvent *e)
+{
+   QAbstractScrollArea::resizeEvent(e);
+   updateMessageWidth();
+   updateScrollBar();
+}
+
+void ChatMessagesTextEdit::scrollContentsBy(int, int)
+{
+   viewport()->update();
+}
+
+ChatMessagesTextEdit::HitTest ChatMessagesTextEdit::hitTest(const QPoint &pos)
+{
+   HitTest result;
+   const auto &partyHeights = heights(currentPartyId_);
+   const int y = pos.y() + verticalScrollBar()->value();
+   const auto row = partyHeights.indexAt(y);
+   if (row >= partyHeights.size()) {
+      return result;
+   }
+   result.row = static_cast<int>(row);
+
+   const int rowY = y - partyHeights.offset(row);
+   auto &messageLayout = layout(row);
+
+   if (pos.x() < timeColumnWidth_) {
+      result.column = Column::Time;
+   }
+   else if (pos.x() < timeColumnWidth_ + iconColumnWidth_) {
+      result.column = Column::Status;
+   }
+   else if (pos.x() < messageColumnX()) {
+      result.column = Column::User;
+      if (rowY < lineHeight()) {
+         result.anchor = messageLayout.userLink;
+      }
+   }
+   else {
+      result.column = Column::Message;
+      result.anchor = messageLayout.text->documentLayout()->anchorAt(QPointF(pos.x() - messageColumnX(), rowY));
+   }
+   return result;
+}
+
+int ChatMessagesTextEdit::textPosition(size_t row, const QPoint &pos)
+{
+   const auto *text = layout(row).text.get();
+   const QPointF point(pos.x() - messageColumnX()
+      , pos.y() + verticalScrollBar()->value() - heights(currentPartyId_).offset(row));
+   if (point.y() < 0) {
+      return 0;
+   }
+   if (point.y() >= text->size().height()) {
+      return text->characterCount() - 1;
+   }
+   return std::max(0, text->documentLayout()->hitTest(point, Qt::FuzzyHit));
+}
+
+void ChatMessagesTextEdit::mousePressEvent(QMouseEvent *e)
+{
+   if (e->button() != Qt::LeftButton) {
+      QAbstractScrollArea::mousePressEvent(e);
+      return;
+   }
+
+   const auto hit = hitTest(e->pos());
+   pressedRow_ = hit.row;
+   pressedPos_ = e->pos();
+   pressedAnchor_ = hit.anchor;
+   pressedTextPos_ = (hit.column == Column::Message) ? textPosition(static_cast<size_t>(hit.row), e->pos()) : -1;
+   selecting_ = false;
+   clearSelection();
+}
+
+void ChatMessagesTextEdit::mouseMoveEvent(QMouseEvent *e)
+{
+   if (!(e->buttons() & Qt::LeftButton) || pressedRow_ < 0) {
+      const auto hit = hitTest(e->pos());
+      if (!hit.anchor.isEmpty()) {
+         viewport()->setCursor(Qt::PointingHandCursor);
+      }
+      else {
+         viewport()->setCursor((hit.column == Column::Message) ? Qt::IBeamCursor : Qt::ArrowCursor);
+      }
+      return;
+   }
+
+   if (!selecting_) {
+      if ((e->pos() - pressedPos_).manhattanLength() < QApplication::startDragDistance()) {
          return;
       }
+      selecting_ = true;
    }
 
-   // show default text context menu
-   if (text.length() > 0 || textCursor_.hasSelection()) {
-      QMenu contextMenu(this);
+   auto *scrollBar = verticalScrollBar();
+   if (e->pos().y() < 0) {
+      scrollBar->setValue(scrollBar->value() - scrollBar->singleStep());
+   }
+   else if (e->pos().y() > viewport()->height()) {
+      scrollBar->setValue(scrollBar->value() + scrollBar->singleStep());
+   }
 
-      QAction copyAction(contextMenuCopy, this);
-      QAction copyLinkLocationAction(contextMenuCopyLink, this);
-      QAction selectAllAction(contextMenuSelectAll, this);
+   const auto &partyHeights = heights(currentPartyId_);
+   const auto row = std::min(partyHeights.indexAt(e->pos().y() + scrollBar->value()), partyHeights.size() - 1);
+   if ((pressedTextPos_ >= 0) && (static_cast<int>(row) == pressedRow_)) {
+      selectText(pressedRow_, pressedTextPos_, textPosition(row, e->pos()));
+   }
+   else {
+      selectRows(pressedRow_, static_cast<int>(row));
+   }
+}
 
-      connect(&copyAction, &QAction::triggered, this, &ChatMessagesTextEdit::onCopyActionTriggered);
-      connect(&copyLinkLocationAction, &QAction::triggered, this, &ChatMessagesTextEdit::onCopyLinkLocationActionTriggered);
-      connect(&selectAllAction, &QAction::triggered, this, &ChatMessagesTextEdit::onSelectAllActionTriggered);
+void ChatMessagesTextEdit::mouseReleaseEvent(QMouseEvent *e)
+{
+   if (e->button() != Qt::LeftButton) {
+      QAbstractScrollArea::mouseReleaseEvent(e);
+      return;
+   }
 
-      contextMenu.addAction(&copyAction);
+   if (!selecting_ && !pressedAnchor_.isEmpty() && hitTest(e->pos()).anchor == pressedAnchor_) {
+      onUrlActivated(QUrl(pressedAnchor_));
+   }
+   pressedRow_ = -1;
+   pressedAnchor_.clear();
+   pressedTextPos_ = -1;
+   selecting_ = false;
+}
+
+void ChatMessagesTextEdit::mouseDoubleClickEvent(QMouseEvent *e)
+{
+   if (e->button() != Qt::LeftButton) {
+      QAbstractScrollArea::mouseDoubleClickEvent(e);
+      return;
+   }
+
+   const auto hit = hitTest(e->pos());
+   if (hit.column != Column::Message) {
+      return;
+   }
+   auto &messageLayout = layout(static_cast<size_t>(hit.row));
+   QTextCursor cursor(messageLayout.text.get());
+   cursor.setPosition(textPosition(static_cast<size_t>(hit.row), e->pos()));
+   cursor.select(QTextCursor::WordUnderCursor);
+   if (cursor.hasSelection()) {
+      selectText(hit.row, cursor.anchor(), cursor.position());
+   }
+}
 
-      // show Copy Link Location only when it needed
-      anchor_ = this->anchorAt(e->pos());
-      if (!anchor_.isEmpty()) {
-         contextMenu.addAction(&copyLinkLocationAction);
+void ChatMessagesTextEdit::keyPressEvent(QKeyEvent *e)
+{
+   if (e->matches(QKeySequence::Copy)) {
+      if (hasSelection()) {
+         QApplication::clipboard()->setText(getFormattedTextFromSelection());
       }
+      return;
+   }
+   if (e->matches(QKeySequence::SelectAll)) {
+      onSelectAllActionTriggered();
+      return;
+   }
+   QAbstractScrollArea::keyPressEvent(e);
+}
+
+void ChatMessagesTextEdit::contextMenuEvent(QContextMenuEvent *e)
+{
+   const auto hit = hitTest(e->pos());
+   if (hit.row < 0) {
+      return;
+   }
+   contextMenuRow_ = hit.row;
+
+   //show contact context menu when username is right clicked in User column
+   const auto &messageLayout = layout(static_cast<size_t>(hit.row));
+   if (hit.column == Column::User && messageLayout.user != ownSenderUserName) {
+      const QString userName = hit.anchor.isEmpty() ? messageLayout.user : QUrl(hit.anchor).path();
+      std::unique_ptr<QMenu> userMenuPtr = initUserContextMenu(userName);
+      userMenuPtr->exec(QCursor::pos());
+      return;
+   }
+
+   // show default text context menu
+   QMenu contextMenu(this);
+
+   QAction copyAction(contextMenuCopy, this);
+   QAction copyLinkLocationAction(contextMenuCopyLink, this);
+   QAction selectAllAction(contextMenuSelectAll, this);
+
+   connect(&copyAction, &QAction::triggered, this, &ChatMessagesTextEdit::onCopyActionTriggered);
+   connect(&copyLinkLocationAction, &QAction::triggered, this, &ChatMessagesTextEdit::onCopyLinkLocationActionTriggered);
+   connect(&selectAllAction, &QAction::triggered, this, &ChatMessagesTextEdit::onSelectAllActionTriggered);
 
-      contextMenu.addSeparator();
-      contextMenu.addAction(&selectAllAction);
+   contextMenu.addAction(&copyAction);
 
-      contextMenu.exec(e->globalPos());
+   // show Copy Link Location only when it needed
+   anchor_ = hit.anchor;
+   if (!anchor_.isEmpty()) {
+      contextMenu.addAction(&copyLinkLocationAction);
    }
+
+   contextMenu.addSeparator();
+   contextMenu.addAction(&selectAllAction);
+
+   contextMenu.exec(e->globalPos());
 }
 
 void ChatMessagesTextEdit::onCopyActionTriggered() const
 {
-   if (textCursor_.hasSelection()) {
+   if (hasSelection()) {
       QApplication::clipboard()->setText(getFormattedTextFromSelection());
    }
-   else {
-      QTextDocument doc;
-      doc.setHtml(textCursor_.block().text());
-      QApplication::clipboard()->setText(doc.toPlainText());
+   else if (contextMenuRow_ >= 0 && contextMenuRow_ < messagesCount(currentPartyId_)) {
+      QApplication::clipboard()->setText(plainText(static_cast<size_t>(contextMenuRow_)));
    }
 }
 
@@ -258,12 +646,10 @@ void ChatMessagesTextEdit::onCopyLinkLocationActionTriggered() const
 
 void ChatMessagesTextEdit::onSelectAllActionTriggered()
 {
-   this->selectAll();
-}
-
-void ChatMessagesTextEdit::onTextChanged() const
-{
-   verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+   const auto count = messagesCount(currentPartyId_);
+   if (count > 0) {
+      selectRows(0, count - 1);
+   }
 }
 
 void ChatMessagesTextEdit::onUserUrlOpened(const QUrl &url)
@@ -311,21 +697,28 @@ void ChatMessagesTextEdit::onShowRequestPartyBox(const std::string& userHash)
 void ChatMessagesTextEdit::onSwitchToChat(const std::string& partyId)
 {
    currentPartyId_ = partyId;
-   clear();
+   layouts_.clear();
+   selectionAnchor_ = -1;
+   selectionCurrent_ = -1;
+   textSelectionRow_ = -1;
+   contextMenuRow_ = -1;
+   relayoutTimer_.stop();
+
+   updateMessageWidth();
+   startRelayout();
+   scrollToBottom();
+
    if (!currentPartyId_.empty()) {
-      showMessages(partyId);
-      onTextChanged();
-      auto clientMessagesHistory = messages_[partyId];
+      const auto clientMessagesHistory = messages_.history(partyId);
 
-      if (clientMessagesHistory.empty()) {
+      if (!clientMessagesHistory) {
          return;
       }
 
-      auto riter = clientMessagesHistory.rbegin();
-      for (; riter != clientMessagesHistory.rend(); ++riter)
+      for (auto row = clientMessagesHistory->size(); row > 0; --row)
       {
-         const auto messagePtr = (*riter);
-         
+         const auto messagePtr = clientMessagesHistory->at(row - 1);
+
          if (messagePtr->partyMessageState() == Chat::PartyMessageState::SEEN) {
             continue;
          }
@@ -347,25 +740,25 @@ void ChatMessagesTextEdit::onLogout()
 Chat::MessagePtr ChatMessagesTextEdit::onMessageStatusChanged(const std::string& partyId, const std::string& message_id,
                                                               const int party_message_state)
 {
-   Chat::MessagePtr message = findMessage(partyId, message_id);
+   Chat::MessagePtr message = messages_.setState(partyId, message_id
+      , static_cast<Chat::PartyMessageState>(party_message_state));
 
    if (message) {
-      message->setPartyMessageState(static_cast<Chat::PartyMessageState>(party_message_state));
       notifyMessageChanged(message);
    }
 
    return message;
 }
 
-void ChatMessagesTextEdit::onSetColumnsWidth(int time, int icon, int user, int message)
+void ChatMessagesTextEdit::onSetColumnsWidth(int time, int icon, int user, int)
 {
-   QVector <QTextLength> col_widths;
-   col_widths << QTextLength(QTextLength::FixedLength, time);
-   col_widths << QTextLength(QTextLength::FixedLength, icon);
-   col_widths << QTextLength(QTextLength::FixedLength, user);
-   col_widths << QTextLength(QTextLength::VariableLength, message);
-   tableFormat_.setColumnWidthConstraints(col_widths);
+   timeColumnWidth_ = time;
+   iconColumnWidth_ = icon;
    userColumnWidth_ = user;
+
+   // user names are elided to the column width
+   layouts_.clear();
+   updateMessageWidth();
 }
 
 void ChatMessagesTextEdit::onSetClientPartyModel(const Chat::ClientPartyModelPtr& partyModel)
@@ -373,34 +766,71 @@ void ChatMessagesTextEdit::onSetClientPartyModel(const Chat::ClientPartyModelPtr
    partyModel_ = partyModel;
 }
 
+QString ChatMessagesTextEdit::plainText(size_t row) const
+{
+   const auto &message = messageAt(row);
+
+   QString text;
+   const auto it = layouts_.find(message->messageId());
+   if (it != layouts_.end()) {
+      text = it->second->text->toPlainText();
+   }
+   else {
+      text = createLayout(message)->text->toPlainText();
+   }
+
+   QString user;
+   QString userLink;
+   userData(message, user, userLink);
+
+   // replace some special characters, because they can display incorrect
+   text.replace(QChar::LineSeparator, QChar::LineFeed);
+
+   return message->timestamp().toLocalTime().toString(QString::fromUtf8("MM/dd/yy hh:mm:ss"))
+      + QChar::Tabulation + user + QChar::Tabulation + text;
+}
+
+QString ChatMessagesTextEdit::selectedText() const
+{
+   const auto &message = messageAt(static_cast<size_t>(textSelectionRow_));
+
+   std::unique_ptr<MessageLayout> temporary;
+   QTextDocument *document = nullptr;
+   const auto it = layouts_.find(message->messageId());
+   if (it != layouts_.end()) {
+      document = it->second->text.get();
+   }
+   else {
+      temporary = createLayout(message);
+      document = temporary->text.get();
+   }
+
+   const int last = document->characterCount() - 1;
+   QTextCursor cursor(document);
+   cursor.setPosition(std::min(textSelectionAnchor_, last));
+   cursor.setPosition(std::min(textSelectionPosition_, last), QTextCursor::KeepAnchor);
+
+   auto text = cursor.selection().toPlainText();
+   text.replace(QChar::LineSeparator, QChar::LineFeed);
+   return text;
+}
+
 QString ChatMessagesTextEdit::getFormattedTextFromSelection() const
 {
+   if (!hasSelection()) {
+      return QString();
+   }
+   if (textSelectionRow_ >= 0) {
+      return selectedText();
+   }
+
    QString text;
-   QTextDocument textDocument;
-
-   // get selected text in html format
-   textDocument.setHtml(createMimeDataFromSelection()->html());      
-   QTextBlock currentBlock = textDocument.begin();
-   int blockCount = 0;
-
-   // each column is presented as a block
-   while (currentBlock.isValid()) {
-      blockCount++;
-      if (!currentBlock.text().isEmpty()) {
-
-         // format columns splits to tabulation
-         if (!text.isEmpty()) {
-            text += QChar::Tabulation;
-            
-            // new row (when few rows are selected)
-            if ((blockCount - 2) % 5 == 0) {
-               text += QChar::LineFeed;
-            }
-         }
-         // replace some special characters, because they can display incorrect
-         text += currentBlock.text().replace(QChar::LineSeparator, QChar::LineFeed);
+   const int last = std::max(selectionAnchor_, selectionCurrent_);
+   for (int row = std::min(selectionAnchor_, selectionCurrent_); row <= last; ++row) {
+      if (!text.isEmpty()) {
+         text += QChar::LineFeed;
       }
-      currentBlock = currentBlock.next();
+      text += plainText(static_cast<size_t>(row));
    }
    return text;
 }
@@ -416,26 +846,40 @@ void  ChatMessagesTextEdit::onUrlActivated(const QUrl &link) {
 
 void ChatMessagesTextEdit::insertMessage(const Chat::MessagePtr& messagePtr)
 {
-   // push new message if it doesn't exist in current chat
-   auto& messagesList = messages_[messagePtr->partyId()];
-   const auto messageIt =
-   std::find_if(messagesList.begin(), messagesList.end(), [messagePtr](const Chat::MessagePtr& m)->bool
-   {
-      return m->messageId() == messagePtr->messageId();
-   });
-
-   // remove duplicates by give message_id
-   if (messageIt != messagesList.cend())
-   {
-      deleteMessage(static_cast<int>(std::distance(messagesList.begin(), messageIt)));
-      messagesList.erase(messageIt);
+   // duplicates by message_id replace the message in place
+   const auto result = messages_.insert(messagePtr);
+   auto& partyHeights = heights(messagePtr->partyId());
+   const bool isCurrent = (messagePtr->partyId() == currentPartyId_);
+
+   if (result.replaced) {
+      partyHeights.invalidate(result.row);
+      if (isCurrent) {
+         layouts_.erase(messagePtr->messageId());
+         startRelayout();
+         viewport()->update();
+      }
    }
+   else {
+      // the oldest message has left history window
+      if (result.dropped) {
+         partyHeights.erase(0);
+         if (isCurrent) {
+            layouts_.erase(result.dropped->messageId());
+            clearSelection();
+         }
+      }
 
-   messagesList.push_back(messagePtr);
-   if (messagePtr->partyId() == currentPartyId_) {
-      showMessage(messagePtr->partyId(), messagePtr->messageId());
+      partyHeights.append(lineHeight());
+      if (isCurrent) {
+         scrollToBottom();
+      }
    }
 
+   notifyMessageRead(messagePtr);
+}
+
+void ChatMessagesTextEdit::notifyMessageRead(const Chat::MessagePtr& messagePtr)
+{
    if (messagePtr->partyMessageState() != Chat::PartyMessageState::SEEN
          && messagePtr->senderHash() != ownUserId_
          && messagePtr->partyId() == currentPartyId_
@@ -444,53 +888,27 @@ void ChatMessagesTextEdit::insertMessage(const Chat::MessagePtr& messagePtr)
    }
 }
 
-void ChatMessagesTextEdit::insertMessageInDoc(QTextCursor& cursor, const std::string& partyId, const std::string& messageId)
+void ChatMessagesTextEdit::mergeHistory(const std::string& partyId, const Chat::MessagePtrList& messagePtrList)
 {
-   cursor.beginEditBlock();
-   auto* table = cursor.insertTable(1, 4, tableFormat_);
+   messages_.merge(partyId, messagePtrList);
 
-   const auto time = data(partyId, messageId, Column::Time);
-   table->cellAt(0, 0).firstCursorPosition().insertHtml(time);
-
-   const auto image = statusImage(partyId, messageId);
-   if (!image.isNull()) {
-      table->cellAt(0, 1).firstCursorPosition().insertImage(image);
+   auto& partyHeights = heights(partyId);
+   partyHeights.clear();
+   for (size_t row = 0; row < messages_.size(partyId); ++row) {
+      partyHeights.append(lineHeight());
    }
 
-   const auto user = data(partyId, messageId, Column::User);
-   table->cellAt(0, 2).firstCursorPosition().insertHtml(user);
-
-   const auto message = data(partyId, messageId, Column::Message);
-   table->cellAt(0, 3).firstCursorPosition().insertHtml(message);
-   cursor.endEditBlock();
-}
-
-void ChatMessagesTextEdit::updateMessage(const std::string& partyId, const std::string& messageId)
-{
-   ClientMessagesHistory messagesList = messages_[partyId];
-   const ClientMessagesHistory::iterator it =
-      std::find_if(messagesList.begin(), messagesList.end(), [messageId](const Chat::MessagePtr& m)->bool
-   {
-      return m->messageId() == messageId;
-   });
-
-   if (it != messagesList.end())
-   {
-      const int distance = std::distance(messagesList.begin(), it);
-      auto cursor = deleteMessage(distance);
-      insertMessageInDoc(cursor, partyId, messageId);
+   if (partyId == currentPartyId_) {
+      layouts_.clear();
+      clearSelection();
+      contextMenuRow_ = -1;
+      startRelayout();
+      scrollToBottom();
    }
-}
-
-QTextCursor ChatMessagesTextEdit::deleteMessage(const int index) const
-{
-   QTextCursor cursor = textCursor();
-   cursor.movePosition(QTextCursor::Start);
-   cursor.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, index * 2);
-   cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, 1);
-   cursor.removeSelectedText();
 
-   return cursor;
+   for (const auto& messagePtr : messagePtrList) {
+      notifyMessageRead(messagePtr);
+   }
 }
 
 QString ChatMessagesTextEdit::elideUserName(const std::string& displayName) const
@@ -498,22 +916,6 @@ QString ChatMessagesTextEdit::elideUserName(const std::string& displayName) cons
    return fontMetrics().elidedText(QString::fromStdString(displayName), Qt::ElideRight, userColumnWidth_);
 }
 
-void ChatMessagesTextEdit::showMessage(const std::string& partyId, const std::string& messageId)
-{
-   /* add text */
-   QTextCursor cursor = textCursor();
-   cursor.movePosition(QTextCursor::End);
-
-   insertMessageInDoc(cursor, partyId, messageId);
-}
-
-void ChatMessagesTextEdit::showMessages(const std::string &partyId)
-{
-   for (const auto& message : messages_[partyId]) {
-      showMessage(partyId, message->messageId());
-   }
-}
-
 std::unique_ptr<QMenu> ChatMessagesTextEdit::initUserContextMenu(const QString& userName)
 {
    std::unique_ptr<QMenu> userMenuPtr = std::make_unique<QMenu>(this);
@@ -546,69 +948,47 @@ void ChatMessagesTextEdit::onMessageUpdate(const Chat::MessagePtrList& messagePt
    std::sort(messagePtrListSorted.begin(), messagePtrListSorted.end(), [](const auto& left, const auto& right) -> bool {
       return left->timestamp() < right->timestamp();
    });
-   for (const auto& messagePtr : messagePtrListSorted) {
 #ifndef QT_NO_DEBUG
+   for (const auto& messagePtr : messagePtrListSorted) {
       Q_ASSERT(partyId == messagePtr->partyId());
+   }
 #endif
-      insertMessage(messagePtr);
+   if (messagePtrListSorted.empty()) {
+      return;
    }
-}
-
-void ChatMessagesTextEdit::onUpdatePartyName(const std::string& partyId)
-{
-   const auto messageHistory = messages_[currentPartyId_];
-   
-   for (const auto& messagePtr : messageHistory)
-   {
-      if (messagePtr->partyId() != partyId) {
-         continue;
-      }
 
-      updateMessage(partyId, messagePtr->messageId());
+   // history reload comes after recent messages and repeats them
+   const auto& batchPartyId = messagePtrListSorted.front()->partyId();
+   if (!messages_.isAppendable(batchPartyId, messagePtrListSorted)) {
+      mergeHistory(batchPartyId, messagePtrListSorted);
+      return;
+   }
+   for (const auto& messagePtr : messagePtrListSorted) {
+      insertMessage(messagePtr);
    }
 }
 
-Chat::MessagePtr ChatMessagesTextEdit::findMessage(const std::string& partyId, const std::string& messageId)
+void ChatMessagesTextEdit::onUpdatePartyName(const std::string& partyId)
 {
-   if (messages_.contains(partyId)) {
-      const auto it = std::find_if(messages_[partyId].begin(), messages_[partyId].end(), [messageId](const Chat::MessagePtr& message) {
-         return message->messageId() == messageId;
-      });
-
-      if (it != messages_[partyId].end()) {
-         return *it;
-      }
+   if (partyId != currentPartyId_) {
+      return;
    }
 
-   return {};
+   // user column is laid out again on paint
+   layouts_.clear();
+   viewport()->update();
 }
 
 void ChatMessagesTextEdit::notifyMessageChanged(const Chat::MessagePtr& message)
 {
-   const std::string& partyId = message->partyId();
-   if (partyId != currentPartyId_) {
+   if (message->partyId() != currentPartyId_) {
       // Do not need to update view
       return;
    }
 
-   if (messages_.contains(partyId)) {
-      const std::string& id = message->messageId();
-      const auto it = std::find_if(messages_[partyId].begin(), messages_[partyId].end(), [id](const Chat::MessagePtr& iteration) {
-         return iteration->messageId() == id;
-      });
-
-      if (it != messages_[partyId].end()) {
-         updateMessage(partyId, (*it)->messageId());
-      }
-   }
-}
-
-QString ChatMessagesTextEdit::toHtmlUsername(const std::string& username, const std::string& userId) const
-{
-   return QStringLiteral("<a href=\"user:%1\" style=\"color:%2\">%3</a>")
-      .arg(QString::fromStdString(userId))
-      .arg(internalStyle_.colorHyperlink().name())
-      .arg(elideUserName(username));
+   // status doesn't change message height
+   layouts_.erase(message->messageId());
+   viewport()->update();
 }
 
 QString ChatMessagesTextEdit::toHtmlInvalid(const QString &text) const
@@ -14,13 +14,17 @@
 #include "ChatProtocol/Message.h"
 #include "ChatProtocol/ClientPartyModel.h"
 
+#include "ChatMessageHeights.h"
+#include "ChatMessageStore.h"
+
+#include <QAbstractScrollArea>
 #include <QDateTime>
 #include <QMenu>
-#include <QTextBrowser>
-#include <QTextTable>
-#include <QVector>
+#include <QTextDocument>
+#include <QTimer>
 
 #include <memory>
+#include <unordered_map>
 
 namespace Chat {
    class MessageData;
@@ -71,16 +75,27 @@ private:
    QColor colorOtc_;
 };
 
-class ChatMessagesTextEdit : public QTextBrowser
+// Chat history view which lays out and paints only visible messages. Layouts
+// of shown messages are cached, message heights of each party are kept in
+// ChatMessageHeights, so that switching between parties and scrolling don't
+// depend on history length. After width changes visible messages are laid
+// out right away and the rest in background chunks.
+// Dragging inside a message or double click selects its text, dragging over
+// several messages selects them whole, as cells of a table.
+class ChatMessagesTextEdit : public QAbstractScrollArea
 {
    Q_OBJECT
 
 public:
    ChatMessagesTextEdit(QWidget* parent = nullptr);
-   ~ChatMessagesTextEdit() noexcept override = default;
+   ~ChatMessagesTextEdit() noexcept override;
 
    QString getFormattedTextFromSelection() const;
    int messagesCount(const std::string& partyId) const;
+   // Messages kept per party, older ones are dropped
+   int historyWindow() const;
+   bool hasSelection() const;
+   void clearSelection();
 
 public slots:
    void onSetColumnsWidth(int time, int icon, int user, int message);
@@ -110,59 +125,125 @@ protected:
       last
    };
 
-   QString data(const std::string& partyId, const std::string& messageId, const Column &column);
-   QString dataMessage(const std::string& partyId, const std::string& messageId, const Column &column) const;
-   QImage statusImage(const std::string& partyId, const std::string& messageId) const;
+   QImage statusImage(const Chat::MessagePtr& message) const;
+   QString elideUserName(const std::string& displayName) const;
 
    void contextMenuEvent(QContextMenuEvent* e) override;
+   void paintEvent(QPaintEvent* e) override;
+   void resizeEvent(QResizeEvent* e) override;
+   void mousePressEvent(QMouseEvent* e) override;
+   void mouseMoveEvent(QMouseEvent* e) override;
+   void mouseReleaseEvent(QMouseEvent* e) override;
+   void mouseDoubleClickEvent(QMouseEvent* e) override;
+   void keyPressEvent(QKeyEvent* e) override;
+   void scrollContentsBy(int dx, int dy) override;
 
 private slots:
    void onUrlActivated(const QUrl &link);
    void onCopyActionTriggered() const;
    void onCopyLinkLocationActionTriggered() const;
    void onSelectAllActionTriggered();
-   void onTextChanged() const;
    void onUserUrlOpened(const QUrl &url);
+   void onRelayoutTimer();
 
 private:
-   Chat::MessagePtr getMessage(const std::string& partyId, const std::string& messageId) const;
+   // Message as shown for the current message column width
+   struct MessageLayout
+   {
+      QString time;
+      QImage  status;
+      QString user;
+      // user:<hash> if user name is a link
+      QString userLink;
+      std::unique_ptr<QTextDocument> text;
+   };
+
+   struct HitTest
+   {
+      int      row = -1;
+      Column   column = Column::last;
+      QString  anchor;
+   };
+
    void setupHighlightPalette();
    std::unique_ptr<QMenu> initUserContextMenu(const QString& userName);
 
-   // #new_logic
-   QString toHtmlUsername(const std::string& username, const std::string& userId) const;
    QString toHtmlText(const QString &text) const;
    QString toHtmlInvalid(const QString &text) const;
 
    void insertMessage(const Chat::MessagePtr& messagePtr);
-   void showMessage(const std::string& partyId, const std::string& messageId);
-   void showMessages(const std::string& partyId);
-   Chat::MessagePtr findMessage(const std::string& partyId, const std::string& messageId);
+   // Puts all messages of the party in order of time again
+   void mergeHistory(const std::string& partyId, const Chat::MessagePtrList& messagePtrList);
+   void notifyMessageRead(const Chat::MessagePtr& messagePtr);
    void notifyMessageChanged(const Chat::MessagePtr& message);
-   void insertMessageInDoc(QTextCursor& cursor, const std::string& partyId, const std::string& messageId);
-   void updateMessage(const std::string& partyId, const std::string& messageId);
-   QTextCursor deleteMessage(int index) const;
-   QString elideUserName(const std::string& displayName) const;
+   void userData(const Chat::MessagePtr& message, QString &user, QString &userLink) const;
+
+   ChatMessageHeights &heights(const std::string& partyId);
+   int lineHeight() const;
+   int messageColumnX() const;
+   int messageColumnWidth() const;
+
+   const Chat::MessagePtr &messageAt(size_t row) const;
+   MessageLayout &layout(size_t row);
+   std::unique_ptr<MessageLayout> createLayout(const Chat::MessagePtr& message) const;
+   void measure(size_t row);
+   // Lays out visible messages not measured for the current width yet
+   void measureVisible();
+   void updateMessageWidth();
+   void updateScrollBar();
+   void scrollToBottom();
+   // Drops cached layouts except the given rows if there are too many
+   void evictLayouts(size_t firstRow, size_t endRow);
+   void startRelayout();
+
+   HitTest hitTest(const QPoint &pos);
+   // Cursor position in message text nearest to the viewport point
+   int textPosition(size_t row, const QPoint &pos);
+   QString plainText(size_t row) const;
+   QString selectedText() const;
+   void selectRows(int anchor, int current);
+   void selectText(int row, int anchor, int position);
 
    Chat::ClientPartyModelPtr partyModel_;
 
    std::string currentPartyId_;
    std::string ownUserId_;
 
-   using ClientMessagesHistory = QVector<Chat::MessagePtr>;
-   QMap<std::string, ClientMessagesHistory> messages_;
+   ChatMessageStore<Chat::MessagePtr> messages_;
+   std::unordered_map<std::string, ChatMessageHeights> heights_;
+   // layouts of the current party messages by message id
+   std::unordered_map<std::string, std::unique_ptr<MessageLayout>> layouts_;
 
    QImage statusImageGreyUnsent_ = QImage({ QLatin1Literal(":/ICON_MSG_STATUS_OFFLINE") }, "PNG");
    QImage statusImageYellowSent_ = QImage({ QLatin1Literal(":/ICON_MSG_STATUS_CONNECTING") }, "PNG");
    QImage statusImageGreenReceived_ = QImage({ QLatin1Literal(":/ICON_MSG_STATUS_ONLINE") }, "PNG");
    QImage statusImageBlueSeen_ = QImage({ QLatin1Literal(":/ICON_MSG_STATUS_READ") }, "PNG");
 
-   QTextTableFormat tableFormat_;
    ChatMessagesTextEditStyle internalStyle_;
 
-   QTextCursor textCursor_;
-   QString anchor_;
+   int timeColumnWidth_ = 0;
+   int iconColumnWidth_ = 0;
    int userColumnWidth_ = 0;
+
+   // selected rows are between anchor and current ones, -1 if none
+   int selectionAnchor_ = -1;
+   int selectionCurrent_ = -1;
+   int pressedRow_ = -1;
+   QPoint pressedPos_;
+   QString pressedAnchor_;
+   // text position of press in message column, -1 if pressed elsewhere
+   int pressedTextPos_ = -1;
+   bool selecting_ = false;
+
+   // characters selected in message text of one row, -1 if none
+   int textSelectionRow_ = -1;
+   int textSelectionAnchor_ = 0;
+   int textSelectionPosition_ = 0;
+
+   int contextMenuRow_ = -1;
+   QString anchor_;
+
+   QTimer relayoutTimer_;
 };
 
 #endif // CHATMESSAGESTEXTEDIT_H
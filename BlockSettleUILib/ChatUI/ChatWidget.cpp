@@ -10,6 +10,7 @@
 */
 #include "ChatWidget.h"
 
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 #include <QClipboard>
@@ -193,7 +194,9 @@ void ChatWidget::init(const std::shared_ptr<ConnectionManager>& connectionManage
    connect(otcHelper_->client(), &OtcClient::sendPublicMessage, this, &ChatWidget::onSendOtcPublicMessage);
    connect(otcHelper_->client(), &OtcClient::peerUpdated, this, &ChatWidget::onOtcUpdated);
    connect(otcHelper_->client(), &OtcClient::publicUpdated, this, &ChatWidget::onOtcPublicUpdated);
-   connect(otcHelper_->client(), &OtcClient::publicUpdated, otcRequestViewModel_, &OTCRequestViewModel::onRequestsUpdated);
+   connect(otcHelper_->client(), &OtcClient::publicRequestAdded, otcRequestViewModel_, &OTCRequestViewModel::onRequestAdded);
+   connect(otcHelper_->client(), &OtcClient::publicRequestUpdated, otcRequestViewModel_, &OTCRequestViewModel::onRequestUpdated);
+   connect(otcHelper_->client(), &OtcClient::publicRequestRemoved, otcRequestViewModel_, &OTCRequestViewModel::onRequestRemoved);
    connect(otcHelper_->client(), &OtcClient::peerError, this, &ChatWidget::onOTCPeerError);
 
 
@@ -351,8 +354,14 @@ bool ChatWidget::eventFilter(QObject* sender, QEvent* event)
       }
    };
 
+   const auto fClearMessagesSelection = [this](bool bForce = false) {
+      if (!ui_->textEditMessages->underMouse() || bForce) {
+         ui_->textEditMessages->clearSelection();
+      }
+   };
+
    if ( QEvent::MouseButtonPress == event->type()) {
-      fClearSelection(ui_->textEditMessages);
+      fClearMessagesSelection();
       fClearSelection(ui_->input_textEdit);
    }
 
@@ -362,15 +371,15 @@ bool ChatWidget::eventFilter(QObject* sender, QEvent* event)
       // handle ctrl+c (cmd+c on macOS)
       if (keyEvent->modifiers().testFlag(Qt::ControlModifier)) {
          if (Qt::Key_C == keyEvent->key()) {
-            if (ui_->textEditMessages->textCursor().hasSelection()) {
+            if (ui_->textEditMessages->hasSelection()) {
                QApplication::clipboard()->setText(ui_->textEditMessages->getFormattedTextFromSelection());
-               fClearSelection(ui_->textEditMessages, true);
+               fClearMessagesSelection(true);
                return true;
             }
          }
       }
       if (keyEvent->matches(QKeySequence::SelectAll)) {
-         fClearSelection(ui_->textEditMessages);
+         fClearMessagesSelection();
       }
    }
 
@@ -720,7 +729,9 @@ void ChatWidget::onPrivateMessagesHistoryCount(const std::string& partyId, quint
       return;
    }
 
-   if (ui_->textEditMessages->messagesCount(partyId) < count)
+   // only the last messages are kept for parties with longer history
+   const auto shown = static_cast<quint64>(ui_->textEditMessages->messagesCount(partyId));
+   if (shown < std::min(count, static_cast<quint64>(ui_->textEditMessages->historyWindow())))
    {
       ui_->showHistoryButton->setVisible(true);
       return;
@@ -115,31 +115,59 @@ void OTCRequestViewModel::onRequestsUpdated()
 {
    beginResetModel();
    request_.clear();
-   for (const auto &peer : otcClient_->requests()) {
-      request_.push_back({ peer->request, peer->isOwnRequest });
+   for (int row = 0; row < int(otcClient_->requests().size()); ++row) {
+      request_.push_back(makeRequest(row));
    }
    endResetModel();
    emit restoreSelectedIndex();
 }
 
-void OTCRequestViewModel::onUpdateDuration()
+void OTCRequestViewModel::onRequestAdded(int row)
 {
-   if (rowCount() == 0) {
+   if (row < 0 || row > rowCount()) {
+      onRequestsUpdated();
       return;
    }
 
-   const qint64 timeout = QDateTime::currentDateTime().toSecsSinceEpoch() - std::chrono::duration_cast<std::chrono::seconds>(
-      bs::network::otc::publicRequestTimeout()).count();
+   beginInsertRows({}, row, row);
+   request_.insert(request_.begin() + row, makeRequest(row));
+   endInsertRows();
+}
 
-   auto it = std::remove_if(request_.begin(), request_.end(), [&](const OTCRequest& req) {
-      return req.request_.timestamp.toSecsSinceEpoch() < timeout;
-   });
+void OTCRequestViewModel::onRequestUpdated(int row)
+{
+   if (row < 0 || row >= rowCount()) {
+      onRequestsUpdated();
+      return;
+   }
 
-   if (it != request_.end()) {
-      const int startIndex = std::distance(request_.begin(), it);
-      beginRemoveRows({}, startIndex, request_.size() - 1);
-      request_.erase(it, request_.end());
-      endRemoveRows();
+   request_[size_t(row)] = makeRequest(row);
+   emit dataChanged(index(row, 0), index(row, static_cast<int>(Columns::Latest)));
+}
+
+void OTCRequestViewModel::onRequestRemoved(int row)
+{
+   if (row < 0 || row >= rowCount()) {
+      onRequestsUpdated();
+      return;
+   }
+
+   beginRemoveRows({}, row, row);
+   request_.erase(request_.begin() + row);
+   endRemoveRows();
+}
+
+OTCRequestViewModel::OTCRequest OTCRequestViewModel::makeRequest(int row) const
+{
+   const auto &peer = otcClient_->requests().at(size_t(row));
+   return { peer->request, peer->isOwnRequest };
+}
+
+void OTCRequestViewModel::onUpdateDuration()
+{
+   // Expired requests are removed by OtcClient, only progress is updated here
+   if (rowCount() == 0) {
+      return;
    }
 
    emit dataChanged(index(0, static_cast<int>(Columns::Duration)),
@@ -52,7 +52,11 @@ public:
    };
 
 public slots:
+   // Reloads all rows, row signals below keep them in sync with OtcClient::requests()
    void onRequestsUpdated();
+   void onRequestAdded(int row);
+   void onRequestUpdated(int row);
+   void onRequestRemoved(int row);
 
 private slots:
    void onUpdateDuration();
@@ -66,6 +70,8 @@ private:
       bs::network::otc::QuoteRequest request_;
       bool isOwnRequest_;
    };
+   OTCRequest makeRequest(int row) const;
+
    std::vector<OTCRequest> request_;
 
    OtcClient *otcClient_{};
@@ -13,6 +13,7 @@
 #include "AssetManager.h"
 #include "AuthAddressManager.h"
 #include "BSMessageBox.h"
+#include "FeeEstimateCache.h"
 #include "OTCWindowsManager.h"
 #include "OtcTypes.h"
 #include "TradesUtils.h"
@@ -365,5 +366,5 @@ void OTCNegotiationRequestWidget::onMaxQuantityClicked()
          ui_->quantitySpinBox->setValue(spendableQuantity);
          });
    };
-   otcManager_->getArmory()->estimateFee(bs::tradeutils::feeTargetBlockCount(), feeCb);
+   getUtxoManager()->feeEstimateCache()->get(bs::tradeutils::feeTargetBlockCount(), feeCb);
 }
@@ -0,0 +1,85 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "CoinControlInputs.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+
+size_t CoinControlInputs::ScrAddrHasher::operator()(const BinaryData &scrAddr) const
+{
+   // script hash after the prefix byte is uniformly distributed already
+   size_t result = 0;
+   if (scrAddr.getSize() > sizeof(result)) {
+      std::memcpy(&result, scrAddr.getPtr() + 1, sizeof(result));
+      return result;
+   }
+   return std::hash<std::string>()(std::string(reinterpret_cast<const char *>(scrAddr.getPtr())
+      , scrAddr.getSize()));
+}
+
+void CoinControlInputs::reserve(size_t count)
+{
+   inputs_.reserve(count);
+}
+
+void CoinControlInputs::add(const UTXO &utxo, int index, bool selected)
+{
+   const auto address = bs::Address::fromUTXO(utxo);
+   inputs_.push_back({ utxo, index, selected, address, utxo.getRecipientScrAddr()
+      , addressWeight(address), utxo.getValue() });
+}
+
+void CoinControlInputs::sort()
+{
+   std::stable_sort(inputs_.begin(), inputs_.end(), [](const Input &a, const Input &b) {
+      if (a.addressWeight != b.addressWeight) {
+         return (a.addressWeight < b.addressWeight);
+      }
+      if (a.index != b.index) {
+         return (a.index < b.index);
+      }
+      return (a.utxo < b.utxo);
+   });
+}
+
+std::vector<CoinControlInputs::AddressGroup> CoinControlInputs::groupByAddress() const
+{
+   std::vector<AddressGroup> result;
+   std::unordered_map<BinaryData, size_t, ScrAddrHasher> groups;
+   groups.reserve(inputs_.size());
+   for (size_t i = 0; i < inputs_.size(); ++i) {
+      const auto itGroup = groups.emplace(inputs_[i].scrAddr, result.size());
+      if (itGroup.second) {
+         result.push_back({ i, {} });
+      }
+      result[itGroup.first->second].inputs.push_back(i);
+   }
+   return result;
+}
+
+int CoinControlInputs::addressWeight(const bs::Address &addr)
+{
+   if (!addr.isValid()) {
+      return INT_MAX;
+   }
+   switch (addr.getType()) {
+   case AddressEntryType_P2WPKH: return 0;
+   case AddressEntryType_P2SH:
+   case static_cast<AddressEntryType>(AddressEntryType_P2SH + AddressEntryType_P2WPKH):
+      return 1;
+   case AddressEntryType_P2PKH:  return 2;
+   default: return 3;
+   }
+}
@@ -0,0 +1,69 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef COIN_CONTROL_INPUTS_H
+#define COIN_CONTROL_INPUTS_H
+
+#include <cstdint>
+#include <vector>
+#include "Address.h"
+#include "TxClasses.h"
+
+// Inputs shown in coin control with their sort and grouping keys, which are
+// derived from output script once per input instead of on each comparison
+class CoinControlInputs
+{
+public:
+   struct Input
+   {
+      UTXO        utxo;
+      // in SelectedTransactionInputs, -1 for incomplete inputs
+      int         index;
+      bool        selected;
+      bs::Address address;
+      BinaryData  scrAddr;
+      // native SegWit first, then nested and legacy
+      int         addressWeight;
+      uint64_t    amount;
+   };
+
+   // Inputs of one address in their current order
+   struct AddressGroup
+   {
+      size_t               first;
+      std::vector<size_t>  inputs;
+   };
+
+   struct ScrAddrHasher
+   {
+      size_t operator()(const BinaryData &) const;
+   };
+
+   void reserve(size_t);
+   void add(const UTXO &, int index, bool selected);
+
+   // By address weight, then by index (incomplete inputs first, ordered by
+   // outpoint), the same input set always gives the same order
+   void sort();
+
+   // Groups follow the order of their first input
+   std::vector<AddressGroup> groupByAddress() const;
+
+   const std::vector<Input> &inputs() const { return inputs_; }
+   const Input &at(size_t i) const { return inputs_.at(i); }
+   size_t size() const { return inputs_.size(); }
+
+   static int addressWeight(const bs::Address &);
+
+private:
+   std::vector<Input>   inputs_;
+};
+
+#endif // COIN_CONTROL_INPUTS_H
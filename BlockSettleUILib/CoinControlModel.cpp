@@ -9,12 +9,14 @@
 
 */
 #include "CoinControlModel.h"
+#include <algorithm>
 #include <QColor>
 #include <QList>
 #include <QString>
 #include <QFont>
 #include "BTCNumericTypes.h"
 #include "BtcUtils.h"
+#include "CoinControlInputs.h"
 #include "SelectedTransactionInputs.h"
 #include "TxClasses.h"
 #include "UiUtils.h"
@@ -316,29 +318,29 @@ private:
 
 
 void CoinControlNode::sort(int column, Qt::SortOrder order) {
-   qSort(std::begin(children_), std::end(children_)
-      , [column, order](CoinControlNode* left, CoinControlNode* right) {
-      bool res = true;
+   // stable, so equal rows keep their relative order when sorted by other column
+   const auto less = [column](CoinControlNode* left, CoinControlNode* right) {
       switch(column){
       case 0:
-         res = (left->type_ != right->type_) ? (left->type_ < right->type_) : (left->getName().compare(right->getName()) < 0);
-         break;
+         if (left->type_ != right->type_) {
+            return (left->type_ < right->type_);
+         }
+         return (left->name_.compare(right->name_) < 0);
       case 1:
-         res = left->getUtxoCount() < right->getUtxoCount();
-         break;
+         return left->getUtxoCount() < right->getUtxoCount();
       case 2:
-         res = left->getComment().compare(right->getComment()) < 0;
-         break;
+         return left->comment_.compare(right->comment_) < 0;
       default:
-         res = ((TransactionNode*)left)->getTotalAmount() < ((TransactionNode*)right)->getTotalAmount();
-         break;
+         return left->getTotalAmount() < right->getTotalAmount();
       }
-
-      if (order == Qt::DescendingOrder)
-         return !res;
-
-      return res;
-   });
+   };
+   if (order == Qt::DescendingOrder) {
+      std::stable_sort(std::begin(children_), std::end(children_)
+         , [less](CoinControlNode* left, CoinControlNode* right) { return less(right, left); });
+   }
+   else {
+      std::stable_sort(std::begin(children_), std::end(children_), less);
+   }
 }
 
 CoinControlModel::CoinControlModel(const std::shared_ptr<SelectedTransactionInputs> &selectedInputs, QObject* parent)
@@ -516,73 +518,34 @@ CoinControlNode* CoinControlModel::getNodeByIndex(const QModelIndex& index) cons
    return static_cast<CoinControlNode*>(index.internalPointer());
 }
 
-static int addressWeight(const bs::Address &addr)
-{
-   if (!addr.isValid()) {
-      return INT_MAX;
-   }
-   switch (addr.getType()) {
-   case AddressEntryType_P2WPKH: return 0;
-   case AddressEntryType_P2SH:
-   case static_cast<AddressEntryType>(AddressEntryType_P2SH + AddressEntryType_P2WPKH):
-      return 1;
-   case AddressEntryType_P2PKH:  return 2;
-   default: return 3;
-   }
-}
-
 void CoinControlModel::loadInputs(const std::shared_ptr<SelectedTransactionInputs>& selectedInputs)
 {
-   struct InputKey {
-      UTXO  utxo;
-      int   index;
-
-      bool operator<(const InputKey &other) const
-      {
-         const auto aw1 = addressWeight(bs::Address::fromUTXO(utxo));
-         const auto aw2 = addressWeight(bs::Address::fromUTXO(other.utxo));
-         if (aw1 != aw2) {
-            return aw1 < aw2;
-         }
-         if (index != other.index) {
-            return (index < other.index);
-         }
-         return (utxo < other.utxo);
-      }
-   };
-   struct UtxoState {
-      bool selected;
-      bool enabled;
-   };
-   std::map<InputKey, UtxoState> inputs;
+   const auto wallet = selectedInputs->GetWallet();
+   const auto incompleteUtxos = selectedInputs->getIncompleteUTXOs();
+   CoinControlInputs inputs;
+   inputs.reserve(selectedInputs->GetTransactionsCount() + incompleteUtxos.size());
    for (int i = 0; i < selectedInputs->GetTransactionsCount(); ++i) {
-      inputs[{selectedInputs->GetTransaction(i), i}] = {
-         selectedInputs->IsTransactionSelected(i), true };
-   }
-
-   for (const auto &utxo : selectedInputs->getIncompleteUTXOs()) {
-      inputs[{utxo, -1}] = { false, false };
-   }
-
-   for (const auto &input : inputs) {
-      const auto address = bs::Address::fromUTXO(input.first.utxo);
-      const auto addrStr = address.display();
-
-      auto addressIt = addressNodes_.find(addrStr);
-      AddressNode *addressNode = nullptr;
-
-      if (addressIt == addressNodes_.end()) {
-         auto wallet = selectedInputs->GetWallet();
-         auto comment = wallet ? wallet->getAddressComment(bs::Address::fromHash(input.first.utxo.getRecipientScrAddr())) : "";
-         addressNode = new AddressNode(CoinControlNode::detectType(address), QString::fromStdString(address.display())
-            , QString::fromStdString(comment), (int)addressNodes_.size(), root_.get());
-         root_->appendChildNode(addressNode);
-         addressNodes_.emplace(addrStr, addressNode);
-      } else {
-         addressNode = static_cast<AddressNode*>(addressIt->second);
+      inputs.add(selectedInputs->GetTransaction(i), i, selectedInputs->IsTransactionSelected(i));
+   }
+   for (const auto &utxo : incompleteUtxos) {
+      inputs.add(utxo, -1, false);
+   }
+   inputs.sort();
+
+   for (const auto &group : inputs.groupByAddress()) {
+      const auto &first = inputs.at(group.first);
+      const auto comment = wallet ? wallet->getAddressComment(bs::Address::fromHash(first.scrAddr)) : "";
+      auto addressNode = new AddressNode(CoinControlNode::detectType(first.address)
+         , QString::fromStdString(first.address.display()), QString::fromStdString(comment)
+         , (int)addressNodes_.size(), root_.get());
+      root_->appendChildNode(addressNode);
+      addressNodes_.emplace(first.scrAddr, addressNode);
+
+      for (const auto i : group.inputs) {
+         const auto &input = inputs.at(i);
+         addressNode->addTransaction(new TransactionNode(input.selected, input.index
+            , input.utxo, wallet, addressNode));    //TODO: Add TX comment
       }
-      addressNode->addTransaction(new TransactionNode(input.second.selected
-         , input.first.index, input.first.utxo, selectedInputs->GetWallet(), addressNode));    //TODO: Add TX comment
    }
 
    const auto cpfpList = selectedInputs->GetCPFPInputs();
@@ -590,25 +553,26 @@ void CoinControlModel::loadInputs(const std::shared_ptr<SelectedTransactionInput
       cpfp_ = std::make_shared<AddressNode>(CoinControlNode::Type::CpfpRoot, tr("CPFP Eligible Outputs"), tr("Child-Pays-For-Parent transactions")
          , addressNodes_.size(), root_.get());
       root_->appendChildNode(cpfp_.get());
+
+      CoinControlInputs cpfpInputs;
+      cpfpInputs.reserve(cpfpList.size());
       for (size_t i = 0; i < cpfpList.size(); i++) {
-         const auto &input = cpfpList[i];
-         const auto address = bs::Address::fromUTXO(input);
-         const auto addrStr = address.display();
-         AddressNode *addressNode = nullptr;
-         const auto itAddr = cpfpNodes_.find(addrStr);
-
-         if (itAddr == cpfpNodes_.end()) {
-            const int row = cpfpNodes_.size();
-            addressNode = new AddressNode(CoinControlNode::Type::DoesNotMatter, QString::fromStdString(address.display())
-               , QString::fromStdString(selectedInputs->GetWallet()->getAddressComment(bs::Address::fromHash(input.getRecipientScrAddr()))), row, cpfp_.get());
-            cpfp_->appendChildNode(addressNode);
-            cpfpNodes_[addrStr] = addressNode;
-         }
-         else {
-            addressNode = static_cast<AddressNode *>(itAddr->second);
+         cpfpInputs.add(cpfpList[i], (int)i
+            , selectedInputs->IsTransactionSelected(i + selectedInputs->GetTransactionsCount()));
+      }
+      for (const auto &group : cpfpInputs.groupByAddress()) {
+         const auto &first = cpfpInputs.at(group.first);
+         const int row = cpfpNodes_.size();
+         auto addressNode = new AddressNode(CoinControlNode::Type::DoesNotMatter, QString::fromStdString(first.address.display())
+            , QString::fromStdString(wallet->getAddressComment(bs::Address::fromHash(first.scrAddr))), row, cpfp_.get());
+         cpfp_->appendChildNode(addressNode);
+         cpfpNodes_.emplace(first.scrAddr, addressNode);
+
+         for (const auto i : group.inputs) {
+            const auto &input = cpfpInputs.at(i);
+            addressNode->addTransaction(new CPFPTransactionNode(input.selected, input.index
+               , input.utxo, wallet, addressNode));
          }
-         const auto isSel = selectedInputs->IsTransactionSelected(i + selectedInputs->GetTransactionsCount());
-         addressNode->addTransaction(new CPFPTransactionNode(isSel, i, input, selectedInputs->GetWallet(), addressNode));
       }
    }
 }
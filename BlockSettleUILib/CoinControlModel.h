@@ -16,6 +16,7 @@
 #include <unordered_map>
 #include <vector>
 #include <QAbstractItemModel>
+#include "CoinControlInputs.h"
 
 namespace bs {
    namespace sync {
@@ -25,8 +26,6 @@ namespace bs {
 class CoinControlNode;
 class SelectedTransactionInputs;
 
-struct UTXO;
-
 class CoinControlModel : public QAbstractItemModel
 {
 Q_OBJECT
@@ -80,7 +79,7 @@ private:
 private:
    std::shared_ptr<CoinControlNode>    root_, cpfp_;
    std::shared_ptr<bs::sync::Wallet>   wallet_;
-   std::unordered_map<std::string, CoinControlNode*> addressNodes_, cpfpNodes_;
+   std::unordered_map<BinaryData, CoinControlNode*, CoinControlInputs::ScrAddrHasher> addressNodes_, cpfpNodes_;
 };
 
 #endif // __COIN_CONTROL_MODEL_H__
@@ -0,0 +1,302 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "CoinSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+using namespace bs;
+
+namespace {
+   const size_t kP2wpkhInputSize = 68;
+   const size_t kP2shP2wpkhInputSize = 91;
+   const size_t kP2pkhInputSize = 148;
+
+   // passes of randomized subset search, each costs one iteration per candidate
+   const size_t kKnapsackRepeats = 1000;
+
+   uint64_t feeFor(float feePerByte, size_t size)
+   {
+      return static_cast<uint64_t>(std::ceil(static_cast<double>(feePerByte) * size));
+   }
+
+   // Candidates from the given one on are searched, best[i] is for candidate
+   // first + i. bestValue stays at max if no subset is found within limit.
+   void approximateBestSubset(const std::vector<CoinSelectionStrategy::Candidate> &candidates
+      , size_t first, uint64_t target, size_t maxIterations, size_t &iterations
+      , std::vector<bool> &best, uint64_t &bestValue)
+   {
+      const size_t count = candidates.size() - first;
+      std::mt19937 rng(1);
+      best.clear();
+      bestValue = std::numeric_limits<uint64_t>::max();
+
+      std::vector<bool> included;
+      for (size_t rep = 0; (rep < kKnapsackRepeats) && (bestValue != target); ++rep) {
+         included.assign(count, false);
+         uint64_t total = 0;
+         bool reached = false;
+         for (int pass = 0; (pass < 2) && !reached; ++pass) {
+            for (size_t i = 0; i < count; ++i) {
+               if (iterations >= maxIterations) {
+                  return;
+               }
+               ++iterations;
+               // first pass: random subset, second pass: add the rest
+               if ((pass == 0) ? ((rng() & 1) != 0) : !included[i]) {
+                  total += candidates[first + i].effectiveValue;
+                  included[i] = true;
+                  if (total >= target) {
+                     reached = true;
+                     if (total < bestValue) {
+                        bestValue = total;
+                        best = included;
+                     }
+                     total -= candidates[first + i].effectiveValue;
+                     included[i] = false;
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+
+
+std::vector<size_t> BranchAndBoundStrategy::select(const std::vector<Candidate> &candidates
+   , const Target &target, size_t &iterations) const
+{
+   uint64_t available = 0;
+   for (const auto &candidate : candidates) {
+      available += candidate.effectiveValue;
+   }
+   if (available < target.value) {
+      return {};
+   }
+   const uint64_t upperBound = target.value + target.costOfChange;
+
+   // selection[i] - whether candidate i is included, for candidates visited so far
+   std::vector<bool> selection;
+   std::vector<bool> best;
+   uint64_t bestExcess = std::numeric_limits<uint64_t>::max();
+   uint64_t value = 0;
+
+   for (iterations = 0; iterations < target.maxIterations; ++iterations) {
+      bool backtrack = false;
+      if ((value + available < target.value) || (value > upperBound)) {
+         backtrack = true;
+      }
+      else if (value >= target.value) {
+         if (value - target.value < bestExcess) {
+            bestExcess = value - target.value;
+            best = selection;
+            if (bestExcess == 0) {
+               break;
+            }
+         }
+         backtrack = true;
+      }
+
+      if (backtrack) {
+         while (!selection.empty() && !selection.back()) {
+            selection.pop_back();
+            available += candidates[selection.size()].effectiveValue;
+         }
+         if (selection.empty()) {
+            break;   // whole tree is searched
+         }
+         selection.back() = false;
+         value -= candidates[selection.size() - 1].effectiveValue;
+      }
+      else {
+         const auto &candidate = candidates[selection.size()];
+         available -= candidate.effectiveValue;
+         value += candidate.effectiveValue;
+         selection.push_back(true);
+      }
+   }
+
+   std::vector<size_t> result;
+   for (size_t i = 0; i < best.size(); ++i) {
+      if (best[i]) {
+         result.push_back(i);
+      }
+   }
+   return result;
+}
+
+std::vector<size_t> KnapsackStrategy::select(const std::vector<Candidate> &candidates
+   , const Target &target, size_t &iterations) const
+{
+   iterations = 0;
+   const uint64_t targetWithChange = target.value + target.costOfChange + target.minChange;
+
+   // candidates are sorted, so the smaller ones go after the larger
+   size_t firstLower = 0;
+   while ((firstLower < candidates.size()) && (candidates[firstLower].effectiveValue >= targetWithChange)) {
+      ++firstLower;
+   }
+   const bool hasLarger = (firstLower > 0);
+   const size_t lowestLarger = firstLower - 1;
+
+   uint64_t totalLower = 0;
+   for (size_t i = firstLower; i < candidates.size(); ++i) {
+      ++iterations;
+      if (candidates[i].effectiveValue == target.value) {
+         return { i };
+      }
+      totalLower += candidates[i].effectiveValue;
+   }
+   if (totalLower == target.value) {
+      std::vector<size_t> lower(candidates.size() - firstLower);
+      std::iota(lower.begin(), lower.end(), firstLower);
+      return lower;
+   }
+   if (totalLower < target.value) {
+      if (hasLarger) {
+         return { lowestLarger };
+      }
+      return {};
+   }
+
+   std::vector<bool> best;
+   uint64_t bestValue = 0;
+   const auto subsetTarget = (totalLower >= targetWithChange) ? targetWithChange : target.value;
+   approximateBestSubset(candidates, firstLower, subsetTarget
+      , target.maxIterations, iterations, best, bestValue);
+
+   if (hasLarger && (candidates[lowestLarger].effectiveValue <= bestValue)) {
+      return { lowestLarger };
+   }
+   std::vector<size_t> result;
+   for (size_t i = 0; i < best.size(); ++i) {
+      if (best[i]) {
+         result.push_back(firstLower + i);
+      }
+   }
+   return result;
+}
+
+std::vector<size_t> LargestFirstStrategy::select(const std::vector<Candidate> &candidates
+   , const Target &target, size_t &iterations) const
+{
+   const uint64_t targetWithChange = target.value + target.costOfChange + target.minChange;
+   std::vector<size_t> result;
+   uint64_t value = 0;
+   for (iterations = 0; iterations < candidates.size(); ++iterations) {
+      if (value >= targetWithChange) {
+         break;
+      }
+      result.push_back(iterations);
+      value += candidates[iterations].effectiveValue;
+   }
+   if (value < target.value) {
+      return {};
+   }
+   return result;
+}
+
+
+CoinSelector::Strategies CoinSelector::defaultStrategies()
+{
+   return { std::make_shared<BranchAndBoundStrategy>(), std::make_shared<KnapsackStrategy>()
+      , std::make_shared<LargestFirstStrategy>() };
+}
+
+CoinSelector::CoinSelector(const Strategies &strategies)
+   : strategies_(strategies)
+{}
+
+CoinSelectionResult CoinSelector::select(const std::vector<UTXO> &utxos, const CoinSelectionParams &params) const
+{
+   CoinSelectionResult result;
+   if (params.amount == 0) {
+      return result;
+   }
+
+   struct Input
+   {
+      CoinSelectionStrategy::Candidate candidate;
+      size_t   utxoIndex;
+   };
+   std::vector<Input> inputs;
+   inputs.reserve(utxos.size());
+   for (size_t i = 0; i < utxos.size(); ++i) {
+      const auto &utxo = utxos[i];
+      const auto size = params.inputSize ? params.inputSize(utxo) : inputSize(utxo);
+      const auto inputFee = feeFor(params.feePerByte, size);
+      // costs more to spend than it's worth
+      if (utxo.getValue() <= inputFee) {
+         continue;
+      }
+      inputs.push_back({ { utxo.getValue(), utxo.getValue() - inputFee, size }, i });
+   }
+   std::stable_sort(inputs.begin(), inputs.end(), [](const Input &a, const Input &b) {
+      return a.candidate.effectiveValue > b.candidate.effectiveValue;
+   });
+   std::vector<CoinSelectionStrategy::Candidate> candidates;
+   candidates.reserve(inputs.size());
+   for (const auto &input : inputs) {
+      candidates.push_back(input.candidate);
+   }
+
+   const float longTermFeePerByte = (params.longTermFeePerByte > 0) ? params.longTermFeePerByte : params.feePerByte;
+   CoinSelectionStrategy::Target target;
+   target.value = params.amount + feeFor(params.feePerByte, params.txOverhead + params.outputsSize);
+   target.costOfChange = feeFor(params.feePerByte, params.changeOutputSize)
+      + feeFor(longTermFeePerByte, params.changeSpendSize);
+   target.minChange = params.dustThreshold;
+   target.maxIterations = params.maxIterations;
+
+   for (const auto &strategy : strategies_) {
+      size_t iterations = 0;
+      const auto selected = strategy->select(candidates, target, iterations);
+      result.iterations += iterations;
+      if (selected.empty()) {
+         continue;
+      }
+
+      size_t txSize = params.txOverhead + params.outputsSize;
+      for (const auto index : selected) {
+         const auto &input = inputs[index];
+         result.inputs.push_back(utxos[input.utxoIndex]);
+         result.total += input.candidate.value;
+         txSize += input.candidate.inputSize;
+      }
+      const auto feeWithChange = feeFor(params.feePerByte, txSize + params.changeOutputSize);
+      if ((result.total >= params.amount + feeWithChange)
+         && (result.total - params.amount - feeWithChange >= params.dustThreshold)) {
+         result.fee = feeWithChange;
+         result.change = result.total - params.amount - feeWithChange;
+      }
+      else {
+         result.fee = result.total - params.amount;
+      }
+      result.strategy = strategy->name();
+      return result;
+   }
+   return result;
+}
+
+size_t CoinSelector::inputSize(const UTXO &utxo)
+{
+   const auto &script = utxo.getScript();
+   if ((script.getSize() == 22) && (script.getPtr()[0] == 0x00)) {
+      return kP2wpkhInputSize;
+   }
+   if ((script.getSize() == 23) && (script.getPtr()[0] == 0xa9)) {
+      return kP2shP2wpkhInputSize;
+   }
+   return kP2pkhInputSize;
+}
@@ -0,0 +1,145 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef COIN_SELECTOR_H
+#define COIN_SELECTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TxClasses.h"
+
+namespace bs {
+
+   // Transaction to fund, sizes are in virtual bytes
+   struct CoinSelectionParams
+   {
+      // paid to recipients, in satoshis
+      uint64_t amount = 0;
+      float    feePerByte = 0;
+      // fee rate expected when change output will be spent, feePerByte if 0
+      float    longTermFeePerByte = 0;
+      size_t   txOverhead = 11;
+      // recipient outputs
+      size_t   outputsSize = 31;
+      size_t   changeOutputSize = 31;
+      // input spending change output later
+      size_t   changeSpendSize = 68;
+      // smaller change is left to miners
+      uint64_t dustThreshold = 546;
+      // work limit of each strategy, keeps selection time bounded
+      size_t   maxIterations = 100000;
+      // by output script type if not set
+      std::function<size_t(const UTXO &)> inputSize;
+   };
+
+   struct CoinSelectionResult
+   {
+      std::vector<UTXO> inputs;
+      uint64_t total = 0;
+      uint64_t fee = 0;
+      // 0 if there is no change output
+      uint64_t change = 0;
+      // of all strategies tried
+      size_t   iterations = 0;
+      std::string strategy;
+
+      bool found() const { return !inputs.empty(); }
+   };
+
+   class CoinSelectionStrategy
+   {
+   public:
+      struct Candidate
+      {
+         uint64_t value;
+         // value less fee of spending it, always positive
+         uint64_t effectiveValue;
+         size_t   inputSize;
+      };
+
+      struct Target
+      {
+         // amount and fee of transaction without inputs and change
+         uint64_t value;
+         // fee of creating change output and of spending it later
+         uint64_t costOfChange;
+         uint64_t minChange;
+         size_t   maxIterations;
+      };
+
+      virtual ~CoinSelectionStrategy() = default;
+
+      virtual std::string name() const = 0;
+      // Candidates are sorted by effective value, largest first. Returns indices
+      // of selected candidates with effective value covering target value,
+      // empty if there is no such selection within iteration limit.
+      virtual std::vector<size_t> select(const std::vector<Candidate> &, const Target &
+         , size_t &iterations) const = 0;
+   };
+
+   // Depth-first search for a selection which doesn't need change output,
+   // i.e. exceeds target by no more than the cost of change. The smallest
+   // excess found within iteration limit is returned.
+   class BranchAndBoundStrategy : public CoinSelectionStrategy
+   {
+   public:
+      std::string name() const override { return "BnB"; }
+      std::vector<size_t> select(const std::vector<Candidate> &, const Target &
+         , size_t &iterations) const override;
+   };
+
+   // Randomized subset search aiming at target with non-dust change, compared
+   // with the single smallest sufficient candidate. Random generator is seeded
+   // with a constant, so the result depends only on the input.
+   class KnapsackStrategy : public CoinSelectionStrategy
+   {
+   public:
+      std::string name() const override { return "Knapsack"; }
+      std::vector<size_t> select(const std::vector<Candidate> &, const Target &
+         , size_t &iterations) const override;
+   };
+
+   // Takes the largest candidates until target with non-dust change is
+   // covered (or just target when all are taken)
+   class LargestFirstStrategy : public CoinSelectionStrategy
+   {
+   public:
+      std::string name() const override { return "LargestFirst"; }
+      std::vector<size_t> select(const std::vector<Candidate> &, const Target &
+         , size_t &iterations) const override;
+   };
+
+   // Tries strategies in order until one of them finds a selection
+   class CoinSelector
+   {
+   public:
+      using Strategies = std::vector<std::shared_ptr<CoinSelectionStrategy>>;
+
+      // BnB, Knapsack, LargestFirst
+      static Strategies defaultStrategies();
+
+      CoinSelector(const Strategies &strategies = defaultStrategies());
+
+      // Result is empty if UTXOs are not sufficient
+      CoinSelectionResult select(const std::vector<UTXO> &, const CoinSelectionParams &) const;
+
+      // P2WPKH, P2SH-P2WPKH or P2PKH input
+      static size_t inputSize(const UTXO &);
+
+   private:
+      const Strategies  strategies_;
+   };
+
+}  // namespace bs
+
+#endif // COIN_SELECTOR_H
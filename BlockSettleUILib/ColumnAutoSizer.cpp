@@ -0,0 +1,148 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "ColumnAutoSizer.h"
+
+#include <QAbstractItemModel>
+#include <QFontMetrics>
+#include <QHeaderView>
+#include <QStyle>
+#include <QTreeView>
+
+#include <algorithm>
+
+namespace {
+   // roughly one frame at 60 FPS
+   const int kFlushIntervalMs = 16;
+
+   // width cache is dropped when grows above this size
+   const int kMaxCachedWidths = 4096;
+}
+
+
+//
+// ColumnAutoSizer
+//
+
+ColumnAutoSizer::ColumnAutoSizer(QTreeView *view, QAbstractItemModel *model, QObject *parent)
+   : QObject(parent)
+   , view_(view)
+   , model_(model)
+{
+   flushTimer_.setSingleShot(true);
+   flushTimer_.setInterval(kFlushIntervalMs);
+   connect(&flushTimer_, &QTimer::timeout, this, &ColumnAutoSizer::flush);
+}
+
+ColumnAutoSizer::~ColumnAutoSizer() noexcept = default;
+
+void ColumnAutoSizer::setMode(Mode mode)
+{
+   if (mode_ == mode) {
+      return;
+   }
+   flush();
+   mode_ = mode;
+}
+
+void ColumnAutoSizer::setSkippedColumns(const std::set<int> &columns)
+{
+   skipped_ = columns;
+}
+
+void ColumnAutoSizer::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+   if (mode_ == Mode::Immediate) {
+      for (int row = first; row <= last; ++row) {
+         for (int i = 1; i < model_->columnCount(parent); ++i) {
+            if (!isSkipped(i)) {
+               view_->resizeColumnToContents(i);
+            }
+         }
+      }
+      return;
+   }
+
+   for (int row = first; row <= last; ++row) {
+      pending_.emplace_back(model_->index(row, 0, parent));
+   }
+
+   if (!flushTimer_.isActive()) {
+      flushTimer_.start();
+   }
+}
+
+void ColumnAutoSizer::flush()
+{
+   flushTimer_.stop();
+   if (pending_.empty()) {
+      return;
+   }
+
+   if (!metrics_ || (cachedFont_ != view_->font())) {
+      cachedFont_ = view_->font();
+      metrics_.reset(new QFontMetrics(cachedFont_));
+      widthCache_.clear();
+   }
+   if (margin_ < 0) {
+      // the same padding QStyledItemDelegate adds around text
+      margin_ = 2 * (view_->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, view_) + 1);
+   }
+
+   auto *header = view_->header();
+   const int columnCount = header->count();
+   std::vector<int> widths(static_cast<std::size_t>(columnCount), 0);
+
+   for (const auto &index : pending_) {
+      if (!index.isValid()) {
+         continue;
+      }
+      for (int i = 1; i < columnCount; ++i) {
+         if (isSkipped(i)) {
+            continue;
+         }
+         const auto text = index.sibling(index.row(), i).data(Qt::DisplayRole).toString();
+         if (text.isEmpty()) {
+            continue;
+         }
+         auto &width = widths[static_cast<std::size_t>(i)];
+         width = std::max(width, textWidth(text) + margin_);
+      }
+   }
+   pending_.clear();
+
+   for (int i = 1; i < columnCount; ++i) {
+      const int width = widths[static_cast<std::size_t>(i)];
+      if (width > header->sectionSize(i)) {
+         header->resizeSection(i, width);
+      }
+   }
+}
+
+int ColumnAutoSizer::textWidth(const QString &text)
+{
+   const auto it = widthCache_.constFind(text);
+   if (it != widthCache_.constEnd()) {
+      return it.value();
+   }
+
+   if (widthCache_.size() >= kMaxCachedWidths) {
+      widthCache_.clear();
+   }
+
+   const int width = metrics_->boundingRect(text).width();
+   widthCache_.insert(text, width);
+   return width;
+}
+
+bool ColumnAutoSizer::isSkipped(int column) const
+{
+   return (skipped_.find(column) != skipped_.end());
+}
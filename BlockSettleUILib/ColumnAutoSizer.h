@@ -0,0 +1,82 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef COLUMN_AUTO_SIZER_H
+#define COLUMN_AUTO_SIZER_H
+
+#include <QFont>
+#include <QHash>
+#include <QObject>
+#include <QPersistentModelIndex>
+#include <QTimer>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+class QAbstractItemModel;
+class QFontMetrics;
+class QTreeView;
+
+//
+// ColumnAutoSizer
+//
+
+//! Grows tree view columns to fit text of inserted rows.
+//! In Deferred mode insertions are collected during a frame, only the text of
+//! the new rows is measured (with widths cached per string) and header is
+//! updated once per frame. Columns never shrink in this mode.
+//! Immediate mode calls QTreeView::resizeColumnToContents() for every inserted
+//! row as before and is kept for comparison.
+class ColumnAutoSizer : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum class Mode {
+      Immediate,
+      Deferred
+   };
+
+   ColumnAutoSizer(QTreeView *view, QAbstractItemModel *model, QObject *parent = nullptr);
+   ~ColumnAutoSizer() noexcept override;
+
+   void setMode(Mode mode);
+   Mode mode() const { return mode_; }
+
+   // Columns are not touched by the sizer, e.g. ones with own delegates
+   void setSkippedColumns(const std::set<int> &columns);
+
+   // Rows are given in terms of model passed to constructor
+   void rowsInserted(const QModelIndex &parent, int first, int last);
+
+   std::size_t cachedWidths() const { return static_cast<std::size_t>(widthCache_.size()); }
+
+private slots:
+   void flush();
+
+private:
+   int textWidth(const QString &text);
+   bool isSkipped(int column) const;
+
+private:
+   QTreeView            *view_;
+   QAbstractItemModel   *model_;
+   Mode                 mode_ = Mode::Deferred;
+   std::set<int>        skipped_;
+   std::vector<QPersistentModelIndex>  pending_;
+   QTimer               flushTimer_;
+   QHash<QString, int>  widthCache_;
+   QFont                cachedFont_;
+   std::unique_ptr<QFontMetrics>    metrics_;
+   int                  margin_ = -1;
+};
+
+#endif // COLUMN_AUTO_SIZER_H
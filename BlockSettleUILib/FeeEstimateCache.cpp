@@ -0,0 +1,172 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "FeeEstimateCache.h"
+
+#include <spdlog/spdlog.h>
+
+
+const std::chrono::milliseconds FeeEstimateCache::kDefaultTtl = std::chrono::seconds(60);
+
+FeeEstimateCache::FeeEstimateCache(const EstimateFunc &estimate, const std::shared_ptr<spdlog::logger> &logger
+   , std::chrono::milliseconds ttl, const NowFunc &now)
+   : estimate_(estimate)
+   , logger_(logger)
+   , now_(now ? now : NowFunc([] { return Clock::now(); }))
+   , state_(std::make_shared<State>())
+{
+   state_->ttl = ttl;
+}
+
+bool FeeEstimateCache::get(unsigned int nbBlocks, const FeeCb &cb)
+{
+   if (!cb) {
+      return false;
+   }
+   const auto current = now_();
+   {
+      std::unique_lock<std::mutex> lock(state_->mutex);
+      auto &entry = state_->entries[nbBlocks];
+      if (entry.valid && (current - entry.updated < state_->ttl)) {
+         state_->stats.hits++;
+         const auto fee = entry.fee;
+         lock.unlock();
+         cb(fee);
+         return true;
+      }
+      entry.waiters.push_back(cb);
+      if (entry.inFlight) {
+         state_->stats.joined++;
+         return true;
+      }
+      state_->stats.misses++;
+      entry.inFlight = true;
+      entry.requested = current;
+   }
+   return send(nbBlocks);
+}
+
+void FeeEstimateCache::refresh()
+{
+   const auto current = now_();
+   std::vector<unsigned int> targets;
+   {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      for (auto &entry : state_->entries) {
+         if (entry.second.inFlight) {
+            continue;
+         }
+         entry.second.inFlight = true;
+         entry.second.requested = current;
+         state_->stats.refreshes++;
+         targets.push_back(entry.first);
+      }
+   }
+   for (const auto nbBlocks : targets) {
+      send(nbBlocks);
+   }
+}
+
+void FeeEstimateCache::setTtl(std::chrono::milliseconds ttl)
+{
+   std::lock_guard<std::mutex> lock(state_->mutex);
+   state_->ttl = ttl;
+}
+
+FeeEstimateCache::Stats FeeEstimateCache::stats() const
+{
+   std::lock_guard<std::mutex> lock(state_->mutex);
+   return state_->stats;
+}
+
+void FeeEstimateCache::logStats() const
+{
+   if (!logger_) {
+      return;
+   }
+   const auto current = stats();
+   const auto requests = current.hits + current.joined + current.misses;
+   const double hitRate = requests ? 100.0 * (current.hits + current.joined) / requests : 0;
+   logger_->info("[FeeEstimateCache::logStats] {} requests: {} hits, {} joined, {} misses ({:.1f}% without"
+      " new estimate), {} refreshes, {} failures; estimate latency mean {} us, p95 {} us, max {} us"
+      , requests, current.hits, current.joined, current.misses, hitRate, current.refreshes
+      , current.failures, current.latency.mean(), current.latency.percentile(0.95), current.latency.max());
+}
+
+bool FeeEstimateCache::send(unsigned int nbBlocks)
+{
+   const std::weak_ptr<State> weakState = state_;
+   const auto sent = estimate_(nbBlocks, [weakState, logger = logger_, now = now_, nbBlocks](float fee) {
+      const auto state = weakState.lock();
+      if (state) {
+         onEstimate(state, logger, now(), nbBlocks, fee);
+      }
+   });
+   if (sent) {
+      return true;
+   }
+   if (logger_) {
+      logger_->error("[FeeEstimateCache::send] failed to request fee estimate for {} blocks", nbBlocks);
+   }
+
+   std::vector<FeeCb> waiters;
+   bool valid = false;
+   float fee = 0;
+   {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      auto &entry = state_->entries[nbBlocks];
+      entry.inFlight = false;
+      state_->stats.failures++;
+      waiters.swap(entry.waiters);
+      valid = entry.valid;
+      fee = entry.fee;
+   }
+   if (!valid) {
+      return false;
+   }
+   for (const auto &cb : waiters) {
+      cb(fee);
+   }
+   return true;
+}
+
+void FeeEstimateCache::onEstimate(const std::shared_ptr<State> &state, const std::shared_ptr<spdlog::logger> &logger
+   , Clock::time_point received, unsigned int nbBlocks, float fee)
+{
+   std::vector<FeeCb> waiters;
+   float result = fee;
+   {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      auto &entry = state->entries[nbBlocks];
+      if (entry.inFlight) {
+         entry.inFlight = false;
+         state->stats.latency.add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            received - entry.requested).count()));
+      }
+      if (fee > 0) {
+         entry.fee = fee;
+         entry.valid = true;
+         entry.updated = received;
+      }
+      else {
+         state->stats.failures++;
+         if (entry.valid) {
+            result = entry.fee;
+         }
+      }
+      waiters.swap(entry.waiters);
+   }
+   if ((fee <= 0) && logger) {
+      logger->warn("[FeeEstimateCache::onEstimate] invalid fee estimate {} for {} blocks", fee, nbBlocks);
+   }
+   for (const auto &cb : waiters) {
+      cb(result);
+   }
+}
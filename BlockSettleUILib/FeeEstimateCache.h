@@ -0,0 +1,103 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef FEE_ESTIMATE_CACHE_H
+#define FEE_ESTIMATE_CACHE_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "LatencyHistogram.h"
+
+namespace spdlog {
+   class logger;
+}
+
+// Fee estimates keyed by confirmation target (in blocks). A value younger
+// than TTL is returned at once, concurrent requests for the same target
+// share one estimate request. refresh() (called on new block) re-requests
+// all known targets in background while old values are still served.
+// Non-positive estimate is not cached - waiters get the last known value
+// instead if there is one. Waiters of a request which could not be sent get
+// the last known value, too, or are dropped.
+// Thread-safe, callbacks are invoked either from the caller's thread (cached
+// value) or from the thread delivering the estimate.
+class FeeEstimateCache
+{
+public:
+   using FeeCb = std::function<void(float fee)>;
+   // Returns false if request could not be sent
+   using EstimateFunc = std::function<bool(unsigned int nbBlocks, const FeeCb &)>;
+   using Clock = std::chrono::steady_clock;
+   using NowFunc = std::function<Clock::time_point()>;
+
+   struct Stats
+   {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      // requests which waited for estimate already in flight
+      uint64_t joined = 0;
+      uint64_t refreshes = 0;
+      uint64_t failures = 0;
+      // estimate request round trips
+      LatencyHistogram  latency;
+   };
+
+   static const std::chrono::milliseconds kDefaultTtl;
+
+   FeeEstimateCache(const EstimateFunc &, const std::shared_ptr<spdlog::logger> &logger = nullptr
+      , std::chrono::milliseconds ttl = kDefaultTtl, const NowFunc &now = {});
+
+   FeeEstimateCache(const FeeEstimateCache &) = delete;
+   FeeEstimateCache &operator=(const FeeEstimateCache &) = delete;
+
+   // Returns false if estimate could not be requested and callback won't be invoked
+   bool get(unsigned int nbBlocks, const FeeCb &);
+   void refresh();
+
+   void setTtl(std::chrono::milliseconds);
+   Stats stats() const;
+   void logStats() const;
+
+private:
+   struct Entry
+   {
+      float             fee = 0;
+      bool              valid = false;
+      Clock::time_point updated;
+      bool              inFlight = false;
+      Clock::time_point requested;
+      std::vector<FeeCb>   waiters;
+   };
+
+   // estimates could arrive after the cache is destroyed
+   struct State
+   {
+      std::mutex  mutex;
+      std::chrono::milliseconds  ttl;
+      std::map<unsigned int, Entry> entries;
+      Stats       stats;
+   };
+
+   bool send(unsigned int nbBlocks);
+   static void onEstimate(const std::shared_ptr<State> &, const std::shared_ptr<spdlog::logger> &
+      , Clock::time_point received, unsigned int nbBlocks, float fee);
+
+private:
+   const EstimateFunc   estimate_;
+   std::shared_ptr<spdlog::logger>  logger_;
+   const NowFunc        now_;
+   std::shared_ptr<State>  state_;
+};
+
+#endif // FEE_ESTIMATE_CACHE_H
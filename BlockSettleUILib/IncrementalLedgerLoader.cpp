@@ -0,0 +1,134 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "IncrementalLedgerLoader.h"
+
+
+LedgerDelegatePageSource::LedgerDelegatePageSource(const std::shared_ptr<AsyncClient::LedgerDelegate> &delegate)
+   : delegate_(delegate)
+{}
+
+void LedgerDelegatePageSource::getPageCount(const PageCountCb &cb)
+{
+   delegate_->getPageCount([cb](ReturnMessage<uint64_t> pageCnt) {
+      uint64_t count = 0;
+      try {
+         count = pageCnt.get();
+      }
+      catch (const std::exception &) {
+         cb(false, 0);
+         return;
+      }
+      cb(true, count);
+   });
+}
+
+void LedgerDelegatePageSource::getHistoryPage(uint32_t pageId, const PageCb &cb)
+{
+   delegate_->getHistoryPage(pageId, [cb](ReturnMessage<std::vector<ClientClasses::LedgerEntry>> entries) {
+      std::vector<bs::TXEntry> result;
+      try {
+         result = bs::TXEntry::fromLedgerEntries(entries.get());
+      }
+      catch (const std::exception &) {
+         cb(false, {});
+         return;
+      }
+      cb(true, std::move(result));
+   });
+}
+
+
+struct IncrementalLedgerLoader::State
+{
+   std::shared_ptr<LedgerPageSource>   source;
+   unsigned int   knownTop;
+   uint64_t       pageCount;
+   std::vector<bs::TXEntry>   entries;
+   ResultCb       cb;
+};
+
+void IncrementalLedgerLoader::load(const std::shared_ptr<LedgerPageSource> &source
+   , unsigned int knownTop, unsigned int newTop, unsigned int branchHgt, const ResultCb &cb)
+{
+   if (isReorg(knownTop, newTop, branchHgt)) {
+      cb(Result::Reorg, {}, 0);
+      return;
+   }
+   auto state = std::make_shared<State>();
+   state->source = source;
+   state->knownTop = knownTop;
+   state->pageCount = 0;
+   state->cb = cb;
+
+   source->getPageCount([state](bool ok, uint64_t pageCount) {
+      if (!ok) {
+         state->cb(Result::Failed, {}, 0);
+         return;
+      }
+      if (pageCount == 0) {
+         state->cb(Result::Loaded, {}, 0);
+         return;
+      }
+      state->pageCount = pageCount;
+      loadPage(state, 0);
+   });
+}
+
+void IncrementalLedgerLoader::loadPage(const std::shared_ptr<State> &state, uint32_t pageId)
+{
+   state->source->getHistoryPage(pageId, [state, pageId](bool ok, std::vector<bs::TXEntry> entries) {
+      if (!ok) {
+         state->cb(Result::Failed, {}, pageId);
+         return;
+      }
+      bool reachedKnown = false;
+      for (auto &entry : entries) {
+         if ((entry.blockNum != UINT32_MAX) && (entry.blockNum <= state->knownTop)) {
+            reachedKnown = true;
+         }
+         state->entries.push_back(std::move(entry));
+      }
+      if (reachedKnown || (pageId + 1 >= state->pageCount)) {
+         state->cb(Result::Loaded, std::move(state->entries), pageId + 1);
+         return;
+      }
+      loadPage(state, pageId + 1);
+   });
+}
+
+bool IncrementalLedgerLoader::isReorg(unsigned int knownTop, unsigned int newTop, unsigned int branchHgt)
+{
+   // top not moving up or branch point below it means some known blocks are gone
+   return (newTop <= knownTop) || ((branchHgt != 0) && (branchHgt < knownTop));
+}
+
+bool IncrementalLedgerLoader::isReorg(const std::vector<bs::TXEntry> &entries, const KnownBlockFunc &knownBlock)
+{
+   for (const auto &entry : entries) {
+      uint32_t blockNum = 0;
+      if (!knownBlock(entry, blockNum)) {
+         continue;
+      }
+      // unconfirmed entry could be mined since then, but mined one never moves
+      if ((blockNum != UINT32_MAX) && (blockNum != entry.blockNum)) {
+         return true;
+      }
+   }
+   return false;
+}
+
+int IncrementalLedgerLoader::confirmations(unsigned int topBlock, uint32_t blockNum)
+{
+   if ((blockNum == UINT32_MAX) || (blockNum > topBlock)) {
+      return 0;
+   }
+   return static_cast<int>(topBlock - blockNum + 1);
+}
@@ -0,0 +1,77 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef INCREMENTAL_LEDGER_LOADER_H
+#define INCREMENTAL_LEDGER_LOADER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ArmoryConnection.h"
+#include "AsyncClient.h"
+
+// Ledger history pages, page 0 holds the newest entries
+class LedgerPageSource
+{
+public:
+   using PageCountCb = std::function<void(bool, uint64_t)>;
+   using PageCb = std::function<void(bool, std::vector<bs::TXEntry>)>;
+
+   virtual ~LedgerPageSource() = default;
+
+   virtual void getPageCount(const PageCountCb &) = 0;
+   virtual void getHistoryPage(uint32_t pageId, const PageCb &) = 0;
+};
+
+class LedgerDelegatePageSource : public LedgerPageSource
+{
+public:
+   LedgerDelegatePageSource(const std::shared_ptr<AsyncClient::LedgerDelegate> &);
+
+   void getPageCount(const PageCountCb &) override;
+   void getHistoryPage(uint32_t pageId, const PageCb &) override;
+
+private:
+   std::shared_ptr<AsyncClient::LedgerDelegate> delegate_;
+};
+
+// Loads only ledger entries which appeared since the known top block. As
+// pages go from newest to oldest, loading stops at the first page reaching
+// entries at or below known top. Reorg is detected either from new block
+// notification or when already loaded entry is found in a different block -
+// caller should reload everything then.
+class IncrementalLedgerLoader
+{
+public:
+   enum class Result
+   {
+      Loaded,
+      Reorg,
+      Failed
+   };
+   using ResultCb = std::function<void(Result, std::vector<bs::TXEntry> entries, uint32_t pagesLoaded)>;
+   // Returns false if entry was not loaded before, block otherwise
+   using KnownBlockFunc = std::function<bool(const bs::TXEntry &, uint32_t &blockNum)>;
+
+   // Callback is invoked once from the page source thread
+   static void load(const std::shared_ptr<LedgerPageSource> &, unsigned int knownTop
+      , unsigned int newTop, unsigned int branchHgt, const ResultCb &);
+
+   static bool isReorg(unsigned int knownTop, unsigned int newTop, unsigned int branchHgt);
+   static bool isReorg(const std::vector<bs::TXEntry> &, const KnownBlockFunc &);
+
+   static int confirmations(unsigned int topBlock, uint32_t blockNum);
+
+private:
+   struct State;
+   static void loadPage(const std::shared_ptr<State> &, uint32_t pageId);
+};
+
+#endif // INCREMENTAL_LEDGER_LOADER_H
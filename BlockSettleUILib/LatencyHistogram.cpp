@@ -0,0 +1,83 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+void LatencyHistogram::add(uint64_t us)
+{
+   ++buckets_[bucketFor(us)];
+   min_ = count_ ? std::min(min_, us) : us;
+   max_ = std::max(max_, us);
+   sum_ += us;
+   ++count_;
+}
+
+void LatencyHistogram::clear()
+{
+   *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const
+{
+   if (!count_) {
+      return 0;
+   }
+   quantile = std::min(std::max(quantile, 0.0), 1.0);
+   const auto rank = std::max<uint64_t>(1
+      , static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count_))));
+
+   uint64_t seen = 0;
+   for (std::size_t i = 0; i < kBucketCount; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+         return std::min(bucketUpperBound(i), max_);
+      }
+   }
+   return max_;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket)
+{
+   if (bucket >= kBucketCount - 1) {
+      return std::numeric_limits<uint64_t>::max();
+   }
+   return (uint64_t(1) << bucket);
+}
+
+std::size_t LatencyHistogram::bucketFor(uint64_t us)
+{
+   if (us <= 1) {
+      return 0;
+   }
+   std::size_t bucket = 0;
+   for (auto v = us - 1; v; v >>= 1) {
+      ++bucket;
+   }
+   return std::min(bucket, kBucketCount - 1);
+}
+
+std::string LatencyHistogram::toCsv(const std::string &name) const
+{
+   std::string result;
+   for (std::size_t i = 0; i < kBucketCount; ++i) {
+      if (!buckets_[i]) {
+         continue;
+      }
+      result += name + ",";
+      result += (i == kBucketCount - 1) ? std::string("inf") : std::to_string(bucketUpperBound(i));
+      result += "," + std::to_string(buckets_[i]) + "\n";
+   }
+   return result;
+}
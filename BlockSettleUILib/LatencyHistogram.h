@@ -0,0 +1,52 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Fixed-size histogram of latencies in microseconds.
+// Bucket 0 holds values up to 1us, bucket i (i > 0) holds (2^(i-1), 2^i] us,
+// the last bucket collects everything above.
+class LatencyHistogram
+{
+public:
+   static constexpr std::size_t kBucketCount = 34;
+
+   void add(uint64_t us);
+   void clear();
+
+   uint64_t count() const { return count_; }
+   uint64_t min() const { return count_ ? min_ : 0; }
+   uint64_t max() const { return max_; }
+   uint64_t mean() const { return count_ ? (sum_ / count_) : 0; }
+
+   // Upper bound of the bucket containing given quantile (0..1), clamped to max()
+   uint64_t percentile(double quantile) const;
+
+   uint64_t bucketValue(std::size_t bucket) const { return buckets_[bucket]; }
+   static uint64_t bucketUpperBound(std::size_t bucket);
+   static std::size_t bucketFor(uint64_t us);
+
+   // Lines of "<name>,<upper bound us>,<count>" for non-empty buckets
+   std::string toCsv(const std::string &name) const;
+
+private:
+   std::array<uint64_t, kBucketCount>  buckets_{};
+   uint64_t count_ = 0;
+   uint64_t sum_ = 0;
+   uint64_t min_ = 0;
+   uint64_t max_ = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,515 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "OhlcCandleCache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <spdlog/logger.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+   // File layout (host byte order):
+   //   header:  magic, version, interval, reserved (uint32 each),
+   //            coverage from, to, firstInDb (int64 each), 16 reserved bytes,
+   //            checksum of the preceding bytes (uint64)
+   //   records: timestamp (int64), open, high, low, close, volume (double),
+   //            checksum of the preceding bytes (uint64)
+   const uint32_t kMagic = 0x434c4842;   // "BHLC"
+   const uint32_t kVersion = 1;
+   const qint64 kHeaderSize = 64;
+   const qint64 kRecordDataSize = 48;
+   const qint64 kRecordSize = kRecordDataSize + 8;
+   const char *kFileSuffix = "ohlc";
+
+   // opened files are kept open only for a few last products
+   const std::size_t kMaxOpenStores = 8;
+
+   uint64_t checksum(const uchar *data, std::size_t size)
+   {  // FNV-1a
+      uint64_t hash = 14695981039346656037ULL;
+      for (std::size_t i = 0; i < size; ++i) {
+         hash ^= data[i];
+         hash *= 1099511628211ULL;
+      }
+      return hash;
+   }
+
+   template <typename T>
+   T readValue(const uchar *data)
+   {
+      T value;
+      std::memcpy(&value, data, sizeof(T));
+      return value;
+   }
+
+   template <typename T>
+   void writeValue(uchar *data, T value)
+   {
+      std::memcpy(data, &value, sizeof(T));
+   }
+}
+
+
+class OhlcCandleCache::Store
+{
+public:
+   Store(const QString &path, int interval, const std::shared_ptr<spdlog::logger> &logger)
+      : file_(path)
+      , interval_(interval)
+      , logger_(logger)
+   {}
+
+   ~Store() noexcept
+   {
+      unmap();
+   }
+
+   bool open();
+   void reset();
+   bool append(const std::vector<Candle> &, const Coverage &);
+   void touch();
+
+   const Coverage &coverage() const { return coverage_; }
+   std::size_t count() const { return index_.size(); }
+   uint64_t fileSize() const { return static_cast<uint64_t>(file_.size()); }
+   QString path() const { return file_.fileName(); }
+
+   // Position of the first candle not older than timestamp
+   std::size_t lowerBound(int64_t timestamp) const
+   {
+      return static_cast<std::size_t>(std::lower_bound(index_.begin(), index_.end()
+         , std::make_pair(timestamp, uint32_t(0))) - index_.begin());
+   }
+
+   Candle candle(std::size_t pos) const
+   {
+      const uchar *data = map_ + kHeaderSize + static_cast<qint64>(index_[pos].second) * kRecordSize;
+      Candle result;
+      result.timestamp = readValue<int64_t>(data);
+      result.open = readValue<double>(data + 8);
+      result.high = readValue<double>(data + 16);
+      result.low = readValue<double>(data + 24);
+      result.close = readValue<double>(data + 32);
+      result.volume = readValue<double>(data + 40);
+      return result;
+   }
+
+   uint64_t lastUse_ = 0;
+
+private:
+   bool writeHeader();
+   bool map();
+   void unmap();
+   bool contains(int64_t timestamp) const
+   {
+      const auto pos = lowerBound(timestamp);
+      return (pos < index_.size()) && (index_[pos].first == timestamp);
+   }
+
+private:
+   QFile    file_;
+   const int   interval_;
+   std::shared_ptr<spdlog::logger>  logger_;
+   uchar    *map_ = nullptr;
+   Coverage coverage_;
+   // (timestamp, record number) sorted by timestamp
+   std::vector<std::pair<int64_t, uint32_t>> index_;
+};
+
+bool OhlcCandleCache::Store::open()
+{
+   if (!file_.open(QIODevice::ReadWrite)) {
+      if (logger_) {
+         logger_->error("[OhlcCandleCache::Store::open] failed to open {}: {}"
+            , file_.fileName().toStdString(), file_.errorString().toStdString());
+      }
+      return false;
+   }
+   if (file_.size() < kHeaderSize) {
+      reset();
+      return map_ != nullptr;
+   }
+   if (!map()) {
+      return false;
+   }
+
+   if ((readValue<uint32_t>(map_) != kMagic) || (readValue<uint32_t>(map_ + 4) != kVersion)
+      || (readValue<uint32_t>(map_ + 8) != static_cast<uint32_t>(interval_))
+      || (readValue<uint64_t>(map_ + kHeaderSize - 8) != checksum(map_, kHeaderSize - 8))) {
+      if (logger_) {
+         logger_->warn("[OhlcCandleCache::Store::open] invalid header in {} - dropping cached data"
+            , file_.fileName().toStdString());
+      }
+      reset();
+      return map_ != nullptr;
+   }
+   coverage_.from = readValue<int64_t>(map_ + 16);
+   coverage_.to = readValue<int64_t>(map_ + 24);
+   coverage_.firstInDb = readValue<int64_t>(map_ + 32);
+
+   const qint64 nbRecords = (file_.size() - kHeaderSize) / kRecordSize;
+   index_.reserve(static_cast<std::size_t>(nbRecords));
+   for (qint64 i = 0; i < nbRecords; ++i) {
+      const uchar *record = map_ + kHeaderSize + i * kRecordSize;
+      if (readValue<uint64_t>(record + kRecordDataSize) != checksum(record, kRecordDataSize)) {
+         // candle inside coverage could be lost
+         if (logger_) {
+            logger_->warn("[OhlcCandleCache::Store::open] damaged record #{} in {} - dropping cached data"
+               , i, file_.fileName().toStdString());
+         }
+         reset();
+         return map_ != nullptr;
+      }
+      index_.emplace_back(readValue<int64_t>(record), static_cast<uint32_t>(i));
+   }
+
+   // interrupted append leaves partial record at the end, header is written
+   // after records, so coverage doesn't depend on it
+   const qint64 validSize = kHeaderSize + nbRecords * kRecordSize;
+   if (validSize != file_.size()) {
+      if (logger_) {
+         logger_->warn("[OhlcCandleCache::Store::open] {} incomplete bytes at the end of {}"
+            , file_.size() - validSize, file_.fileName().toStdString());
+      }
+      unmap();
+      file_.resize(validSize);
+      if (!map()) {
+         return false;
+      }
+   }
+
+   std::sort(index_.begin(), index_.end());
+   // keep the last written record of the same candle
+   std::vector<std::pair<int64_t, uint32_t>> unique;
+   unique.reserve(index_.size());
+   for (const auto &entry : index_) {
+      if (!unique.empty() && (unique.back().first == entry.first)) {
+         unique.back() = entry;
+      }
+      else {
+         unique.push_back(entry);
+      }
+   }
+   index_.swap(unique);
+   return true;
+}
+
+void OhlcCandleCache::Store::reset()
+{
+   unmap();
+   index_.clear();
+   coverage_ = {};
+   file_.resize(0);
+   if (writeHeader()) {
+      map();
+   }
+}
+
+bool OhlcCandleCache::Store::append(const std::vector<Candle> &candles, const Coverage &coverage)
+{
+   std::vector<uchar> buffer;
+   buffer.reserve(candles.size() * kRecordSize);
+   std::vector<std::pair<int64_t, uint32_t>> added;
+   uint32_t recordNo = static_cast<uint32_t>((file_.size() - kHeaderSize) / kRecordSize);
+
+   for (const auto &candle : candles) {
+      if (contains(candle.timestamp)) {
+         continue;
+      }
+      const auto offset = buffer.size();
+      buffer.resize(offset + kRecordSize);
+      uchar *record = buffer.data() + offset;
+      writeValue(record, candle.timestamp);
+      writeValue(record + 8, candle.open);
+      writeValue(record + 16, candle.high);
+      writeValue(record + 24, candle.low);
+      writeValue(record + 32, candle.close);
+      writeValue(record + 40, candle.volume);
+      writeValue(record + kRecordDataSize, checksum(record, kRecordDataSize));
+      added.emplace_back(candle.timestamp, recordNo++);
+   }
+
+   unmap();
+   // records go first - if header update is lost they just stay outside coverage
+   if (!buffer.empty()) {
+      if (!file_.seek(file_.size())
+         || (file_.write(reinterpret_cast<const char *>(buffer.data()), static_cast<qint64>(buffer.size()))
+            != static_cast<qint64>(buffer.size()))
+         || !file_.flush()) {
+         if (logger_) {
+            logger_->error("[OhlcCandleCache::Store::append] failed to write {}: {}"
+               , file_.fileName().toStdString(), file_.errorString().toStdString());
+         }
+         map();
+         return false;
+      }
+   }
+   coverage_ = coverage;
+   const bool result = writeHeader();
+   if (!map()) {
+      return false;
+   }
+
+   std::sort(added.begin(), added.end());
+   added.erase(std::unique(added.begin(), added.end()
+      , [](const std::pair<int64_t, uint32_t> &a, const std::pair<int64_t, uint32_t> &b) {
+      return a.first == b.first;
+   }), added.end());
+   const auto mid = index_.size();
+   index_.insert(index_.end(), added.begin(), added.end());
+   std::inplace_merge(index_.begin(), index_.begin() + static_cast<std::ptrdiff_t>(mid), index_.end());
+   return result;
+}
+
+void OhlcCandleCache::Store::touch()
+{
+   file_.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+}
+
+bool OhlcCandleCache::Store::writeHeader()
+{
+   uchar header[kHeaderSize] = {};
+   writeValue(header, kMagic);
+   writeValue(header + 4, kVersion);
+   writeValue(header + 8, static_cast<uint32_t>(interval_));
+   writeValue(header + 16, coverage_.from);
+   writeValue(header + 24, coverage_.to);
+   writeValue(header + 32, coverage_.firstInDb);
+   writeValue(header + kHeaderSize - 8, checksum(header, kHeaderSize - 8));
+
+   if (!file_.seek(0) || (file_.write(reinterpret_cast<const char *>(header), kHeaderSize) != kHeaderSize)
+      || !file_.flush()) {
+      if (logger_) {
+         logger_->error("[OhlcCandleCache::Store::writeHeader] failed to write {}: {}"
+            , file_.fileName().toStdString(), file_.errorString().toStdString());
+      }
+      return false;
+   }
+   return true;
+}
+
+bool OhlcCandleCache::Store::map()
+{
+   map_ = file_.map(0, file_.size());
+   if (!map_ && logger_) {
+      logger_->error("[OhlcCandleCache::Store::map] failed to map {}: {}"
+         , file_.fileName().toStdString(), file_.errorString().toStdString());
+   }
+   return map_ != nullptr;
+}
+
+void OhlcCandleCache::Store::unmap()
+{
+   if (map_) {
+      file_.unmap(map_);
+      map_ = nullptr;
+   }
+}
+
+
+OhlcCandleCache::OhlcCandleCache(const QString &dir, uint64_t maxSize
+   , const std::shared_ptr<spdlog::logger> &logger)
+   : dir_(dir)
+   , maxSize_(maxSize)
+   , logger_(logger)
+{
+   QDir().mkpath(dir_);
+}
+
+OhlcCandleCache::~OhlcCandleCache() noexcept = default;
+
+QString OhlcCandleCache::fileName(const std::string &product, int interval) const
+{
+   // product names contain '/' and could contain anything else
+   return QDir(dir_).filePath(QStringLiteral("%1_%2.%3")
+      .arg(QString::fromLatin1(QByteArray::fromStdString(product).toHex()))
+      .arg(interval).arg(QLatin1String(kFileSuffix)));
+}
+
+OhlcCandleCache::Store *OhlcCandleCache::open(const std::string &product, int interval)
+{
+   const auto path = fileName(product, interval);
+   auto it = stores_.find(path);
+   if (it == stores_.end()) {
+      if (stores_.size() >= kMaxOpenStores) {
+         const auto itOldest = std::min_element(stores_.begin(), stores_.end()
+            , [](const decltype(stores_)::value_type &a, const decltype(stores_)::value_type &b) {
+            return a.second->lastUse_ < b.second->lastUse_;
+         });
+         stores_.erase(itOldest);
+      }
+      auto store = std::unique_ptr<Store>(new Store(path, interval, logger_));
+      if (!store->open()) {
+         return nullptr;
+      }
+      it = stores_.emplace(path, std::move(store)).first;
+   }
+   if (it->second->lastUse_ != useCounter_) {
+      it->second->lastUse_ = ++useCounter_;
+      it->second->touch();
+   }
+   return it->second.get();
+}
+
+OhlcCandleCache::Coverage OhlcCandleCache::coverage(const std::string &product, int interval)
+{
+   const auto store = open(product, interval);
+   return store ? store->coverage() : Coverage{};
+}
+
+std::vector<OhlcCandleCache::Candle> OhlcCandleCache::newest(const std::string &product
+   , int interval, std::size_t count)
+{
+   const auto store = open(product, interval);
+   if (!store || store->coverage().empty()) {
+      return {};
+   }
+   return before(product, interval, store->coverage().to + 1, count);
+}
+
+std::vector<OhlcCandleCache::Candle> OhlcCandleCache::before(const std::string &product
+   , int interval, int64_t timestamp, std::size_t count)
+{
+   const auto store = open(product, interval);
+   if (!store) {
+      return {};
+   }
+   const auto &coverage = store->coverage();
+   if (coverage.empty() || (timestamp <= coverage.from) || (timestamp > coverage.to + 1)) {
+      return {};
+   }
+
+   std::vector<Candle> result;
+   const auto first = store->lowerBound(coverage.from);
+   auto pos = store->lowerBound(timestamp);
+   while ((pos > first) && (result.size() < count)) {
+      result.push_back(store->candle(--pos));
+   }
+   return result;
+}
+
+void OhlcCandleCache::store(const std::string &product, int interval
+   , const std::vector<Candle> &candles, int64_t from, int64_t to, int64_t firstInDb)
+{
+   if (to < from) {
+      return;
+   }
+   const auto store = open(product, interval);
+   if (!store) {
+      return;
+   }
+
+   Coverage coverage{ from, to, firstInDb };
+   const auto &prev = store->coverage();
+   if (!prev.empty() && (from <= prev.to + 1) && (to + 1 >= prev.from)) {
+      coverage.from = std::min(from, prev.from);
+      coverage.to = std::max(to, prev.to);
+      if (!firstInDb) {
+         coverage.firstInDb = prev.firstInDb;
+      }
+   }
+   else if (store->count() > 0) {
+      // there is a hole between old and new candles
+      store->reset();
+   }
+
+   std::vector<Candle> inRange;
+   inRange.reserve(candles.size());
+   for (const auto &candle : candles) {
+      if ((candle.timestamp >= from) && (candle.timestamp <= to)) {
+         inRange.push_back(candle);
+      }
+   }
+   store->append(inRange, coverage);
+
+   if (totalSize() > maxSize_) {
+      evict(store);
+   }
+}
+
+void OhlcCandleCache::storeResponse(const std::string &product, int interval
+   , const std::vector<Candle> &candles, int requested, int64_t to, int64_t firstInDb)
+{
+   int64_t from = std::numeric_limits<int64_t>::max();
+   for (const auto &candle : candles) {
+      from = std::min(from, candle.timestamp);
+   }
+   if (candles.size() < static_cast<std::size_t>(requested)) {
+      from = std::min(from, firstInDb);
+   }
+   store(product, interval, candles, from, to, firstInDb);
+}
+
+int OhlcCandleCache::headRequestCount(const Coverage &coverage, int64_t now, int64_t intervalWidth, int limit)
+{
+   if (coverage.empty() || (intervalWidth <= 0)) {
+      return limit;
+   }
+   const auto gap = (now - coverage.to) / intervalWidth;
+   return static_cast<int>(std::min<int64_t>(limit, std::max<int64_t>(gap, 0) + 2));
+}
+
+void OhlcCandleCache::clear()
+{
+   stores_.clear();
+   for (const auto &fileInfo : QDir(dir_).entryInfoList({ QStringLiteral("*.%1").arg(QLatin1String(kFileSuffix)) }
+      , QDir::Files)) {
+      QFile::remove(fileInfo.absoluteFilePath());
+   }
+}
+
+uint64_t OhlcCandleCache::totalSize() const
+{
+   uint64_t result = 0;
+   for (const auto &fileInfo : QDir(dir_).entryInfoList({ QStringLiteral("*.%1").arg(QLatin1String(kFileSuffix)) }
+      , QDir::Files)) {
+      result += static_cast<uint64_t>(fileInfo.size());
+   }
+   return result;
+}
+
+void OhlcCandleCache::evict(Store *keep)
+{
+   auto files = QDir(dir_).entryInfoList({ QStringLiteral("*.%1").arg(QLatin1String(kFileSuffix)) }
+      , QDir::Files, QDir::Time | QDir::Reversed);
+   uint64_t total = 0;
+   for (const auto &fileInfo : files) {
+      total += static_cast<uint64_t>(fileInfo.size());
+   }
+
+   const auto keepPath = QFileInfo(keep->path()).absoluteFilePath();
+   for (const auto &fileInfo : files) {
+      if (total <= maxSize_) {
+         break;
+      }
+      const auto path = fileInfo.absoluteFilePath();
+      if (path == keepPath) {
+         continue;
+      }
+      stores_.erase(QDir(dir_).filePath(fileInfo.fileName()));
+      if (QFile::remove(path)) {
+         total -= static_cast<uint64_t>(fileInfo.size());
+         if (logger_) {
+            logger_->debug("[OhlcCandleCache::evict] removed {}", path.toStdString());
+         }
+      }
+   }
+
+   // the only file left doesn't fit alone
+   if (total > maxSize_) {
+      keep->reset();
+   }
+}
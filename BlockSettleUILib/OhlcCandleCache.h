@@ -0,0 +1,106 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef OHLC_CANDLE_CACHE_H
+#define OHLC_CANDLE_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <QString>
+
+namespace spdlog {
+   class logger;
+}
+
+// Local cache of MDHS candle history, one file per (product, interval).
+// Files are append-only logs of checksummed candle records which are read
+// through memory mapping. Header keeps the span of timestamps for which the
+// cache is known to hold everything the server has, only candles inside it
+// are returned. Incomplete record at the end is cut off on open, damaged
+// header or record drops the file. Least recently used files are removed
+// when total size exceeds the cap.
+class OhlcCandleCache
+{
+public:
+   struct Candle
+   {
+      int64_t  timestamp;  // ms, start of the candle
+      double   open;
+      double   high;
+      double   low;
+      double   close;
+      double   volume;
+   };
+
+   struct Coverage
+   {
+      int64_t  from = 0;
+      int64_t  to = -1;
+      int64_t  firstInDb = 0;
+
+      bool empty() const { return to < from; }
+   };
+
+   static constexpr uint64_t kDefaultMaxSize = 32 * 1024 * 1024;
+
+   OhlcCandleCache(const QString &dir, uint64_t maxSize = kDefaultMaxSize
+      , const std::shared_ptr<spdlog::logger> &logger = nullptr);
+   ~OhlcCandleCache() noexcept;
+
+   OhlcCandleCache(const OhlcCandleCache&) = delete;
+   OhlcCandleCache& operator = (const OhlcCandleCache&) = delete;
+
+   Coverage coverage(const std::string &product, int interval);
+
+   // Both return candles newest first, as MDHS does.
+   // Up to count newest cached candles
+   std::vector<Candle> newest(const std::string &product, int interval, std::size_t count);
+   // Up to count candles older than timestamp, which should be inside coverage
+   std::vector<Candle> before(const std::string &product, int interval
+      , int64_t timestamp, std::size_t count);
+
+   // Candles are all server has in [from, to]. They extend cached span if it
+   // overlaps or touches, otherwise replace it. Candles outside are ignored.
+   void store(const std::string &product, int interval, const std::vector<Candle> &
+      , int64_t from, int64_t to, int64_t firstInDb);
+   // Stores MDHS answer to request for up to requested candles before to:
+   // short answer means there is nothing older on server
+   void storeResponse(const std::string &product, int interval, const std::vector<Candle> &
+      , int requested, int64_t to, int64_t firstInDb);
+
+   // How many newest candles to request when the cache covers up to coverage.to
+   static int headRequestCount(const Coverage &, int64_t now, int64_t intervalWidth, int limit);
+
+   void clear();
+
+   uint64_t totalSize() const;
+   uint64_t maxSize() const { return maxSize_; }
+   void setMaxSize(uint64_t maxSize) { maxSize_ = maxSize; }
+
+   QString fileName(const std::string &product, int interval) const;
+
+private:
+   class Store;
+
+   Store *open(const std::string &product, int interval);
+   void evict(Store *keep);
+
+private:
+   const QString  dir_;
+   uint64_t       maxSize_;
+   std::shared_ptr<spdlog::logger>  logger_;
+   std::map<QString, std::unique_ptr<Store>> stores_;
+   uint64_t       useCounter_ = 0;
+};
+
+#endif // OHLC_CANDLE_CACHE_H
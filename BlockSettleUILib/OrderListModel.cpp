@@ -447,106 +447,60 @@ OrderListModel::StatusGroup::Type OrderListModel::getStatusGroup(const bs::netwo
    return StatusGroup::last;
 }
 
-std::pair<OrderListModel::Group*, int> OrderListModel::findItem(const bs::network::Order &order)
+bool OrderListModel::isShownBefore(const Data &left, const Data &right)
 {
-   const auto itGroups = groups_.find(order.exchOrderId.toStdString());
-   const auto assetGrpName = tr(bs::network::Asset::toString(order.assetType));
-   StatusGroup *sg = nullptr;
-
-   if (itGroups != groups_.end()) {
-      sg = (itGroups->second == StatusGroup::UnSettled ? unsettled_.get() : settled_.get());
-
-      auto it = std::find_if(sg->rows_.cbegin(), sg->rows_.cend(),
-         [assetGrpName] (const std::unique_ptr<Market> & m) { return (m->name_ == assetGrpName); });
-
-      if (it != sg->rows_.cend()) {
-         auto git = std::find_if((*it)->rows_.cbegin(), (*it)->rows_.cend(),
-            [&order] (const std::unique_ptr<Group> &g)
-               { return (order.security == g->security_.toStdString()); } );
-
-         if (git != (*it)->rows_.cend()) {
-            auto dit = std::find_if((*git)->rows_.cbegin(), (*git)->rows_.cend(),
-               [&order] (const std::unique_ptr<Data> &d) { return (d->id_ == order.exchOrderId); });
-
-            if (dit != (*git)->rows_.cend()) {
-               return std::make_pair(git->get(),
-                  static_cast<int>(std::distance((*git)->rows_.cbegin(), dit)));
-            } else {
-               return std::make_pair(git->get(), -1);
-            }
-         } else {
-            return std::make_pair(nullptr, -1);
-         }
-      } else {
-         return std::make_pair(nullptr, -1);
-      }
+   if (left.timestamp_ != right.timestamp_) {
+      return (left.timestamp_ > right.timestamp_);
    }
+   return (left.key_ < right.key_);
+}
 
-   sg = (getStatusGroup(order) == StatusGroup::UnSettled ? unsettled_.get() : settled_.get());
-
-   auto it = std::find_if(sg->rows_.cbegin(), sg->rows_.cend(),
-      [assetGrpName] (const std::unique_ptr<Market> & g) { return (g->name_ == assetGrpName); });
-
-   if (it != sg->rows_.cend()) {
-      auto git = std::find_if((*it)->rows_.cbegin(), (*it)->rows_.cend(),
-         [&order] (const std::unique_ptr<Group> &g)
-            { return (order.security == g->security_.toStdString()); } );
+int OrderListModel::findRow(Group *group, const Data *data) const
+{
+   const auto it = std::lower_bound(group->rows_.cbegin(), group->rows_.cend(), data,
+      [] (const std::unique_ptr<Data> &d, const Data *value) { return isShownBefore(*d, *value); });
 
-      if (git != (*it)->rows_.cend()) {
-         return std::make_pair(git->get(), -1);
-      } else {
-         return std::make_pair(nullptr, -1);
-      }
+   if ((it != group->rows_.cend()) && (it->get() == data)) {
+      return static_cast<int>(std::distance(group->rows_.cbegin(), it));
    } else {
-      return std::make_pair(nullptr, -1);
+      return -1;
    }
 }
 
-void OrderListModel::removeRowIfContainerChanged(const bs::network::Order &order,
-   int &oldOrderRow)
+void OrderListModel::removeOrder(uint64_t id)
 {
-   // Remove row if container (settled/unsettled) changed.
-   auto git = groups_.find(order.exchOrderId.toStdString());
-
-   if (git != groups_.end() && git->second != getStatusGroup(order) && oldOrderRow >= 0) {
-      StatusGroup *tmpsg = (git->second == StatusGroup::UnSettled ? unsettled_.get() :
-         settled_.get());
-
-      const auto assetGrpName = tr(bs::network::Asset::toString(order.assetType));
-
-      auto mit = std::find_if(tmpsg->rows_.cbegin(), tmpsg->rows_.cend(),
-         [assetGrpName] (const std::unique_ptr<Market> & m) { return (m->name_ == assetGrpName); });
-
-      if (mit != tmpsg->rows_.cend()) {
-         auto git = std::find_if((*mit)->rows_.cbegin(), (*mit)->rows_.cend(),
-            [&order] (const std::unique_ptr<Group> &g)
-               { return (order.security == g->security_.toStdString()); });
-
-         if (git != (*mit)->rows_.cend()) {
-            const auto groupRow = findGroup(mit->get(), git->get());
-            const auto didx = createIndex(groupRow, 0, &(*git)->idx_);
+   const auto itOrder = orders_.find(id);
+   if (itOrder == orders_.end()) {
+      return;
+   }
+   const auto data = itOrder->second;
+   orders_.erase(itOrder);
+
+   auto group = static_cast<Group*>(data->idx_.parent_->data_);
+   auto market = static_cast<Market*>(group->idx_.parent_->data_);
+   auto sg = static_cast<StatusGroup*>(market->idx_.parent_->data_);
+   const auto row = findRow(group, data);
+   if (row < 0) {
+      return;
+   }
 
-            beginRemoveRows(didx, oldOrderRow, oldOrderRow);
-            (*git)->rows_.erase((*git)->rows_.begin() + oldOrderRow);
-            oldOrderRow = -1;
-            endRemoveRows();
+   const auto groupRow = findGroup(market, group);
+   beginRemoveRows(createIndex(groupRow, 0, &group->idx_), row, row);
+   group->rows_.erase(group->rows_.begin() + row);
+   endRemoveRows();
 
-            const auto marketRow = findMarket(tmpsg, mit->get());
+   const auto marketRow = findMarket(sg, market);
 
-            if (!(*git)->rows_.size()) {
-               beginRemoveRows(createIndex(marketRow, 0, &(*mit)->idx_),
-                  groupRow, groupRow);
-               (*mit)->rows_.erase(git);
-               endRemoveRows();
-            }
+   if (group->rows_.empty()) {
+      beginRemoveRows(createIndex(marketRow, 0, &market->idx_), groupRow, groupRow);
+      market->rows_.erase(market->rows_.begin() + groupRow);
+      endRemoveRows();
+   }
 
-            if (!(*mit)->rows_.size()) {
-               beginRemoveRows(createIndex(tmpsg->row_, 0, &tmpsg->idx_), marketRow, marketRow);
-               tmpsg->rows_.erase(mit);
-               endRemoveRows();
-            }
-         }
-      }
+   if (market->rows_.empty()) {
+      beginRemoveRows(createIndex(sg->row_, 0, &sg->idx_), marketRow, marketRow);
+      sg->rows_.erase(sg->rows_.begin() + marketRow);
+      endRemoveRows();
    }
 }
 
@@ -610,7 +564,8 @@ void OrderListModel::createGroupsIfNeeded(const bs::network::Order &order, Marke
 void OrderListModel::reset()
 {
    beginResetModel();
-   groups_.clear();
+   snapshot_.clear();
+   orders_.clear();
    unsettled_ = std::make_unique<StatusGroup>(StatusGroup::toString(StatusGroup::UnSettled), 0);
    settled_ = std::make_unique<StatusGroup>(StatusGroup::toString(StatusGroup::Settled), 1);
    endResetModel();
@@ -620,12 +575,14 @@ void OrderListModel::processUpdateOrders(const Blocksettle::Communication::Proxy
 {
    // Save latest selected index first
    resetLatestChangedStatus(message);
-   // OrderListModel supposed to work correctly when orders states updated one by one.
-   // We don't use this anymore (server sends all active orders every time) so just clear old caches.
-   // Remove this if old behavior is needed
-   reset();
-   // Use some fake orderId so old code works correctly
-   int orderId = 0;
+
+   // Server sends all active orders every time, only the difference with
+   // previous snapshot is applied to the tree
+   std::vector<bs::network::Order> orders;
+   std::vector<OrderSnapshotDiff::Entry> snapshot;
+   orders.reserve(static_cast<std::size_t>(message.orders_size()));
+   snapshot.reserve(static_cast<std::size_t>(message.orders_size()));
+   OrderSnapshotDiff::IdMaker makeId(static_cast<std::size_t>(message.orders_size()));
 
    for (const auto &data : message.orders()) {
       bs::network::Order order;
@@ -656,8 +613,6 @@ void OrderListModel::processUpdateOrders(const Blocksettle::Communication::Proxy
          order.assetType = bs::network::Asset::SpotFX;
       }
 
-      orderId += 1;
-      order.exchOrderId = QString::number(orderId);
       order.side = bs::network::Side::Type(data.side());
       order.pendingStatus = data.status_text();
       order.dateTime = QDateTime::fromMSecsSinceEpoch(data.timestamp_ms());
@@ -666,8 +621,40 @@ void OrderListModel::processUpdateOrders(const Blocksettle::Communication::Proxy
       order.security = data.product() + "/" + data.product_against();
       order.price = data.price();
 
-      onOrderUpdated(order);
+      // Orders have no ID in the message, so it's made of fields which don't change
+      const auto securityHash = OrderSnapshotDiff::hash(order.security);
+      auto idHash = OrderSnapshotDiff::hashCombine(static_cast<uint64_t>(data.timestamp_ms()), securityHash);
+      idHash = OrderSnapshotDiff::hashCombine(idHash, static_cast<uint64_t>(data.side()));
+      idHash = OrderSnapshotDiff::hashCombine(idHash, OrderSnapshotDiff::hash(order.quantity));
+      idHash = OrderSnapshotDiff::hashCombine(idHash, OrderSnapshotDiff::hash(order.price));
+      const auto id = makeId(idHash);
+      order.exchOrderId = QString::number(id);
+
+      const auto container = OrderSnapshotDiff::hashCombine(OrderSnapshotDiff::hashCombine(
+         static_cast<uint64_t>(getStatusGroup(order)), static_cast<uint64_t>(order.assetType)), securityHash);
+      const auto state = OrderSnapshotDiff::hashCombine(static_cast<uint64_t>(order.status)
+         , OrderSnapshotDiff::hash(order.pendingStatus));
+      snapshot.push_back({ id, container, state });
+      orders.push_back(std::move(order));
+   }
+
+   const auto diff = OrderSnapshotDiff::compute(snapshot_, snapshot);
+
+   for (const auto i : diff.removed) {
+      removeOrder(snapshot_[i].id);
+   }
+   for (const auto &move : diff.moved) {
+      removeOrder(snapshot_[move.first].id);
+      insertOrder(orders[move.second]);
+   }
+   for (const auto i : diff.updated) {
+      updateOrder(orders[i]);
+   }
+   for (const auto i : diff.inserted) {
+      insertOrder(orders[i]);
    }
+
+   snapshot_ = std::move(snapshot);
 }
 
 void OrderListModel::resetLatestChangedStatus(const Blocksettle::Communication::ProxyTerminalPb::Response_UpdateOrders &message)
@@ -700,48 +687,61 @@ void OrderListModel::resetLatestChangedStatus(const Blocksettle::Communication::
    sortedPeviousOrderStatuses_ = std::move(newOrderStatuses);
 }
 
-void OrderListModel::onOrderUpdated(const bs::network::Order& order)
+void OrderListModel::insertOrder(const bs::network::Order& order)
 {
-   auto found = findItem(order);
-
    Group *groupItem = nullptr;
    Market *marketItem = nullptr;
 
-   removeRowIfContainerChanged(order, found.second);
-
    findMarketAndGroup(order, marketItem, groupItem);
 
    createGroupsIfNeeded(order, marketItem, groupItem);
 
-   groups_[order.exchOrderId.toStdString()] = getStatusGroup(order);
-
    const auto parentIndex = createIndex(findGroup(marketItem, groupItem), 0, &groupItem->idx_);
 
-   if (found.second < 0) {
-      beginInsertRows(parentIndex, 0, 0);
+   // As quantity is now could be negative need to invert value
+   double value = - order.quantity * order.price;
+   if (order.security.substr(0, order.security.find('/')) != order.product) {
+      value = order.quantity / order.price;
+   }
 
-      // As quantity is now could be negative need to invert value
-      double value = - order.quantity * order.price;
-      if (order.security.substr(0, order.security.find('/')) != order.product) {
-         value = order.quantity / order.price;
-      }
+   auto data = make_unique<Data>(
+      UiUtils::displayTimeMs(order.dateTime),
+      QString::fromStdString(order.product),
+      tr(bs::network::Side::toString(order.side)),
+      UiUtils::displayQty(order.quantity, order.security, order.product, order.assetType),
+      UiUtils::displayPriceForAssetType(order.price, order.assetType),
+      UiUtils::displayValue(value, order.security, order.product, order.assetType),
+      QString(),
+      order.exchOrderId,
+      &groupItem->idx_);
+   data->timestamp_ = order.dateTime.toMSecsSinceEpoch();
+   data->key_ = order.exchOrderId.toULongLong();
+   orders_[data->key_] = data.get();
 
-      groupItem->rows_.push_front(make_unique<Data>(
-         UiUtils::displayTimeMs(order.dateTime),
-         QString::fromStdString(order.product),
-         tr(bs::network::Side::toString(order.side)),
-         UiUtils::displayQty(order.quantity, order.security, order.product, order.assetType),
-         UiUtils::displayPriceForAssetType(order.price, order.assetType),
-         UiUtils::displayValue(value, order.security, order.product, order.assetType),
-         QString(),
-         order.exchOrderId,
-         &groupItem->idx_));
+   const auto it = std::lower_bound(groupItem->rows_.begin(), groupItem->rows_.end(), data,
+      [] (const std::unique_ptr<Data> &d, const std::unique_ptr<Data> &value) { return isShownBefore(*d, *value); });
+   const auto row = static_cast<int>(std::distance(groupItem->rows_.begin(), it));
 
-      setOrderStatus(groupItem, 0, order);
+   beginInsertRows(parentIndex, row, row);
 
-      endInsertRows();
+   groupItem->rows_.insert(it, std::move(data));
+
+   setOrderStatus(groupItem, row, order);
+
+   endInsertRows();
+}
+
+void OrderListModel::updateOrder(const bs::network::Order& order)
+{
+   const auto itOrder = orders_.find(order.exchOrderId.toULongLong());
+   if (itOrder == orders_.end()) {
+      insertOrder(order);
+      return;
    }
-   else {
-      setOrderStatus(groupItem, found.second, order, true);
+   auto group = static_cast<Group*>(itOrder->second->idx_.parent_->data_);
+   const auto row = findRow(group, itOrder->second);
+   if (row < 0) {
+      return;
    }
+   setOrderStatus(group, row, order, true);
 }
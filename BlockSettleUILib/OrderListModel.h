@@ -16,8 +16,10 @@
 #include <QColor>
 
 #include "CommonTypes.h"
+#include "OrderSnapshotDiff.h"
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <deque>
 
@@ -101,6 +103,8 @@ private:
       QString id_;
       QColor statusColor_;
       IndexHelper idx_;
+      int64_t timestamp_{};
+      uint64_t key_{};
 
       Data(const QString &time, const QString &prod,
          const QString &side, const QString &quantity, const QString &price,
@@ -171,13 +175,17 @@ private:
 
    static StatusGroup::Type getStatusGroup(const bs::network::Order &);
 
-   void onOrderUpdated(const bs::network::Order &);
+   // Rows of group are sorted by time, most recent first
+   static bool isShownBefore(const Data &, const Data &);
+
+   void insertOrder(const bs::network::Order &);
+   void updateOrder(const bs::network::Order &);
+   void removeOrder(uint64_t id);
    int findGroup(Market *market, Group *group) const;
    int findMarket(StatusGroup *statusGroup, Market *market) const;
-   std::pair<Group*, int> findItem(const bs::network::Order &order);
+   int findRow(Group *group, const Data *data) const;
    void setOrderStatus(Group *group, int index, const bs::network::Order& order,
       bool emitUpdate = false);
-   void removeRowIfContainerChanged(const bs::network::Order &order, int &oldOrderRow);
    void findMarketAndGroup(const bs::network::Order &order, Market *&market, Group *&group);
    void createGroupsIfNeeded(const bs::network::Order &order, Market *&market, Group *&group);
 
@@ -186,7 +194,9 @@ private:
    void resetLatestChangedStatus(const Blocksettle::Communication::ProxyTerminalPb::Response_UpdateOrders &message);
 
    std::shared_ptr<AssetManager>    assetManager_;
-   std::unordered_map<std::string, StatusGroup::Type> groups_;
+   // latest snapshot and its orders in the tree by ID
+   std::vector<OrderSnapshotDiff::Entry> snapshot_;
+   std::unordered_map<uint64_t, Data*> orders_;
    std::unique_ptr<StatusGroup> unsettled_;
    std::unique_ptr<StatusGroup> settled_;
    QDateTime latestOrderTimestamp_;
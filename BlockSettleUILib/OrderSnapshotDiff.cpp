@@ -0,0 +1,83 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "OrderSnapshotDiff.h"
+
+#include <cstring>
+#include <unordered_map>
+
+
+OrderSnapshotDiff::IdMaker::IdMaker(size_t expectedCount)
+{
+   used_.reserve(expectedCount);
+}
+
+uint64_t OrderSnapshotDiff::IdMaker::operator()(uint64_t fieldsHash)
+{
+   auto id = fieldsHash;
+   while (!used_.insert(id).second) {
+      ++id;
+   }
+   return id;
+}
+
+uint64_t OrderSnapshotDiff::hashCombine(uint64_t seed, uint64_t value)
+{
+   // 64-bit version of boost::hash_combine
+   return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+uint64_t OrderSnapshotDiff::hash(const std::string &value)
+{
+   return static_cast<uint64_t>(std::hash<std::string>()(value));
+}
+
+uint64_t OrderSnapshotDiff::hash(double value)
+{
+   uint64_t result = 0;
+   static_assert(sizeof(result) == sizeof(value), "unexpected double size");
+   std::memcpy(&result, &value, sizeof(result));
+   return result;
+}
+
+OrderSnapshotDiff::Result OrderSnapshotDiff::compute(const std::vector<Entry> &oldSnapshot
+   , const std::vector<Entry> &newSnapshot)
+{
+   Result result;
+   std::unordered_map<uint64_t, size_t> oldIndices;
+   oldIndices.reserve(oldSnapshot.size());
+   for (size_t i = 0; i < oldSnapshot.size(); ++i) {
+      oldIndices.emplace(oldSnapshot[i].id, i);
+   }
+
+   std::vector<bool> kept(oldSnapshot.size(), false);
+   for (size_t i = 0; i < newSnapshot.size(); ++i) {
+      const auto &entry = newSnapshot[i];
+      const auto it = oldIndices.find(entry.id);
+      if ((it == oldIndices.end()) || kept[it->second]) {
+         result.inserted.push_back(i);
+         continue;
+      }
+      kept[it->second] = true;
+      const auto &oldEntry = oldSnapshot[it->second];
+      if (oldEntry.container != entry.container) {
+         result.moved.push_back({ it->second, i });
+      }
+      else if (oldEntry.state != entry.state) {
+         result.updated.push_back(i);
+      }
+   }
+   for (size_t i = 0; i < oldSnapshot.size(); ++i) {
+      if (!kept[i]) {
+         result.removed.push_back(i);
+      }
+   }
+   return result;
+}
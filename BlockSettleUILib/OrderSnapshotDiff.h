@@ -0,0 +1,71 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef ORDER_SNAPSHOT_DIFF_H
+#define ORDER_SNAPSHOT_DIFF_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Difference between two full snapshots of orders list. Each order is shown
+// in some container (status group, market and product group in
+// OrderListModel) and could move to other one when its status changes.
+class OrderSnapshotDiff
+{
+public:
+   // Fields are hashes, so that 50k orders snapshot could be compared in a
+   // few milliseconds
+   struct Entry
+   {
+      // unique in snapshot
+      uint64_t id;
+      uint64_t container;
+      // of all displayed fields which could change
+      uint64_t state;
+   };
+
+   // Indices of orders in old or new snapshot
+   struct Result
+   {
+      std::vector<size_t>  removed;
+      // old and new index of orders moved to other container
+      std::vector<std::pair<size_t, size_t>> moved;
+      // in the same container with other state
+      std::vector<size_t>  updated;
+      std::vector<size_t>  inserted;
+
+      bool empty() const { return removed.empty() && moved.empty() && updated.empty() && inserted.empty(); }
+   };
+
+   // Makes IDs of orders in one snapshot from hash of their fields which
+   // don't change during order lifetime. Orders with the same fields get
+   // the next unused values in order of appearance.
+   class IdMaker
+   {
+   public:
+      explicit IdMaker(size_t expectedCount = 0);
+
+      uint64_t operator()(uint64_t fieldsHash);
+
+   private:
+      std::unordered_set<uint64_t>  used_;
+   };
+
+   static uint64_t hashCombine(uint64_t seed, uint64_t value);
+   static uint64_t hash(const std::string &);
+   static uint64_t hash(double);
+
+   static Result compute(const std::vector<Entry> &oldSnapshot, const std::vector<Entry> &newSnapshot);
+};
+
+#endif // ORDER_SNAPSHOT_DIFF_H
@@ -85,6 +85,7 @@ void PortfolioWidget::SetTransactionsModel(const std::shared_ptr<TransactionsVie
       , Qt::SortOrder::DescendingOrder);
    ui_->treeViewUnconfirmedTransactions->hideColumn(
       static_cast<int>(TransactionsViewModel::Columns::TxHash));
+   trackVisibleRows(ui_->treeViewUnconfirmedTransactions);
 }
 
 void PortfolioWidget::init(const std::shared_ptr<ApplicationSettings> &appSettings
@@ -0,0 +1,71 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "ReplotScheduler.h"
+
+#include <algorithm>
+
+#include "CustomControls/qcustomplot.h"
+
+
+ReplotScheduler::ReplotScheduler(QCustomPlot *plot, QObject *parent)
+   : QObject(parent)
+   , plot_(plot)
+{
+   timer_.setSingleShot(true);
+   connect(&timer_, &QTimer::timeout, this, &ReplotScheduler::onTimeout);
+
+   connect(plot_, &QCustomPlot::beforeReplot, this, [this] {
+      frameTimer_.start();
+   });
+   connect(plot_, &QCustomPlot::afterReplot, this, [this] {
+      if (frameTimer_.isValid()) {
+         frameTimes_.add(static_cast<uint64_t>(frameTimer_.nsecsElapsed() / 1000));
+      }
+      ++replots_;
+      sinceReplot_.start();
+   });
+}
+
+void ReplotScheduler::request()
+{
+   ++requests_;
+   if (timer_.isActive()) {
+      return;
+   }
+   // the first request after a quiet period is queued to the next event loop
+   // iteration, requests made until then are served by the same replot
+   const qint64 frameMs = 1000 / maxFrameRate_;
+   const qint64 elapsed = sinceReplot_.isValid() ? sinceReplot_.elapsed() : frameMs;
+   timer_.start(static_cast<int>(std::max<qint64>(frameMs - elapsed, 0)));
+}
+
+void ReplotScheduler::replotNow()
+{
+   timer_.stop();
+   plot_->replot();
+}
+
+void ReplotScheduler::setMaxFrameRate(int fps)
+{
+   maxFrameRate_ = std::max(fps, 1);
+}
+
+void ReplotScheduler::resetStats()
+{
+   requests_ = 0;
+   replots_ = 0;
+   frameTimes_.clear();
+}
+
+void ReplotScheduler::onTimeout()
+{
+   plot_->replot();
+}
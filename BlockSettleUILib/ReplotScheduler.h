@@ -0,0 +1,62 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef REPLOT_SCHEDULER_H
+#define REPLOT_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include "LatencyHistogram.h"
+
+class QCustomPlot;
+
+// Coalesces replot requests of a plot: any number of request() calls
+// results in at most one replot per frame, which is run from the event loop.
+// Also collects durations of all replots of the plot.
+class ReplotScheduler : public QObject
+{
+   Q_OBJECT
+public:
+   static constexpr int kDefaultMaxFrameRate = 60;
+
+   explicit ReplotScheduler(QCustomPlot *plot, QObject *parent = nullptr);
+   ~ReplotScheduler() noexcept override = default;
+
+   void request();
+   // Replots right away, pending request is dropped
+   void replotNow();
+
+   void setMaxFrameRate(int fps);
+   int maxFrameRate() const { return maxFrameRate_; }
+
+   bool isPending() const { return timer_.isActive(); }
+   uint64_t requests() const { return requests_; }
+   uint64_t replots() const { return replots_; }
+   // Replot durations in microseconds
+   const LatencyHistogram &frameTimes() const { return frameTimes_; }
+   void resetStats();
+
+private:
+   void onTimeout();
+
+private:
+   QCustomPlot    *plot_;
+   QTimer         timer_;
+   QElapsedTimer  sinceReplot_;
+   QElapsedTimer  frameTimer_;
+   int            maxFrameRate_ = kDefaultMaxFrameRate;
+   uint64_t       requests_ = 0;
+   uint64_t       replots_ = 0;
+   LatencyHistogram  frameTimes_;
+};
+
+#endif // REPLOT_SCHEDULER_H
@@ -0,0 +1,101 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef ROW_DIFF_H
+#define ROW_DIFF_H
+
+#include <algorithm>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Changes turning one list of model rows into another, for emitting row
+// signals instead of resetting the model. Rows are matched by key and
+// compared with operator== to find changed ones.
+struct RowDiff
+{
+   // first and last row, inclusive
+   using Range = std::pair<int, int>;
+
+   // Rows present in both lists are in a different order - model should be reset
+   bool  reordered = false;
+   // Rows of the old list, the last range goes first, so that ranges
+   // could be removed one after another
+   std::vector<Range>   removed;
+   // Rows of the new list in ascending order, inserted after removal
+   std::vector<Range>   inserted;
+   // Rows of the new list in ascending order
+   std::vector<Range>   changed;
+
+   bool empty() const { return !reordered && removed.empty() && inserted.empty() && changed.empty(); }
+
+   // Joins sorted row numbers into ranges of adjacent ones
+   static std::vector<Range> ranges(const std::vector<int> &rows)
+   {
+      std::vector<Range> result;
+      for (const auto row : rows) {
+         if (!result.empty() && (result.back().second + 1 == row)) {
+            result.back().second = row;
+         }
+         else {
+            result.push_back({ row, row });
+         }
+      }
+      return result;
+   }
+
+   template <typename Row, typename KeyFunc>
+   static RowDiff compute(const std::vector<Row> &oldRows, const std::vector<Row> &newRows, const KeyFunc &key)
+   {
+      using Key = typename std::decay<decltype(key(std::declval<const Row &>()))>::type;
+      RowDiff result;
+
+      std::map<Key, int> newRowByKey;
+      for (int i = 0; i < static_cast<int>(newRows.size()); ++i) {
+         newRowByKey.emplace(key(newRows[i]), i);
+      }
+
+      // old row of each new one, -1 if it's new
+      std::vector<int> oldRowOf(newRows.size(), -1);
+      std::vector<int> removedRows;
+      int lastKept = -1;
+      for (int i = 0; i < static_cast<int>(oldRows.size()); ++i) {
+         const auto it = newRowByKey.find(key(oldRows[i]));
+         if ((it == newRowByKey.end()) || (oldRowOf[it->second] >= 0)) {
+            removedRows.push_back(i);
+            continue;
+         }
+         if (it->second < lastKept) {
+            result.reordered = true;
+            return result;
+         }
+         lastKept = it->second;
+         oldRowOf[it->second] = i;
+      }
+      result.removed = ranges(removedRows);
+      std::reverse(result.removed.begin(), result.removed.end());
+
+      std::vector<int> insertedRows, changedRows;
+      for (int i = 0; i < static_cast<int>(newRows.size()); ++i) {
+         if (oldRowOf[i] < 0) {
+            insertedRows.push_back(i);
+         }
+         else if (!(oldRows[oldRowOf[i]] == newRows[i])) {
+            changedRows.push_back(i);
+         }
+      }
+      result.inserted = ranges(insertedRows);
+      result.changed = ranges(changedRows);
+      return result;
+   }
+};
+
+#endif // ROW_DIFF_H
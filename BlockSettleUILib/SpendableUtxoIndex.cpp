@@ -0,0 +1,304 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "SpendableUtxoIndex.h"
+
+#include <algorithm>
+
+using namespace bs;
+
+
+SpendableUtxoIndex::Delta SpendableUtxoIndex::setLeaf(const std::string &hdWalletId, const std::string &leafId
+   , bs::hd::Purpose purpose, const std::vector<UTXO> &utxos, const std::vector<UTXO> &zcUtxos)
+{
+   std::map<UTXO, UtxoType> newUtxos;
+   for (const auto &utxo : utxos) {
+      newUtxos[utxo] = UtxoType::Normal;
+   }
+   for (const auto &utxo : zcUtxos) {
+      newUtxos[utxo] = UtxoType::Zc;
+   }
+
+   Delta delta;
+   auto itLeaf = leaves_.find(leafId);
+   if (itLeaf == leaves_.end()) {
+      delta.newLeaf = true;
+      itLeaf = leaves_.emplace(leafId, Leaf{ hdWalletId, purpose, {} }).first;
+   }
+   auto &leaf = itLeaf->second;
+   if ((leaf.hdWalletId != hdWalletId) || (leaf.purpose != purpose)) {
+      for (const auto &utxo : leaf.utxos) {
+         remove(leaf, utxo.first, utxo.second);
+      }
+      delta.removed += leaf.utxos.size();
+      leaf.utxos.clear();
+      leaf.hdWalletId = hdWalletId;
+      leaf.purpose = purpose;
+   }
+
+   for (auto itOld = leaf.utxos.begin(); itOld != leaf.utxos.end(); ) {
+      const auto itNew = newUtxos.find(itOld->first);
+      if ((itNew == newUtxos.end()) || (itNew->second != itOld->second)) {
+         remove(leaf, itOld->first, itOld->second);
+         itOld = leaf.utxos.erase(itOld);
+         delta.removed++;
+      }
+      else {
+         ++itOld;
+      }
+   }
+   for (const auto &utxo : newUtxos) {
+      if (leaf.utxos.find(utxo.first) == leaf.utxos.end()) {
+         add(leafId, leaf, utxo.first, utxo.second);
+         delta.added++;
+      }
+   }
+   return delta;
+}
+
+std::string SpendableUtxoIndex::removeLeaf(const std::string &leafId)
+{
+   const auto itLeaf = leaves_.find(leafId);
+   if (itLeaf == leaves_.end()) {
+      return {};
+   }
+   for (const auto &utxo : itLeaf->second.utxos) {
+      remove(itLeaf->second, utxo.first, utxo.second);
+   }
+   const auto hdWalletId = itLeaf->second.hdWalletId;
+   leaves_.erase(itLeaf);
+   return hdWalletId;
+}
+
+std::vector<std::string> SpendableUtxoIndex::removeWallet(const std::string &hdWalletId)
+{
+   std::vector<std::string> leafIds;
+   for (const auto &leaf : leaves_) {
+      if (leaf.second.hdWalletId == hdWalletId) {
+         leafIds.push_back(leaf.first);
+      }
+   }
+   for (const auto &leafId : leafIds) {
+      removeLeaf(leafId);
+   }
+   wallets_.erase(hdWalletId);
+   return leafIds;
+}
+
+void SpendableUtxoIndex::clear()
+{
+   wallets_.clear();
+   leaves_.clear();
+   locations_.clear();
+}
+
+bool SpendableUtxoIndex::hasWallet(const std::string &hdWalletId) const
+{
+   return (wallets_.find(hdWalletId) != wallets_.end());
+}
+
+bool SpendableUtxoIndex::hasLeaf(const std::string &leafId) const
+{
+   return (leaves_.find(leafId) != leaves_.end());
+}
+
+void SpendableUtxoIndex::reserve(const std::vector<UTXO> &utxos)
+{
+   for (const auto &utxo : utxos) {
+      if (++reserved_[utxo] > 1) {
+         continue;
+      }
+      const auto itLoc = locations_.find(utxo);
+      if (itLoc == locations_.end()) {
+         continue;
+      }
+      const auto &leaf = leaves_.at(itLoc->second.leafId);
+      group(leaf, leaf.utxos.at(utxo))->reservedSum += utxo.getValue();
+   }
+}
+
+void SpendableUtxoIndex::unreserve(const std::vector<UTXO> &utxos)
+{
+   for (const auto &utxo : utxos) {
+      const auto itReserved = reserved_.find(utxo);
+      if (itReserved == reserved_.end()) {
+         continue;
+      }
+      if (--itReserved->second > 0) {
+         continue;
+      }
+      reserved_.erase(itReserved);
+      const auto itLoc = locations_.find(utxo);
+      if (itLoc == locations_.end()) {
+         continue;
+      }
+      const auto &leaf = leaves_.at(itLoc->second.leafId);
+      group(leaf, leaf.utxos.at(utxo))->reservedSum -= utxo.getValue();
+   }
+}
+
+bool SpendableUtxoIndex::isReserved(const UTXO &utxo) const
+{
+   return (reserved_.find(utxo) != reserved_.end());
+}
+
+template <typename F>
+void SpendableUtxoIndex::forEachGroup(const std::string &hdWalletId, bool includeZc, const F &f) const
+{
+   const auto itWallet = wallets_.find(hdWalletId);
+   if (itWallet == wallets_.end()) {
+      return;
+   }
+   for (const auto &group : itWallet->second) {
+      if (includeZc || (group.first.second == UtxoType::Normal)) {
+         f(group.second);
+      }
+   }
+}
+
+std::vector<UTXO> SpendableUtxoIndex::available(const std::string &hdWalletId, bool includeZc) const
+{
+   std::vector<UTXO> result;
+   forEachGroup(hdWalletId, includeZc, [this, &result](const Group &group) {
+      for (const auto &utxo : group.utxos) {
+         if (!isReserved(utxo)) {
+            result.push_back(utxo);
+         }
+      }
+   });
+   // same order as before, coin selection results should not depend on update history
+   std::sort(result.begin(), result.end());
+   return result;
+}
+
+std::vector<UTXO> SpendableUtxoIndex::available(const std::string &hdWalletId, bs::hd::Purpose purpose
+   , bool includeZc) const
+{
+   std::vector<UTXO> result;
+   for (const auto type : { UtxoType::Normal, UtxoType::Zc }) {
+      if ((type == UtxoType::Zc) && !includeZc) {
+         continue;
+      }
+      const auto g = group(hdWalletId, purpose, type);
+      if (!g) {
+         continue;
+      }
+      for (const auto &utxo : g->utxos) {
+         if (!isReserved(utxo)) {
+            result.push_back(utxo);
+         }
+      }
+   }
+   std::sort(result.begin(), result.end());
+   return result;
+}
+
+uint64_t SpendableUtxoIndex::availableSum(const std::string &hdWalletId, bool includeZc) const
+{
+   uint64_t result = 0;
+   forEachGroup(hdWalletId, includeZc, [&result](const Group &group) {
+      result += group.sum - group.reservedSum;
+   });
+   return result;
+}
+
+uint64_t SpendableUtxoIndex::availableSum(const std::string &hdWalletId, bs::hd::Purpose purpose
+   , bool includeZc) const
+{
+   uint64_t result = 0;
+   for (const auto type : { UtxoType::Normal, UtxoType::Zc }) {
+      if ((type == UtxoType::Zc) && !includeZc) {
+         continue;
+      }
+      const auto g = group(hdWalletId, purpose, type);
+      if (g) {
+         result += g->sum - g->reservedSum;
+      }
+   }
+   return result;
+}
+
+const std::vector<UTXO> &SpendableUtxoIndex::utxos(const std::string &hdWalletId, bs::hd::Purpose purpose
+   , UtxoType type) const
+{
+   static const std::vector<UTXO> empty;
+   const auto g = group(hdWalletId, purpose, type);
+   return g ? g->utxos : empty;
+}
+
+std::string SpendableUtxoIndex::leafOf(const UTXO &utxo) const
+{
+   const auto itLoc = locations_.find(utxo);
+   if (itLoc == locations_.end()) {
+      return {};
+   }
+   return itLoc->second.leafId;
+}
+
+void SpendableUtxoIndex::add(const std::string &leafId, Leaf &leaf, const UTXO &utxo, UtxoType type)
+{
+   const auto itLoc = locations_.find(utxo);
+   if (itLoc != locations_.end()) {
+      // the same output reported by other leaf - the last one wins
+      auto &other = leaves_.at(itLoc->second.leafId);
+      const auto itOther = other.utxos.find(utxo);
+      remove(other, utxo, itOther->second);
+      other.utxos.erase(itOther);
+   }
+
+   leaf.utxos[utxo] = type;
+   auto g = group(leaf, type);
+   locations_[utxo] = Location{ leafId, g->utxos.size() };
+   g->utxos.push_back(utxo);
+   g->sum += utxo.getValue();
+   if (isReserved(utxo)) {
+      g->reservedSum += utxo.getValue();
+   }
+}
+
+void SpendableUtxoIndex::remove(Leaf &leaf, const UTXO &utxo, UtxoType type)
+{
+   const auto itLoc = locations_.find(utxo);
+   if (itLoc == locations_.end()) {
+      return;
+   }
+   auto g = group(leaf, type);
+   const auto pos = itLoc->second.pos;
+   if (pos + 1 < g->utxos.size()) {
+      g->utxos[pos] = g->utxos.back();
+      locations_.at(g->utxos[pos]).pos = pos;
+   }
+   g->utxos.pop_back();
+   locations_.erase(itLoc);
+
+   g->sum -= utxo.getValue();
+   if (isReserved(utxo)) {
+      g->reservedSum -= utxo.getValue();
+   }
+}
+
+SpendableUtxoIndex::Group *SpendableUtxoIndex::group(const Leaf &leaf, UtxoType type)
+{
+   return &wallets_[leaf.hdWalletId][GroupKey{ leaf.purpose, type }];
+}
+
+const SpendableUtxoIndex::Group *SpendableUtxoIndex::group(const std::string &hdWalletId
+   , bs::hd::Purpose purpose, UtxoType type) const
+{
+   const auto itWallet = wallets_.find(hdWalletId);
+   if (itWallet == wallets_.end()) {
+      return nullptr;
+   }
+   const auto itGroup = itWallet->second.find(GroupKey{ purpose, type });
+   if (itGroup == itWallet->second.end()) {
+      return nullptr;
+   }
+   return &itGroup->second;
+}
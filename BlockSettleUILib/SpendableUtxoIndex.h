@@ -0,0 +1,120 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef SPENDABLE_UTXO_INDEX_H
+#define SPENDABLE_UTXO_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HDPath.h"
+#include "TxClasses.h"
+
+namespace bs {
+
+   // Spendable XBT outputs of HD wallets, grouped by leaf purpose and by
+   // confirmed/ZC state. Leaves are updated one at a time and only the
+   // difference with their previous outputs is applied, so a balance change
+   // of one leaf doesn't touch the others. Sums of each group are kept
+   // up to date, reserved outputs are tracked to be excluded from the
+   // available ones.
+   // Not thread-safe.
+   class SpendableUtxoIndex
+   {
+   public:
+      enum class UtxoType {
+         Normal,
+         Zc,
+      };
+
+      struct Delta
+      {
+         size_t   added = 0;
+         size_t   removed = 0;
+         // leaf was not set before
+         bool     newLeaf = false;
+
+         bool changed() const { return newLeaf || added || removed; }
+      };
+
+      // Replaces outputs of the leaf, output present in both lists is ZC
+      Delta setLeaf(const std::string &hdWalletId, const std::string &leafId, bs::hd::Purpose
+         , const std::vector<UTXO> &utxos, const std::vector<UTXO> &zcUtxos);
+      // Returns HD wallet ID of the removed leaf (empty if it was not set)
+      std::string removeLeaf(const std::string &leafId);
+      // Returns IDs of the removed leaves
+      std::vector<std::string> removeWallet(const std::string &hdWalletId);
+      // Reservations are kept
+      void clear();
+
+      bool hasWallet(const std::string &hdWalletId) const;
+      bool hasLeaf(const std::string &leafId) const;
+
+      // Could be called for outputs not added yet; each reserve() of an output
+      // should be matched by unreserve()
+      void reserve(const std::vector<UTXO> &);
+      void unreserve(const std::vector<UTXO> &);
+      bool isReserved(const UTXO &) const;
+
+      // Not reserved outputs and their sums
+      std::vector<UTXO> available(const std::string &hdWalletId, bool includeZc) const;
+      std::vector<UTXO> available(const std::string &hdWalletId, bs::hd::Purpose, bool includeZc) const;
+      uint64_t availableSum(const std::string &hdWalletId, bool includeZc) const;
+      uint64_t availableSum(const std::string &hdWalletId, bs::hd::Purpose, bool includeZc) const;
+
+      // All outputs of the group including reserved ones, in no particular order
+      const std::vector<UTXO> &utxos(const std::string &hdWalletId, bs::hd::Purpose, UtxoType) const;
+
+      // Empty if output is not known
+      std::string leafOf(const UTXO &) const;
+
+   private:
+      struct Group
+      {
+         std::vector<UTXO> utxos;
+         uint64_t sum = 0;
+         uint64_t reservedSum = 0;
+      };
+      using GroupKey = std::pair<bs::hd::Purpose, UtxoType>;
+      using Groups = std::map<GroupKey, Group>;
+
+      struct Leaf
+      {
+         std::string       hdWalletId;
+         bs::hd::Purpose   purpose;
+         std::map<UTXO, UtxoType>   utxos;
+      };
+
+      struct Location
+      {
+         std::string leafId;
+         // position in Group::utxos
+         size_t      pos;
+      };
+
+      void add(const std::string &leafId, Leaf &, const UTXO &, UtxoType);
+      void remove(Leaf &, const UTXO &, UtxoType);
+      Group *group(const Leaf &, UtxoType);
+      const Group *group(const std::string &hdWalletId, bs::hd::Purpose, UtxoType) const;
+      template <typename F>
+      void forEachGroup(const std::string &hdWalletId, bool includeZc, const F &) const;
+
+   private:
+      std::unordered_map<std::string, Groups>   wallets_;
+      std::unordered_map<std::string, Leaf>     leaves_;
+      std::map<UTXO, Location>   locations_;
+      std::map<UTXO, unsigned int>  reserved_;
+   };
+
+}  // namespace bs
+
+#endif // SPENDABLE_UTXO_INDEX_H
@@ -0,0 +1,224 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "TimerWheel.h"
+
+#include <limits>
+
+namespace {
+
+   const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+   // slot list heads of all levels go first, then the firing list head
+   const uint32_t kHeads = TimerWheel::kLevels * TimerWheel::kSlots + 1;
+
+} // namespace
+
+
+TimerWheel::TimerWheel(uint64_t currentTick)
+   : freeHead_(kNone)
+   , firingHead_(kHeads - 1)
+   , currentTick_(currentTick)
+{
+   nodes_.resize(kHeads);
+   for (uint32_t i = 0; i < kHeads; ++i) {
+      nodes_[i].prev = i;
+      nodes_[i].next = i;
+      nodes_[i].generation = 0;
+      nodes_[i].level = -1;
+      nodes_[i].tick = 0;
+   }
+}
+
+TimerWheel::Handle TimerWheel::schedule(uint64_t tick, Callback callback)
+{
+   const auto node = allocate();
+   nodes_[node].tick = (tick > currentTick_) ? tick : currentTick_ + 1;
+   nodes_[node].callback = std::move(callback);
+   place(node);
+   ++size_;
+   return (static_cast<Handle>(nodes_[node].generation) << 32) | node;
+}
+
+bool TimerWheel::cancel(Handle h)
+{
+   if (!isPending(h)) {
+      return false;
+   }
+   const auto node = index(h);
+   unlink(node);
+   release(node);
+   --size_;
+   return true;
+}
+
+bool TimerWheel::isPending(Handle h) const
+{
+   const auto node = index(h);
+   return (node >= kHeads) && (node < nodes_.size()) && (generation(h) != 0)
+      && (nodes_[node].generation == generation(h));
+}
+
+size_t TimerWheel::advance(uint64_t tick)
+{
+   size_t fired = 0;
+   while (currentTick_ < tick) {
+      const auto distance = nextEventDistance();
+      if ((distance == 0) || (distance > tick - currentTick_)) {
+         // nothing due and no cascade until then
+         currentTick_ = tick;
+         break;
+      }
+      currentTick_ += distance;
+
+      if (slotOf(0, currentTick_) == 0) {
+         int top = 1;
+         while ((top + 1 < kLevels) && (slotOf(top, currentTick_) == 0)) {
+            ++top;
+         }
+         for (int level = top; level >= 1; --level) {
+            cascade(level);
+         }
+      }
+      fired += fireSlot();
+   }
+   return fired;
+}
+
+uint64_t TimerWheel::nextEventDistance() const
+{
+   const auto current = slotOf(0, currentTick_);
+   if (levelSizes_[0] > 0) {
+      for (auto slot = current + 1; slot < kSlots; ++slot) {
+         if (!isEmptyList(slotHead(0, slot))) {
+            return slot - current;
+         }
+      }
+   }
+   // lower levels are empty, so their cascades could be skipped
+   for (int level = 1; level < kLevels; ++level) {
+      if (levelSizes_[level] > 0) {
+         const uint64_t span = uint64_t(1) << (level * kSlotBits);
+         return span - (currentTick_ & (span - 1));
+      }
+   }
+   return 0;
+}
+
+uint32_t TimerWheel::allocate()
+{
+   if (freeHead_ != kNone) {
+      const auto node = freeHead_;
+      freeHead_ = nodes_[node].next;
+      return node;
+   }
+   Node node;
+   node.prev = kNone;
+   node.next = kNone;
+   node.generation = 1;
+   node.level = -1;
+   node.tick = 0;
+   nodes_.push_back(std::move(node));
+   return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::release(uint32_t node)
+{
+   auto &n = nodes_[node];
+   n.callback = nullptr;
+   n.level = -1;
+   if (++n.generation == 0) {
+      n.generation = 1;
+   }
+   n.prev = kNone;
+   n.next = freeHead_;
+   freeHead_ = node;
+}
+
+void TimerWheel::link(uint32_t head, uint32_t node)
+{
+   const auto last = nodes_[head].prev;
+   nodes_[node].prev = last;
+   nodes_[node].next = head;
+   nodes_[last].next = node;
+   nodes_[head].prev = node;
+}
+
+void TimerWheel::unlink(uint32_t node)
+{
+   auto &n = nodes_[node];
+   nodes_[n.prev].next = n.next;
+   nodes_[n.next].prev = n.prev;
+   if (n.level >= 0) {
+      --levelSizes_[n.level];
+   }
+}
+
+void TimerWheel::place(uint32_t node)
+{
+   // the highest differing slot index of deadline and current tick gives the
+   // level, timer is cascaded down when current tick reaches that slot
+   const auto tick = nodes_[node].tick;
+   const auto diff = tick ^ currentTick_;
+   int level = 0;
+   while ((level + 1 < kLevels) && ((diff >> ((level + 1) * kSlotBits)) != 0)) {
+      ++level;
+   }
+   link(slotHead(level, slotOf(level, tick)), node);
+   nodes_[node].level = level;
+   ++levelSizes_[level];
+}
+
+void TimerWheel::cascade(int level)
+{
+   const auto head = slotHead(level, slotOf(level, currentTick_));
+   auto node = nodes_[head].next;
+   // detach the list first, as timers beyond the top level come back to it
+   nodes_[head].prev = head;
+   nodes_[head].next = head;
+   while (node != head) {
+      const auto next = nodes_[node].next;
+      --levelSizes_[level];
+      place(node);
+      node = next;
+   }
+}
+
+size_t TimerWheel::fireSlot()
+{
+   const auto head = slotHead(0, slotOf(0, currentTick_));
+   if (isEmptyList(head)) {
+      return 0;
+   }
+   for (auto node = nodes_[head].next; node != head; node = nodes_[node].next) {
+      nodes_[node].level = -1;
+      --levelSizes_[0];
+   }
+   nodes_[firingHead_].next = nodes_[head].next;
+   nodes_[firingHead_].prev = nodes_[head].prev;
+   nodes_[nodes_[firingHead_].next].prev = firingHead_;
+   nodes_[nodes_[firingHead_].prev].next = firingHead_;
+   nodes_[head].prev = head;
+   nodes_[head].next = head;
+
+   size_t fired = 0;
+   while (!isEmptyList(firingHead_)) {
+      const auto node = nodes_[firingHead_].next;
+      unlink(node);
+      auto callback = std::move(nodes_[node].callback);
+      release(node);
+      --size_;
+      ++fired;
+      if (callback) {
+         callback();
+      }
+   }
+   return fired;
+}
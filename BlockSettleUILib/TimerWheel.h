@@ -0,0 +1,96 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Hierarchical timer wheel: 4 levels of 256 slots, each level slot spans all
+// slots of the level below. Timers are kept in intrusive lists, so that
+// scheduling, cancelling and expiry are O(1) per timer, and advancing costs
+// one slot per elapsed tick (and a cascade of one slot per 256 ticks).
+// Time is measured in ticks, the caller chooses tick duration.
+// Not thread-safe.
+class TimerWheel
+{
+public:
+   using Callback = std::function<void()>;
+   // 0 is never a valid handle
+   using Handle = uint64_t;
+
+   static constexpr int kLevels = 4;
+   static constexpr int kSlotBits = 8;
+   static constexpr int kSlots = 1 << kSlotBits;
+
+   explicit TimerWheel(uint64_t currentTick = 0);
+
+   // Callback is called from advance() when it reaches the given tick, but
+   // not earlier than the tick after current one. Deadlines beyond the range
+   // of the top level go round it until they are due.
+   Handle schedule(uint64_t tick, Callback);
+   // Returns false if timer has fired or was cancelled already
+   bool cancel(Handle);
+   bool isPending(Handle) const;
+
+   // Fires all timers up to the given tick, returns their number. Callbacks
+   // could schedule and cancel timers, including the ones due on this call,
+   // but must not call advance().
+   size_t advance(uint64_t tick);
+
+   // Ticks from current one to the next tick when advance() has something
+   // to do: an expiry or a cascade from upper levels. Not later than the
+   // earliest deadline, 0 if there are no timers.
+   uint64_t nextEventDistance() const;
+
+   uint64_t currentTick() const { return currentTick_; }
+   size_t size() const { return size_; }
+   bool empty() const { return size_ == 0; }
+
+private:
+   struct Node
+   {
+      uint32_t prev;
+      uint32_t next;
+      uint32_t generation;
+      // -1 if node is free or being fired
+      int      level;
+      uint64_t tick;
+      Callback callback;
+   };
+
+   static uint32_t index(Handle h) { return static_cast<uint32_t>(h); }
+   static uint32_t generation(Handle h) { return static_cast<uint32_t>(h >> 32); }
+   static uint32_t slotHead(int level, uint64_t slot) { return static_cast<uint32_t>(level * kSlots + slot); }
+   static uint64_t slotOf(int level, uint64_t tick) { return (tick >> (level * kSlotBits)) & (kSlots - 1); }
+
+   uint32_t allocate();
+   void release(uint32_t);
+   void link(uint32_t head, uint32_t node);
+   void unlink(uint32_t node);
+   bool isEmptyList(uint32_t head) const { return nodes_[head].next == head; }
+   void place(uint32_t node);
+   void cascade(int level);
+   size_t fireSlot();
+
+   std::vector<Node> nodes_;
+   uint32_t freeHead_;
+   // list of timers being fired by advance()
+   uint32_t firingHead_;
+   uint64_t currentTick_;
+   size_t   size_ = 0;
+   // timers on each level, to skip scanning empty levels
+   size_t   levelSizes_[kLevels] = {};
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,99 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "TimerWheelService.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThread>
+
+
+TimerWheelService *TimerWheelService::instance()
+{
+   static QPointer<TimerWheelService> globalInstance;
+   if (!globalInstance) {
+      globalInstance = new TimerWheelService(kDefaultTickMs, QCoreApplication::instance());
+   }
+   return globalInstance.data();
+}
+
+TimerWheelService::TimerWheelService(int tickMs, QObject *parent)
+   : QObject(parent)
+   , tickMs_(std::max(tickMs, 1))
+{
+   clock_.start();
+   timer_.setSingleShot(true);
+   timer_.setTimerType(Qt::PreciseTimer);
+   connect(&timer_, &QTimer::timeout, this, &TimerWheelService::onTimeout);
+}
+
+TimerWheelService::Handle TimerWheelService::schedule(std::chrono::milliseconds timeout
+   , QObject *context, std::function<void()> cb)
+{
+   assert(QThread::currentThread() == thread());
+
+   // round deadline up, so that it doesn't fire early
+   const auto deadlineMs = clock_.elapsed() + std::max<qint64>(timeout.count(), 0);
+   const auto tick = static_cast<uint64_t>((deadlineMs + tickMs_ - 1) / tickMs_);
+
+   Handle handle = 0;
+   if (context) {
+      handle = wheel_.schedule(tick, [context = QPointer<QObject>(context), cb = std::move(cb)] {
+         if (context) {
+            cb();
+         }
+      });
+   }
+   else {
+      handle = wheel_.schedule(tick, std::move(cb));
+   }
+
+   if (!timer_.isActive() || (tick < armedTick_)) {
+      rearm();
+   }
+   return handle;
+}
+
+bool TimerWheelService::cancel(Handle handle)
+{
+   // timer stays armed, next timeout just rearms it
+   return wheel_.cancel(handle);
+}
+
+bool TimerWheelService::isPending(Handle handle) const
+{
+   return wheel_.isPending(handle);
+}
+
+void TimerWheelService::onTimeout()
+{
+   wheel_.advance(currentTick());
+   rearm();
+}
+
+void TimerWheelService::rearm()
+{
+   const auto distance = wheel_.nextEventDistance();
+   if (distance == 0) {
+      timer_.stop();
+      return;
+   }
+   armedTick_ = wheel_.currentTick() + distance;
+   const auto interval = static_cast<qint64>(armedTick_) * tickMs_ - clock_.elapsed();
+   timer_.start(static_cast<int>(std::min<qint64>(std::max<qint64>(interval, 0), std::numeric_limits<int>::max())));
+}
+
+uint64_t TimerWheelService::currentTick() const
+{
+   return static_cast<uint64_t>(clock_.elapsed() / tickMs_);
+}
@@ -0,0 +1,61 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef TIMER_WHEEL_SERVICE_H
+#define TIMER_WHEEL_SERVICE_H
+
+#include <chrono>
+#include <functional>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include "TimerWheel.h"
+
+// Runs timeouts of OTC deals, public requests and settlements on one shared
+// TimerWheel. Single timer is armed for the next event of the wheel only,
+// instead of a QTimer per timeout or a periodic poll. Timeouts never fire
+// earlier than requested and up to one tick later.
+// Should be used from the thread of the instance only.
+class TimerWheelService : public QObject
+{
+   Q_OBJECT
+public:
+   using Handle = TimerWheel::Handle;
+
+   static constexpr int kDefaultTickMs = 10;
+
+   // Created on first call as a child of application object
+   static TimerWheelService *instance();
+
+   explicit TimerWheelService(int tickMs = kDefaultTickMs, QObject *parent = nullptr);
+   ~TimerWheelService() noexcept override = default;
+
+   // Callback is dropped if context (when set) is destroyed before timeout
+   Handle schedule(std::chrono::milliseconds timeout, QObject *context, std::function<void()>);
+   bool cancel(Handle);
+   bool isPending(Handle) const;
+   size_t pending() const { return wheel_.size(); }
+
+private:
+   void onTimeout();
+   void rearm();
+   uint64_t currentTick() const;
+
+private:
+   const int      tickMs_;
+   QElapsedTimer  clock_;
+   TimerWheel     wheel_;
+   QTimer         timer_;
+   // tick which the timer is armed for
+   uint64_t       armedTick_ = 0;
+};
+
+#endif // TIMER_WHEEL_SERVICE_H
@@ -14,9 +14,13 @@
 #include "AutoSignQuoteProvider.h"
 #include "BSErrorCodeStrings.h"
 #include "BSMessageBox.h"
+#include "UserScriptRunner.h"
 
+#include <QMenu>
+#include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QStandardPaths>
 
 namespace {
    constexpr int kSelectAQFileItemIndex = 1;
@@ -53,6 +57,20 @@ void AutoSignQuoteWidget::init(const std::shared_ptr<AutoSignScriptProvider> &au
       , this, &AutoSignQuoteWidget::validateGUI);
 
    ui_->labelAutoSignWalletName->setText(autoSignProvider_->getAutoSignWalletName());
+
+   const bool isAQRunner = qobject_cast<AQScriptRunner *>(autoSignProvider_->scriptRunner()) != nullptr;
+   ui_->pushButtonAQLatency->setVisible(isAQRunner);
+   if (isAQRunner) {
+      auto latencyMenu = new QMenu(ui_->pushButtonAQLatency);
+      latencyMenu->addAction(tr("Export auto-quote latency..."), this, &AutoSignQuoteWidget::exportAQLatency);
+      latencyMenu->addAction(tr("Reset auto-quote latency"), this, [this] {
+         const auto aqRunner = qobject_cast<AQScriptRunner *>(autoSignProvider_->scriptRunner());
+         if (aqRunner) {
+            aqRunner->resetLatency();
+         }
+      });
+      ui_->pushButtonAQLatency->setMenu(latencyMenu);
+   }
 }
 
 AutoSignQuoteWidget::~AutoSignQuoteWidget() = default;
@@ -181,8 +199,12 @@ QString AutoSignQuoteWidget::askForScript()
       lastDir = AutoSignScriptProvider::getDefaultScriptsDir();
    }
 
+   // auto-quoting also accepts native strategy libraries
+   const bool isAQ = (qobject_cast<AQScriptRunner *>(autoSignProvider_->scriptRunner()) != nullptr);
+   const auto filter = isAQ ? tr("Scripts (*.qml *.so *.dylib *.dll)") : tr("QML files (*.qml)");
+
    auto path = QFileDialog::getOpenFileName(this, tr("Open script file")
-      , lastDir, tr("QML files (*.qml)"));
+      , lastDir, filter);
 
    if (!path.isEmpty()) {
       autoSignProvider_->setLastDir(path);
@@ -190,3 +212,26 @@ QString AutoSignQuoteWidget::askForScript()
 
    return path;
 }
+
+void AutoSignQuoteWidget::exportAQLatency()
+{
+   const auto aqRunner = qobject_cast<AQScriptRunner *>(autoSignProvider_->scriptRunner());
+   if (!aqRunner) {
+      return;
+   }
+   const auto fileName = QFileDialog::getSaveFileName(this, tr("Export auto-quote latency")
+      , QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+         + QStringLiteral("/aq_latency.csv")
+      , tr("CSV files (*.csv)"));
+   if (fileName.isEmpty()) {
+      return;
+   }
+
+   QFile file(fileName);
+   if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      BSMessageBox(BSMessageBox::critical, tr("Export failed")
+         , tr("Failed to open %1 for writing").arg(fileName), this).exec();
+      return;
+   }
+   file.write(QByteArray::fromStdString(aqRunner->latencyReport()));
+}
@@ -44,6 +44,8 @@ private slots:
    void onAutoQuoteToggled();
    void onAutoSignToggled();
 
+   void exportAQLatency();
+
 private:
    QString askForScript();
    void validateGUI();
@@ -11,21 +11,58 @@
 #include "MarketDataModel.h"
 #include "CommonTypes.h"
 #include "Colors.h"
-#include <QLocale>
+#include <QBrush>
+#include <QDateTime>
+
+#include <algorithm>
+#include <limits>
 
 #include "UiUtils.h"
 
+namespace {
+   // price change highlight duration
+   const qint64 kFlashDurationMs = 3000;
+
+   const int kDefaultMaxFrameRate = 30;
+
+   int valueIndex(MarketDataModel::MarketDataColumns col)
+   {
+      return static_cast<int>(col) - static_cast<int>(MarketDataModel::MarketDataColumns::BidPrice);
+   }
+
+   bool isValueColumn(int col)
+   {
+      return (col >= static_cast<int>(MarketDataModel::MarketDataColumns::BidPrice))
+         && (col <= static_cast<int>(MarketDataModel::MarketDataColumns::DailyVol));
+   }
+
+   QString getVolumeString(double value, bs::network::Asset::Type at)
+   {
+      if (qFuzzyIsNull(value)) {
+         return QString{};
+      }
+
+      switch(at) {
+      case bs::network::Asset::SpotFX:
+         return UiUtils::displayCurrencyAmount(value);
+      case bs::network::Asset::SpotXBT:
+         return UiUtils::displayAmount(value);
+      case bs::network::Asset::PrivateMarket:
+         return UiUtils::displayCCAmount(value);
+      default:
+         break;
+      }
+
+      return QString();
+   }
+}
+
 MarketDataModel::MarketDataModel(const QStringList &showSettings, QObject* parent)
-   : QStandardItemModel(parent)
+   : QAbstractItemModel(parent)
+   , maxFrameRate_(kDefaultMaxFrameRate)
 {
-   QStringList headerLabels;
    for (int col = static_cast<int>(MarketDataColumns::First); col < static_cast<int>(MarketDataColumns::ColumnsCount); col++) {
-      headerLabels << columnName(static_cast<MarketDataColumns>(col));
-   }
-   setHorizontalHeaderLabels(headerLabels);
-
-   for (int col = static_cast<int>(MarketDataColumns::First) + 1; col < static_cast<int>(MarketDataColumns::ColumnsCount); col++) {
-      horizontalHeaderItem(col)->setTextAlignment(Qt::AlignCenter);
+      headerLabels_ << columnName(static_cast<MarketDataColumns>(col));
    }
 
    for (const auto &setting : showSettings) {
@@ -35,6 +72,10 @@ MarketDataModel::MarketDataModel(const QStringList &showSettings, QObject* paren
    timer_.setInterval(500);
    connect(&timer_, &QTimer::timeout, this, &MarketDataModel::ticker);
    timer_.start();
+
+   flushTimer_.setSingleShot(true);
+   flushTimer_.setInterval(1000 / maxFrameRate_);
+   connect(&flushTimer_, &QTimer::timeout, this, &MarketDataModel::flush);
 }
 
 QString MarketDataModel::columnName(MarketDataColumns col) const
@@ -51,97 +92,223 @@ QString MarketDataModel::columnName(MarketDataColumns col) const
    }
 }
 
-static double toDoubleFromPriceStr(const QString &priceStr)
+void MarketDataModel::setMaxFrameRate(int fps)
+{
+   maxFrameRate_ = std::max(fps, 1);
+   flushTimer_.setInterval(1000 / maxFrameRate_);
+}
+
+QModelIndex MarketDataModel::index(int row, int column, const QModelIndex &parent) const
+{
+   if ((row < 0) || (column < 0) || (column >= columnCount())) {
+      return {};
+   }
+   // internal id is 0 for groups and group index + 1 for instruments
+   if (!parent.isValid()) {
+      if (static_cast<std::size_t>(row) >= groups_.size()) {
+         return {};
+      }
+      return createIndex(row, column, quintptr(0));
+   }
+   if ((parent.internalId() != 0) || (static_cast<std::size_t>(parent.row()) >= groups_.size())) {
+      return {};
+   }
+   if (static_cast<std::size_t>(row) >= groups_[static_cast<std::size_t>(parent.row())].rows_.size()) {
+      return {};
+   }
+   return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex MarketDataModel::parent(const QModelIndex &index) const
 {
-   if (priceStr.isEmpty()) {
-      return std::numeric_limits<double>::infinity();
+   if (!index.isValid() || (index.internalId() == 0)) {
+      return {};
    }
-   bool ok;
-   double rv = priceStr.toDouble(&ok);
-   if (!ok) {
-      rv = QLocale().toDouble(priceStr, &ok);
+   return createIndex(static_cast<int>(index.internalId() - 1), 0, quintptr(0));
+}
+
+int MarketDataModel::rowCount(const QModelIndex &parent) const
+{
+   if (!parent.isValid()) {
+      return static_cast<int>(groups_.size());
    }
-   if (!ok) {
-      return std::numeric_limits<double>::infinity();
+   if ((parent.internalId() != 0) || (parent.column() != 0)) {
+      return 0;
    }
-   return rv;
+   return static_cast<int>(groups_[static_cast<std::size_t>(parent.row())].rows_.size());
 }
 
-QToggleItem* priceItem(const QString &price)
+int MarketDataModel::columnCount(const QModelIndex &) const
 {
-   auto item = new QToggleItem(price);
-   item->setData(Qt::AlignRight, Qt::TextAlignmentRole);
-   return item;
+   return static_cast<int>(MarketDataColumns::ColumnsCount);
 }
 
-QToggleItem *MarketDataModel::getGroup(bs::network::Asset::Type assetType)
+const MarketDataModel::Instrument *MarketDataModel::instrumentAt(const QModelIndex &index) const
 {
-   QString productGroup;
-   if (assetType == bs::network::Asset::Undefined) {
-      productGroup = tr("Rejected");
+   if (!index.isValid() || (index.internalId() == 0)) {
+      return nullptr;
    }
-   else {
-      productGroup = tr(bs::network::Asset::toString(assetType));
+   const auto &group = groups_[static_cast<std::size_t>(index.internalId() - 1)];
+   return &instruments_[static_cast<std::size_t>(group.rows_[static_cast<std::size_t>(index.row())])];
+}
+
+QVariant MarketDataModel::data(const QModelIndex &index, int role) const
+{
+   if (!index.isValid()) {
+      return {};
    }
-   auto groupItems = findItems(productGroup);
-   QToggleItem* groupItem = nullptr;
-   if (groupItems.isEmpty()) {
-      groupItem = new QToggleItem(productGroup, isVisible(productGroup));
-      groupItem->setData(-1);
-      appendRow(QList<QStandardItem*>() << groupItem);
+
+   if (index.internalId() == 0) {
+      const auto &group = groups_[static_cast<std::size_t>(index.row())];
+      if (index.column() != 0) {
+         return {};
+      }
+      switch (role) {
+      case Qt::DisplayRole:
+         return group.name_;
+      case Qt::CheckStateRole:
+         return checkable_ ? QVariant(groupCheckState(group)) : QVariant();
+      default:
+         return {};
+      }
    }
-   else {
-      groupItem = static_cast<QToggleItem *>(groupItems.first());
+
+   const auto instr = instrumentAt(index);
+   const auto &group = groups_[static_cast<std::size_t>(instr->group_)];
+   const int col = index.column();
+
+   if (col == static_cast<int>(MarketDataColumns::Product)) {
+      switch (role) {
+      case Qt::DisplayRole:
+         return instr->rejectReason_.isEmpty() ? instr->security_ : instr->rejectReason_;
+      case Qt::ForegroundRole:
+         return instr->rejectReason_.isEmpty() ? QVariant() : QVariant(QBrush(Qt::red));
+      case Qt::CheckStateRole:
+         return checkable_ ? QVariant(instr->visible_ ? Qt::Checked : Qt::Unchecked) : QVariant();
+      default:
+         return {};
+      }
+   }
+
+   if (role == Qt::TextAlignmentRole) {
+      return static_cast<int>(Qt::AlignRight);
+   }
+   if (!isValueColumn(col)) {
+      return {};
+   }
+
+   const int i = valueIndex(static_cast<MarketDataColumns>(col));
+   const bool valid = (instr->valid_ & (1 << i));
+   const double value = instr->values_[static_cast<std::size_t>(i)];
+
+   switch (role) {
+   case Qt::DisplayRole:
+      if (!valid) {
+         return QString();
+      }
+      if (col == static_cast<int>(MarketDataColumns::DailyVol)) {
+         return getVolumeString(value, group.assetType_);
+      }
+      return UiUtils::displayPriceForAssetType(value, group.assetType_);
+
+   case Qt::BackgroundRole: {
+      const auto flash = instr->flash_[static_cast<std::size_t>(i)];
+      if (flash > 0) {
+         return QBrush(c_greenColor);
+      }
+      if (flash < 0) {
+         return QBrush(c_redColor);
+      }
+      return {};
+   }
+
+   case PriceRole:
+      return valid ? value : std::numeric_limits<double>::infinity();
+
+   default:
+      return {};
    }
-   return groupItem;
 }
 
-struct PriceItem {
-   QString  str;
-   double   value;
-};
-using PriceMap = std::map<MarketDataModel::MarketDataColumns, PriceItem>;
+bool MarketDataModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+   if (!index.isValid() || (index.column() != 0) || (role != Qt::CheckStateRole) || !checkable_) {
+      return false;
+   }
+   const bool visible = (static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked);
 
-static QString getVolumeString(double value, bs::network::Asset::Type at)
+   if (index.internalId() == 0) {
+      setGroupVisible(index.row(), visible);
+   }
+   else {
+      const auto &group = groups_[static_cast<std::size_t>(index.internalId() - 1)];
+      setInstrumentVisible(group.rows_[static_cast<std::size_t>(index.row())], visible);
+   }
+   return true;
+}
+
+Qt::ItemFlags MarketDataModel::flags(const QModelIndex &index) const
 {
-   if (qFuzzyIsNull(value)) {
-      return QString{};
+   if (!index.isValid()) {
+      return Qt::NoItemFlags;
+   }
+   auto result = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+   if (checkable_ && (index.column() == 0)) {
+      result |= Qt::ItemIsUserCheckable;
    }
+   return result;
+}
 
-   switch(at) {
-   case bs::network::Asset::SpotFX:
-      return UiUtils::displayCurrencyAmount(value);
-   case bs::network::Asset::SpotXBT:
-      return UiUtils::displayAmount(value);
-   case bs::network::Asset::PrivateMarket:
-      return UiUtils::displayCCAmount(value);
+QVariant MarketDataModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+   if ((orientation != Qt::Horizontal) || (section < 0) || (section >= headerLabels_.size())) {
+      return {};
+   }
+   switch (role) {
+   case Qt::DisplayRole:
+      return headerLabels_.at(section);
+   case Qt::TextAlignmentRole:
+      return (section > 0) ? QVariant(static_cast<int>(Qt::AlignCenter)) : QVariant();
+   default:
+      return {};
    }
+}
 
-   return QString();
+bool MarketDataModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role)
+{
+   if ((orientation != Qt::Horizontal) || (section < 0) || (section >= headerLabels_.size())
+      || ((role != Qt::EditRole) && (role != Qt::DisplayRole))) {
+      return false;
+   }
+   headerLabels_[section] = value.toString();
+   emit headerDataChanged(orientation, section, section);
+   return true;
 }
 
-static void FieldsToMap(bs::network::Asset::Type at, const bs::network::MDFields &fields, PriceMap &map)
+int MarketDataModel::getGroup(bs::network::Asset::Type assetType)
 {
-   for (const auto &field : fields) {
-      switch (field.type) {
-      case bs::network::MDField::PriceBid:
-         map[MarketDataModel::MarketDataColumns::BidPrice] = { UiUtils::displayPriceForAssetType(field.value, at), UiUtils::truncatePriceForAsset(field.value, at) };
-         break;
-      case bs::network::MDField::PriceOffer:
-         map[MarketDataModel::MarketDataColumns::OfferPrice] = { UiUtils::displayPriceForAssetType(field.value, at), UiUtils::truncatePriceForAsset(field.value, at) };
-         break;
-      case bs::network::MDField::PriceLast:
-         map[MarketDataModel::MarketDataColumns::LastPrice] = { UiUtils::displayPriceForAssetType(field.value, at), UiUtils::truncatePriceForAsset(field.value, at) };
-         break;
-      case bs::network::MDField::DailyVolume:
-         map[MarketDataModel::MarketDataColumns::DailyVol] = { getVolumeString(field.value, at), field.value };
-         break;
-      case bs::network::MDField::Reject:
-         map[MarketDataModel::MarketDataColumns::ColumnsCount] = { field.desc, 0 };
-         break;
-      default:  break;
+   // there are only few asset types
+   for (std::size_t i = 0; i < groups_.size(); ++i) {
+      if (groups_[i].assetType_ == assetType) {
+         return static_cast<int>(i);
       }
    }
+
+   Group group;
+   if (assetType == bs::network::Asset::Undefined) {
+      group.name_ = tr("Rejected");
+   }
+   else {
+      group.name_ = tr(bs::network::Asset::toString(assetType));
+   }
+   group.assetType_ = assetType;
+   group.visible_ = isVisible(group.name_);
+
+   const int row = static_cast<int>(groups_.size());
+   beginInsertRows(QModelIndex(), row, row);
+   groups_.push_back(std::move(group));
+   endInsertRows();
+   return row;
 }
 
 bool MarketDataModel::isVisible(const QString &id) const
@@ -156,243 +323,290 @@ bool MarketDataModel::isVisible(const QString &id) const
    return false;
 }
 
+bool MarketDataModel::isShown(const Instrument &instr) const
+{
+   return (checkable_ || instr.visible_);
+}
+
 void MarketDataModel::onMDUpdated(bs::network::Asset::Type assetType, const QString &security, bs::network::MDFields mdFields)
 {
    if ((assetType == bs::network::Asset::Undefined) && security.isEmpty()) {  // Celer disconnected
-      priceUpdates_.clear();
-      removeRows(0, rowCount());
+      clear();
       return;
    }
 
-   PriceMap fieldsMap;
-   FieldsToMap(assetType, mdFields, fieldsMap);
-   auto groupItem = getGroup(assetType);
-   auto childRow = groupItem->findRowWithText(security);
-   const auto timeNow = QDateTime::currentDateTime();
-   if (!childRow.empty()) {
-      for (const auto &price : fieldsMap) {
-         childRow[static_cast<int>(price.first)]->setText(price.second.str);
-         childRow[static_cast<int>(price.first)]->setBackground(bgColorForCol(security, price.first, price.second.value, timeNow, childRow));
-      }
-      return;
-   }
+   const int groupIdx = getGroup(assetType);
+   auto &group = groups_[static_cast<std::size_t>(groupIdx)];
+   const int existing = group.bySecurity_.value(security, -1);
+   const int instrIdx = (existing >= 0) ? existing : static_cast<int>(instruments_.size());
 
-   // If we reach here, the product wasn't found, so we make a new row for it
-   QToggleItem::QToggleRow items;
-   if (assetType == bs::network::Asset::Type::Undefined) {
-      const auto rejItem = new QToggleItem(fieldsMap[MarketDataColumns::ColumnsCount].str);
-      rejItem->setForeground(Qt::red);
-      items << rejItem;
+   if (existing < 0) {
+      Instrument instr;
+      instr.security_ = security;
+      instr.group_ = groupIdx;
+      instr.visible_ = (assetType == bs::network::Asset::Undefined) || isVisible(security) || group.visible_;
+      instruments_.push_back(std::move(instr));
+      group.instruments_.push_back(instrIdx);
+      group.bySecurity_.insert(security, instrIdx);
    }
-   else {
-      items << new QToggleItem(security, isVisible(security) | groupItem->isVisible());
-      for (int col = static_cast<int>(MarketDataColumns::First) + 1; col < static_cast<int>(MarketDataColumns::ColumnsCount); col++) {
-         const auto price = fieldsMap[static_cast<MarketDataColumns>(col)];
-         auto item = priceItem(price.str);
-         items << item;
+
+   const auto timeNow = QDateTime::currentMSecsSinceEpoch();
+   for (const auto &field : mdFields) {
+      switch (field.type) {
+      case bs::network::MDField::PriceBid:
+         setValue(instrIdx, MarketDataColumns::BidPrice, field.value, timeNow);
+         break;
+      case bs::network::MDField::PriceOffer:
+         setValue(instrIdx, MarketDataColumns::OfferPrice, field.value, timeNow);
+         break;
+      case bs::network::MDField::PriceLast:
+         setValue(instrIdx, MarketDataColumns::LastPrice, field.value, timeNow);
+         break;
+      case bs::network::MDField::DailyVolume:
+         setValue(instrIdx, MarketDataColumns::DailyVol, field.value, timeNow);
+         break;
+      case bs::network::MDField::Reject:
+         instruments_[static_cast<std::size_t>(instrIdx)].rejectReason_ = field.desc;
+         markDirty(instrIdx, MarketDataColumns::Product);
+         break;
+      default:  break;
       }
    }
-   groupItem->addRow(items);
+
+   auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+   if ((existing < 0) && isShown(instr)) {
+      const int row = static_cast<int>(group.rows_.size());
+      beginInsertRows(index(groupIdx, 0), row, row);
+      instr.row_ = row;
+      group.rows_.push_back(instrIdx);
+      endInsertRows();
+   }
 }
 
-QBrush MarketDataModel::bgColorForCol(const QString &security, MarketDataModel::MarketDataColumns col, double price
-   , const QDateTime &updTime, const QList<QToggleItem *> &row)
+void MarketDataModel::setValue(int instrIdx, MarketDataColumns col, double value, qint64 timeMs)
 {
-   switch (col) {
-   case MarketDataModel::MarketDataColumns::BidPrice:
-   case MarketDataModel::MarketDataColumns::OfferPrice:
-   case MarketDataModel::MarketDataColumns::LastPrice:
-   {
-      const auto prev = priceUpdates_[security][col].price;
-      priceUpdates_[security][col] = { price, updTime, {} };
+   auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+   const auto i = static_cast<std::size_t>(valueIndex(col));
+
+   if (col != MarketDataColumns::DailyVol) {
+      const auto assetType = groups_[static_cast<std::size_t>(instr.group_)].assetType_;
+      const double prev = (instr.valid_ & (1 << i))
+         ? UiUtils::truncatePriceForAsset(instr.values_[i], assetType) : 0;
+      const double price = UiUtils::truncatePriceForAsset(value, assetType);
+
+      int8_t flash = 0;
       if (!qFuzzyIsNull(prev)) {
          if (price > prev) {
-            priceUpdates_[security][col].row = row;
-            return c_greenColor;
+            flash = 1;
          }
          else if (price < prev) {
-            priceUpdates_[security][col].row = row;
-            return c_redColor;
+            flash = -1;
          }
       }
-      break;
+      instr.flash_[i] = flash;
+      if (flash) {
+         instr.flashSince_[i] = timeMs;
+         flashes_.push_back({ instrIdx, static_cast<int>(i), timeMs });
+      }
+   }
+
+   instr.values_[i] = value;
+   instr.valid_ |= (1 << i);
+   markDirty(instrIdx, col);
+}
+
+void MarketDataModel::markDirty(int instrIdx, MarketDataColumns col)
+{
+   auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+   if (!instr.dirty_) {
+      dirty_.push_back(instrIdx);
    }
-   default:    break;
+   instr.dirty_ |= (1 << static_cast<int>(col));
+
+   if (!flushTimer_.isActive()) {
+      flushTimer_.start();
    }
-   return {};
 }
 
-QStringList MarketDataModel::getVisibilitySettings() const
+void MarketDataModel::flush()
 {
-   QStringList rv;
-   for (int i = 0; i < rowCount(); i++) {
-      const auto toggleGrp = static_cast<QToggleItem *>(item(i));
-      if (toggleGrp == nullptr) {
-         continue;
+   flushTimer_.stop();
+   if (dirty_.empty()) {
+      return;
+   }
+
+   struct DirtyRow {
+      int group;
+      int row;
+      uint8_t columns;
+   };
+   std::vector<DirtyRow> rows;
+   rows.reserve(dirty_.size());
+   for (const auto instrIdx : dirty_) {
+      auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+      if (instr.row_ >= 0) {
+         rows.push_back({ instr.group_, instr.row_, instr.dirty_ });
       }
-      if (toggleGrp->isVisible()) {
-         rv << toggleGrp->text();
-         continue;
+      instr.dirty_ = 0;
+   }
+   dirty_.clear();
+
+   std::sort(rows.begin(), rows.end(), [](const DirtyRow &a, const DirtyRow &b) {
+      return (a.group < b.group) || ((a.group == b.group) && (a.row < b.row));
+   });
+
+   // one signal per contiguous range of rows, spanning all their changed columns
+   static const QVector<int> roles = { Qt::DisplayRole, Qt::BackgroundRole, Qt::ForegroundRole, PriceRole };
+   std::size_t first = 0;
+   while (first < rows.size()) {
+      std::size_t last = first;
+      uint8_t columns = rows[first].columns;
+      while ((last + 1 < rows.size()) && (rows[last + 1].group == rows[first].group)
+         && (rows[last + 1].row == rows[last].row + 1)) {
+         ++last;
+         columns |= rows[last].columns;
       }
-      for (int i = 0; i < toggleGrp->rowCount(); i++) {
-         const auto child = static_cast<QToggleItem *>(toggleGrp->child(i, 0));
-         if (child == nullptr) {
-            continue;
-         }
-         if (child->isVisible()) {
-            rv << child->text();
-         }
+
+      int firstCol = 0;
+      while (!(columns & (1 << firstCol))) {
+         ++firstCol;
       }
+      int lastCol = static_cast<int>(MarketDataColumns::ColumnsCount) - 1;
+      while (!(columns & (1 << lastCol))) {
+         --lastCol;
+      }
+
+      const auto parentIdx = index(rows[first].group, 0);
+      emit dataChanged(index(rows[first].row, firstCol, parentIdx)
+         , index(rows[last].row, lastCol, parentIdx), roles);
+      first = last + 1;
    }
-   return rv;
 }
 
-void MarketDataModel::onVisibilityToggled(bool filtered)
+QStringList MarketDataModel::getVisibilitySettings() const
 {
-   for (int i = 0; i < rowCount(); i++) {
-      auto toggleGrp = static_cast<QToggleItem*>(item(i));
-      if (toggleGrp == nullptr) {
+   QStringList rv;
+   for (const auto &group : groups_) {
+      if (group.visible_) {
+         rv << group.name_;
          continue;
       }
-      toggleGrp->showCheckBox(!filtered);
-   }
-   emit needResize();
-}
-
-void MarketDataModel::ticker()
-{
-   const auto timeNow = QDateTime::currentDateTime();
-   for (const auto &priceUpd : priceUpdates_) {
-      for (auto price : priceUpd.second) {
-         if (price.second.row.empty()) {
-            continue;
-         }
-         if (price.second.updated.msecsTo(timeNow) > 3000) {
-            price.second.row[static_cast<int>(price.first)]->setBackground(QBrush());
-            price.second.row.clear();
+      for (const auto instrIdx : group.instruments_) {
+         const auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+         if (instr.visible_) {
+            rv << instr.security_;
          }
       }
    }
+   return rv;
 }
 
-
-QToggleItem::QToggleRow QToggleItem::findRowWithText(const QString &text, int column)
+Qt::CheckState MarketDataModel::groupCheckState(const Group &group) const
 {
-   for (int i = 0; i < rowCount(); i++) {
-      if (child(i, column)->text() == text) {
-         QToggleRow rv;
-         for (int j = 0; j < columnCount(); j++) {
-            rv << static_cast<QToggleItem*>(child(i, j));
-         }
-         return rv;
-      }
+   if (group.instruments_.empty()) {
+      return group.visible_ ? Qt::Checked : Qt::Unchecked;
    }
-   for (const auto invChild : invisibleChildren_) {
-      if (invChild.at(column)->text() == text) {
-         return invChild;
+   std::size_t nbVisible = 0;
+   for (const auto instrIdx : group.instruments_) {
+      if (instruments_[static_cast<std::size_t>(instrIdx)].visible_) {
+         nbVisible++;
       }
    }
-   return {};
+   if (!nbVisible) {
+      return Qt::Unchecked;
+   }
+   return (nbVisible == group.instruments_.size()) ? Qt::Checked : Qt::PartiallyChecked;
 }
 
-void QToggleItem::showCheckBox(bool state, int column)
+void MarketDataModel::setGroupVisible(int groupIdx, bool visible)
 {
-   if (state) {
-      setCheckState(isVisible_ ? Qt::Checked : Qt::Unchecked);
-      for (const auto &row : invisibleChildren_) {
-         appendRow(row);
-      }
+   auto &group = groups_[static_cast<std::size_t>(groupIdx)];
+   group.visible_ = visible;
+   for (const auto instrIdx : group.instruments_) {
+      instruments_[static_cast<std::size_t>(instrIdx)].visible_ = visible;
    }
 
-   setCheckable(state);
-   for (int i = 0; i < rowCount(); i++) {
-      auto tgChild = static_cast<QToggleItem*>(child(i, column));
-      tgChild->showCheckBox(state, column);
+   const auto groupIndex = index(groupIdx, 0);
+   emit dataChanged(groupIndex, groupIndex, { Qt::CheckStateRole });
+   if (!group.rows_.empty()) {
+      emit dataChanged(index(0, 0, groupIndex)
+         , index(static_cast<int>(group.rows_.size()) - 1, 0, groupIndex), { Qt::CheckStateRole });
    }
+}
 
-   if (!state) {
-      setData(QVariant(), Qt::CheckStateRole);
+void MarketDataModel::setInstrumentVisible(int instrIdx, bool visible)
+{
+   auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+   instr.visible_ = visible;
 
-      QList<QList<QStandardItem*> > takenRows;
-      int i = 0;
-      while (rowCount() > 0) {
-         if (i >= rowCount()) {
-            break;
-         }
-         auto tgChild = static_cast<QToggleItem*>(child(i, column));
-         if (tgChild->isVisible()) {
-            i++;
-         }
-         else {
-            takenRows << takeRow(i);
-         }
-      }
-      invisibleChildren_.clear();
-      for (const auto row : takenRows) {
-         QToggleRow tRow;
-         for (const auto item : row) {
-            tRow << static_cast<QToggleItem *>(item);
-         }
-         invisibleChildren_ << tRow;
-      }
+   auto &group = groups_[static_cast<std::size_t>(instr.group_)];
+   group.visible_ = (groupCheckState(group) == Qt::Checked);
+
+   const auto groupIndex = index(instr.group_, 0);
+   emit dataChanged(groupIndex, groupIndex, { Qt::CheckStateRole });
+   if (instr.row_ >= 0) {
+      const auto instrIndex = index(instr.row_, 0, groupIndex);
+      emit dataChanged(instrIndex, instrIndex, { Qt::CheckStateRole });
    }
 }
 
-void QToggleItem::setData(const QVariant &value, int role)
+void MarketDataModel::rebuildRows()
 {
-   QStandardItem::setData(value, role);
-
-   if ((role == Qt::CheckStateRole) && value.isValid()) {
-      const auto state = static_cast<Qt::CheckState>(value.toInt());
-      setVisible(state == Qt::Checked);
-      auto tParent = dynamic_cast<QToggleItem *>(parent());
-      if (tParent != nullptr) {
-         tParent->updateCheckMark();
-      } else {
-         for (int  i=0; i < rowCount(); i++) {
-            auto childItem = dynamic_cast<QToggleItem *>(child(i, 0));
-            childItem->setVisible(state == Qt::Checked);
-            childItem->QStandardItem::setData(state, Qt::CheckStateRole);
+   for (auto &group : groups_) {
+      group.rows_.clear();
+      for (const auto instrIdx : group.instruments_) {
+         auto &instr = instruments_[static_cast<std::size_t>(instrIdx)];
+         if (isShown(instr)) {
+            instr.row_ = static_cast<int>(group.rows_.size());
+            group.rows_.push_back(instrIdx);
+         }
+         else {
+            instr.row_ = -1;
          }
       }
    }
 }
 
-void QToggleItem::updateCheckMark(int column)
+void MarketDataModel::onVisibilityToggled(bool filtered)
 {
-   int nbVisibleChildren = 0;
-   for (int i = 0; i < rowCount(); i++) {
-      const auto tgChild = static_cast<QToggleItem*>(child(i, column));
-      if (tgChild->isVisible()) {
-         nbVisibleChildren++;
-      }
-   }
-   if (!nbVisibleChildren) {
-      QStandardItem::setData(Qt::Unchecked, Qt::CheckStateRole);
-   }
-   else {
-      setVisible(nbVisibleChildren != 0);
-      QStandardItem::setData((nbVisibleChildren == rowCount()) ? Qt::Checked : Qt::PartiallyChecked, Qt::CheckStateRole);
+   if (checkable_ != filtered) {
+      emit needResize();
+      return;
    }
+   beginResetModel();
+   checkable_ = !filtered;
+   rebuildRows();
+   endResetModel();
+   emit needResize();
 }
 
-void QToggleItem::addRow(const QToggleItem::QToggleRow &row, int visColumn)
+void MarketDataModel::clear()
 {
-   if (row[visColumn]->isVisible()) {
-      appendRow(row);
-   }
-   else {
-      invisibleChildren_ << row;
-   }
+   beginResetModel();
+   groups_.clear();
+   instruments_.clear();
+   dirty_.clear();
+   flashes_.clear();
+   flushTimer_.stop();
+   endResetModel();
 }
 
-void QToggleItem::appendRow(const QToggleItem::QToggleRow &row)
+void MarketDataModel::ticker()
 {
-   QList<QStandardItem *> list;
-   for (const auto &item : row) {
-      list << item;
+   const auto timeNow = QDateTime::currentMSecsSinceEpoch();
+   while (!flashes_.empty() && ((timeNow - flashes_.front().since_) > kFlashDurationMs)) {
+      const auto flash = flashes_.front();
+      flashes_.pop_front();
+
+      auto &instr = instruments_[static_cast<std::size_t>(flash.instrument_)];
+      const auto i = static_cast<std::size_t>(flash.value_);
+      // cell could be updated again since then
+      if (instr.flash_[i] && (instr.flashSince_[i] == flash.since_)) {
+         instr.flash_[i] = 0;
+         markDirty(flash.instrument_, static_cast<MarketDataColumns>(
+            flash.value_ + static_cast<int>(MarketDataColumns::BidPrice)));
+      }
    }
-   QStandardItem::appendRow(list);
 }
 
 
@@ -418,14 +632,20 @@ bool MDSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex
       }
    }
 
-   if ((leftData.type() == QVariant::String) && (rightData.type() == QVariant::String)) {
-      if ((left.column() > 0) && (right.column() > 0)) {
-         double priceLeft = toDoubleFromPriceStr(leftData.toString());
-         double priceRight = toDoubleFromPriceStr(rightData.toString());
+   if ((left.column() > 0) && (right.column() > 0)) {
+      // numeric values are taken from the model directly instead of parsing text
+      const auto leftPrice = sourceModel()->data(left, MarketDataModel::PriceRole);
+      const auto rightPrice = sourceModel()->data(right, MarketDataModel::PriceRole);
+      if (leftPrice.isValid() && rightPrice.isValid()) {
+         const double priceLeft = leftPrice.toDouble();
+         const double priceRight = rightPrice.toDouble();
 
          if ((priceLeft > 0) && (priceRight > 0))
             return (priceLeft < priceRight);
       }
+   }
+
+   if ((leftData.type() == QVariant::String) && (rightData.type() == QVariant::String)) {
       return (leftData.toString() < rightData.toString());
    }
    return (leftData < rightData);
@@ -11,47 +11,30 @@
 #ifndef __MARKET_DATA_MODEL_H__
 #define __MARKET_DATA_MODEL_H__
 
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <set>
 #include <string>
 #include <vector>
-#include <set>
-#include <unordered_map>
-#include <QBrush>
-#include <QStandardItemModel>
+#include <QAbstractItemModel>
+#include <QHash>
 #include <QSortFilterProxyModel>
+#include <QStringList>
 #include <QTimer>
 #include "CommonTypes.h"
 
 
-class QToggleItem : public QStandardItem
-{
-public:
-   QToggleItem(const QString &text, bool visible = true)
-      : QStandardItem(text), isVisible_(visible) {}
-
-   typedef QList<QToggleItem *>  QToggleRow;
-   QToggleRow findRowWithText(const QString &text, int column = 0);
-
-   void addRow(const QToggleRow &, int visColumn = 0);
-   void setVisible(bool visible) { isVisible_ = visible; }
-   bool isVisible() const { return isVisible_; }
-   void showCheckBox(bool state, int column = 0);
-   void updateCheckMark(int column = 0);
-
-   void setData(const QVariant &value, int role = Qt::UserRole + 1) override;
-
-private:
-   bool              isVisible_ = true;
-   QList<QToggleRow> invisibleChildren_;
-
-   void appendRow(const QToggleRow &);
-};
-
-class MarketDataModel : public QStandardItemModel
+// Two-level model of market data: asset type groups with instruments.
+// Prices are kept as numbers in a flat per-instrument table and are formatted
+// only when view asks for them. Changed cells are collected and reported
+// with dataChanged() at most maxFrameRate() times per second.
+class MarketDataModel : public QAbstractItemModel
 {
 Q_OBJECT
 public:
    MarketDataModel(const QStringList &showSettings = {}, QObject *parent = nullptr);
-   ~MarketDataModel() noexcept = default;
+   ~MarketDataModel() noexcept override = default;
 
    MarketDataModel(const MarketDataModel&) = delete;
    MarketDataModel& operator = (const MarketDataModel&) = delete;
@@ -60,6 +43,21 @@ public:
 
    QStringList getVisibilitySettings() const;
 
+   void setMaxFrameRate(int fps);
+   int maxFrameRate() const { return maxFrameRate_; }
+   // Reports pending cell changes right away
+   void flush();
+
+   QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+   QModelIndex parent(const QModelIndex &index) const override;
+   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+   QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+   bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+   Qt::ItemFlags flags(const QModelIndex &index) const override;
+   QVariant headerData(int section, Qt::Orientation, int role = Qt::DisplayRole) const override;
+   bool setHeaderData(int section, Qt::Orientation, const QVariant &value, int role = Qt::EditRole) override;
+
 public slots:
    void onMDUpdated(bs::network::Asset::Type, const QString &security, bs::network::MDFields);
    void onVisibilityToggled(bool filtered);
@@ -83,25 +81,69 @@ public:
       ColumnsCount
    };
 
+   enum Roles {
+      // numeric value of price and volume columns, +inf if not known yet
+      PriceRole = Qt::UserRole + 1
+   };
+
 private:
-   struct PriceUpdate {
-      double      price;
-      QDateTime   updated;
-      QList<QToggleItem *> row;
+   // Bid, offer, last price and daily volume
+   static const int kValueCount = 4;
+
+   struct Instrument {
+      QString  security_;
+      QString  rejectReason_;
+      int      group_;
+      // row in the group, -1 if not shown
+      int      row_ = -1;
+      bool     visible_ = true;
+      uint8_t  valid_ = 0;    // bit per value
+      uint8_t  dirty_ = 0;    // bit per column
+      std::array<double, kValueCount>  values_{};
+      std::array<int8_t, kValueCount>  flash_{};
+      std::array<qint64, kValueCount>  flashSince_{};
+   };
+
+   struct Group {
+      QString  name_;
+      bs::network::Asset::Type   assetType_;
+      bool     visible_;
+      std::vector<int>  instruments_;
+      // instruments shown in view
+      std::vector<int>  rows_;
+      QHash<QString, int>  bySecurity_;
+   };
+
+   struct Flash {
+      int      instrument_;
+      int      value_;
+      qint64   since_;
    };
-   typedef std::map<MarketDataModel::MarketDataColumns, PriceUpdate> PriceByCol;
-   typedef std::map<QString, PriceByCol>     PriceUpdates;
 
    std::set<QString>    instrVisible_;
-   PriceUpdates         priceUpdates_;
+   std::vector<Group>   groups_;
+   std::vector<Instrument> instruments_;
+   std::vector<int>     dirty_;
+   std::deque<Flash>    flashes_;
+   QStringList          headerLabels_;
+   bool                 checkable_ = false;
+   int                  maxFrameRate_;
    QTimer               timer_;
+   QTimer               flushTimer_;
 
 private:
-   QToggleItem *getGroup(bs::network::Asset::Type);
+   int getGroup(bs::network::Asset::Type);
    QString columnName(MarketDataColumns) const;
    bool isVisible(const QString &id) const;
-   QBrush bgColorForCol(const QString &security, MarketDataModel::MarketDataColumns, double price
-      , const QDateTime &, const QList<QToggleItem *> &row);
+   bool isShown(const Instrument &) const;
+   const Instrument *instrumentAt(const QModelIndex &) const;
+   void setValue(int instrument, MarketDataColumns, double value, qint64 timeMs);
+   void markDirty(int instrument, MarketDataColumns);
+   void setGroupVisible(int group, bool visible);
+   void setInstrumentVisible(int instrument, bool visible);
+   Qt::CheckState groupCheckState(const Group &) const;
+   void rebuildRows();
+   void clear();
 };
 
 
@@ -12,7 +12,6 @@
 
 #include <QApplication>
 #include <QFile>
-#include <QTimer>
 
 #include <spdlog/spdlog.h>
 
@@ -23,6 +22,7 @@
 #include "EncryptionUtils.h"
 #include "OfflineSigner.h"
 #include "ProtobufUtils.h"
+#include "TimerWheelService.h"
 #include "TradesUtils.h"
 #include "UiUtils.h"
 #include "UtxoReservationManager.h"
@@ -308,7 +308,8 @@ bool OtcClient::sendQuoteRequest(const QuoteRequest &request)
    d->set_range(Otc::RangeType(request.rangeType));
    emit sendPublicMessage(BinaryData::fromString(msg.SerializeAsString()));
 
-   updatePublicLists();
+   addPublicRequest(ownRequest_);
+   emit publicUpdated();
 
    return true;
 }
@@ -336,7 +337,8 @@ bool OtcClient::sendQuoteResponse(const PeerPtr &peer, const QuoteResponse &quot
    copyRange(quoteResponse.amount, d->mutable_amount());
    send(peer, msg);
 
-   updatePublicLists();
+   updatePublicRequest(peer);
+   emit publicUpdated();
    return true;
 }
 
@@ -413,17 +415,21 @@ bool OtcClient::pullOrReject(const PeerPtr &peer)
       assert(peer == ownRequest_);
 
       SPDLOG_LOGGER_DEBUG(logger_, "pull own quote request");
+      removePublicRequest(ownRequest_->contactId);
       ownRequest_.reset();
 
       // This will remove everything when we pull public request.
       // We could keep current shield and show that our public request was pulled instead.
+      while (!responses_.empty()) {
+         removePublicResponse(responses_.peers().back()->contactId);
+      }
       responseMap_.clear();
 
       Otc::PublicMessage msg;
       msg.mutable_close();
       emit sendPublicMessage(BinaryData::fromString(msg.SerializeAsString()));
 
-      updatePublicLists();
+      emit publicUpdated();
       return true;
    }
 
@@ -445,12 +451,14 @@ bool OtcClient::pullOrReject(const PeerPtr &peer)
                // Keep public request even if we reject it
                resetPeerStateToIdle(peer);
                // Need to call this as peer would be removed from "sent requests" list
-               updatePublicLists();
+               updatePublicRequest(peer);
+               emit publicUpdated();
                break;
             case PeerType::Response:
                // Remove peer from received responses if we reject it
+               removePublicResponse(peer->contactId);
                responseMap_.erase(peer->contactId);
-               updatePublicLists();
+               emit publicUpdated();
                break;
          }
 
@@ -472,12 +480,14 @@ bool OtcClient::pullOrReject(const PeerPtr &peer)
 
          switch (peer->type) {
          case PeerType::Request:
+            removePublicRequest(peer->contactId);
             requestMap_.erase(peer->contactId);
-            updatePublicLists();
+            emit publicUpdated();
             break;
          case PeerType::Response:
+            removePublicResponse(peer->contactId);
             responseMap_.erase(peer->contactId);
-            updatePublicLists();
+            emit publicUpdated();
             break;
          }
 
@@ -685,6 +695,7 @@ void OtcClient::processContactMessage(const std::string &contactId, const Binary
          if (!peer) {
             auto result = responseMap_.emplace(contactId, std::make_shared<Peer>(contactId, PeerType::Response));
             peer = result.first->second;
+            addPublicResponse(peer);
             emit publicUpdated();
          }
          break;
@@ -1087,14 +1098,16 @@ void OtcClient::processClose(const PeerPtr &peer, const ContactMessage_Close &ms
       case State::WaitPayinInfo: {
          if (peer->type == PeerType::Response) {
             SPDLOG_LOGGER_DEBUG(logger_, "remove active response because peer have sent close message");
+            removePublicResponse(peer->contactId);
             responseMap_.erase(peer->contactId);
-            updatePublicLists();
+            emit publicUpdated();
             return;
          }
 
          resetPeerStateToIdle(peer);
          if (peer->type != PeerType::Contact) {
-            updatePublicLists();
+            updatePublicRequest(peer);
+            emit publicUpdated();
          }
          break;
       }
@@ -1141,7 +1154,8 @@ void OtcClient::processQuoteResponse(const PeerPtr &peer, const ContactMessage_Q
    copyRange(msg.price(), &peer->response.price);
    copyRange(msg.amount(), &peer->response.amount);
 
-   updatePublicLists();
+   updatePublicResponse(peer);
+   emit publicUpdated();
 }
 
 void OtcClient::processPublicRequest(QDateTime timestamp, const std::string &contactId, const PublicMessage_Request &msg)
@@ -1152,22 +1166,24 @@ void OtcClient::processPublicRequest(QDateTime timestamp, const std::string &con
       return;
    }
 
-   requestMap_.erase(contactId);
-   auto result = requestMap_.emplace(contactId, std::make_shared<Peer>(contactId, PeerType::Request));
-   const auto &peer = result.first->second;
-
+   auto peer = std::make_shared<Peer>(contactId, PeerType::Request);
    peer->request.ourSide = otc::switchSide(otc::Side(msg.sender_side()));
    peer->request.rangeType = range;
    peer->request.timestamp = timestamp;
+   // New request from the same contact replaces old one in place
+   requestMap_[contactId] = peer;
 
-   updatePublicLists();
+   addPublicRequest(peer);
+   scheduleRequestExpiry(peer);
+   emit publicUpdated();
 }
 
 void OtcClient::processPublicClose(QDateTime timestamp, const std::string &contactId, const PublicMessage_Close &msg)
 {
+   removePublicRequest(contactId);
    requestMap_.erase(contactId);
 
-   updatePublicLists();
+   emit publicUpdated();
 }
 
 void OtcClient::processPbStartOtc(const ProxyTerminalPb::Response_StartOtc &response)
@@ -1303,7 +1319,7 @@ void OtcClient::processPbUpdateOtcState(const ProxyTerminalPb::Response_UpdateOt
 
          changePeerState(peer, State::WaitBuyerSign);
 
-         QTimer::singleShot(payoutTimeout() + kLocalTimeoutDelay, this, [this, peer, handle = peer->validityFlag.handle()] {
+         TimerWheelService::instance()->schedule(payoutTimeout() + kLocalTimeoutDelay, this, [this, peer, handle = peer->validityFlag.handle()] {
             if (!handle.isValid() || peer->state != State::WaitBuyerSign) {
                return;
             }
@@ -1340,7 +1356,7 @@ void OtcClient::processPbUpdateOtcState(const ProxyTerminalPb::Response_UpdateOt
 
          changePeerState(peer, State::WaitSellerSeal);
 
-         QTimer::singleShot(payinTimeout() + kLocalTimeoutDelay, this, [this, peer, handle = peer->validityFlag.handle()] {
+         TimerWheelService::instance()->schedule(payinTimeout() + kLocalTimeoutDelay, this, [this, peer, handle = peer->validityFlag.handle()] {
             if (!handle.isValid() || peer->state != State::WaitSellerSeal) {
                return;
             }
@@ -1370,12 +1386,14 @@ void OtcClient::processPbUpdateOtcState(const ProxyTerminalPb::Response_UpdateOt
             resetPeerStateToIdle(peer);
             break;
          case PeerType::Request:
+            removePublicRequest(peer->contactId);
             requestMap_.erase(peer->contactId);
-            updatePublicLists();
+            emit publicUpdated();
             break;
          case PeerType::Response:
+            removePublicResponse(peer->contactId);
             responseMap_.erase(peer->contactId);
-            updatePublicLists();
+            emit publicUpdated();
             break;
          }
 
@@ -1635,7 +1653,7 @@ void OtcClient::sendSellerAccepts(const PeerPtr &peer)
    d->set_request_id(requestId);
    emit sendPbMessage(request.SerializeAsString());
 
-   QTimer::singleShot(kStartOtcTimeout, this, [this, requestId, peer, handle = peer->validityFlag.handle()] {
+   TimerWheelService::instance()->schedule(kStartOtcTimeout, this, [this, requestId, peer, handle = peer->validityFlag.handle()] {
       if (!handle.isValid()) {
          return;
       }
@@ -1698,8 +1716,8 @@ void OtcClient::resetPeerStateToIdle(const PeerPtr &peer)
 
 void OtcClient::scheduleCloseAfterTimeout(std::chrono::milliseconds timeout, const PeerPtr &peer)
 {
-   // Use PreciseTimer to prevent time out earlier than expected
-   QTimer::singleShot(timeout, Qt::PreciseTimer, this, [this, peer, oldState = peer->state, handle = peer->validityFlag.handle(), timeout] {
+   // Timer wheel never times out earlier than expected
+   TimerWheelService::instance()->schedule(timeout, this, [this, peer, oldState = peer->state, handle = peer->validityFlag.handle(), timeout] {
       if (!handle.isValid() || peer->state != oldState) {
          return;
       }
@@ -1781,30 +1799,91 @@ void OtcClient::setComments(OtcClientDeal *deal)
    }
 }
 
-void OtcClient::updatePublicLists()
+void OtcClient::addPublicRequest(const PeerPtr &peer)
 {
-   contacts_.clear();
-   contacts_.reserve(contactMap_.size());
-   for (auto &item : contactMap_) {
-      contacts_.push_back(item.second);
+   int row = requests_.replace(peer);
+   if (row >= 0) {
+      emit publicRequestUpdated(row);
+      return;
    }
 
-   requests_.clear();
-   requests_.reserve(requestMap_.size() + (ownRequest_ ? 1 : 0));
-   if (ownRequest_) {
-      requests_.push_back(ownRequest_);
+   row = peer->isOwnRequest ? requests_.pushFront(peer) : requests_.pushBack(peer);
+   emit publicRequestAdded(row);
+}
+
+void OtcClient::updatePublicRequest(const PeerPtr &peer)
+{
+   if (isExpired(peer)) {
+      const auto contactId = peer->contactId;
+      removePublicRequest(contactId);
+      requestMap_.erase(contactId);
+      return;
+   }
+
+   const int row = requests_.find(peer->contactId);
+   if (row >= 0) {
+      emit publicRequestUpdated(row);
+   }
+}
+
+void OtcClient::removePublicRequest(const std::string &contactId)
+{
+   const int row = requests_.remove(contactId);
+   if (row >= 0) {
+      emit publicRequestRemoved(row);
    }
-   for (auto &item : requestMap_) {
-      requests_.push_back(item.second);
+}
+
+void OtcClient::addPublicResponse(const PeerPtr &peer)
+{
+   const int row = responses_.pushBack(peer);
+   if (row >= 0) {
+      emit publicResponseAdded(row);
    }
+}
 
-   responses_.clear();
-   responses_.reserve(responseMap_.size());
-   for (auto &item : responseMap_) {
-      responses_.push_back(item.second);
+void OtcClient::updatePublicResponse(const PeerPtr &peer)
+{
+   const int row = responses_.find(peer->contactId);
+   if (row >= 0) {
+      emit publicResponseUpdated(row);
    }
+}
 
-   emit publicUpdated();
+void OtcClient::removePublicResponse(const std::string &contactId)
+{
+   const int row = responses_.remove(contactId);
+   if (row >= 0) {
+      emit publicResponseRemoved(row);
+   }
+}
+
+void OtcClient::scheduleRequestExpiry(const PeerPtr &peer)
+{
+   const auto age = std::chrono::milliseconds(peer->request.timestamp.msecsTo(QDateTime::currentDateTime()));
+   std::chrono::milliseconds timeout = otc::publicRequestTimeout() - age;
+   if (timeout.count() < 0) {
+      timeout = std::chrono::milliseconds(0);
+   }
+
+   // Requests in negotiation are removed when they go back to Idle state
+   TimerWheelService::instance()->schedule(timeout, this, [this, peer] {
+      if (request(peer->contactId) != peer || !isExpired(peer)) {
+         return;
+      }
+      updatePublicRequest(peer);
+      emit publicUpdated();
+   });
+}
+
+bool OtcClient::isExpired(const PeerPtr &peer) const
+{
+   // Own request is pulled with scheduleCloseAfterTimeout
+   if (peer->isOwnRequest || peer->type != PeerType::Request || peer->state != State::Idle) {
+      return false;
+   }
+   const auto age = std::chrono::milliseconds(peer->request.timestamp.msecsTo(QDateTime::currentDateTime()));
+   return age >= otc::publicRequestTimeout();
 }
 
 void OtcClient::initTradesArgs(bs::tradeutils::Args &args, const PeerPtr &peer, const std::string &settlementId)
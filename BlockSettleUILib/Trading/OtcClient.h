@@ -18,6 +18,7 @@
 
 #include "BSErrorCode.h"
 #include "BinaryData.h"
+#include "OtcPublicList.h"
 #include "OtcTypes.h"
 #include "UtxoReservationToken.h"
 
@@ -120,8 +121,9 @@ public:
    void setReservation(const bs::network::otc::PeerPtr &peer, bs::UtxoReservationToken&& reserv);
    bs::UtxoReservationToken releaseReservation(const bs::network::otc::PeerPtr &peer);
 
-   const bs::network::otc::PeerPtrs &requests() { return requests_; }
-   const bs::network::otc::PeerPtrs &responses() { return responses_; }
+   // Own request goes first, others in order of arrival
+   const bs::network::otc::PeerPtrs &requests() { return requests_.peers(); }
+   const bs::network::otc::PeerPtrs &responses() { return responses_.peers(); }
    const bs::network::otc::PeerPtr &ownRequest() const;
 
 public slots:
@@ -140,6 +142,15 @@ signals:
    // Used to update UI when there is some problems (for example deal verification failed)
    void peerError(const bs::network::otc::PeerPtr &peer, bs::network::otc::PeerErrorType type, const std::string *errorMsg);
 
+   // Rows are in requests() and responses(), as they are after addition or
+   // update and before removal. publicUpdated follows each change.
+   void publicRequestAdded(int row);
+   void publicRequestUpdated(int row);
+   void publicRequestRemoved(int row);
+   void publicResponseAdded(int row);
+   void publicResponseUpdated(int row);
+   void publicResponseRemoved(int row);
+
    void publicUpdated();
 
 private slots:
@@ -190,7 +201,16 @@ private:
    void verifyAuthAddresses(OtcClientDeal *deal);
    void setComments(OtcClientDeal *deal);
 
-   void updatePublicLists();
+   // Keep requests_ and responses_ in sync with the maps, emit only row signals
+   void addPublicRequest(const bs::network::otc::PeerPtr &peer);
+   // Removes idle foreign request which is expired already (from requestMap_ too)
+   void updatePublicRequest(const bs::network::otc::PeerPtr &peer);
+   void removePublicRequest(const std::string &contactId);
+   void addPublicResponse(const bs::network::otc::PeerPtr &peer);
+   void updatePublicResponse(const bs::network::otc::PeerPtr &peer);
+   void removePublicResponse(const std::string &contactId);
+   void scheduleRequestExpiry(const bs::network::otc::PeerPtr &peer);
+   bool isExpired(const bs::network::otc::PeerPtr &peer) const;
 
    void initTradesArgs(bs::tradeutils::Args &args, const bs::network::otc::PeerPtr &peer, const std::string &settlementId);
 
@@ -225,10 +245,9 @@ private:
    std::unordered_map<std::string, bs::network::otc::PeerPtr> requestMap_;
    std::unordered_map<std::string, bs::network::otc::PeerPtr> responseMap_;
 
-   // Cached pointer lists from the above
-   bs::network::otc::PeerPtrs contacts_;
-   bs::network::otc::PeerPtrs requests_;
-   bs::network::otc::PeerPtrs responses_;
+   // Own and foreign requests, and responses from the above
+   OtcPublicList<bs::network::otc::PeerPtrs> requests_;
+   OtcPublicList<bs::network::otc::PeerPtrs> responses_;
 
    OtcClientParams params_;
 
@@ -0,0 +1,100 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef OTC_PUBLIC_LIST_H
+#define OTC_PUBLIC_LIST_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+// Peers shown in public OTC lists, in order of appearance and with lookup by
+// contact id. Row of a peer only changes when some peer before it is removed,
+// so that models could follow the list with row signals.
+template <typename PeerPtrs>
+class OtcPublicList
+{
+public:
+   using PeerPtr = typename PeerPtrs::value_type;
+
+   // Return row of the added peer, or -1 if its contact is in the list already
+   int pushFront(const PeerPtr &peer)
+   {
+      if (!rows_.emplace(peer->contactId, 0).second) {
+         return -1;
+      }
+      peers_.insert(peers_.begin(), peer);
+      reindex(1);
+      return 0;
+   }
+
+   int pushBack(const PeerPtr &peer)
+   {
+      const auto row = peers_.size();
+      if (!rows_.emplace(peer->contactId, row).second) {
+         return -1;
+      }
+      peers_.push_back(peer);
+      return static_cast<int>(row);
+   }
+
+   // Puts peer in place of the one with the same contact id, returns its row or -1
+   int replace(const PeerPtr &peer)
+   {
+      const auto row = find(peer->contactId);
+      if (row >= 0) {
+         peers_[static_cast<size_t>(row)] = peer;
+      }
+      return row;
+   }
+
+   // Returns row which removed peer had, or -1
+   int remove(const std::string &contactId)
+   {
+      const auto it = rows_.find(contactId);
+      if (it == rows_.end()) {
+         return -1;
+      }
+      const auto row = it->second;
+      rows_.erase(it);
+      peers_.erase(peers_.begin() + static_cast<std::ptrdiff_t>(row));
+      reindex(row);
+      return static_cast<int>(row);
+   }
+
+   int find(const std::string &contactId) const
+   {
+      const auto it = rows_.find(contactId);
+      return (it == rows_.end()) ? -1 : static_cast<int>(it->second);
+   }
+
+   void clear()
+   {
+      peers_.clear();
+      rows_.clear();
+   }
+
+   const PeerPtrs &peers() const { return peers_; }
+   size_t size() const { return peers_.size(); }
+   bool empty() const { return peers_.empty(); }
+
+private:
+   void reindex(size_t first)
+   {
+      for (size_t i = first; i < peers_.size(); ++i) {
+         rows_[peers_[i]->contactId] = i;
+      }
+   }
+
+   PeerPtrs peers_;
+   std::unordered_map<std::string, size_t> rows_;
+};
+
+#endif // OTC_PUBLIC_LIST_H
@@ -22,6 +22,7 @@
 #include "SettlementContainer.h"
 #include "UiUtils.h"
 
+#include <algorithm>
 #include <chrono>
 
 
@@ -389,8 +390,8 @@ QModelIndex QuoteRequestsModel::index(int r, int column, const QModelIndex &pare
          default :
             return QModelIndex();
       }
-   } else if (row < data_.size()) {
-      return createIndex(r, column, &data_.at(row)->idx_);
+   } else if (row < store_.markets().size()) {
+      return createIndex(r, column, &store_.markets().at(row)->idx_);
    } else {
       return QModelIndex();
    }
@@ -398,57 +399,12 @@ QModelIndex QuoteRequestsModel::index(int r, int column, const QModelIndex &pare
 
 int QuoteRequestsModel::findGroup(IndexHelper *idx) const
 {
-   if (idx->parent_) {
-      auto *market = static_cast<Market*>(idx->parent_->data_);
-
-      auto it = std::find_if(market->groups_.cbegin(), market->groups_.cend(),
-         [&idx](const std::unique_ptr<Group> &g) { return (&g->idx_ == idx); });
-
-      if (it != market->groups_.cend()) {
-         return static_cast<int>(std::distance(market->groups_.cbegin(), it));
-      } else {
-         return -1;
-      }
-   } else if (idx->type_ == DataType::Market) {
-      return findMarket(idx);
-   } else {
-      return -1;
-   }
-}
-
-QuoteRequestsModel::Group* QuoteRequestsModel::findGroup(Market *market, const QString &security) const
-{
-   auto it = std::find_if(market->groups_.cbegin(), market->groups_.cend(),
-      [&] (const std::unique_ptr<Group> &g) { return (g->security_ == security); } );
-
-   if (it != market->groups_.cend()) {
-      return it->get();
-   } else {
-      return nullptr;
-   }
+   return store_.row(idx);
 }
 
 int QuoteRequestsModel::findMarket(IndexHelper *idx) const
 {
-   auto it = std::find_if(data_.cbegin(), data_.cend(),
-      [&idx](const std::unique_ptr<Market> &m) { return (&m->idx_ == idx); });
-
-   if (it != data_.cend()) {
-      return static_cast<int>(std::distance(data_.cbegin(), it));
-   } else {
-      return -1;
-   }
-}
-
-QuoteRequestsModel::Market* QuoteRequestsModel::findMarket(const QString &name) const
-{
-   for (size_t i = 0; i < data_.size(); ++i) {
-      if (data_[i]->security_ == name) {
-         return data_[i].get();
-      }
-   }
-
-   return nullptr;
+   return store_.row(idx);
 }
 
 QModelIndex QuoteRequestsModel::parent(const QModelIndex &index) const
@@ -496,7 +452,7 @@ int QuoteRequestsModel::rowCount(const QModelIndex &parent) const
             return 0;
       }
    } else {
-      return static_cast<int>(data_.size());
+      return static_cast<int>(store_.markets().size());
    }
 }
 
@@ -526,7 +482,7 @@ QVariant QuoteRequestsModel::headerData(int section, Qt::Orientation orientation
 
 void QuoteRequestsModel::limitRfqs(const QModelIndex &index, int limit)
 {
-   if (!index.parent().isValid() && index.row() < static_cast<int>(data_.size())) {
+   if (!index.parent().isValid() && index.row() < static_cast<int>(store_.markets().size())) {
       IndexHelper *idx = static_cast<IndexHelper*>(index.internalPointer());
 
       auto *m = static_cast<Market*>(idx->data_);
@@ -545,7 +501,7 @@ void QuoteRequestsModel::limitRfqs(const QModelIndex &index, int limit)
 
 QModelIndex QuoteRequestsModel::findMarketIndex(const QString &name) const
 {
-   auto *m = findMarket(name);
+   auto *m = store_.findMarket(name);
 
    if (m) {
       return createIndex(findMarket(&m->idx_), 0, &m->idx_);
@@ -571,7 +527,7 @@ void QuoteRequestsModel::showQuotedRfqs(bool on)
    if (showQuoted_ != on) {
       showQuoted_ = on;
 
-      for (auto mit = data_.cbegin(), mlast = data_.cend(); mit != mlast; ++mit) {
+      for (auto mit = store_.markets().cbegin(), mlast = store_.markets().cend(); mit != mlast; ++mit) {
          for (auto it = (*mit)->groups_.cbegin(), last = (*mit)->groups_.cend();
             it != last; ++it) {
                const auto idx = createIndex(
@@ -589,12 +545,11 @@ void QuoteRequestsModel::SetAssetManager(const std::shared_ptr<AssetManager>& as
 }
 
 void QuoteRequestsModel::ticker() {
-   std::unordered_set<std::string>  deletedRows;
-   const auto timeNow = QDateTime::currentDateTime();
-
    for (const auto &id : pendingDeleteIds_) {
       forSpecificId(id, [this](Group *g, int idxItem) {
-         beginRemoveRows(createIndex(findGroup(&g->idx_), 0, &g->idx_), idxItem, idxItem);
+         auto *parentIdx = QuoteRequestsStore::parentIndex(g);
+         const int row = QuoteRequestsStore::rowInParent(g, idxItem);
+         beginRemoveRows(createIndex(findGroup(parentIdx), 0, parentIdx), row, row);
          if (g->rfqs_[static_cast<std::size_t>(idxItem)]->quoted_) {
             --g->quotedRfqsCount_;
          }
@@ -602,84 +557,96 @@ void QuoteRequestsModel::ticker() {
             --g->visibleCount_;
             showRfqsFromBack(g);
          }
-         g->rfqs_.erase(g->rfqs_.begin() + idxItem);
+         store_.removeRfq(g, idxItem);
          endRemoveRows();
 
          emit invalidateFilterModel();
       });
-      deletedRows.insert(id);
+      notifications_.erase(id);
+      expiry_.remove(id);
    }
    pendingDeleteIds_.clear();
 
-   for (auto qrn : notifications_) {
-      const auto timeDiff = timeNow.msecsTo(qrn.second.expirationTime.addMSecs(qrn.second.timeSkewMs));
-      if ((timeDiff < 0) || (qrn.second.status == bs::network::QuoteReqNotification::Withdrawn)) {
-         forSpecificId(qrn.second.quoteRequestId, [this](Group *grp, int itemIndex) {
-            const auto row = findGroup(&grp->idx_);
-            beginRemoveRows(createIndex(row, 0, &grp->idx_), itemIndex, itemIndex);
-            if (grp->rfqs_[static_cast<std::size_t>(itemIndex)]->quoted_) {
-               --grp->quotedRfqsCount_;
-            }
-            if (grp->rfqs_[static_cast<std::size_t>(itemIndex)]->visible_) {
-               --grp->visibleCount_;
-               showRfqsFromBack(grp);
-            }
-            grp->rfqs_.erase(grp->rfqs_.begin() + itemIndex);
-            endRemoveRows();
+   const auto tickResult = expiry_.tick(QDateTime::currentMSecsSinceEpoch());
 
-            if ((grp->rfqs_.size() == 0) && (row >= 0)) {
-               const auto m = findMarket(grp->idx_.parent_);
-               beginRemoveRows(createIndex(m, 0, grp->idx_.parent_), row, row);
-               data_[m]->groups_.erase(data_[m]->groups_.begin() + row);
-               endRemoveRows();
-            } else {
-               emit invalidateFilterModel();
-            }
-         });
-         deletedRows.insert(qrn.second.quoteRequestId);
-      }
-      else if ((qrn.second.status == bs::network::QuoteReqNotification::PendingAck)
-         || (qrn.second.status == bs::network::QuoteReqNotification::Replied)) {
-         forSpecificId(qrn.second.quoteRequestId, [timeDiff](Group *grp, int itemIndex) {
-            grp->rfqs_[static_cast<std::size_t>(itemIndex)]->status_.timeleft_ =
-               static_cast<int>(timeDiff);
-         });
-      }
+   for (const auto &id : tickResult.expired_) {
+      forSpecificId(id, [this](Group *grp, int itemIndex) {
+         const auto row = findGroup(&grp->idx_);
+         beginRemoveRows(createIndex(row, 0, &grp->idx_), itemIndex, itemIndex);
+         if (grp->rfqs_[static_cast<std::size_t>(itemIndex)]->quoted_) {
+            --grp->quotedRfqsCount_;
+         }
+         if (grp->rfqs_[static_cast<std::size_t>(itemIndex)]->visible_) {
+            --grp->visibleCount_;
+            showRfqsFromBack(grp);
+         }
+         store_.removeRfq(grp, itemIndex);
+         endRemoveRows();
+
+         if ((grp->rfqs_.size() == 0) && (row >= 0)) {
+            auto *market = static_cast<Market*>(grp->idx_.parent_->data_);
+            beginRemoveRows(createIndex(market->row_, 0, &market->idx_), row, row);
+            store_.removeGroup(market, row);
+            endRemoveRows();
+         } else {
+            emit invalidateFilterModel();
+         }
+      });
+      notifications_.erase(id);
    }
 
-   for (auto delRow : deletedRows) {
-      notifications_.erase(delRow);
+   // rows are collected after all removals so that they stay valid till emit
+   ChangedRows changedRows;
+
+   for (const auto &changed : tickResult.changed_) {
+      const auto itQRN = notifications_.find(changed.first);
+      if ((itQRN == notifications_.end())
+         || ((itQRN->second.status != bs::network::QuoteReqNotification::PendingAck)
+            && (itQRN->second.status != bs::network::QuoteReqNotification::Replied))) {
+         continue;
+      }
+      forSpecificId(changed.first, [this, &changedRows, timeLeft = changed.second]
+         (Group *grp, int itemIndex) {
+         auto *rfq = grp->rfqs_[static_cast<std::size_t>(itemIndex)].get();
+         rfq->status_.timeleft_ = static_cast<int>(timeLeft);
+         changedRows[QuoteRequestsStore::parentIndex(grp)].emplace_back(QuoteRequestsStore::rowInParent(grp, itemIndex), rfq);
+      });
    }
 
    for (const auto &settlContainer : settlContainers_) {
       forSpecificId(settlContainer.second->id(),
-         [timeLeft = settlContainer.second->timeLeftMs()](Group *grp, int itemIndex) {
-         grp->rfqs_[static_cast<std::size_t>(itemIndex)]->status_.timeleft_ =
-            static_cast<int>(timeLeft);
+         [this, &changedRows, timeLeft = settlContainer.second->timeLeftMs()](Group *grp, int itemIndex) {
+         auto *rfq = grp->rfqs_[static_cast<std::size_t>(itemIndex)].get();
+         if (rfq->status_.timeleft_ == static_cast<int>(timeLeft)) {
+            return;
+         }
+         rfq->status_.timeleft_ = static_cast<int>(timeLeft);
+         changedRows[QuoteRequestsStore::parentIndex(grp)].emplace_back(QuoteRequestsStore::rowInParent(grp, itemIndex), rfq);
       });
    }
 
-   if (!data_.empty()) {
-      for (size_t i = 0; i < data_.size(); ++i) {
-         for (size_t j = 0; j < data_[i]->groups_.size(); ++j) {
-            if (data_[i]->groups_[j]->rfqs_.empty()) {
-               continue;
-            }
-            emit dataChanged(createIndex(0, static_cast<int>(Column::Status),
-                  &data_[i]->groups_[j]->rfqs_.front()->idx_),
-               createIndex(static_cast<int>(data_[i]->groups_[j]->rfqs_.size() - 1),
-                  static_cast<int>(Column::Status),
-                  &data_[i]->groups_[j]->rfqs_.back()->idx_));
-         }
+   emitStatusChanged(changedRows);
+}
 
-         if (!data_[i]->settl_.rfqs_.empty()) {
-            const int r = static_cast<int>(data_[i]->groups_.size());
-            emit dataChanged(createIndex(r, static_cast<int>(Column::Status),
-                  &data_[i]->settl_.rfqs_.front()->idx_),
-               createIndex(r + static_cast<int>(data_[i]->settl_.rfqs_.size()) - 1,
-                  static_cast<int>(Column::Status),
-                  &data_[i]->settl_.rfqs_.back()->idx_));
+void QuoteRequestsModel::emitStatusChanged(ChangedRows &changedRows)
+{
+   for (auto &parentRows : changedRows) {
+      auto &rows = parentRows.second;
+      std::sort(rows.begin(), rows.end(), [](const std::pair<int, RFQ*> &a, const std::pair<int, RFQ*> &b) {
+         return (a.first < b.first);
+      });
+
+      // emit one signal per contiguous range of rows
+      std::size_t first = 0;
+      for (std::size_t i = 1; i <= rows.size(); ++i) {
+         if ((i < rows.size()) && (rows[i].first <= rows[i - 1].first + 1)) {
+            continue;
          }
+         emit dataChanged(createIndex(rows[first].first, static_cast<int>(Column::Status),
+               &rows[first].second->idx_),
+            createIndex(rows[i - 1].first, static_cast<int>(Column::Status),
+               &rows[i - 1].second->idx_));
+         first = i;
       }
    }
 }
@@ -835,30 +802,26 @@ QBrush QuoteRequestsModel::colorForQuotedPrice(double quotedPrice, double bestQP
 void QuoteRequestsModel::onQuoteReqNotifReceived(const bs::network::QuoteReqNotification &qrn)
 {
    QString marketName = tr(bs::network::Asset::toString(qrn.assetType));
-   auto *market = findMarket(marketName);
+   auto *market = store_.findMarket(marketName);
 
    if (!market) {
-      beginInsertRows(QModelIndex(), static_cast<int>(data_.size()),
-         static_cast<int>(data_.size()));
-      data_.push_back(std::unique_ptr<Market>(new Market(marketName,
-         appSettings_->get<int>(UiUtils::limitRfqSetting(qrn.assetType)))));
-      market = data_.back().get();
+      const int row = static_cast<int>(store_.markets().size());
+      beginInsertRows(QModelIndex(), row, row);
+      market = store_.addMarket(marketName,
+         appSettings_->get<int>(UiUtils::limitRfqSetting(qrn.assetType)));
       endInsertRows();
    }
 
    QString groupNameSec = QString::fromStdString(qrn.security);
-   auto *group = findGroup(market, groupNameSec);
+   auto *group = store_.findGroup(market, groupNameSec);
 
    if (!group) {
-      beginInsertRows(createIndex(findMarket(&market->idx_), 0, &market->idx_),
+      beginInsertRows(createIndex(market->row_, 0, &market->idx_),
          static_cast<int>(market->groups_.size()),
          static_cast<int>(market->groups_.size()));
       QFont font;
       font.setBold(true);
-      market->groups_.push_back(std::unique_ptr<Group>(new Group(groupNameSec,
-         market->limit_, font)));
-      market->groups_.back()->idx_.parent_ = &market->idx_;
-      group = market->groups_.back().get();
+      group = store_.addGroup(market, groupNameSec, font);
       endInsertRows();
    }
 
@@ -880,7 +843,7 @@ void QuoteRequestsModel::insertRfq(Group *group, const bs::network::QuoteReqNoti
          static_cast<int>(group->rfqs_.size()),
          static_cast<int>(group->rfqs_.size()));
 
-      group->rfqs_.push_back(std::unique_ptr<RFQ>(new RFQ(QString::fromStdString(qrn.security),
+      auto *rfq = store_.addRfq(group, std::unique_ptr<RFQ>(new RFQ(QString::fromStdString(qrn.security),
          QString::fromStdString(qrn.product),
          tr(bs::network::Side::toString(qrn.side)),
          QString(),
@@ -901,14 +864,15 @@ void QuoteRequestsModel::insertRfq(Group *group, const bs::network::QuoteReqNoti
          assetType,
          qrn.quoteRequestId)));
 
-      group->rfqs_.back()->idx_.parent_ = &group->idx_;
-
       endInsertRows();
 
       notifications_[qrn.quoteRequestId] = qrn;
+      expiry_.schedule(qrn.quoteRequestId
+         , qrn.expirationTime.addMSecs(qrn.timeSkewMs).toMSecsSinceEpoch()
+         , QDateTime::currentMSecsSinceEpoch());
 
       if (group->limit_ > 0 && group->limit_ > group->visibleCount_) {
-         group->rfqs_.back()->visible_ = true;
+         rfq->visible_ = true;
          ++group->visibleCount_;
 
          emit invalidateFilterModel();
@@ -948,13 +912,12 @@ void QuoteRequestsModel::addSettlementContainer(const std::shared_ptr<bs::Settle
       deleteSettlement(id);
    }, Qt::QueuedConnection);
 
-   auto *market = findMarket(groupNameSettlements_);
+   auto *market = store_.findMarket(groupNameSettlements_);
 
    if (!market) {
-      beginInsertRows(QModelIndex(), static_cast<int>(data_.size()),
-         static_cast<int>(data_.size()));
-      data_.push_back(std::unique_ptr<Market>(new Market(groupNameSettlements_, -1)));
-      market = data_.back().get();
+      const int row = static_cast<int>(store_.markets().size());
+      beginInsertRows(QModelIndex(), row, row);
+      market = store_.addMarket(groupNameSettlements_, -1);
       endInsertRows();
    }
 
@@ -964,11 +927,11 @@ void QuoteRequestsModel::addSettlementContainer(const std::shared_ptr<bs::Settle
       ? UiUtils::displayCCAmount(container->quantity())
       : UiUtils::displayQty(container->quantity(), container->product());
 
-   beginInsertRows(createIndex(findMarket(&market->idx_), 0, &market->idx_),
+   beginInsertRows(createIndex(market->row_, 0, &market->idx_),
       static_cast<int>(market->groups_.size() + market->settl_.rfqs_.size()),
       static_cast<int>(market->groups_.size() + market->settl_.rfqs_.size()));
 
-   market->settl_.rfqs_.push_back(std::unique_ptr<RFQ>(new RFQ(
+   auto *settl = store_.addSettlement(market, std::unique_ptr<RFQ>(new RFQ(
       QString::fromStdString(container->security()),
       QString::fromStdString(container->product()),
       tr(bs::network::Side::toString(container->side())),
@@ -986,10 +949,8 @@ void QuoteRequestsModel::addSettlementContainer(const std::shared_ptr<bs::Settle
       assetType,
       container->id())));
 
-   market->settl_.rfqs_.back()->idx_.parent_ = &market->idx_;
-
    connect(container.get(), &bs::SettlementContainer::timerStarted,
-      [s = market->settl_.rfqs_.back().get(), this,
+      [s = settl, this,
        row = static_cast<int>(market->groups_.size() + market->settl_.rfqs_.size() - 1)](int msDuration) {
          s->status_.timeout_ = msDuration;
          const QModelIndex idx = createIndex(row, 0, &s->idx_);
@@ -1004,7 +965,7 @@ void QuoteRequestsModel::addSettlementContainer(const std::shared_ptr<bs::Settle
 void QuoteRequestsModel::clearModel()
 {
    beginResetModel();
-   data_.clear();
+   store_.clear();
    endResetModel();
 }
 
@@ -1086,10 +1047,10 @@ void QuoteRequestsModel::deleteSettlement(const std::string &id)
 
 void QuoteRequestsModel::updateSettlementCounters()
 {
-   auto * market = findMarket(groupNameSettlements_);
+   auto * market = store_.findMarket(groupNameSettlements_);
 
    if (market) {
-      const int row = findMarket(&market->idx_);
+      const int row = market->row_;
 
       emit dataChanged(createIndex(row, static_cast<int>(Column::Product), &market->idx_),
          createIndex(row, static_cast<int>(Column::Side), &market->idx_));
@@ -1098,36 +1059,21 @@ void QuoteRequestsModel::updateSettlementCounters()
 
 void QuoteRequestsModel::forSpecificId(const std::string &reqId, const cbItem &cb)
 {
-   for (size_t i = 0; i < data_.size(); ++i) {
-      if (!data_[i]->settl_.rfqs_.empty()) {
-         for (size_t k = 0; k < data_[i]->settl_.rfqs_.size(); ++k) {
-            if (data_[i]->settl_.rfqs_[k]->reqId_ == reqId) {
-               cb(&data_[i]->settl_, static_cast<int>(k));
-               return;
-            }
-         }
-      }
+   auto location = store_.findSettlement(reqId);
+   if (!location.isValid()) {
+      location = store_.findRfq(reqId);
+   }
 
-      for (size_t j = 0; j < data_[i]->groups_.size(); ++j) {
-         for (size_t k = 0; k < data_[i]->groups_[j]->rfqs_.size(); ++k) {
-            if (data_[i]->groups_[j]->rfqs_[k]->reqId_ == reqId) {
-               cb(data_[i]->groups_[j].get(), static_cast<int>(k));
-               return;
-            }
-         }
-      }
+   if (location.isValid()) {
+      cb(location.group_, location.rfq_->row_);
    }
 }
 
 void QuoteRequestsModel::forEachSecurity(const QString &security, const cbItem &cb)
 {
-   for (size_t i = 0; i < data_.size(); ++i) {
-      for (size_t j = 0; j < data_[i]->groups_.size(); ++j) {
-         if (data_[i]->groups_[j]->security_ != security)
-            continue;
-         for (size_t k = 0; k < data_[i]->groups_[j]->rfqs_.size(); ++k) {
-            cb(data_[i]->groups_[j].get(), static_cast<int>(k));
-         }
+   for (auto *group : store_.groupsForSecurity(security.toStdString())) {
+      for (size_t k = 0; k < group->rfqs_.size(); ++k) {
+         cb(group, static_cast<int>(k));
       }
    }
 }
@@ -1202,6 +1148,10 @@ void QuoteRequestsModel::setStatus(const std::string &reqId, bs::network::QuoteR
    if (itQRN != notifications_.end()) {
       itQRN->second.status = status;
 
+      if (status == bs::network::QuoteReqNotification::Withdrawn) {
+         expiry_.expireNow(reqId);
+      }
+
       forSpecificId(reqId, [this, status, details](Group *grp, int index) {
 
          auto *rfq = grp->rfqs_[static_cast<std::size_t>(index)].get();
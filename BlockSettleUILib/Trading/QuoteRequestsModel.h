@@ -23,6 +23,8 @@
 #include <vector>
 
 #include "CommonTypes.h"
+#include "QuoteRequestsStore.h"
+#include "RfqExpiryScheduler.h"
 
 
 namespace bs {
@@ -85,12 +87,7 @@ public:
       SortOrder
    };
 
-   enum class DataType {
-      RFQ = 0,
-      Group,
-      Market,
-      Unknown
-   };
+   using DataType = QuoteRequestsStore::DataType;
 
 public:
    QuoteRequestsModel(const std::shared_ptr<bs::SecurityStatsCollector> &
@@ -159,165 +156,15 @@ private:
    int priceUpdateInterval_;
    bool showQuoted_;
 
-   struct IndexHelper {
-      IndexHelper *parent_;
-      void *data_;
-      DataType type_;
-
-      IndexHelper()
-         : parent_(nullptr)
-         , data_(nullptr)
-         , type_(DataType::Unknown)
-      {}
-
-      IndexHelper(IndexHelper *parent, void *data, DataType type)
-         : parent_(parent)
-         , data_(data)
-         , type_(type)
-      {}
-   };
-
-   struct Status {
-      QString status_;
-      bool showProgress_;
-      int timeout_;
-      int timeleft_;
-
-      Status()
-         : showProgress_(false)
-         , timeout_(0)
-         , timeleft_(0)
-      {}
+   using IndexHelper = QuoteRequestsStore::IndexHelper;
+   using Status = QuoteRequestsStore::Status;
+   using RFQ = QuoteRequestsStore::RFQ;
+   using Group = QuoteRequestsStore::Group;
+   using Market = QuoteRequestsStore::Market;
 
-      Status(const QString &status,
-         bool showProgress,
-         int timeout = 0,
-         int timeleft = 0)
-         : status_(status)
-         , showProgress_(showProgress)
-         , timeout_(timeout)
-         , timeleft_(timeleft)
-      {}
-   };
-
-   struct RFQ {
-      QString security_;
-      QString product_;
-      QString sideString_;
-      QString party_;
-      QString quantityString_;
-      QString quotedPriceString_;
-      QString indicativePxString_;
-      QString bestQuotedPxString_;
-      Status status_;
-      double indicativePx_;
-      double quotedPrice_;
-      double bestQuotedPx_;
-      bs::network::Side::Type side_;
-      bs::network::Asset::Type assetType_;
-      std::string reqId_;
-      QBrush quotedPriceBrush_;
-      QBrush indicativePxBrush_;
-      QBrush stateBrush_;
-      IndexHelper idx_;
-      bool quoted_;
-      bool visible_;
-      bool withdrawn_ = false;
-
-      RFQ()
-         : idx_(nullptr, this, DataType::RFQ)
-         , quoted_(false)
-         , visible_(false)
-      {}
-
-      RFQ(const QString &security,
-         const QString &product,
-         const QString &sideString,
-         const QString &party,
-         const QString &quantityString,
-         const QString &quotedPriceString,
-         const QString &indicativePxString,
-         const QString &bestQuotedPxString,
-         const Status &status,
-         double indicativePx,
-         double quotedPrice,
-         double bestQuotedPx,
-         bs::network::Side::Type side,
-         bs::network::Asset::Type assetType,
-         const std::string &reqId)
-         : security_(security)
-         , product_(product)
-         , sideString_(sideString)
-         , party_(party)
-         , quantityString_(quantityString)
-         , quotedPriceString_(quotedPriceString)
-         , indicativePxString_(indicativePxString)
-         , bestQuotedPxString_(bestQuotedPxString)
-         , status_(status)
-         , indicativePx_(indicativePx)
-         , quotedPrice_(quotedPrice)
-         , bestQuotedPx_(bestQuotedPx)
-         , side_(side)
-         , assetType_(assetType)
-         , reqId_(reqId)
-         , idx_(nullptr, this, DataType::RFQ)
-         , quoted_(false)
-         , visible_(false)
-      {}
-   };
-
-   struct Group {
-      QString security_;
-      QFont font_;
-      std::vector<std::unique_ptr<RFQ>> rfqs_;
-      IndexHelper idx_;
-      int limit_;
-      int quotedRfqsCount_;
-      int visibleCount_;
-
-      Group()
-         : idx_(nullptr, this, DataType::Group)
-         , limit_(5)
-         , quotedRfqsCount_(0)
-         , visibleCount_(0)
-      {}
-
-      explicit Group(const QString &security, int limit, const QFont & font = QFont())
-         : security_(security)
-         , font_(font)
-         , idx_(nullptr, this, DataType::Group)
-         , limit_(limit)
-         , quotedRfqsCount_(0)
-         , visibleCount_(0)
-      {}
-   };
-
-   struct Market {
-      QString security_;
-      QFont font_;
-      std::vector<std::unique_ptr<Group>> groups_;
-      IndexHelper idx_;
-      Group settl_;
-      int limit_;
-
-      Market()
-         : idx_(nullptr, this, DataType::Market)
-         , limit_(5)
-      {
-         settl_.idx_ = idx_;
-      }
-
-      explicit Market(const QString &security, int limit, const QFont & font = QFont())
-         : security_(security)
-         , font_(font)
-         , idx_(nullptr, this, DataType::Market)
-         , limit_(limit)
-      {
-         settl_.idx_ = idx_;
-      }
-   };
-
-   std::vector<std::unique_ptr<Market>> data_;
+   QuoteRequestsStore store_;
+   // time left is updated on every tick of timer_ (500 ms)
+   RfqExpiryScheduler expiry_{ 500 };
 
    struct BestQuotePrice {
       double price_;
@@ -329,9 +176,7 @@ private:
 
 private:
    int findGroup(IndexHelper *idx) const;
-   Group* findGroup(Market *market, const QString &security) const;
    int findMarket(IndexHelper *idx) const;
-   Market* findMarket(const QString &name) const;
    void updatePrices(const QString &security, const bs::network::MDField &pxBid,
       const bs::network::MDField &pxOffer, std::vector<std::pair<QModelIndex, QModelIndex>> *idxs = nullptr);
    void showRfqsFromBack(Group *g);
@@ -340,6 +185,9 @@ private:
    void updateBestQuotePrice(const QString &reqId, double price, bool own,
       std::vector<std::pair<QModelIndex, QModelIndex>> *idxs = nullptr);
 
+   using ChangedRows = std::map<IndexHelper*, std::vector<std::pair<int, RFQ*>>>;
+   void emitStatusChanged(ChangedRows &);
+
 private:
    using cbItem = std::function<void(Group *g, int itemIndex)>;
 
@@ -0,0 +1,197 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "QuoteRequestsStore.h"
+
+#include <algorithm>
+
+
+QuoteRequestsStore::Market *QuoteRequestsStore::findMarket(const QString &name) const
+{
+   // there are only few markets, no need for a separate index here
+   for (const auto &market : markets_) {
+      if (market->security_ == name) {
+         return market.get();
+      }
+   }
+   return nullptr;
+}
+
+QuoteRequestsStore::Group *QuoteRequestsStore::findGroup(Market *market, const QString &security) const
+{
+   const auto &groups = groupsForSecurity(security.toStdString());
+   for (auto *group : groups) {
+      if (group->idx_.parent_ == &market->idx_) {
+         return group;
+      }
+   }
+   return nullptr;
+}
+
+int QuoteRequestsStore::row(const IndexHelper *idx) const
+{
+   if (!idx || !idx->data_) {
+      return -1;
+   }
+
+   switch (idx->type_) {
+      case DataType::Market :
+         return static_cast<Market*>(idx->data_)->row_;
+
+      case DataType::Group :
+         return static_cast<Group*>(idx->data_)->row_;
+
+      default :
+         return -1;
+   }
+}
+
+QuoteRequestsStore::IndexHelper *QuoteRequestsStore::parentIndex(Group *group)
+{
+   // settlement group shares IndexHelper data with its market
+   if (group->idx_.type_ == DataType::Market) {
+      return &static_cast<Market*>(group->idx_.data_)->idx_;
+   }
+   return &group->idx_;
+}
+
+int QuoteRequestsStore::rowInParent(Group *group, int itemIndex)
+{
+   if (group->idx_.type_ == DataType::Market) {
+      return static_cast<int>(static_cast<Market*>(group->idx_.data_)->groups_.size()) + itemIndex;
+   }
+   return itemIndex;
+}
+
+QuoteRequestsStore::Market *QuoteRequestsStore::addMarket(const QString &name, int limit, const QFont &font)
+{
+   markets_.push_back(std::unique_ptr<Market>(new Market(name, limit, font)));
+   auto *market = markets_.back().get();
+   market->row_ = static_cast<int>(markets_.size() - 1);
+   return market;
+}
+
+QuoteRequestsStore::Group *QuoteRequestsStore::addGroup(Market *market, const QString &security, const QFont &font)
+{
+   market->groups_.push_back(std::unique_ptr<Group>(new Group(security, market->limit_, font)));
+   auto *group = market->groups_.back().get();
+   group->idx_.parent_ = &market->idx_;
+   group->row_ = static_cast<int>(market->groups_.size() - 1);
+   groupsBySecurity_[security.toStdString()].push_back(group);
+   return group;
+}
+
+QuoteRequestsStore::RFQ *QuoteRequestsStore::addRfq(Group *group, std::unique_ptr<RFQ> rfq)
+{
+   group->rfqs_.push_back(std::move(rfq));
+   auto *result = group->rfqs_.back().get();
+   result->idx_.parent_ = &group->idx_;
+   result->row_ = static_cast<int>(group->rfqs_.size() - 1);
+   rfqs_[result->reqId_] = { group, result };
+   return result;
+}
+
+QuoteRequestsStore::RFQ *QuoteRequestsStore::addSettlement(Market *market, std::unique_ptr<RFQ> rfq)
+{
+   market->settl_.rfqs_.push_back(std::move(rfq));
+   auto *result = market->settl_.rfqs_.back().get();
+   result->idx_.parent_ = &market->idx_;
+   result->row_ = static_cast<int>(market->settl_.rfqs_.size() - 1);
+   settlements_[result->reqId_] = { &market->settl_, result };
+   return result;
+}
+
+void QuoteRequestsStore::removeRfq(Group *group, int row)
+{
+   if ((row < 0) || (static_cast<std::size_t>(row) >= group->rfqs_.size())) {
+      return;
+   }
+
+   const auto &reqId = group->rfqs_[static_cast<std::size_t>(row)]->reqId_;
+   if (isSettlementGroup(group)) {
+      settlements_.erase(reqId);
+   } else {
+      rfqs_.erase(reqId);
+   }
+
+   group->rfqs_.erase(group->rfqs_.begin() + row);
+   for (std::size_t i = static_cast<std::size_t>(row); i < group->rfqs_.size(); ++i) {
+      group->rfqs_[i]->row_ = static_cast<int>(i);
+   }
+}
+
+void QuoteRequestsStore::removeGroup(Market *market, int row)
+{
+   if ((row < 0) || (static_cast<std::size_t>(row) >= market->groups_.size())) {
+      return;
+   }
+
+   auto *group = market->groups_[static_cast<std::size_t>(row)].get();
+   for (const auto &rfq : group->rfqs_) {
+      rfqs_.erase(rfq->reqId_);
+   }
+
+   const auto itSec = groupsBySecurity_.find(group->security_.toStdString());
+   if (itSec != groupsBySecurity_.end()) {
+      itSec->second.erase(std::remove(itSec->second.begin(), itSec->second.end(), group)
+         , itSec->second.end());
+      if (itSec->second.empty()) {
+         groupsBySecurity_.erase(itSec);
+      }
+   }
+
+   market->groups_.erase(market->groups_.begin() + row);
+   for (std::size_t i = static_cast<std::size_t>(row); i < market->groups_.size(); ++i) {
+      market->groups_[i]->row_ = static_cast<int>(i);
+   }
+}
+
+void QuoteRequestsStore::clear()
+{
+   rfqs_.clear();
+   settlements_.clear();
+   groupsBySecurity_.clear();
+   markets_.clear();
+}
+
+QuoteRequestsStore::Location QuoteRequestsStore::findRfq(const std::string &reqId) const
+{
+   const auto it = rfqs_.find(reqId);
+   if (it == rfqs_.end()) {
+      return {};
+   }
+   return it->second;
+}
+
+QuoteRequestsStore::Location QuoteRequestsStore::findSettlement(const std::string &id) const
+{
+   const auto it = settlements_.find(id);
+   if (it == settlements_.end()) {
+      return {};
+   }
+   return it->second;
+}
+
+const QuoteRequestsStore::Groups &QuoteRequestsStore::groupsForSecurity(const std::string &security) const
+{
+   static const Groups emptyGroups;
+
+   const auto it = groupsBySecurity_.find(security);
+   if (it == groupsBySecurity_.end()) {
+      return emptyGroups;
+   }
+   return it->second;
+}
+
+bool QuoteRequestsStore::isSettlementGroup(const Group *group)
+{
+   // settlement group reuses IndexHelper of its market
+   return (group->idx_.type_ == DataType::Market);
+}
@@ -0,0 +1,263 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef QUOTE_REQUESTS_STORE_H
+#define QUOTE_REQUESTS_STORE_H
+
+#include <QBrush>
+#include <QFont>
+#include <QString>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CommonTypes.h"
+
+// Owns Market -> Group -> RFQ tree displayed by QuoteRequestsModel.
+// Besides the tree itself it keeps hash indices by reqId, settlement id and
+// security and caches row positions of every node, so that lookups from
+// notifications and QAbstractItemModel::parent() calls are O(1).
+// Row signals (beginInsertRows etc) are the responsibility of the model.
+class QuoteRequestsStore
+{
+public:
+   enum class DataType {
+      RFQ = 0,
+      Group,
+      Market,
+      Unknown
+   };
+
+   struct IndexHelper {
+      IndexHelper *parent_;
+      void *data_;
+      DataType type_;
+
+      IndexHelper()
+         : parent_(nullptr)
+         , data_(nullptr)
+         , type_(DataType::Unknown)
+      {}
+
+      IndexHelper(IndexHelper *parent, void *data, DataType type)
+         : parent_(parent)
+         , data_(data)
+         , type_(type)
+      {}
+   };
+
+   struct Status {
+      QString status_;
+      bool showProgress_;
+      int timeout_;
+      int timeleft_;
+
+      Status()
+         : showProgress_(false)
+         , timeout_(0)
+         , timeleft_(0)
+      {}
+
+      Status(const QString &status,
+         bool showProgress,
+         int timeout = 0,
+         int timeleft = 0)
+         : status_(status)
+         , showProgress_(showProgress)
+         , timeout_(timeout)
+         , timeleft_(timeleft)
+      {}
+   };
+
+   struct RFQ {
+      QString security_;
+      QString product_;
+      QString sideString_;
+      QString party_;
+      QString quantityString_;
+      QString quotedPriceString_;
+      QString indicativePxString_;
+      QString bestQuotedPxString_;
+      Status status_;
+      double indicativePx_;
+      double quotedPrice_;
+      double bestQuotedPx_;
+      bs::network::Side::Type side_;
+      bs::network::Asset::Type assetType_;
+      std::string reqId_;
+      QBrush quotedPriceBrush_;
+      QBrush indicativePxBrush_;
+      QBrush stateBrush_;
+      IndexHelper idx_;
+      bool quoted_;
+      bool visible_;
+      bool withdrawn_ = false;
+      // position inside owning Group::rfqs_, maintained by the store
+      int row_ = 0;
+
+      RFQ()
+         : idx_(nullptr, this, DataType::RFQ)
+         , quoted_(false)
+         , visible_(false)
+      {}
+
+      RFQ(const QString &security,
+         const QString &product,
+         const QString &sideString,
+         const QString &party,
+         const QString &quantityString,
+         const QString &quotedPriceString,
+         const QString &indicativePxString,
+         const QString &bestQuotedPxString,
+         const Status &status,
+         double indicativePx,
+         double quotedPrice,
+         double bestQuotedPx,
+         bs::network::Side::Type side,
+         bs::network::Asset::Type assetType,
+         const std::string &reqId)
+         : security_(security)
+         , product_(product)
+         , sideString_(sideString)
+         , party_(party)
+         , quantityString_(quantityString)
+         , quotedPriceString_(quotedPriceString)
+         , indicativePxString_(indicativePxString)
+         , bestQuotedPxString_(bestQuotedPxString)
+         , status_(status)
+         , indicativePx_(indicativePx)
+         , quotedPrice_(quotedPrice)
+         , bestQuotedPx_(bestQuotedPx)
+         , side_(side)
+         , assetType_(assetType)
+         , reqId_(reqId)
+         , idx_(nullptr, this, DataType::RFQ)
+         , quoted_(false)
+         , visible_(false)
+      {}
+   };
+
+   struct Group {
+      QString security_;
+      QFont font_;
+      std::vector<std::unique_ptr<RFQ>> rfqs_;
+      IndexHelper idx_;
+      int limit_;
+      int quotedRfqsCount_;
+      int visibleCount_;
+      // position inside owning Market::groups_, maintained by the store
+      int row_ = 0;
+
+      Group()
+         : idx_(nullptr, this, DataType::Group)
+         , limit_(5)
+         , quotedRfqsCount_(0)
+         , visibleCount_(0)
+      {}
+
+      explicit Group(const QString &security, int limit, const QFont & font = QFont())
+         : security_(security)
+         , font_(font)
+         , idx_(nullptr, this, DataType::Group)
+         , limit_(limit)
+         , quotedRfqsCount_(0)
+         , visibleCount_(0)
+      {}
+   };
+
+   struct Market {
+      QString security_;
+      QFont font_;
+      std::vector<std::unique_ptr<Group>> groups_;
+      IndexHelper idx_;
+      Group settl_;
+      int limit_;
+      // position among top-level rows, maintained by the store
+      int row_ = 0;
+
+      Market()
+         : idx_(nullptr, this, DataType::Market)
+         , limit_(5)
+      {
+         settl_.idx_ = idx_;
+      }
+
+      explicit Market(const QString &security, int limit, const QFont & font = QFont())
+         : security_(security)
+         , font_(font)
+         , idx_(nullptr, this, DataType::Market)
+         , limit_(limit)
+      {
+         settl_.idx_ = idx_;
+      }
+   };
+
+   struct Location {
+      Group *group_ = nullptr;
+      RFQ *rfq_ = nullptr;
+
+      bool isValid() const { return (rfq_ != nullptr); }
+   };
+
+   using Markets = std::vector<std::unique_ptr<Market>>;
+   using Groups = std::vector<Group*>;
+
+public:
+   QuoteRequestsStore() = default;
+   ~QuoteRequestsStore() = default;
+
+   QuoteRequestsStore(const QuoteRequestsStore&) = delete;
+   QuoteRequestsStore& operator=(const QuoteRequestsStore&) = delete;
+   QuoteRequestsStore(QuoteRequestsStore&&) = delete;
+   QuoteRequestsStore& operator=(QuoteRequestsStore&&) = delete;
+
+   const Markets &markets() const { return markets_; }
+
+   Market *findMarket(const QString &name) const;
+   Group *findGroup(Market *market, const QString &security) const;
+
+   // Row of market or group in its parent container, -1 for unknown nodes.
+   // Settlement group shares market's IndexHelper and resolves to market row.
+   int row(const IndexHelper *idx) const;
+   // Parent of group's RFQ rows: market for its settlement group
+   static IndexHelper *parentIndex(Group *group);
+   // Row of group's RFQ under parentIndex(), settlements follow all groups
+   static int rowInParent(Group *group, int itemIndex);
+
+   Market *addMarket(const QString &name, int limit, const QFont &font = QFont());
+   Group *addGroup(Market *market, const QString &security, const QFont &font = QFont());
+   RFQ *addRfq(Group *group, std::unique_ptr<RFQ> rfq);
+   RFQ *addSettlement(Market *market, std::unique_ptr<RFQ> rfq);
+
+   // Both group and settlement RFQs are removed through this call
+   void removeRfq(Group *group, int row);
+   void removeGroup(Market *market, int row);
+   void clear();
+
+   Location findRfq(const std::string &reqId) const;
+   Location findSettlement(const std::string &id) const;
+   const Groups &groupsForSecurity(const std::string &security) const;
+
+   std::size_t rfqCount() const { return rfqs_.size(); }
+   std::size_t settlementCount() const { return settlements_.size(); }
+
+private:
+   static bool isSettlementGroup(const Group *group);
+
+private:
+   Markets  markets_;
+   std::unordered_map<std::string, Location>  rfqs_;
+   std::unordered_map<std::string, Location>  settlements_;
+   std::unordered_map<std::string, Groups>    groupsBySecurity_;
+};
+
+#endif // QUOTE_REQUESTS_STORE_H
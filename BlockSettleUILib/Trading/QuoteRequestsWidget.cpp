@@ -62,6 +62,7 @@ QuoteRequestsWidget::QuoteRequestsWidget(QWidget* parent)
    , ui_(new Ui::QuoteRequestsWidget())
    , model_(nullptr)
    , sortModel_(nullptr)
+   , autoSizer_(nullptr)
 {
    ui_->setupUi(this);
    ui_->treeViewQuoteRequests->setUniformRowHeights(true);
@@ -98,6 +99,10 @@ void QuoteRequestsWidget::init(std::shared_ptr<spdlog::logger> logger, const std
       static_cast<int>(QuoteRequestsModel::Column::SecurityID),
       QHeaderView::ResizeToContents);
 
+   autoSizer_ = new ColumnAutoSizer(ui_->treeViewQuoteRequests, model_, this);
+   autoSizer_->setMode(autoSizeMode_);
+   autoSizer_->setSkippedColumns({ static_cast<int>(QuoteRequestsModel::Column::Status) });
+
    connect(ui_->treeViewQuoteRequests, &QTreeView::collapsed,
            this, &QuoteRequestsWidget::onCollapsed);
    connect(ui_->treeViewQuoteRequests, &QTreeView::expanded,
@@ -314,15 +319,19 @@ void QuoteRequestsWidget::onRowsInserted(const QModelIndex &parent, int first, i
          expandIfNeeded();
       }
       else {
-         for (int i = 1; i < sortModel_->columnCount(); ++i) {
-            if (i != static_cast<int>(QuoteRequestsModel::Column::Status)) {
-               ui_->treeViewQuoteRequests->resizeColumnToContents(i);
-            }
-         }
+         autoSizer_->rowsInserted(parent, row, row);
       }
    }
 }
 
+void QuoteRequestsWidget::setColumnAutoSizeMode(ColumnAutoSizer::Mode mode)
+{
+   autoSizeMode_ = mode;
+   if (autoSizer_) {
+      autoSizer_->setMode(mode);
+   }
+}
+
 void QuoteRequestsWidget::onRowsRemoved(const QModelIndex &, int, int)
 {
    const auto &indices = ui_->treeViewQuoteRequests->selectionModel()->selectedIndexes();
@@ -12,6 +12,7 @@
 #define QUOTE_REQUESTS_WIDGET_H
 
 #include "ApplicationSettings.h"
+#include "ColumnAutoSizer.h"
 #include "QuoteRequestsModel.h"
 #include "ProgressViewDelegateBase.h"
 
@@ -133,6 +134,9 @@ public:
 
    RFQBlotterTreeView* view() const;
 
+   // Deferred by default, Immediate restores per-row resizeColumnToContents()
+   void setColumnAutoSizeMode(ColumnAutoSizer::Mode);
+
 signals:
    void Selected(const QString& productGroup, const bs::network::QuoteReqNotification& qrc, double indicBid, double indicAsk);
    void quoteReqNotifStatusChanged(const bs::network::QuoteReqNotification &qrn);
@@ -168,6 +172,8 @@ private:
    QStringList             collapsed_;
    QuoteRequestsModel *    model_;
    QuoteReqSortModel *     sortModel_;
+   ColumnAutoSizer *       autoSizer_;
+   ColumnAutoSizer::Mode   autoSizeMode_ = ColumnAutoSizer::Mode::Deferred;
    bool  dropQN_ = false;
 };
 
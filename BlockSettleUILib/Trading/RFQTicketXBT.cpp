@@ -26,6 +26,7 @@
 #include "CurrencyPair.h"
 #include "EncryptionUtils.h"
 #include "FXAmountValidator.h"
+#include "FeeEstimateCache.h"
 #include "QuoteProvider.h"
 #include "SelectedTransactionInputs.h"
 #include "SignContainer.h"
@@ -1282,7 +1283,7 @@ void RFQTicketXBT::onMaxClicked()
                updateSubmitButton();
                });
          };
-         armory_->estimateFee(bs::tradeutils::feeTargetBlockCount(), feeCb);
+         utxoReservationManager_->feeEstimateCache()->get(bs::tradeutils::feeTargetBlockCount(), feeCb);
 
          return;
       }
@@ -0,0 +1,98 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "RfqExpiryScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+
+RfqExpiryScheduler::RfqExpiryScheduler(int64_t displayStepMs)
+   : displayStepMs_(std::max<int64_t>(displayStepMs, 1))
+{}
+
+void RfqExpiryScheduler::schedule(const std::string &id, int64_t expirationMs, int64_t nowMs)
+{
+   auto &entry = entries_[id];
+   entry.expirationMs_ = expirationMs;
+   entry.expired_ = false;
+   push(id, entry, nextWakeup(expirationMs, nowMs));
+}
+
+void RfqExpiryScheduler::expireNow(const std::string &id)
+{
+   auto it = entries_.find(id);
+   if (it == entries_.end()) {
+      return;
+   }
+   it->second.expired_ = true;
+   push(id, it->second, std::numeric_limits<int64_t>::min());
+}
+
+void RfqExpiryScheduler::remove(const std::string &id)
+{
+   // heap events of removed entry are dropped lazily in tick()
+   entries_.erase(id);
+}
+
+void RfqExpiryScheduler::clear()
+{
+   entries_.clear();
+   heap_ = decltype(heap_)();
+}
+
+RfqExpiryScheduler::TickResult RfqExpiryScheduler::tick(int64_t nowMs)
+{
+   TickResult result;
+
+   while (!heap_.empty() && (heap_.top().wakeupMs_ <= nowMs)) {
+      const auto event = heap_.top();
+      heap_.pop();
+
+      auto it = entries_.find(event.id_);
+      if ((it == entries_.end()) || (it->second.generation_ != event.generation_)) {
+         continue;   // stale event
+      }
+
+      const auto timeLeft = it->second.expirationMs_ - nowMs;
+      if (it->second.expired_ || (timeLeft < 0)) {
+         result.expired_.push_back(event.id_);
+         entries_.erase(it);
+         continue;
+      }
+
+      result.changed_.emplace_back(event.id_, timeLeft);
+      push(event.id_, it->second, nextWakeup(it->second.expirationMs_, nowMs));
+   }
+
+   return result;
+}
+
+bool RfqExpiryScheduler::contains(const std::string &id) const
+{
+   return (entries_.find(id) != entries_.end());
+}
+
+int64_t RfqExpiryScheduler::nextWakeup(int64_t expirationMs, int64_t nowMs) const
+{
+   const auto timeLeft = expirationMs - nowMs;
+   if (timeLeft < 0) {
+      return nowMs;
+   }
+   // displayed step changes as soon as time left drops below current step boundary
+   const auto step = timeLeft / displayStepMs_;
+   return expirationMs - step * displayStepMs_ + 1;
+}
+
+void RfqExpiryScheduler::push(const std::string &id, Entry &entry, int64_t wakeupMs)
+{
+   entry.generation_ = ++generation_;
+   heap_.push({ wakeupMs, entry.generation_, id });
+}
@@ -0,0 +1,76 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef RFQ_EXPIRY_SCHEDULER_H
+#define RFQ_EXPIRY_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Min-heap of RFQ deadlines used by QuoteRequestsModel::ticker().
+// Besides expiration every entry is woken up when its displayed countdown
+// (time left rounded down to displayStepMs) changes, so a tick only visits
+// RFQs that need repainting instead of all live ones.
+// All times are in milliseconds since epoch.
+class RfqExpiryScheduler
+{
+public:
+   struct TickResult {
+      std::vector<std::string> expired_;
+      // id and time left in ms for entries whose countdown step has changed
+      std::vector<std::pair<std::string, int64_t>> changed_;
+   };
+
+   explicit RfqExpiryScheduler(int64_t displayStepMs = 1000);
+
+   // Adds new entry or reschedules existing one
+   void schedule(const std::string &id, int64_t expirationMs, int64_t nowMs);
+   // Entry will be reported as expired on next tick regardless of its deadline
+   void expireNow(const std::string &id);
+   void remove(const std::string &id);
+   void clear();
+
+   TickResult tick(int64_t nowMs);
+
+   bool contains(const std::string &id) const;
+   std::size_t size() const { return entries_.size(); }
+   // Heap size including stale entries not yet collected
+   std::size_t pendingEvents() const { return heap_.size(); }
+
+private:
+   struct Entry {
+      int64_t expirationMs_;
+      uint64_t generation_;
+      bool expired_;
+   };
+
+   struct Event {
+      int64_t wakeupMs_;
+      uint64_t generation_;
+      std::string id_;
+
+      bool operator>(const Event &other) const { return wakeupMs_ > other.wakeupMs_; }
+   };
+
+   int64_t nextWakeup(int64_t expirationMs, int64_t nowMs) const;
+   void push(const std::string &id, Entry &entry, int64_t wakeupMs);
+
+private:
+   const int64_t displayStepMs_;
+   uint64_t generation_ = 0;
+   std::unordered_map<std::string, Entry> entries_;
+   std::priority_queue<Event, std::vector<Event>, std::greater<Event>> heap_;
+};
+
+#endif // RFQ_EXPIRY_SCHEDULER_H
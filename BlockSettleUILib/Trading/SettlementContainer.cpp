@@ -9,6 +9,9 @@
 
 */
 #include "SettlementContainer.h"
+
+#include <algorithm>
+
 #include "UiUtils.h"
 
 using namespace bs;
@@ -30,6 +33,7 @@ SettlementContainer::SettlementContainer(UtxoReservationToken utxoRes
 
 SettlementContainer::~SettlementContainer()
 {
+   TimerWheelService::instance()->cancel(timerHandle_);
    if (utxoRes_.isValid()) {
       QTimer::singleShot(kUtxoReleaseDelay, [utxoRes = std::move(utxoRes_)] () mutable {
          utxoRes.release();
@@ -70,32 +74,35 @@ sync::PasswordDialogData SettlementContainer::toPayOutTxDetailsPasswordDialogDat
    return dialogData;
 }
 
+int SettlementContainer::timeLeftMs() const
+{
+   if (msDuration_ == 0) {
+      return 0;
+   }
+   const auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime_);
+   return std::max(msDuration_ - static_cast<int>(timeDiff.count()), 0);
+}
+
 void SettlementContainer::startTimer(const unsigned int durationSeconds)
 {
-   timer_.stop();
-   timer_.setInterval(250);
+   auto timerService = TimerWheelService::instance();
+   timerService->cancel(timerHandle_);
    msDuration_ = durationSeconds * 1000;
    startTime_ = std::chrono::steady_clock::now();
 
-   connect(&timer_, &QTimer::timeout, [this] {
-      const auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime_);
-      msTimeLeft_ = msDuration_ - timeDiff.count();
-      if (msTimeLeft_ < 0) {
-         timer_.stop();
-         msDuration_ = 0;
-         msTimeLeft_ = 0;
-         emit timerExpired();
-      }
+   timerHandle_ = timerService->schedule(std::chrono::seconds(durationSeconds), this, [this] {
+      timerHandle_ = 0;
+      msDuration_ = 0;
+      emit timerExpired();
    });
-   timer_.start();
    emit timerStarted(msDuration_);
 }
 
 void SettlementContainer::stopTimer()
 {
+   TimerWheelService::instance()->cancel(timerHandle_);
+   timerHandle_ = 0;
    msDuration_ = 0;
-   msTimeLeft_ = 0;
-   timer_.stop();
    emit timerStopped();
 }
 
@@ -21,6 +21,7 @@
 #include "CoreWallet.h"
 #include "EncryptionUtils.h"
 #include "PasswordDialogData.h"
+#include "TimerWheelService.h"
 #include "UtxoReservationToken.h"
 #include "ValidityFlag.h"
 #include "BSErrorCode.h"
@@ -51,7 +52,7 @@ namespace bs {
       virtual double amount() const = 0;
 
       int durationMs() const { return msDuration_; }
-      int timeLeftMs() const { return msTimeLeft_; }
+      int timeLeftMs() const;
 
       virtual bs::sync::PasswordDialogData toPasswordDialogData(QDateTime timestamp) const;
       virtual bs::sync::PasswordDialogData toPayOutTxDetailsPasswordDialogData(bs::core::wallet::TXSignRequest payOutReq
@@ -82,9 +83,8 @@ namespace bs {
       bool expandTxDialogInfo_{};
 
    private:
-      QTimer   timer_;
+      TimerWheelService::Handle  timerHandle_ = 0;
       int      msDuration_ = 0;
-      int      msTimeLeft_ = 0;
       std::chrono::steady_clock::time_point startTime_;
    };
 
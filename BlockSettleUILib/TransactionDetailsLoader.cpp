@@ -0,0 +1,146 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "TransactionDetailsLoader.h"
+
+#include <algorithm>
+
+
+TransactionDetailsLoader::TransactionDetailsLoader(const FetchFunc &fetch, size_t maxInFlight)
+   : fetch_(fetch)
+   , maxInFlight_(maxInFlight > 0 ? maxInFlight : 1)
+{}
+
+void TransactionDetailsLoader::setWanted(const std::vector<Item> &items)
+{
+   std::unordered_set<Item> newWanted(items.cbegin(), items.cend());
+   for (const auto &item : wanted_) {
+      if (newWanted.find(item) == newWanted.end()) {
+         stats_.dropped++;
+      }
+   }
+   wanted_.clear();
+   std::unordered_set<Item> added;
+   for (const auto &item : items) {
+      if (!item || isInFlight(item) || isLoaded(item) || !added.insert(item).second) {
+         continue;
+      }
+      wanted_.push_back(item);
+   }
+   pump();
+}
+
+void TransactionDetailsLoader::request(const Item &item)
+{
+   if (!item || isInFlight(item) || isLoaded(item)) {
+      return;
+   }
+   removeFrom(explicit_, item);
+   explicit_.push_front(item);
+   pump();
+}
+
+void TransactionDetailsLoader::requestBackground(const std::vector<Item> &items)
+{
+   std::unordered_set<Item> queued(background_.cbegin(), background_.cend());
+   for (const auto &item : items) {
+      if (!item || isInFlight(item) || isLoaded(item) || !queued.insert(item).second) {
+         continue;
+      }
+      background_.push_back(item);
+   }
+   pump();
+}
+
+void TransactionDetailsLoader::remove(const Item &item)
+{
+   removeFrom(explicit_, item);
+   removeFrom(wanted_, item);
+   removeFrom(background_, item);
+   inFlight_.erase(item);
+   loaded_.erase(item);
+   pump();
+}
+
+void TransactionDetailsLoader::clear()
+{
+   explicit_.clear();
+   wanted_.clear();
+   background_.clear();
+   inFlight_.clear();
+   loaded_.clear();
+   generation_++;
+}
+
+bool TransactionDetailsLoader::isQueued(const Item &item) const
+{
+   for (const auto *queue : { &explicit_, &wanted_, &background_ }) {
+      if (std::find(queue->cbegin(), queue->cend(), item) != queue->cend()) {
+         return true;
+      }
+   }
+   return false;
+}
+
+void TransactionDetailsLoader::pump()
+{
+   if (pumping_) {   // fetch completed synchronously
+      return;
+   }
+   pumping_ = true;
+   while (inFlight_.size() < maxInFlight_) {
+      Item item;
+      for (auto *queue : { &explicit_, &wanted_, &background_ }) {
+         while (!item && !queue->empty()) {
+            item = queue->front();
+            queue->pop_front();
+            // the same item could be queued with other priority, too
+            if (isInFlight(item) || isLoaded(item)) {
+               item.reset();
+            }
+         }
+         if (item) {
+            break;
+         }
+      }
+      if (!item) {
+         break;
+      }
+      inFlight_.insert(item);
+      stats_.fetched++;
+      const auto generation = generation_;
+      fetch_(item, [this, item, generation](bool loaded) {
+         onFetched(item, generation, loaded);
+      });
+   }
+   pumping_ = false;
+}
+
+void TransactionDetailsLoader::onFetched(const Item &item, uint64_t generation, bool loaded)
+{
+   if (generation != generation_) {
+      return;
+   }
+   if (inFlight_.erase(item) == 0) {
+      return;     // removed meanwhile
+   }
+   if (loaded) {
+      loaded_.insert(item);
+   }
+   else {
+      stats_.failed++;
+   }
+   pump();
+}
+
+void TransactionDetailsLoader::removeFrom(std::deque<Item> &queue, const Item &item)
+{
+   queue.erase(std::remove(queue.begin(), queue.end(), item), queue.end());
+}
@@ -0,0 +1,85 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef TRANSACTION_DETAILS_LOADER_H
+#define TRANSACTION_DETAILS_LOADER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+struct TransactionsViewItem;
+
+// Schedules loading of transaction details (TX, its inputs, direction and
+// main address) for rows which are actually shown. Explicitly requested
+// items go first, then ones in and near the viewport in the given order,
+// then background ones. Number of loads in flight is bounded; queued items
+// which are no longer wanted are dropped before their turn, failed ones
+// could be requested again.
+// Not thread-safe, fetch callbacks should be invoked on the loader's thread.
+class TransactionDetailsLoader
+{
+public:
+   using Item = std::shared_ptr<TransactionsViewItem>;
+   using DoneCb = std::function<void(bool loaded)>;
+   using FetchFunc = std::function<void(const Item &, const DoneCb &)>;
+
+   struct Stats
+   {
+      size_t   fetched = 0;
+      size_t   failed = 0;
+      // queued but not wanted any more before being fetched
+      size_t   dropped = 0;
+   };
+
+   static constexpr size_t kDefaultMaxInFlight = 8;
+
+   TransactionDetailsLoader(const FetchFunc &, size_t maxInFlight = kDefaultMaxInFlight);
+
+   // Replaces the previous list of wanted items, most important first
+   void setWanted(const std::vector<Item> &);
+   // E.g. expanded row - goes before all others and stays queued until loaded
+   void request(const Item &);
+   // Loaded after all wanted ones, stay queued until loaded
+   void requestBackground(const std::vector<Item> &);
+   // Item is gone - result of its fetch in flight is ignored
+   void remove(const Item &);
+   void clear();
+
+   bool isQueued(const Item &) const;
+   bool isInFlight(const Item &item) const { return (inFlight_.find(item) != inFlight_.end()); }
+   bool isLoaded(const Item &item) const { return (loaded_.find(item) != loaded_.end()); }
+   size_t queued() const { return explicit_.size() + wanted_.size() + background_.size(); }
+   size_t inFlight() const { return inFlight_.size(); }
+   const Stats &stats() const { return stats_; }
+
+private:
+   void pump();
+   void onFetched(const Item &, uint64_t generation, bool loaded);
+   static void removeFrom(std::deque<Item> &, const Item &);
+
+private:
+   const FetchFunc   fetch_;
+   const size_t      maxInFlight_;
+
+   std::deque<Item>  explicit_;
+   std::deque<Item>  wanted_;
+   std::deque<Item>  background_;
+   std::unordered_set<Item>   inFlight_;
+   std::unordered_set<Item>   loaded_;
+   // results of fetches started before clear() are ignored
+   uint64_t    generation_ = 0;
+   bool        pumping_ = false;
+   Stats       stats_;
+};
+
+#endif // TRANSACTION_DETAILS_LOADER_H
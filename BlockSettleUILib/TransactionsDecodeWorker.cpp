@@ -0,0 +1,91 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "TransactionsDecodeWorker.h"
+
+
+TransactionsDecodeWorker::TransactionsDecodeWorker(const DecodeFunc &decode, const ResultCb &cbResult
+   , size_t maxQueued)
+   : decode_(decode)
+   , cbResult_(cbResult)
+   , maxQueued_(maxQueued > 0 ? maxQueued : 1)
+{
+   thread_ = std::thread(&TransactionsDecodeWorker::process, this);
+}
+
+TransactionsDecodeWorker::~TransactionsDecodeWorker() noexcept
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+      queue_.clear();
+      ++generation_;
+   }
+   cv_.notify_one();
+   if (thread_.joinable()) {
+      thread_.join();
+   }
+}
+
+bool TransactionsDecodeWorker::submit(const std::vector<bs::TXEntry> &entries)
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queue_.size() + (busy_ ? 1 : 0) >= maxQueued_) {
+         return false;
+      }
+      queue_.push_back(entries);
+   }
+   cv_.notify_one();
+   return true;
+}
+
+void TransactionsDecodeWorker::cancel()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   queue_.clear();
+   ++generation_;
+}
+
+size_t TransactionsDecodeWorker::queued() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return queue_.size() + (busy_ ? 1 : 0);
+}
+
+void TransactionsDecodeWorker::process()
+{
+   while (true) {
+      std::vector<bs::TXEntry> entries;
+      uint64_t generation = 0;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+         if (stop_) {
+            return;
+         }
+         entries = std::move(queue_.front());
+         queue_.pop_front();
+         generation = generation_;
+         busy_ = true;
+      }
+
+      const auto isCancelled = [this, generation] {
+         return (generation != generation_);
+      };
+      auto batch = decode_(entries, isCancelled);
+
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         busy_ = false;
+      }
+      cbResult_(generation, std::move(batch));
+   }
+}
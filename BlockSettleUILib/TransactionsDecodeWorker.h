@@ -0,0 +1,83 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef TRANSACTIONS_DECODE_WORKER_H
+#define TRANSACTIONS_DECODE_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ArmoryConnection.h"
+
+class TXNode;
+struct TransactionsViewItem;
+
+// Turns ledger entries into rows of TransactionsViewModel on own thread, one
+// batch at a time in order of submission. Number of waiting and running
+// batches is bounded. cancel() drops waiting batches and marks running one
+// as stale - result callback is still invoked for it, with old generation.
+class TransactionsDecodeWorker
+{
+public:
+   struct Batch
+   {
+      // ready to be inserted, owned by receiver
+      std::vector<TXNode *>   newNodes;
+      // entries which are already in the model
+      std::vector<std::shared_ptr<TransactionsViewItem>> updatedItems;
+      size_t   failed = 0;
+   };
+
+   using IsCancelledFunc = std::function<bool()>;
+   // Invoked on the worker thread, should return early when cancelled
+   using DecodeFunc = std::function<Batch(const std::vector<bs::TXEntry> &, const IsCancelledFunc &)>;
+   // Invoked on the worker thread after each batch
+   using ResultCb = std::function<void(uint64_t generation, Batch)>;
+
+   static constexpr size_t kDefaultMaxQueued = 4;
+
+   TransactionsDecodeWorker(const DecodeFunc &, const ResultCb &, size_t maxQueued = kDefaultMaxQueued);
+   ~TransactionsDecodeWorker() noexcept;
+
+   TransactionsDecodeWorker(const TransactionsDecodeWorker&) = delete;
+   TransactionsDecodeWorker& operator = (const TransactionsDecodeWorker&) = delete;
+
+   // Returns false if too many batches are queued already
+   bool submit(const std::vector<bs::TXEntry> &);
+   void cancel();
+
+   uint64_t generation() const { return generation_; }
+   // Waiting and running batches
+   size_t queued() const;
+   size_t maxQueued() const { return maxQueued_; }
+
+private:
+   void process();
+
+private:
+   const DecodeFunc  decode_;
+   const ResultCb    cbResult_;
+   const size_t      maxQueued_;
+
+   mutable std::mutex      mutex_;
+   std::condition_variable cv_;
+   std::deque<std::vector<bs::TXEntry>>   queue_;
+   bool                    busy_ = false;
+   bool                    stop_ = false;
+   std::atomic<uint64_t>   generation_{ 0 };
+   std::thread             thread_;
+};
+
+#endif // TRANSACTIONS_DECODE_WORKER_H
@@ -0,0 +1,320 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#include "TransactionsSnapshot.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <spdlog/logger.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+   // File layout (host byte order):
+   //   header:  magic, version, top block, row count (uint32 each),
+   //            size of rows, checksum of rows (uint64 each),
+   //            checksum of the preceding bytes (uint64)
+   //   rows:    fields of TransactionsSnapshot::Row in declaration order,
+   //            strings are UTF-8, strings and byte arrays are prefixed
+   //            with their size (uint32)
+   const uint32_t kMagic = 0x53585442;   // "BTXS"
+   const int kHeaderSize = 40;
+   // size field of a damaged file should not make us allocate much
+   const uint32_t kMaxFieldSize = 1024 * 1024;
+
+   uint64_t checksum(const uchar *data, std::size_t size)
+   {  // FNV-1a
+      uint64_t hash = 14695981039346656037ULL;
+      for (std::size_t i = 0; i < size; ++i) {
+         hash ^= data[i];
+         hash *= 1099511628211ULL;
+      }
+      return hash;
+   }
+
+   template <typename T>
+   T readValue(const uchar *data)
+   {
+      T value;
+      std::memcpy(&value, data, sizeof(T));
+      return value;
+   }
+
+   template <typename T>
+   void writeValue(uchar *data, T value)
+   {
+      std::memcpy(data, &value, sizeof(T));
+   }
+
+   class Writer
+   {
+   public:
+      template <typename T>
+      void put(T value)
+      {
+         const auto pos = data_.size();
+         data_.resize(pos + int(sizeof(T)));
+         writeValue<T>(reinterpret_cast<uchar *>(data_.data()) + pos, value);
+      }
+
+      void putBytes(const std::string &bytes)
+      {
+         put<uint32_t>(uint32_t(bytes.size()));
+         data_.append(bytes.data(), int(bytes.size()));
+      }
+
+      void putString(const QString &str)
+      {
+         putBytes(str.toStdString());
+      }
+
+      const QByteArray &data() const { return data_; }
+
+   private:
+      QByteArray  data_;
+   };
+
+   class Reader
+   {
+   public:
+      Reader(const uchar *data, std::size_t size)
+         : data_(data), size_(size)
+      {}
+
+      template <typename T>
+      bool get(T &value)
+      {
+         if (size_ - pos_ < sizeof(T)) {
+            return false;
+         }
+         value = readValue<T>(data_ + pos_);
+         pos_ += sizeof(T);
+         return true;
+      }
+
+      bool getBytes(std::string &bytes)
+      {
+         uint32_t size = 0;
+         if (!get(size) || (size > kMaxFieldSize) || (size_ - pos_ < size)) {
+            return false;
+         }
+         bytes.assign(reinterpret_cast<const char *>(data_ + pos_), size);
+         pos_ += size;
+         return true;
+      }
+
+      bool getString(QString &str)
+      {
+         std::string bytes;
+         if (!getBytes(bytes)) {
+            return false;
+         }
+         str = QString::fromStdString(bytes);
+         return true;
+      }
+
+      bool atEnd() const { return pos_ == size_; }
+
+   private:
+      const uchar *data_;
+      const std::size_t size_;
+      std::size_t pos_ = 0;
+   };
+
+   void writeRow(Writer &writer, const TransactionsSnapshot::Row &row)
+   {
+      writer.putBytes(row.txHash.toBinStr());
+      writer.put<uint32_t>(uint32_t(row.walletIds.size()));
+      for (const auto &walletId : row.walletIds) {
+         writer.putBytes(walletId);
+      }
+      writer.putString(row.walletId);
+      writer.putString(row.walletName);
+      writer.putString(row.mainAddress);
+      writer.putString(row.dirStr);
+      writer.putString(row.amountStr);
+      writer.putString(row.comment);
+      writer.put<double>(row.amount);
+      writer.put<int64_t>(row.value);
+      writer.put<uint32_t>(row.blockNum);
+      writer.put<uint32_t>(row.txTime);
+      writer.put<int32_t>(row.direction);
+      writer.put<uint8_t>(row.isRBF ? 1 : 0);
+   }
+
+   bool readRow(Reader &reader, TransactionsSnapshot::Row &row)
+   {
+      std::string txHash;
+      if (!reader.getBytes(txHash)) {
+         return false;
+      }
+      row.txHash = BinaryData::fromString(txHash);
+
+      uint32_t nbWallets = 0;
+      if (!reader.get(nbWallets) || (nbWallets > kMaxFieldSize)) {
+         return false;
+      }
+      for (uint32_t i = 0; i < nbWallets; ++i) {
+         std::string walletId;
+         if (!reader.getBytes(walletId)) {
+            return false;
+         }
+         row.walletIds.insert(walletId);
+      }
+
+      int32_t direction = 0;
+      uint8_t isRBF = 0;
+      if (!reader.getString(row.walletId) || !reader.getString(row.walletName)
+         || !reader.getString(row.mainAddress) || !reader.getString(row.dirStr)
+         || !reader.getString(row.amountStr) || !reader.getString(row.comment)
+         || !reader.get(row.amount) || !reader.get(row.value) || !reader.get(row.blockNum)
+         || !reader.get(row.txTime) || !reader.get(direction) || !reader.get(isRBF)) {
+         return false;
+      }
+      row.direction = direction;
+      row.isRBF = (isRBF != 0);
+      return true;
+   }
+}
+
+const uint32_t TransactionsSnapshot::kVersion = 1;
+
+bool TransactionsSnapshot::Row::operator==(const Row &other) const
+{
+   return (txHash == other.txHash) && (walletIds == other.walletIds)
+      && (walletId == other.walletId) && (walletName == other.walletName)
+      && (mainAddress == other.mainAddress) && (dirStr == other.dirStr)
+      && (amountStr == other.amountStr) && (comment == other.comment)
+      && (amount == other.amount) && (value == other.value)
+      && (blockNum == other.blockNum) && (txTime == other.txTime)
+      && (direction == other.direction) && (isRBF == other.isRBF);
+}
+
+TransactionsSnapshot::TransactionsSnapshot(const QString &path, const std::shared_ptr<spdlog::logger> &logger)
+   : path_(path)
+   , logger_(logger)
+{}
+
+TransactionsSnapshot::Status TransactionsSnapshot::load(Content &content) const
+{
+   QFile file(path_);
+   if (!file.exists()) {
+      return Status::Missing;
+   }
+   if (!file.open(QIODevice::ReadOnly)) {
+      if (logger_) {
+         logger_->error("[TransactionsSnapshot::load] failed to open {}: {}"
+            , path_.toStdString(), file.errorString().toStdString());
+      }
+      return Status::Missing;
+   }
+   const auto fileData = file.readAll();
+   file.close();
+
+   const auto status = [&content, &fileData] {
+      if (fileData.size() < kHeaderSize) {
+         return Status::Corrupted;
+      }
+      const auto data = reinterpret_cast<const uchar *>(fileData.constData());
+      if (readValue<uint32_t>(data) != kMagic) {
+         return Status::Corrupted;
+      }
+      if (readValue<uint32_t>(data + 4) != kVersion) {
+         return Status::VersionMismatch;
+      }
+      if (readValue<uint64_t>(data + 32) != checksum(data, 32)) {
+         return Status::Corrupted;
+      }
+      const auto rowsSize = readValue<uint64_t>(data + 16);
+      if (rowsSize != uint64_t(fileData.size() - kHeaderSize)) {
+         return Status::Corrupted;
+      }
+      const auto rowsData = data + kHeaderSize;
+      if (readValue<uint64_t>(data + 24) != checksum(rowsData, rowsSize)) {
+         return Status::Corrupted;
+      }
+
+      const auto nbRows = readValue<uint32_t>(data + 12);
+      Content result;
+      result.topBlock = readValue<uint32_t>(data + 8);
+      result.rows.reserve(std::min<std::size_t>(nbRows, rowsSize));
+      Reader reader(rowsData, rowsSize);
+      for (uint32_t i = 0; i < nbRows; ++i) {
+         Row row;
+         if (!readRow(reader, row)) {
+            return Status::Corrupted;
+         }
+         result.rows.push_back(std::move(row));
+      }
+      if (!reader.atEnd()) {
+         return Status::Corrupted;
+      }
+      content = std::move(result);
+      return Status::Loaded;
+   }();
+
+   switch (status) {
+   case Status::Corrupted:
+      if (logger_) {
+         logger_->warn("[TransactionsSnapshot::load] {} is damaged - removing", path_.toStdString());
+      }
+      remove();
+      break;
+   case Status::VersionMismatch:
+      if (logger_) {
+         logger_->info("[TransactionsSnapshot::load] {} is of other version - removing", path_.toStdString());
+      }
+      remove();
+      break;
+   default:
+      break;
+   }
+   return status;
+}
+
+bool TransactionsSnapshot::save(const Content &content) const
+{
+   Writer rows;
+   for (const auto &row : content.rows) {
+      writeRow(rows, row);
+   }
+   const auto rowsData = reinterpret_cast<const uchar *>(rows.data().constData());
+   const auto rowsSize = static_cast<std::size_t>(rows.data().size());
+
+   QByteArray header(kHeaderSize, 0);
+   auto data = reinterpret_cast<uchar *>(header.data());
+   writeValue<uint32_t>(data, kMagic);
+   writeValue<uint32_t>(data + 4, kVersion);
+   writeValue<uint32_t>(data + 8, content.topBlock);
+   writeValue<uint32_t>(data + 12, uint32_t(content.rows.size()));
+   writeValue<uint64_t>(data + 16, rowsSize);
+   writeValue<uint64_t>(data + 24, checksum(rowsData, rowsSize));
+   writeValue<uint64_t>(data + 32, checksum(data, 32));
+
+   // old snapshot stays in place until the new one is completely written
+   QSaveFile file(path_);
+   if (!file.open(QIODevice::WriteOnly)
+      || (file.write(header) != header.size())
+      || (file.write(rows.data()) != rows.data().size())
+      || !file.commit()) {
+      if (logger_) {
+         logger_->error("[TransactionsSnapshot::save] failed to write {}: {}"
+            , path_.toStdString(), file.errorString().toStdString());
+      }
+      return false;
+   }
+   return true;
+}
+
+void TransactionsSnapshot::remove() const
+{
+   QFile::remove(path_);
+}
@@ -0,0 +1,83 @@
+/*
+
+***********************************************************************************
+* Copyright (C) 2019 - 2020, BlockSettle AB
+* Distributed under the GNU Affero General Public License (AGPL v3)
+* See LICENSE or http://www.gnu.org/licenses/agpl.html
+*
+**********************************************************************************
+
+*/
+#ifndef TRANSACTIONS_SNAPSHOT_H
+#define TRANSACTIONS_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <QString>
+#include "BinaryData.h"
+
+namespace spdlog {
+   class logger;
+}
+
+// Prepared rows of TransactionsViewModel saved after each complete load, so
+// that the Transactions tab could show them at startup before the ledger is
+// loaded from Armory. File is replaced at once and holds format version and
+// checksum of the rows - file of other version or with bad checksum is
+// removed and treated as missing.
+class TransactionsSnapshot
+{
+public:
+   struct Row
+   {
+      BinaryData  txHash;
+      std::set<std::string>   walletIds;
+      QString     walletId;
+      QString     walletName;
+      QString     mainAddress;
+      QString     dirStr;
+      QString     amountStr;
+      QString     comment;
+      double      amount = 0;
+      int64_t     value = 0;
+      uint32_t    blockNum = UINT32_MAX;
+      uint32_t    txTime = 0;
+      int         direction = 0;
+      bool        isRBF = false;
+
+      bool operator==(const Row &) const;
+   };
+
+   struct Content
+   {
+      unsigned int      topBlock = 0;
+      std::vector<Row>  rows;
+   };
+
+   enum class Status
+   {
+      Loaded,
+      Missing,
+      VersionMismatch,
+      Corrupted
+   };
+
+   static const uint32_t kVersion;
+
+   TransactionsSnapshot(const QString &path, const std::shared_ptr<spdlog::logger> &logger = nullptr);
+
+   Status load(Content &) const;
+   bool save(const Content &) const;
+   void remove() const;
+
+   const QString &path() const { return path_; }
+
+private:
+   const QString  path_;
+   std::shared_ptr<spdlog::logger>  logger_;
+};
+
+#endif // TRANSACTIONS_SNAPSHOT_H
@@ -19,6 +19,14 @@
 #include <QDateTime>
 #include <QMutexLocker>
 #include <QFutureWatcher>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+   // details of a page which are not received in time are counted as failed
+   const auto kDecodeTimeout = std::chrono::seconds(30);
+}
 
 
 TXNode::TXNode()
@@ -114,6 +122,9 @@ QVariant TXNode::data(int column, int role) const
       default:    return QVariant();
       }
    } else if (role == Qt::TextColorRole) {
+      if (item_->stale) {
+         return colorUnknown_;
+      }
       switch (col) {
       case TransactionsViewModel::Columns::Address:
       case TransactionsViewModel::Columns::Wallet:
@@ -246,6 +257,94 @@ unsigned int TXNode::level() const
 }
 
 
+size_t TXNodeIndex::TxHashHasher::operator()(const BinaryData &txHash) const
+{
+   // TX hashes are uniformly distributed already
+   size_t result = 0;
+   if (txHash.getSize() > 0) {
+      std::memcpy(&result, txHash.getPtr(), std::min(sizeof(result), txHash.getSize()));
+   }
+   return result;
+}
+
+size_t TXNodeIndex::WalletKeyHasher::operator()(const WalletKey &key) const
+{
+   return TxHashHasher()(key.txHash) ^ (std::hash<std::string>()(key.walletId) * 31);
+}
+
+void TXNodeIndex::add(TXNode *node)
+{
+   const auto &entry = node->item()->txEntry;
+   byTxHash_[entry.txHash].push_back(node);
+   for (const auto &walletId : entry.walletIds) {
+      // first added node wins, as with tree search
+      byWallet_.emplace(WalletKey{ entry.txHash, walletId }, node);
+   }
+   ++count_;
+}
+
+void TXNodeIndex::remove(TXNode *node)
+{
+   const auto &entry = node->item()->txEntry;
+   const auto itHash = byTxHash_.find(entry.txHash);
+   if (itHash == byTxHash_.end()) {
+      return;
+   }
+   auto &nodes = itHash->second;
+   const auto itNode = std::find(nodes.begin(), nodes.end(), node);
+   if (itNode == nodes.end()) {
+      return;
+   }
+   nodes.erase(itNode);
+   --count_;
+
+   for (const auto &walletId : entry.walletIds) {
+      const auto it = byWallet_.find({ entry.txHash, walletId });
+      if ((it == byWallet_.end()) || (it->second != node)) {
+         continue;
+      }
+      byWallet_.erase(it);
+      // other node of the same TX could share this wallet
+      for (const auto &other : nodes) {
+         if (other->item()->txEntry.walletIds.count(walletId)) {
+            byWallet_.emplace(WalletKey{ entry.txHash, walletId }, other);
+            break;
+         }
+      }
+   }
+   if (nodes.empty()) {
+      byTxHash_.erase(itHash);
+   }
+}
+
+void TXNodeIndex::clear()
+{
+   byTxHash_.clear();
+   byWallet_.clear();
+   count_ = 0;
+}
+
+TXNode *TXNodeIndex::find(const bs::TXEntry &entry) const
+{
+   for (const auto &walletId : entry.walletIds) {
+      const auto it = byWallet_.find({ entry.txHash, walletId });
+      if (it != byWallet_.end()) {
+         return it->second;
+      }
+   }
+   return nullptr;
+}
+
+std::vector<TXNode *> TXNodeIndex::nodesByTxHash(const BinaryData &txHash) const
+{
+   const auto it = byTxHash_.find(txHash);
+   if (it == byTxHash_.end()) {
+      return {};
+   }
+   return it->second;
+}
+
+
 TransactionsViewModel::TransactionsViewModel(const std::shared_ptr<ArmoryConnection> &armory
                          , const std::shared_ptr<bs::sync::WalletsManager> &walletsManager
                          , const std::shared_ptr<AsyncClient::LedgerDelegate> &ledgerDelegate
@@ -287,6 +386,25 @@ void TransactionsViewModel::init()
 
    rootNode_.reset(new TXNode);
 
+   const auto &decode = [this](const std::vector<bs::TXEntry> &entries
+      , const TransactionsDecodeWorker::IsCancelledFunc &isCancelled)
+   {
+      return decodeEntries(entries, isCancelled);
+   };
+   const auto &cbDecoded = [this](uint64_t generation, TransactionsDecodeWorker::Batch batch)
+   {
+      QMetaObject::invokeMethod(this, [this, generation, batch] {
+         onEntriesDecoded(generation, batch);
+      });
+   };
+   decodeWorker_ = std::make_unique<TransactionsDecodeWorker>(decode, cbDecoded);
+
+   detailsLoader_ = std::make_unique<TransactionDetailsLoader>([this]
+      (const TransactionPtr &item, const TransactionDetailsLoader::DoneCb &cbDone)
+   {
+      fetchDetails(item, cbDone);
+   });
+
    connect(walletsManager_.get(), &bs::sync::WalletsManager::walletChanged, this, &TransactionsViewModel::refresh, Qt::QueuedConnection);
    connect(walletsManager_.get(), &bs::sync::WalletsManager::walletDeleted, this, &TransactionsViewModel::onWalletDeleted, Qt::QueuedConnection);
    connect(walletsManager_.get(), &bs::sync::WalletsManager::walletImportFinished, this, &TransactionsViewModel::refresh, Qt::QueuedConnection);
@@ -299,19 +417,122 @@ void TransactionsViewModel::init()
 
 TransactionsViewModel::~TransactionsViewModel() noexcept
 {
+   // worker uses the model, so it must be stopped first
+   decodeWorker_.reset();
+   if (lazyDetails_ && logger_) {
+      const auto &stats = detailsLoader_->stats();
+      logger_->info("[TransactionsViewModel] details requested for {} of {} rows ({} failed, {} dropped)"
+         ", up to {} getTxByHash/getTXsByHash pairs avoided", stats.fetched, lazyRows_, stats.failed
+         , stats.dropped, (lazyRows_ > stats.fetched) ? lazyRows_ - stats.fetched : 0);
+   }
    cleanup();
    *stopped_ = true;
 }
 
-void TransactionsViewModel::onNewBlock(unsigned int, unsigned int)
+void TransactionsViewModel::onNewBlock(unsigned int height, unsigned int branchHgt)
 {
-   QMetaObject::invokeMethod(this, [this] {
+   QMetaObject::invokeMethod(this, [this, height, branchHgt] {
       if (allWallets_) {
-         loadAllWallets(true);
+         loadNewBlockEntries(height, branchHgt);
       }
    });
 }
 
+void TransactionsViewModel::loadNewBlockEntries(unsigned int height, unsigned int branchHgt)
+{
+   if (!incrementalRefresh_ || !loadedTopBlock_ || !ledgerDelegate_ || !initialLoadCompleted_) {
+      loadAllWallets(true);
+      return;
+   }
+   initialLoadCompleted_ = false;
+   newBlockLoading_ = true;
+
+   QPointer<TransactionsViewModel> thisPtr = this;
+   const auto &cbLoaded = [thisPtr, height, generation = loadGeneration_](IncrementalLedgerLoader::Result result
+      , std::vector<bs::TXEntry> entries, uint32_t pagesLoaded)
+   {
+      QMetaObject::invokeMethod(qApp, [thisPtr, height, generation, result, entries, pagesLoaded] {
+         if (thisPtr) {
+            thisPtr->onNewBlockEntries(generation, result, entries, height, pagesLoaded);
+         }
+      });
+   };
+   IncrementalLedgerLoader::load(std::make_shared<LedgerDelegatePageSource>(ledgerDelegate_)
+      , loadedTopBlock_, height, branchHgt, cbLoaded);
+}
+
+void TransactionsViewModel::onNewBlockEntries(uint64_t generation, IncrementalLedgerLoader::Result result
+   , const std::vector<bs::TXEntry> &entries, unsigned int height, uint32_t pagesLoaded)
+{
+   if (generation != loadGeneration_) {
+      // full reload was started meanwhile and it owns initialLoadCompleted_ now
+      logger_->debug("[TransactionsViewModel::onNewBlockEntries] entries for block {} are dropped", height);
+      return;
+   }
+   newBlockLoading_ = false;
+
+   const auto &knownBlock = [this](const bs::TXEntry &entry, uint32_t &blockNum) {
+      QMutexLocker locker(&updateMutex_);
+      const auto node = nodeIndex_.find(entry);
+      if (!node) {
+         return false;
+      }
+      blockNum = node->item()->txEntry.blockNum;
+      return true;
+   };
+   if ((result == IncrementalLedgerLoader::Result::Loaded)
+      && IncrementalLedgerLoader::isReorg(entries, knownBlock)) {
+      result = IncrementalLedgerLoader::Result::Reorg;
+   }
+
+   switch (result) {
+   case IncrementalLedgerLoader::Result::Loaded:
+      logger_->debug("[TransactionsViewModel::onNewBlockEntries] {} entries from {} page[s] for block {}"
+         , entries.size(), pagesLoaded, height);
+      loadedTopBlock_ = height;
+      updateConfirmations(height);
+      // initialLoadCompleted_ is set when the entries are decoded
+      if (!entries.empty()) {
+         updateTransactionsPage(entries, true);
+      }
+      else {
+         onLoadDecoded();
+      }
+      return;
+
+   case IncrementalLedgerLoader::Result::Reorg:
+      logger_->info("[TransactionsViewModel::onNewBlockEntries] reorg detected at block {}"
+         ", reloading all entries", height);
+      // entries from orphaned blocks should disappear, too
+      clear();
+      break;
+
+   case IncrementalLedgerLoader::Result::Failed:
+      logger_->warn("[TransactionsViewModel::onNewBlockEntries] failed to load new entries"
+         ", reloading all of them");
+      break;
+   }
+   loadedTopBlock_ = 0;
+   initialLoadCompleted_ = true;
+   loadAllWallets(true);
+}
+
+void TransactionsViewModel::updateConfirmations(unsigned int topBlock)
+{
+   if (!rootNode_->hasChildren()) {
+      return;
+   }
+   {
+      QMutexLocker locker(&updateMutex_);
+      for (const auto &node : rootNode_->children()) {
+         const auto &item = node->item();
+         item->confirmations = IncrementalLedgerLoader::confirmations(topBlock, item->txEntry.blockNum);
+      }
+   }
+   emit dataChanged(index(0, static_cast<int>(Columns::Status))
+      , index(rootNode_->nbChildren() - 1, static_cast<int>(Columns::Flag)));
+}
+
 void TransactionsViewModel::loadAllWallets(bool onNewBlock)
 {
    const auto &cbWalletsLD = [this, onNewBlock](const std::shared_ptr<AsyncClient::LedgerDelegate> &delegate) {
@@ -340,6 +561,109 @@ void TransactionsViewModel::loadAllWallets(bool onNewBlock)
    }
 }
 
+void TransactionsViewModel::setSnapshot(const std::shared_ptr<TransactionsSnapshot> &snapshot)
+{
+   snapshot_ = snapshot;
+   loadSnapshot();
+}
+
+void TransactionsViewModel::requestDetails(const std::vector<int> &rows)
+{
+   if (!lazyDetails_) {
+      return;
+   }
+   std::vector<TransactionPtr> items;
+   items.reserve(rows.size());
+   for (const int row : rows) {
+      const auto node = rootNode_->child(row);
+      if (node && node->item() && !node->item()->initialized) {
+         items.push_back(node->item());
+      }
+   }
+   detailsLoader_->setWanted(items);
+}
+
+void TransactionsViewModel::requestDetails(const QModelIndex &index)
+{
+   if (!lazyDetails_) {
+      return;
+   }
+   const auto &item = getItem(index);
+   if (item && !item->initialized) {
+      detailsLoader_->request(item);
+   }
+}
+
+void TransactionsViewModel::requestAllDetails()
+{
+   if (!lazyDetails_) {
+      return;
+   }
+   allDetailsWanted_ = true;
+   std::vector<TransactionPtr> items;
+   for (const auto &node : rootNode_->children()) {
+      const auto &item = node->item();
+      if (!item->initialized) {
+         items.push_back(item);
+      }
+   }
+   detailsLoader_->requestBackground(items);
+}
+
+void TransactionsViewModel::fetchDetails(const TransactionPtr &item, const TransactionDetailsLoader::DoneCb &cbDone)
+{
+   // row could be shown meanwhile, so details are collected in a copy
+   const auto copy = std::make_shared<TransactionsViewItem>(*item);
+   // rows restored from snapshot show its details until they are loaded
+   copy->mainAddress.clear();
+   copy->dirStr.clear();
+   copy->amountStr.clear();
+   if (copy->wallets.empty()) {
+      for (const auto &walletId : copy->txEntry.walletIds) {
+         const auto wallet = walletsManager_->getWalletById(walletId);
+         if (wallet) {
+            copy->wallets.push_back(wallet);
+         }
+      }
+      if (copy->wallets.empty()) {  // wallets are not synced yet
+         cbDone(false);
+         return;
+      }
+   }
+   auto called = std::make_shared<std::atomic_bool>(false);
+   QPointer<TransactionsViewModel> thisPtr = this;
+   updateTransactionDetails(copy, [thisPtr, item, cbDone, called](const TransactionPtr &loaded) {
+      if (called->exchange(true)) {
+         return;
+      }
+      QMetaObject::invokeMethod(qApp, [thisPtr, item, cbDone, loaded] {
+         if (thisPtr) {
+            thisPtr->onDetailsLoaded(item, loaded);
+            cbDone(loaded != nullptr);
+         }
+      });
+   });
+}
+
+void TransactionsViewModel::onDetailsLoaded(const TransactionPtr &item, const TransactionPtr &loaded)
+{
+   if (!loaded) {
+      return;
+   }
+   int row = -1;
+   {
+      QMutexLocker locker(&updateMutex_);
+      const auto node = nodeIndex_.find(item->txEntry);
+      if (!node || (node->item() != item)) {
+         return;     // removed or replaced meanwhile
+      }
+      item->setDetails(*loaded);
+      row = node->row();
+   }
+   emit dataChanged(index(row, static_cast<int>(Columns::first))
+      , index(row, static_cast<int>(Columns::last)));
+}
+
 int TransactionsViewModel::columnCount(const QModelIndex &) const
 {
    return static_cast<int>(Columns::last) + 1;
@@ -505,6 +829,8 @@ QVariant TransactionsViewModel::headerData(int section, Qt::Orientation orientat
 
 void TransactionsViewModel::refresh()
 {
+   // rows being prepared may belong to changed wallets
+   cancelDecoding();
    updatePage();
 }
 
@@ -514,6 +840,27 @@ void TransactionsViewModel::onWalletDeleted(std::string)
    updatePage();
 }
 
+void TransactionsViewModel::cancelDecoding()
+{
+   decodeWorker_->cancel();
+   bool lastOfLoad = std::find(submittedPages_.cbegin(), submittedPages_.cend(), true) != submittedPages_.cend();
+   for (const auto &page : pendingPages_) {
+      lastOfLoad |= page.lastOfLoad;
+   }
+   pendingPages_.clear();
+   submittedPages_.clear();
+   if (newBlockLoading_) {
+      // new block entries may belong to changed wallets, too
+      newBlockLoading_ = false;
+      ++loadGeneration_;
+      lastOfLoad = true;
+   }
+   // the rest of load is dropped, so it won't complete by itself
+   if (lastOfLoad) {
+      initialLoadCompleted_ = true;
+   }
+}
+
 void TransactionsViewModel::updatePage()
 {
    if (allWallets_) {
@@ -524,11 +871,16 @@ void TransactionsViewModel::updatePage()
 void TransactionsViewModel::clear()
 {
    *stopped_ = true;
+   cancelDecoding();
+   detailsLoader_->clear();
    beginResetModel();
    {
       QMutexLocker locker(&updateMutex_);
       rootNode_->clear();
+      nodeIndex_.clear();
       oldestItem_ = {};
+      loadedTopBlock_ = 0;
+      staleCount_ = 0;
    }
    endResetModel();
    *stopped_ = false;
@@ -540,7 +892,7 @@ void TransactionsViewModel::onStateChanged(ArmoryState state)
       if (state == ArmoryState::Offline) {
          ledgerDelegate_.reset();
          clear();
-      } else if ((state == ArmoryState::Ready) && !rootNode_->hasChildren()) {
+      } else if ((state == ArmoryState::Ready) && (!rootNode_->hasChildren() || staleCount_)) {
          loadAllWallets();
       }
    });
@@ -591,7 +943,7 @@ void TransactionsViewModel::onZCInvalidated(const std::set<BinaryData> &ids)
    {
       QMutexLocker locker(&updateMutex_);
       for (const auto &txHash : ids) {
-         const auto invNodes = rootNode_->nodesByTxHash(txHash);
+         const auto invNodes = nodeIndex_.nodesByTxHash(txHash);
          for (const auto &node : invNodes) {
             delRows.push_back(node->row());
          }
@@ -653,170 +1005,349 @@ static bool isChildOf(TransactionPtr child, TransactionPtr parent)
 }
 #endif   //TX_MODEL_NESTED_NODES
 
-std::pair<size_t, size_t> TransactionsViewModel::updateTransactionsPage(const std::vector<bs::TXEntry> &page)
+void TransactionsViewModel::updateTransactionsPage(const std::vector<bs::TXEntry> &page, bool lastOfLoad)
 {
-   struct ItemKey {
-      BinaryData  txHash;
-      std::set<std::string>   walletIds;
-      bool operator<(const ItemKey &ik) const {
-         if (txHash != ik.txHash) {
-            return (txHash < ik.txHash);
-         }
-         return (walletIds < ik.walletIds);
-      }
-   };
-   auto newItems = std::make_shared<std::vector<TXNode *>>();
-   auto updatedItems = std::make_shared<std::vector<TransactionPtr>>();
-   auto newTxKeys = std::make_shared<std::set<ItemKey>>();
+   pendingPages_.push_back({ page, lastOfLoad });
+   feedDecodeWorker();
+}
 
-   const auto mergedPage = allWallets_ ? walletsManager_->mergeEntries(page) : page;
+void TransactionsViewModel::feedDecodeWorker()
+{
+   while (!pendingPages_.empty()) {
+      if (!decodeWorker_->submit(pendingPages_.front().entries)) {
+         break;
+      }
+      submittedPages_.push_back(pendingPages_.front().lastOfLoad);
+      pendingPages_.pop_front();
+   }
+}
 
-   const auto lbdAddNew = [this, newItems, newTxKeys](const TransactionPtr &item)
+TransactionsDecodeWorker::Batch TransactionsViewModel::decodeEntries(const std::vector<bs::TXEntry> &page
+   , const TransactionsDecodeWorker::IsCancelledFunc &isCancelled)
+{
+   struct DecodeState
    {
-      if (!oldestItem_ || (oldestItem_->txEntry.txTime >= item->txEntry.txTime)) {
-         oldestItem_ = item;
-      }
-      newTxKeys->insert({ item->txEntry.txHash, item->txEntry.walletIds });
-      newItems->push_back(new TXNode(item));
+      std::mutex  mutex;
+      std::condition_variable cv;
+      bool        prepared = false;
+      // worker doesn't wait for this page anymore
+      bool        abandoned = false;
+      bool        lazy = false;
+      std::vector<TransactionPtr>   newItems;
+      std::vector<TransactionPtr>   updatedItems;
+      std::vector<int>  results;    // 0 - pending, 1 - initialized, -1 - failed
+      size_t      left = 0;
    };
+   auto state = std::make_shared<DecodeState>();
 
-   const auto mergeItem = [this, updatedItems](const TransactionPtr &item) -> bool
-   {
-      for (const auto &node : rootNode_->children()) {
-         if (!node) {
-            continue;
-         }
-         if (walletsManager_->mergeableEntries(node->item()->txEntry, item->txEntry)) {
-            item->txEntry.merge(node->item()->txEntry);
-            updatedItems->push_back(item);
-            return true;
+   // WalletsManager is not thread-safe, so items are made on the model's thread,
+   // and this thread only waits for details coming from Armory callbacks
+   QMetaObject::invokeMethod(this, [this, page, state] {
+      {
+         std::lock_guard<std::mutex> lock(state->mutex);
+         if (state->abandoned) {
+            return;
          }
       }
-      return false;
-   };
+      const auto mergedPage = allWallets_ ? walletsManager_->mergeEntries(page) : page;
 
-   for (const auto &entry : mergedPage) {
-      const auto item = itemFromTransaction(entry);
-      if (item->wallets.empty()) {
-         continue;
-      }
+      std::vector<TransactionPtr> newItems, updatedItems;
+      for (const auto &entry : mergedPage) {
+         const auto item = itemFromTransaction(entry);
+         if (item->wallets.empty()) {
+            continue;
+         }
 
-      TXNode *node = nullptr;
-      {
          QMutexLocker locker(&updateMutex_);
-         node = rootNode_->find(item->txEntry);
-      }
-      if (node) {
-         updatedItems->push_back(item);
-      }
-      else {
+         // stale rows are replaced with fully loaded ones
+         const auto existing = nodeIndex_.find(item->txEntry);
+         if (existing && !existing->item()->stale) {
+            updatedItems.push_back(item);
+            continue;
+         }
+         bool merged = false;
          if (allWallets_) {
-            if (!mergeItem(item)) {
-               lbdAddNew(item);
+            // only entries of the same TX are mergeable
+            for (const auto &node : nodeIndex_.nodesByTxHash(item->txEntry.txHash)) {
+               if (node->item()->stale) {
+                  continue;
+               }
+               if (walletsManager_->mergeableEntries(node->item()->txEntry, item->txEntry)) {
+                  item->txEntry.merge(node->item()->txEntry);
+                  updatedItems.push_back(item);
+                  merged = true;
+                  break;
+               }
             }
          }
-         else {
-            lbdAddNew(item);
+         if (!merged) {
+            newItems.push_back(item);
          }
       }
-   }
 
-   const auto &cbInited = [this, newItems, updatedItems, newTxKeys]
-      (const TransactionPtr &itemPtr)
-   {
-      if (!itemPtr || !itemPtr->initialized) {
-         logger_->error("item is not inited");
-         return;
-      }
-      if (newTxKeys->empty()) {
-         logger_->warn("TX keys already empty");
-         return;
+      const bool lazy = lazyDetails_;
+      {
+         std::lock_guard<std::mutex> lock(state->mutex);
+         state->lazy = lazy;
+         state->newItems = newItems;
+         state->updatedItems = updatedItems;
+         state->results.resize(lazy ? 0 : newItems.size(), 0);
+         state->left = state->results.size();
+      }
+      if (lazy) {
+         // the rest is loaded later and only for shown rows
+         for (const auto &item : newItems) {
+            item->loadComment();
+         }
       }
-      newTxKeys->erase({ itemPtr->txEntry.txHash, itemPtr->txEntry.walletIds });
-      if (newTxKeys->empty()) {
-#ifdef TX_MODEL_NESTED_NODES
-         std::unordered_set<std::string> deletedItems;
-         if (rootNode_->hasChildren()) {
-            std::vector<int> delRows;
-            const auto &cbEachExisting = [newItems, &delRows](TXNode *txNode) {
-               for (auto &newItem : *newItems) {
-                  if (newItem.second.second->find(txNode->item()->id())
-                     || txNode->find(newItem.first)) {   // avoid looped graphs
-                     continue;
-                  }
-                  if (isChildOf(txNode->item(), newItem.second.first)) {
-                     delRows.push_back(txNode->row());
-                     auto &&children = txNode->children();
-                     newItem.second.second->add(txNode);
-                     for (auto &child : children) {
-                        newItem.second.second->add(child);
-                     }
-                     txNode->clear(false);
-                  }
-                  else if (isChildOf(newItem.second.first, txNode->item())) {
-                     // do nothing, yet
-                  }
-               }
-            };
-            {
-               QMutexLocker locker(&updateMutex_);
-               for (auto &child : rootNode_->children()) {
-                  cbEachExisting(child);
+      else {
+         for (size_t i = 0; i < newItems.size(); ++i) {
+            updateTransactionDetails(newItems[i], [state, i](const TransactionPtr &item) {
+               std::lock_guard<std::mutex> lock(state->mutex);
+               if (state->results[i] != 0) {
+                  return;
                }
-            }
-            if (!delRows.empty()) {
-               onDelRows(delRows);
-            }
+               state->results[i] = (item && item->initialized) ? 1 : -1;
+               state->left--;
+               state->cv.notify_one();
+            });
          }
-         const auto newItemsCopy = *newItems;
-         for (auto &parentItem : *newItems) {
-            if (deletedItems.find(parentItem.first) != deletedItems.end()) {  // don't treat child-parent transitively
-               continue;
-            }
-            for (auto &childItem : newItemsCopy) {
-               if (parentItem.first == childItem.first) { // don't compare with self
-                  continue;
-               }
-               if (deletedItems.find(childItem.first) != deletedItems.end()) {
-                  continue;
-               }
-               if (isChildOf(childItem.second.first, parentItem.second.first)) {
-                  parentItem.second.second->add(childItem.second.second);
-                  deletedItems.insert(childItem.second.first->id());
-               }
-            }
-         }
-         for (const auto &delId : deletedItems) {
-            newItems->erase(delId);
+      }
+      {
+         std::lock_guard<std::mutex> lock(state->mutex);
+         state->prepared = true;
+      }
+      state->cv.notify_one();
+   });
+
+   TransactionsDecodeWorker::Batch batch;
+   const auto deadline = std::chrono::steady_clock::now() + kDecodeTimeout;
+   std::unique_lock<std::mutex> lock(state->mutex);
+   while (!state->prepared || (state->left > 0)) {
+      if (isCancelled()) {
+         state->abandoned = true;
+         return batch;
+      }
+      if (std::chrono::steady_clock::now() >= deadline) {
+         if (!state->prepared) {
+            state->abandoned = true;
+            logger_->error("[TransactionsViewModel::decodeEntries] page of {} entries was not"
+               " prepared in time", page.size());
+            batch.failed = page.size();
+            return batch;
          }
-#endif   //TX_MODEL_NESTED_NODES
-         if (!newItems->empty()) {
-            onNewItems(*newItems);
-            if (signalOnEndLoading_) {
-               signalOnEndLoading_ = false;
-               emit dataLoaded(int(newItems->size()));
+         logger_->error("[TransactionsViewModel::decodeEntries] no details for {} of {} entries"
+            " in time", state->left, state->results.size());
+         // late callbacks see that the entry was counted already
+         for (auto &result : state->results) {
+            if (result == 0) {
+               result = -1;
             }
          }
-         if (!updatedItems->empty()) {
-            updateBlockHeight(*updatedItems);
-         }
+         state->left = 0;
+         break;
       }
-   };
+      state->cv.wait_for(lock, std::chrono::milliseconds(100));
+   }
 
-   const auto newItemsCopy = *newItems;
-   if (!newItemsCopy.empty()) {
-      for (const auto &node : newItemsCopy) {
-         updateTransactionDetails(node->item(), cbInited);
+   batch.updatedItems = state->updatedItems;
+   for (size_t i = 0; i < state->newItems.size(); ++i) {
+      if (state->lazy || (state->results[i] > 0)) {
+         batch.newNodes.push_back(new TXNode(state->newItems[i]));
+      }
+      else {
+         batch.failed++;
       }
    }
-   else {
-      if (!updatedItems->empty()) {
-         updateBlockHeight(*updatedItems);
+   return batch;
+}
+
+void TransactionsViewModel::onEntriesDecoded(uint64_t generation, const TransactionsDecodeWorker::Batch &batch)
+{
+   if (generation != decodeWorker_->generation()) {
+      qDeleteAll(batch.newNodes);
+      feedDecodeWorker();
+      return;
+   }
+   bool lastOfLoad = false;
+   if (!submittedPages_.empty()) {
+      lastOfLoad = submittedPages_.front();
+      submittedPages_.pop_front();
+   }
+   if (batch.failed) {
+      logger_->error("[TransactionsViewModel::onEntriesDecoded] failed to get details of {} entries", batch.failed);
+   }
+
+   for (const auto &node : batch.newNodes) {
+      const auto &item = node->item();
+      if (!oldestItem_ || (oldestItem_->txEntry.txTime >= item->txEntry.txTime)) {
+         oldestItem_ = item;
+      }
+   }
+   if (!batch.newNodes.empty()) {
+      if (lazyDetails_) {
+         lazyRows_ += batch.newNodes.size();
+      }
+      auto newNodes = batch.newNodes;
+      if (staleCount_) {
+         replaceStaleRows(newNodes);
+      }
+      onNewItems(newNodes);
+      if (lazyDetails_ && allDetailsWanted_) {
+         requestAllDetails();
       }
+      if (signalOnEndLoading_) {
+         signalOnEndLoading_ = false;
+         emit dataLoaded(int(batch.newNodes.size()));
+      }
+   }
+   else {
       emit dataLoaded(0);
    }
+   if (!batch.updatedItems.empty()) {
+      updateBlockHeight(batch.updatedItems);
+   }
+   if (lastOfLoad) {
+      onLoadDecoded();
+   }
+   feedDecodeWorker();
+}
 
-   return { newItemsCopy.size(), updatedItems->size() };
+void TransactionsViewModel::onLoadDecoded()
+{
+   // next load may start only when all rows of this one are in place
+   initialLoadCompleted_ = true;
+   if (staleCount_) {
+      removeStaleRows();
+   }
+   saveSnapshot();
+}
+
+void TransactionsViewModel::loadSnapshot()
+{
+   if (!snapshot_ || rootNode_->hasChildren()) {
+      return;
+   }
+   TransactionsSnapshot::Content content;
+   if (snapshot_->load(content) != TransactionsSnapshot::Status::Loaded) {
+      return;
+   }
+
+   std::vector<TXNode *> nodes;
+   nodes.reserve(content.rows.size());
+   for (const auto &row : content.rows) {
+      auto item = std::make_shared<TransactionsViewItem>();
+      item->txEntry.txHash = row.txHash;
+      item->txEntry.walletIds = row.walletIds;
+      item->txEntry.value = row.value;
+      item->txEntry.blockNum = row.blockNum;
+      item->txEntry.txTime = row.txTime;
+      item->txEntry.isRBF = row.isRBF;
+      item->displayDateTime = UiUtils::displayDateTime(row.txTime);
+      item->walletID = row.walletId;
+      item->walletName = row.walletName;
+      item->mainAddress = row.mainAddress;
+      item->direction = static_cast<bs::sync::Transaction::Direction>(row.direction);
+      item->dirStr = row.dirStr;
+      item->amountStr = row.amountStr;
+      item->amount = row.amount;
+      item->comment = row.comment;
+      item->confirmations = IncrementalLedgerLoader::confirmations(content.topBlock, row.blockNum);
+      item->stale = true;
+      nodes.push_back(new TXNode(item));
+   }
+   onNewItems(nodes);
+   staleCount_ = rootNode_->nbChildren();
+   logger_->debug("[TransactionsViewModel::loadSnapshot] {} rows for block {}"
+      , staleCount_, content.topBlock);
+}
+
+void TransactionsViewModel::saveSnapshot()
+{
+   if (!snapshot_) {
+      return;
+   }
+   TransactionsSnapshot::Content content;
+   content.topBlock = loadedTopBlock_;
+   {
+      QMutexLocker locker(&updateMutex_);
+      content.rows.reserve(rootNode_->nbChildren());
+      for (const auto &node : rootNode_->children()) {
+         const auto &item = node->item();
+         // rows never shown with lazy details have nothing to restore
+         if (item->stale || (!item->initialized && item->dirStr.isEmpty())) {
+            continue;
+         }
+         TransactionsSnapshot::Row row;
+         row.txHash = item->txEntry.txHash;
+         row.walletIds = item->txEntry.walletIds;
+         row.walletId = item->walletID;
+         row.walletName = item->walletName;
+         row.mainAddress = item->mainAddress;
+         row.dirStr = item->dirStr;
+         row.amountStr = item->amountStr;
+         row.comment = item->comment;
+         row.amount = item->amount;
+         row.value = item->txEntry.value;
+         row.blockNum = item->txEntry.blockNum;
+         row.txTime = item->txEntry.txTime;
+         row.direction = static_cast<int>(item->direction);
+         row.isRBF = item->txEntry.isRBF;
+         content.rows.push_back(std::move(row));
+      }
+   }
+   snapshot_->save(content);
+}
+
+void TransactionsViewModel::replaceStaleRows(std::vector<TXNode *> &newItems)
+{
+   std::vector<TXNode *> rest;
+   rest.reserve(newItems.size());
+   for (const auto &newItem : newItems) {
+      TXNode *node = nullptr;
+      {
+         QMutexLocker locker(&updateMutex_);
+         node = nodeIndex_.find(newItem->item()->txEntry);
+         if (!node || !node->item()->stale) {
+            rest.push_back(newItem);
+            continue;
+         }
+         auto &freshItem = *newItem->item();
+         const auto &staleItem = node->item();
+         if (!freshItem.initialized) {
+            if (staleItem->initialized) {    // loaded while the row was restored
+               freshItem.setDetails(*staleItem);
+            }
+            else {   // keep showing snapshot details until they are loaded
+               freshItem.mainAddress = staleItem->mainAddress;
+               freshItem.direction = staleItem->direction;
+               freshItem.dirStr = staleItem->dirStr;
+               freshItem.amountStr = staleItem->amountStr;
+               freshItem.amount = staleItem->amount;
+            }
+         }
+         nodeIndex_.remove(node);
+         node->setData(freshItem);
+         nodeIndex_.add(node);
+      }
+      delete newItem;
+      staleCount_--;
+      emit dataChanged(index(node->row(), static_cast<int>(Columns::first))
+         , index(node->row(), static_cast<int>(Columns::last)));
+   }
+   newItems.swap(rest);
+}
+
+void TransactionsViewModel::removeStaleRows()
+{
+   std::vector<int> rows;
+   for (const auto &node : rootNode_->children()) {
+      if (node->item()->stale) {
+         rows.push_back(node->row());
+      }
+   }
+   logger_->debug("[TransactionsViewModel::removeStaleRows] {} rows are not in ledger", rows.size());
+   onDelRows(rows);
 }
 
 void TransactionsViewModel::updateBlockHeight(const std::vector<std::shared_ptr<TransactionsViewItem>> &updItems)
@@ -830,7 +1361,7 @@ void TransactionsViewModel::updateBlockHeight(const std::vector<std::shared_ptr<
       TXNode *node = nullptr;
       {
          QMutexLocker locker(&updateMutex_);
-         node = rootNode_->find(updItem->txEntry);
+         node = nodeIndex_.find(updItem->txEntry);
       }
       if (!node) {
          continue;
@@ -842,9 +1373,16 @@ void TransactionsViewModel::updateBlockHeight(const std::vector<std::shared_ptr<
       if (item->txEntry.value != updItem->txEntry.value) {
          item->wallets = updItem->wallets;
          item->walletID = updItem->walletID;
-         item->txEntry = updItem->txEntry;
-         item->amountStr.clear();
-         item->calcAmount(walletsManager_);
+         {  // merged entry may have more wallets
+            QMutexLocker locker(&updateMutex_);
+            nodeIndex_.remove(node);
+            item->txEntry = updItem->txEntry;
+            nodeIndex_.add(node);
+         }
+         if (item->initialized) {   // otherwise it's calculated with details
+            item->amountStr.clear();
+            item->calcAmount(walletsManager_);
+         }
       }
       const auto newBlockNum = updItem->txEntry.blockNum;
       if (newBlockNum != UINT32_MAX) {
@@ -862,7 +1400,7 @@ void TransactionsViewModel::updateBlockHeight(const std::vector<std::shared_ptr<
 void TransactionsViewModel::onItemConfirmed(const TransactionPtr item)
 {
    if (item->txEntry.isRBF && (item->confirmations == 1)) {
-      const auto node = rootNode_->find(item->txEntry);
+      const auto node = nodeIndex_.find(item->txEntry);
       if (node && node->hasChildren()) {
          beginRemoveRows(index(node->row(), 0), 0, node->nbChildren() - 1);
          node->clear();
@@ -885,7 +1423,9 @@ void TransactionsViewModel::onRefreshTxValidity()
       if (item->isValid != newState) {
          item->isValid = newState;
          // Update balance in case lotSize_ is received after CC gen file loaded
-         item->calcAmount(walletsManager_);
+         if (item->initialized) {
+            item->calcAmount(walletsManager_);
+         }
          emit dataChanged(index(i, static_cast<int>(Columns::first))
          , index(i, static_cast<int>(Columns::last)));
       }
@@ -901,12 +1441,14 @@ void TransactionsViewModel::loadLedgerEntries(bool onNewBlock)
       return;
    }
    initialLoadCompleted_ = false;
+   ++loadGeneration_;
 
    QPointer<TransactionsViewModel> thisPtr = this;
    auto rawData = std::make_shared<std::map<int, std::vector<bs::TXEntry>>>();
    auto rawDataMutex = std::make_shared<std::mutex>();
+   const auto topBlock = armory_->topBlock();
 
-   const auto &cbPageCount = [thisPtr, onNewBlock, stopped = stopped_, logger = logger_, rawData, rawDataMutex, ledgerDelegate = ledgerDelegate_]
+   const auto &cbPageCount = [thisPtr, onNewBlock, stopped = stopped_, logger = logger_, rawData, rawDataMutex, ledgerDelegate = ledgerDelegate_, topBlock]
       (ReturnMessage<uint64_t> pageCnt)
    {
       try {
@@ -930,7 +1472,7 @@ void TransactionsViewModel::loadLedgerEntries(bool onNewBlock)
                break;
             }
 
-            const auto &cbLedger = [thisPtr, onNewBlock, pageId, inPageCnt, rawData, logger, rawDataMutex]
+            const auto &cbLedger = [thisPtr, onNewBlock, pageId, inPageCnt, rawData, logger, rawDataMutex, topBlock]
                (ReturnMessage<std::vector<ClientClasses::LedgerEntry>> entries)->void {
                try {
                   auto le = entries.get();
@@ -944,8 +1486,9 @@ void TransactionsViewModel::loadLedgerEntries(bool onNewBlock)
                   }
 
                   if (int(rawData->size()) >= inPageCnt) {
-                     QMetaObject::invokeMethod(qApp, [thisPtr, rawData, onNewBlock] {
+                     QMetaObject::invokeMethod(qApp, [thisPtr, rawData, onNewBlock, topBlock] {
                         if (thisPtr) {
+                           thisPtr->loadedTopBlock_ = topBlock;
                            thisPtr->ledgerToTxData(*rawData, onNewBlock);
                         }
                      });
@@ -981,10 +1524,9 @@ void TransactionsViewModel::ledgerToTxData(const std::map<int, std::vector<bs::T
 
    signalOnEndLoading_ = true;
    for (const auto &le : rawData) {
-      updateTransactionsPage(le.second);
+      updateTransactionsPage(le.second, (pageCnt + 1 == int(rawData.size())));
       emit updateProgress(int(rawData.size()) + pageCnt++);
    }
-   initialLoadCompleted_ = true;
 }
 
 void TransactionsViewModel::onNewItems(const std::vector<TXNode *> &newItems)
@@ -1005,11 +1547,14 @@ void TransactionsViewModel::onNewItems(const std::vector<TXNode *> &newItems)
 
    std::vector<TXNode *> actualChanges(newItems.size());
    int nextInserPosition = 0;
-   for (const auto &newItem : newItems) {
-      if (rootNode_->find(newItem->item()->txEntry)) {
-         continue;
+   {
+      QMutexLocker locker(&updateMutex_);
+      for (const auto &newItem : newItems) {
+         if (nodeIndex_.find(newItem->item()->txEntry)) {
+            continue;
+         }
+         actualChanges[nextInserPosition++] = newItem;
       }
-      actualChanges[nextInserPosition++] = newItem;
    }
    actualChanges.resize(nextInserPosition);
 
@@ -1022,6 +1567,7 @@ void TransactionsViewModel::onNewItems(const std::vector<TXNode *> &newItems)
       beginInsertRows(QModelIndex(), curLastIdx, curLastIdx + actualChanges.size() - 1);
       for (const auto &newItem : actualChanges) {
          rootNode_->add(newItem);
+         nodeIndex_.add(newItem);
       }
       endInsertRows();
    }
@@ -1039,6 +1585,11 @@ void TransactionsViewModel::onDelRows(std::vector<int> rows)
       }
 
       beginRemoveRows(QModelIndex(), row, row);
+      if (rootNode_->child(row)->item()->stale) {
+         staleCount_--;
+      }
+      detailsLoader_->remove(rootNode_->child(row)->item());
+      nodeIndex_.remove(rootNode_->child(row));
       rootNode_->del(row);
       endRemoveRows();
       rowCnt--;
@@ -1174,12 +1725,7 @@ void TransactionsViewItem::initialize(const TransactionPtr &item, ArmoryConnecti
          return;
       }
       if (item->comment.isEmpty()) {
-         item->comment = item->wallets.empty() ? QString()
-            : QString::fromStdString(item->wallets[0]->getTransactionComment(item->txEntry.txHash));
-         const auto endLineIndex = item->comment.indexOf(QLatin1Char('\n'));
-         if (endLineIndex != -1) {
-            item->comment = item->comment.left(endLineIndex) + QLatin1String("...");
-         }
+         item->loadComment();
       }
 
       if (!item->tx.isInitialized()) {
@@ -1333,6 +1879,36 @@ void TransactionsViewItem::calcAmount(const std::shared_ptr<bs::sync::WalletsMan
    }
 }
 
+void TransactionsViewItem::loadComment()
+{
+   comment = wallets.empty() ? QString()
+      : QString::fromStdString(wallets[0]->getTransactionComment(txEntry.txHash));
+   const auto endLineIndex = comment.indexOf(QLatin1Char('\n'));
+   if (endLineIndex != -1) {
+      comment = comment.left(endLineIndex) + QLatin1String("...");
+   }
+}
+
+void TransactionsViewItem::setDetails(const TransactionsViewItem &other)
+{
+   tx = other.tx;
+   initialized = other.initialized;
+   mainAddress = other.mainAddress;
+   addressCount = other.addressCount;
+   direction = other.direction;
+   dirStr = other.dirStr;
+   comment = other.comment;
+   amountStr = other.amountStr;
+   amount = other.amount;
+   txOutIndex = other.txOutIndex;
+   txMultipleOutIndex = other.txMultipleOutIndex;
+   isCPFP = other.isCPFP;
+   parentId = other.parentId;
+   groupId = other.groupId;
+   txHashesReceived = other.txHashesReceived;
+   txIns = other.txIns;
+}
+
 bool TransactionsViewItem::containsInputsFrom(const Tx &inTx) const
 {
    const bs::TxChecker checker(tx);
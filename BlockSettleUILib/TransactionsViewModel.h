@@ -12,6 +12,7 @@
 #define __TRANSACTIONS_VIEW_MODEL_H__
 
 #include <deque>
+#include <unordered_map>
 #include <unordered_set>
 #include <QAbstractItemModel>
 #include <QMutex>
@@ -22,6 +23,10 @@
 #include <atomic>
 #include "ArmoryConnection.h"
 #include "AsyncClient.h"
+#include "IncrementalLedgerLoader.h"
+#include "TransactionDetailsLoader.h"
+#include "TransactionsDecodeWorker.h"
+#include "TransactionsSnapshot.h"
 #include "Wallets/SyncWallet.h"
 
 namespace spdlog {
@@ -59,6 +64,8 @@ struct TransactionsViewItem
    bs::sync::TxValidity isValid = bs::sync::TxValidity::Invalid;
    bool     isCPFP = false;
    int confirmations = 0;
+   // restored from snapshot, not loaded from Armory yet
+   bool     stale = false;
 
    BinaryData  parentId;   // universal grouping support
    BinaryData  groupId;
@@ -68,6 +75,9 @@ struct TransactionsViewItem
       , const std::shared_ptr<bs::sync::WalletsManager> &
       , std::function<void(const TransactionPtr &)>);
    void calcAmount(const std::shared_ptr<bs::sync::WalletsManager> &);
+   void loadComment();
+   // Copies fields filled by initialize()
+   void setDetails(const TransactionsViewItem &);
    bool containsInputsFrom(const Tx &tx) const;
 
    bool isRBFeligible() const;
@@ -120,6 +130,46 @@ private:
    QColor   colorGray_, colorRed_, colorYellow_, colorGreen_, colorInvalid_, colorUnknown_;
 };
 
+// Lookup of top-level nodes by TX hash and by (TX hash, wallet id), kept in
+// sync with the tree by the model to avoid walking all nodes on each entry.
+// Node's txEntry must not change between add() and remove().
+class TXNodeIndex
+{
+public:
+   void add(TXNode *);
+   void remove(TXNode *);
+   void clear();
+
+   // Same match as TXNode::find(): equal hash and intersecting wallet sets
+   TXNode *find(const bs::TXEntry &) const;
+   std::vector<TXNode *> nodesByTxHash(const BinaryData &) const;
+   size_t size() const { return count_; }
+
+private:
+   struct TxHashHasher
+   {
+      size_t operator()(const BinaryData &) const;
+   };
+   struct WalletKey
+   {
+      BinaryData  txHash;
+      std::string walletId;
+
+      bool operator==(const WalletKey &other) const
+      {
+         return (txHash == other.txHash) && (walletId == other.walletId);
+      }
+   };
+   struct WalletKeyHasher
+   {
+      size_t operator()(const WalletKey &) const;
+   };
+
+   std::unordered_map<BinaryData, std::vector<TXNode *>, TxHashHasher>  byTxHash_;
+   std::unordered_map<WalletKey, TXNode *, WalletKeyHasher>             byWallet_;
+   size_t   count_ = 0;
+};
+
 Q_DECLARE_METATYPE(TransactionsViewItem)
 Q_DECLARE_METATYPE(TransactionItems)
 
@@ -149,6 +199,28 @@ public:
    void loadAllWallets(bool onNewBlock=false);
    size_t itemsCount() const { return rootNode_->nbChildren(); }
 
+   // On new block load only entries since previously loaded top block
+   // instead of all ledger pages (enabled by default)
+   void setIncrementalRefresh(bool enabled) { incrementalRefresh_ = enabled; }
+   bool incrementalRefresh() const { return incrementalRefresh_; }
+
+   // Shows rows from snapshot until they are replaced with loaded ones (rows
+   // not found in ledger are removed), snapshot is rewritten after each load
+   void setSnapshot(const std::shared_ptr<TransactionsSnapshot> &);
+
+   // Rows are inserted without details (direction, address and amount from
+   // TX inputs and outputs) which are loaded only for rows requested by
+   // views (disabled by default)
+   void setLazyDetails(bool enabled) { lazyDetails_ = enabled; }
+   bool lazyDetails() const { return lazyDetails_; }
+   // Rows in and near the viewport, most important first
+   void requestDetails(const std::vector<int> &rows);
+   // Expanded or picked row
+   void requestDetails(const QModelIndex &);
+   // All rows after requested ones, e.g. for sorting or filtering by details
+   void requestAllDetails();
+   const TransactionDetailsLoader::Stats &detailsStats() const { return detailsLoader_->stats(); }
+
 public:
    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -183,9 +255,27 @@ private:
    void init();
    void clear();
    void loadLedgerEntries(bool onNewBlock=false);
+   void loadNewBlockEntries(unsigned int height, unsigned int branchHgt);
+   void onNewBlockEntries(uint64_t generation, IncrementalLedgerLoader::Result, const std::vector<bs::TXEntry> &
+      , unsigned int height, uint32_t pagesLoaded);
+   void updateConfirmations(unsigned int topBlock);
    void ledgerToTxData(const std::map<int, std::vector<bs::TXEntry>> &rawData
       , bool onNewBlock=false);
-   std::pair<size_t, size_t> updateTransactionsPage(const std::vector<bs::TXEntry> &);
+   // Entries are turned into rows by decode worker
+   void updateTransactionsPage(const std::vector<bs::TXEntry> &, bool lastOfLoad = false);
+   void feedDecodeWorker();
+   // Drops pages which are not decoded yet
+   void cancelDecoding();
+   TransactionsDecodeWorker::Batch decodeEntries(const std::vector<bs::TXEntry> &
+      , const TransactionsDecodeWorker::IsCancelledFunc &);
+   void onEntriesDecoded(uint64_t generation, const TransactionsDecodeWorker::Batch &);
+   void onLoadDecoded();
+   void loadSnapshot();
+   void saveSnapshot();
+   void replaceStaleRows(std::vector<TXNode *> &newItems);
+   void removeStaleRows();
+   void fetchDetails(const TransactionPtr &, const TransactionDetailsLoader::DoneCb &);
+   void onDetailsLoaded(const TransactionPtr &item, const TransactionPtr &loaded);
    void updateBlockHeight(const std::vector<std::shared_ptr<TransactionsViewItem>> &);
    void updateTransactionDetails(const TransactionPtr &item
       , const std::function<void(const TransactionPtr &)> &cb);
@@ -221,6 +311,7 @@ public:
 
 private:
    std::unique_ptr<TXNode> rootNode_;
+   TXNodeIndex             nodeIndex_;
    TransactionPtr oldestItem_;
    std::shared_ptr<spdlog::logger>     logger_;
    std::shared_ptr<AsyncClient::LedgerDelegate> ledgerDelegate_;
@@ -231,6 +322,12 @@ private:
    const bool        allWallets_;
    std::shared_ptr<std::atomic_bool>  stopped_;
    std::atomic_bool  initialLoadCompleted_{ true };
+   bool              incrementalRefresh_{ true };
+   // top block at the moment of last complete load, 0 if nothing is loaded
+   unsigned int      loadedTopBlock_{ 0 };
+   // incremented when full reload starts, incremental loads of older ones are dropped
+   uint64_t          loadGeneration_{ 0 };
+   bool              newBlockLoading_{ false };
 
    // If set, amount field will show only related address balance changes
    // (without fees because fees are related to transaction, not address).
@@ -240,6 +337,26 @@ private:
 
    // Tx that could be revoked
    std::map<BinaryData, bool> revocableTxs_;
+
+   struct LedgerPage
+   {
+      std::vector<bs::TXEntry>   entries;
+      bool  lastOfLoad;
+   };
+   // pages waiting for free slot in decode worker queue
+   std::deque<LedgerPage>  pendingPages_;
+   // lastOfLoad of pages submitted to decode worker, in the same order
+   std::deque<bool>        submittedPages_;
+   std::unique_ptr<TransactionsDecodeWorker> decodeWorker_;
+
+   std::shared_ptr<TransactionsSnapshot>  snapshot_;
+   size_t            staleCount_{ 0 };
+
+   std::atomic_bool  lazyDetails_{ false };
+   bool              allDetailsWanted_{ false };
+   std::unique_ptr<TransactionDetailsLoader> detailsLoader_;
+   // rows inserted without details
+   size_t            lazyRows_{ 0 };
 };
 
 #endif // __TRANSACTIONS_VIEW_MODEL_H__
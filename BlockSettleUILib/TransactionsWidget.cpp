@@ -200,47 +200,21 @@ TransactionsWidget::TransactionsWidget(QWidget* parent)
       auto addressIndex = model_->index(index.row(), static_cast<int>(TransactionsViewModel::Columns::Address));
       curAddress_ = model_->data(addressIndex).toString();
 
-      contextMenu_.clear();
-
+      pendingMenuIndex_ = QPersistentModelIndex();
       if (sortFilterModel_) {
          const auto &sourceIndex = sortFilterModel_->mapToSource(ui_->treeViewTransactions->indexAt(p));
+         fillContextMenu(sourceIndex);
          const auto &txNode = model_->getNode(sourceIndex);
-         if (txNode && txNode->item() && txNode->item()->initialized) {
-            if (txNode->item()->isRBFeligible() && (txNode->level() < 2)) {
-               contextMenu_.addAction(actionRBF_);
-               actionRBF_->setData(sourceIndex);
-            }
-            else {
-               actionRBF_->setData(-1);
-            }
-
-            if (txNode->item()->isCPFPeligible()) {
-               contextMenu_.addAction(actionCPFP_);
-               actionCPFP_->setData(sourceIndex);
-            }
-            else {
-               actionCPFP_->setData(-1);
-            }
-
-            if (txNode->item()->isPayin()) {
-               contextMenu_.addAction(actionRevoke_);
-               actionRevoke_->setData(sourceIndex);
-               actionRevoke_->setEnabled(model_->isTxRevocable(txNode->item()->tx));
-            }
-            else {
-               actionRevoke_->setData(-1);
-            }
-
-            // save transaction id and add context menu for copying it to clipboard
-            curTx_ = QString::fromStdString(txNode->item()->txEntry.txHash.toHexStr(true));
-            contextMenu_.addAction(actionCopyTx_);
-
-            // allow copy address only if there is only 1 address
-            if (txNode->item()->addressCount == 1) {
-               contextMenu_.addAction(actionCopyAddr_);
-            }
+         if (txNode && txNode->item() && !txNode->item()->initialized) {
+            // menu is rebuilt in place once details arrive
+            pendingMenuIndex_ = sourceIndex;
+            pendingMenuPos_ = ui_->treeViewTransactions->mapToGlobal(p);
+            model_->requestDetails(sourceIndex);
          }
       }
+      else {
+         contextMenu_.clear();
+      }
       contextMenu_.popup(ui_->treeViewTransactions->mapToGlobal(p));
    });
    ui_->treeViewTransactions->setUniformRowHeights(true);
@@ -249,6 +223,9 @@ TransactionsWidget::TransactionsWidget(QWidget* parent)
    ui_->treeViewTransactions->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
 
    connect(ui_->typeFilterComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), [&](int index) {
+      if (model_ && (index != bs::sync::Transaction::Unknown)) {
+         model_->requestAllDetails();  // direction is a part of details
+      }
       sortFilterModel_->updateFilters(sortFilterModel_->walletIds, sortFilterModel_->searchString
          , static_cast<bs::sync::Transaction::Direction>(index));
    });
@@ -293,12 +270,78 @@ void TransactionsWidget::init(const std::shared_ptr<bs::sync::WalletsManager> &w
    scheduleDateFilterCheck();
 }
 
+void TransactionsWidget::fillContextMenu(const QModelIndex &sourceIndex)
+{
+   contextMenu_.clear();
+
+   const auto &txNode = model_->getNode(sourceIndex);
+   if (!txNode || !txNode->item()) {
+      return;
+   }
+   if (!txNode->item()->initialized) {
+      auto loadingAction = contextMenu_.addAction(tr("Loading transaction details..."));
+      loadingAction->setEnabled(false);
+      return;
+   }
+
+   if (txNode->item()->isRBFeligible() && (txNode->level() < 2)) {
+      contextMenu_.addAction(actionRBF_);
+      actionRBF_->setData(sourceIndex);
+   }
+   else {
+      actionRBF_->setData(-1);
+   }
+
+   if (txNode->item()->isCPFPeligible()) {
+      contextMenu_.addAction(actionCPFP_);
+      actionCPFP_->setData(sourceIndex);
+   }
+   else {
+      actionCPFP_->setData(-1);
+   }
+
+   if (txNode->item()->isPayin()) {
+      contextMenu_.addAction(actionRevoke_);
+      actionRevoke_->setData(sourceIndex);
+      actionRevoke_->setEnabled(model_->isTxRevocable(txNode->item()->tx));
+   }
+   else {
+      actionRevoke_->setData(-1);
+   }
+
+   // save transaction id and add context menu for copying it to clipboard
+   curTx_ = QString::fromStdString(txNode->item()->txEntry.txHash.toHexStr(true));
+   contextMenu_.addAction(actionCopyTx_);
+
+   // allow copy address only if there is only 1 address
+   if (txNode->item()->addressCount == 1) {
+      contextMenu_.addAction(actionCopyAddr_);
+   }
+}
+
+void TransactionsWidget::onModelDataChanged(const QModelIndex &, const QModelIndex &)
+{
+   if (!pendingMenuIndex_.isValid() || !contextMenu_.isVisible()) {
+      return;
+   }
+   const auto &txNode = model_->getNode(pendingMenuIndex_);
+   if (!txNode || !txNode->item() || !txNode->item()->initialized) {
+      return;
+   }
+   const QModelIndex sourceIndex = pendingMenuIndex_;
+   pendingMenuIndex_ = QPersistentModelIndex();
+   contextMenu_.hide();
+   fillContextMenu(sourceIndex);
+   contextMenu_.popup(pendingMenuPos_);
+}
+
 void TransactionsWidget::SetTransactionsModel(const std::shared_ptr<TransactionsViewModel>& model)
 {
    model_ = model;
    connect(model_.get(), &TransactionsViewModel::dataLoaded, this, &TransactionsWidget::onDataLoaded, Qt::QueuedConnection);
    connect(model_.get(), &TransactionsViewModel::initProgress, this, &TransactionsWidget::onProgressInited);
    connect(model_.get(), &TransactionsViewModel::updateProgress, this, &TransactionsWidget::onProgressUpdated);
+   connect(model_.get(), &TransactionsViewModel::dataChanged, this, &TransactionsWidget::onModelDataChanged);
 
    sortFilterModel_ = new TransactionsSortFilterModel(appSettings_, this);
    sortFilterModel_->setSourceModel(model.get());
@@ -318,6 +361,9 @@ void TransactionsWidget::SetTransactionsModel(const std::shared_ptr<Transactions
    connect(ui_->dateEditEnd, &QDateTimeEdit::dateTimeChanged, updateDateTimes);
 
    connect(ui_->searchField, &QLineEdit::textChanged, [=](const QString& text) {
+      if (!text.isEmpty()) {
+         model_->requestAllDetails();  // address is a part of details
+      }
       sortFilterModel_->updateFilters(sortFilterModel_->walletIds, text, sortFilterModel_->transactionDirection);
    });
 
@@ -328,6 +374,19 @@ void TransactionsWidget::SetTransactionsModel(const std::shared_ptr<Transactions
    ui_->treeViewTransactions->sortByColumn(static_cast<int>(TransactionsViewModel::Columns::Date), Qt::DescendingOrder);
    ui_->treeViewTransactions->sortByColumn(static_cast<int>(TransactionsViewModel::Columns::Status), Qt::AscendingOrder);
 
+   connect(ui_->treeViewTransactions->header(), &QHeaderView::sortIndicatorChanged, this, [this](int column) {
+      switch (static_cast<TransactionsViewModel::Columns>(column)) {
+      case TransactionsViewModel::Columns::SendReceive:
+      case TransactionsViewModel::Columns::Address:
+      case TransactionsViewModel::Columns::Amount:
+      case TransactionsViewModel::Columns::Flag:
+         model_->requestAllDetails();
+         break;
+      default: break;
+      }
+   });
+   trackVisibleRows(ui_->treeViewTransactions);
+
 //   ui_->treeViewTransactions->hideColumn(static_cast<int>(TransactionsViewModel::Columns::MissedBlocks));
 }
 
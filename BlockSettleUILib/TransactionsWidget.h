@@ -66,12 +66,16 @@ private slots:
    void onDataLoaded(int count);
    void onProgressInited(int start, int end);
    void onProgressUpdated(int value);
+   void onModelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
 
 private:
    void scheduleDateFilterCheck();
+   void fillContextMenu(const QModelIndex &sourceIndex);
    std::unique_ptr<Ui::TransactionsWidget> ui_;
 
    TransactionsSortFilterModel         *  sortFilterModel_;
+   QPersistentModelIndex   pendingMenuIndex_;
+   QPoint                  pendingMenuPos_;
    
 };
 
@@ -22,8 +22,19 @@
 #include "UiUtils.h"
 #include "UtxoReservationManager.h"
 #include <spdlog/spdlog.h>
+#include <QAbstractProxyModel>
 #include <QApplication>
 #include <QClipboard>
+#include <QScrollBar>
+#include <QTimer>
+#include <QTreeView>
+
+namespace {
+   // rows loaded in advance above and below the viewport, in viewport heights
+   const int kPrefetchPages = 1;
+   // coalesces updates while scrolling
+   const int kVisibleRowsUpdateDelayMs = 50;
+}
 
 
 TransactionsWidgetInterface::TransactionsWidgetInterface(QWidget *parent)
@@ -67,6 +78,99 @@ void TransactionsWidgetInterface::init(const std::shared_ptr<bs::sync::WalletsMa
    connect(signContainer_.get(), &SignContainer::TXSigned, this, &TransactionsWidgetInterface::onTXSigned);
 }
 
+void TransactionsWidgetInterface::trackVisibleRows(QTreeView *view)
+{
+   trackedView_ = view;
+   if (!visibleRowsTimer_) {
+      visibleRowsTimer_ = new QTimer(this);
+      visibleRowsTimer_->setSingleShot(true);
+      visibleRowsTimer_->setInterval(kVisibleRowsUpdateDelayMs);
+      connect(visibleRowsTimer_, &QTimer::timeout, this, &TransactionsWidgetInterface::requestVisibleDetails);
+   }
+
+   connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view->verticalScrollBar(), &QScrollBar::rangeChanged, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view->model(), &QAbstractItemModel::rowsInserted, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view->model(), &QAbstractItemModel::rowsRemoved, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view->model(), &QAbstractItemModel::layoutChanged, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view->model(), &QAbstractItemModel::modelReset, this, &TransactionsWidgetInterface::scheduleVisibleRowsUpdate);
+   connect(view, &QTreeView::expanded, this, [this](const QModelIndex &index) {
+      if (model_) {
+         model_->requestDetails(sourceIndex(index));
+      }
+   });
+   scheduleVisibleRowsUpdate();
+}
+
+QModelIndex TransactionsWidgetInterface::sourceIndex(const QModelIndex &index) const
+{
+   auto result = index;
+   while (const auto proxy = qobject_cast<const QAbstractProxyModel *>(result.model())) {
+      result = proxy->mapToSource(result);
+   }
+   return result;
+}
+
+void TransactionsWidgetInterface::showEvent(QShowEvent *event)
+{
+   TabWithShortcut::showEvent(event);
+   // the other widget could request its rows while this one was hidden
+   scheduleVisibleRowsUpdate();
+}
+
+void TransactionsWidgetInterface::scheduleVisibleRowsUpdate()
+{
+   if (visibleRowsTimer_ && !visibleRowsTimer_->isActive()) {
+      visibleRowsTimer_->start();
+   }
+}
+
+void TransactionsWidgetInterface::requestVisibleDetails()
+{
+   if (!trackedView_ || !model_ || !trackedView_->isVisible()) {
+      return;
+   }
+   const auto view = trackedView_.data();
+   const auto model = view->model();
+   const int rowCount = model ? model->rowCount() : 0;
+   if (rowCount == 0) {
+      model_->requestDetails(std::vector<int>{});
+      return;
+   }
+   const auto topLevelRow = [](QModelIndex index) {
+      while (index.parent().isValid()) {
+         index = index.parent();
+      }
+      return index.row();
+   };
+   const auto first = view->indexAt(QPoint(0, 0));
+   const auto last = view->indexAt(QPoint(0, view->viewport()->height() - 1));
+   const int firstRow = first.isValid() ? topLevelRow(first) : 0;
+   const int lastRow = last.isValid() ? topLevelRow(last) : rowCount - 1;
+   const int margin = (lastRow - firstRow + 1) * kPrefetchPages;
+
+   std::vector<int> rows;
+   rows.reserve(lastRow - firstRow + 1 + 2 * margin);
+   const auto addRow = [this, model, &rows](int row) {
+      const auto index = sourceIndex(model->index(row, 0));
+      if (index.isValid()) {
+         rows.push_back(index.row());
+      }
+   };
+   for (int row = firstRow; row <= lastRow; ++row) {
+      addRow(row);
+   }
+   for (int i = 1; i <= margin; ++i) {    // closest to the viewport first
+      if (lastRow + i < rowCount) {
+         addRow(lastRow + i);
+      }
+      if (firstRow - i >= 0) {
+         addRow(firstRow - i);
+      }
+   }
+   model_->requestDetails(rows);
+}
+
 void TransactionsWidgetInterface::onRevokeSettlement()
 {
    auto txItem = model_->getItem(actionRevoke_->data().toModelIndex());
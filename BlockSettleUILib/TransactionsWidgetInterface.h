@@ -15,6 +15,8 @@
 #include "TabWithShortcut.h"
 #include <set>
 #include <QMenu>
+#include <QModelIndex>
+#include <QPointer>
 #include "BinaryData.h"
 #include "BSErrorCode.h"
 
@@ -29,6 +31,8 @@ namespace bs {
 }
 class ApplicationSettings;
 class ArmoryConnection;
+class QTimer;
+class QTreeView;
 class TransactionsViewModel;
 class WalletSignerContainer;
 
@@ -52,6 +56,13 @@ protected slots:
    void onTXSigned(unsigned int id, BinaryData signedTX, bs::error::ErrorCode, std::string error);
 
 protected:
+   // Requests details of rows in and near the viewport of view (showing
+   // model_ through proxies) and of expanded ones
+   void trackVisibleRows(QTreeView *);
+   QModelIndex sourceIndex(const QModelIndex &) const;
+
+   void showEvent(QShowEvent *) override;
+
    std::shared_ptr<spdlog::logger>     logger_;
    std::shared_ptr<bs::sync::WalletsManager> walletsManager_;
    std::shared_ptr<WalletSignerContainer> signContainer_;
@@ -70,6 +81,14 @@ protected:
    QAction  *actionRevoke_ = nullptr;
    QString  curAddress_;
    QString  curTx_;
+
+private:
+   void scheduleVisibleRowsUpdate();
+   void requestVisibleDetails();
+
+private:
+   QPointer<QTreeView>  trackedView_;
+   QTimer   *visibleRowsTimer_ = nullptr;
 };
 
 #endif // _TRANSACTIONS_WIDGET_INTERFACE_
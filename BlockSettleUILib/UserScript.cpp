@@ -14,8 +14,10 @@
 #include <spdlog/logger.h>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QMetaMethod>
 #include <QQmlComponent>
 #include <QQmlContext>
+#include "AQNativeStrategy.h"
 
 #include "AssetManager.h"
 #include "CurrencyPair.h"
@@ -249,41 +251,175 @@ void Constants::setWalletsManager(std::shared_ptr<bs::sync::WalletsManager> wall
 }
 
 
+namespace {
+   // idle script objects created right after script load
+   const std::size_t kInitialPoolSize = 4;
+   // pool target is not grown above this limit, extra released objects are destroyed
+   const std::size_t kMaxPoolSize = 64;
+}
+
 AutoQuoter::AutoQuoter(const std::shared_ptr<spdlog::logger> &logger
    , const std::shared_ptr<AssetManager> &assetManager
    , const std::shared_ptr<MDCallbacksQt> &mdCallbacks
    , const ExtConnections &extConns, QObject* parent)
    : UserScript(logger, mdCallbacks, extConns, parent)
    , assetManager_(assetManager)
+   , strategyContext_(new AQStrategyContext(logger, assetManager))
+   , poolTarget_(kInitialPoolSize)
 {
    qmlRegisterType<BSQuoteReqReply>("bs.terminal", 1, 0, "BSQuoteReqReply");
    qmlRegisterUncreatableType<BSQuoteRequest>("bs.terminal", 1, 0, "BSQuoteRequest", tr("Can't create this type"));
+
+   connect(this, &UserScript::loaded, this, &AutoQuoter::onLoaded);
+}
+
+AutoQuoter::~AutoQuoter()
+{
+   clearPool();
+}
+
+bool AutoQuoter::load(const QString &filename)
+{
+   if (!AQStrategyLibrary::isStrategyLibrary(filename)) {
+      strategy_.reset();
+      return UserScript::load(filename);
+   }
+
+   QString error;
+   const auto strategy = AQStrategyLibrary::load(filename, strategyContext_.get(), error);
+   if (!strategy) {
+      logger_->error("[AutoQuoter::load] failed to load strategy {}: {}"
+         , filename.toStdString(), error.toStdString());
+      emit failed(error);
+      return false;
+   }
+   setStrategy(strategy);
+   return true;
+}
+
+void AutoQuoter::setStrategy(const std::shared_ptr<bs::aq::Strategy> &strategy)
+{
+   strategy_ = strategy;
+   emit loaded();
 }
 
 QObject *AutoQuoter::instantiate(const bs::network::QuoteReqNotification &qrn)
 {
-   QObject *rv = UserScript::instantiate();
-   if (rv) {
-      BSQuoteReqReply *qrr = qobject_cast<BSQuoteReqReply *>(rv);
-      qrr->init(logger_, assetManager_, this);
+   BSQuoteReqReply *qrr = nullptr;
+   if (!pool_.empty()) {
+      qrr = pool_.back();
+      pool_.pop_back();
+   }
+   else {
+      qrr = create();
+      if (!qrr) {
+         return nullptr;
+      }
+      // pool was too small for the current RFQ rate
+      poolTarget_ = std::min(poolTarget_ * 2, kMaxPoolSize);
+   }
+   inUse_.insert(qrr);
 
-      BSQuoteRequest *qr = new BSQuoteRequest(rv);
-      qr->init(QString::fromStdString(qrn.quoteRequestId), QString::fromStdString(qrn.product)
-         , (qrn.side == bs::network::Side::Buy), qrn.quantity, static_cast<int>(qrn.assetType));
+   qrr->quoteReq()->init(QString::fromStdString(qrn.quoteRequestId), QString::fromStdString(qrn.product)
+      , (qrn.side == bs::network::Side::Buy), qrn.quantity, static_cast<int>(qrn.assetType));
+   qrr->setSecurity(QString::fromStdString(qrn.security));
 
-      qrr->setQuoteReq(qr);
-      qrr->setSecurity(QString::fromStdString(qrn.security));
+   schedulePrewarm();
+   return qrr;
+}
 
-      connect(qrr, &BSQuoteReqReply::sendingQuoteReply, [this](const QString &reqId, double price) {
-         emit sendingQuoteReply(reqId, price);
-      });
-      connect(qrr, &BSQuoteReqReply::pullingQuoteReply, [this](const QString &reqId) {
-         emit pullingQuoteReply(reqId);
-      });
+void AutoQuoter::release(QObject *obj)
+{
+   if (!obj) {
+      return;
+   }
+   auto qrr = qobject_cast<BSQuoteReqReply *>(obj);
+   // objects instantiated before script reload are not in inUse_
+   const bool owned = qrr && (inUse_.erase(qrr) > 0);
+   if (!owned || !recyclable_ || (pool_.size() >= kMaxPoolSize)) {
+      obj->deleteLater();
+      schedulePrewarm();
+      return;
+   }
+   qrr->reset();
+   pool_.push_back(qrr);
+}
 
-      qrr->start();
+void AutoQuoter::onLoaded()
+{
+   clearPool();
+   inUse_.clear();
+   poolTarget_ = kInitialPoolSize;
+
+   while (pool_.size() < poolTarget_) {
+      auto qrr = create();
+      if (!qrr) {
+         break;
+      }
+      pool_.push_back(qrr);
    }
-   return rv;
+}
+
+BSQuoteReqReply *AutoQuoter::create()
+{
+   QObject *rv = strategy_ ? new BSQuoteReqReply() : UserScript::instantiate();
+   if (!rv) {
+      return nullptr;
+   }
+   BSQuoteReqReply *qrr = qobject_cast<BSQuoteReqReply *>(rv);
+   if (!qrr) {
+      logger_->error("[AutoQuoter::create] script root object is not BSQuoteReqReply");
+      delete rv;
+      return nullptr;
+   }
+   qrr->init(logger_, assetManager_, this);
+   qrr->setQuoteReq(new BSQuoteRequest(rv));
+
+   connect(qrr, &BSQuoteReqReply::sendingQuoteReply, [this](const QString &reqId, double price) {
+      emit sendingQuoteReply(reqId, price);
+   });
+   connect(qrr, &BSQuoteReqReply::pullingQuoteReply, [this](const QString &reqId) {
+      emit pullingQuoteReply(reqId);
+   });
+   if (strategy_) {
+      new AQStrategyBinding(strategy_, qrr);
+   }
+
+   // QML signal handlers (and native strategy binding) are connected during
+   // creation, so script which doesn't handle recycled() can't reset its own
+   // state for reuse
+   recyclable_ = qrr->isSignalConnected(QMetaMethod::fromSignal(&BSQuoteReqReply::recycled));
+   return qrr;
+}
+
+void AutoQuoter::clearPool()
+{
+   for (auto qrr : pool_) {
+      delete qrr;
+   }
+   pool_.clear();
+}
+
+void AutoQuoter::schedulePrewarm()
+{
+   if (prewarmScheduled_ || (pool_.size() >= poolTarget_)) {
+      return;
+   }
+   prewarmScheduled_ = true;
+
+   // one object per event loop turn to let pending RFQs through in between
+   QMetaObject::invokeMethod(this, [this] {
+      prewarmScheduled_ = false;
+      if (pool_.size() >= poolTarget_) {
+         return;
+      }
+      auto qrr = create();
+      if (!qrr) {
+         return;
+      }
+      pool_.push_back(qrr);
+      schedulePrewarm();
+   }, Qt::QueuedConnection);
 }
 
 
@@ -304,6 +440,19 @@ void BSQuoteReqReply::init(const std::shared_ptr<spdlog::logger> &logger
    parent_ = parent;
 }
 
+void BSQuoteReqReply::reset()
+{
+   started_ = false;
+   expirationInSec_ = 0;
+   security_.clear();
+   indicBid_ = 0;
+   indicAsk_ = 0;
+   lastPrice_ = 0;
+   bestPrice_ = 0;
+   isOwnBestPrice_ = false;
+   emit recycled();
+}
+
 void BSQuoteReqReply::log(const QString &s)
 {
    logger_->info("[BSQuoteReqReply] {}", s.toStdString());
@@ -16,6 +16,8 @@
 #include "CommonTypes.h"
 
 #include <map>
+#include <unordered_set>
+#include <vector>
 
 namespace spdlog {
    class logger;
@@ -25,7 +27,14 @@ namespace bs {
       class WalletsManager;
    }
 }
+namespace bs {
+   namespace aq {
+      class Strategy;
+   }
+}
+class AQStrategyContext;
 class AssetManager;
+class BSQuoteReqReply;
 class DataConnection;
 class MDCallbacksQt;
 class QQmlComponent;
@@ -123,7 +132,7 @@ public:
    ~UserScript() override;
 
    void setWalletsManager(std::shared_ptr<bs::sync::WalletsManager> walletsManager);
-   bool load(const QString &filename);
+   virtual bool load(const QString &filename);
 
    bool sendExtConn(const QString &name, const QString &type, const QString &message);
 
@@ -153,16 +162,46 @@ public:
       , const std::shared_ptr<AssetManager> &
       , const std::shared_ptr<MDCallbacksQt> &
       , const ExtConnections &, QObject* parent = nullptr);
-   ~AutoQuoter() override = default;
+   ~AutoQuoter() override;
+
+   // Accepts QML script or native strategy library
+   bool load(const QString &filename) override;
+   // Uses given native strategy instead of QML script
+   void setStrategy(const std::shared_ptr<bs::aq::Strategy> &);
 
+   // Takes script object from the pool (creates new one if the pool is empty)
+   // and binds it to the quote request. Returned object is not started yet.
    QObject *instantiate(const bs::network::QuoteReqNotification &qrn);
+   // Returns object obtained from instantiate() back to the pool. Objects are
+   // reused only if script handles BSQuoteReqReply::recycled(), otherwise
+   // they are destroyed and the pool is refilled with fresh ones.
+   void release(QObject *);
+
+   std::size_t pooledCount() const { return pool_.size(); }
+   std::size_t poolTarget() const { return poolTarget_; }
 
 signals:
    void sendingQuoteReply(const QString &reqId, double price);
    void pullingQuoteReply(const QString &reqId);
 
+private slots:
+   void onLoaded();
+
+private:
+   BSQuoteReqReply *create();
+   void clearPool();
+   void schedulePrewarm();
+
 private:
    std::shared_ptr<AssetManager> assetManager_;
+   std::unique_ptr<AQStrategyContext>  strategyContext_;
+   std::shared_ptr<bs::aq::Strategy>   strategy_;
+
+   std::vector<BSQuoteReqReply *>         pool_;
+   std::unordered_set<BSQuoteReqReply *>  inUse_;
+   std::size_t poolTarget_;
+   bool recyclable_ = false;
+   bool prewarmScheduled_ = false;
 };
 
 
@@ -266,12 +305,28 @@ public:
          emit bestPriceChanged();
       }
    }
+   // Applies only prices that are known (positive)
+   void setMDInfo(const bs::network::MDInfo &mdInfo) {
+      if (mdInfo.bidPrice > 0) {
+         setIndicBid(mdInfo.bidPrice);
+      }
+      if (mdInfo.askPrice > 0) {
+         setIndicAsk(mdInfo.askPrice);
+      }
+      if (mdInfo.lastPrice > 0) {
+         setLastPrice(mdInfo.lastPrice);
+      }
+   }
+
    double indicBid() const { return indicBid_; }
    double indicAsk() const { return indicAsk_; }
    double lastPrice() const { return lastPrice_; }
    double bestPrice() const { return bestPrice_; }
    bool   isOwnBestPrice() const { return isOwnBestPrice_; }
 
+   // Brings object back to the just created state before binding it to another RFQ
+   void reset();
+
    void init(const std::shared_ptr<spdlog::logger> &logger
       , const std::shared_ptr<AssetManager> &assetManager, UserScript *parent);
 
@@ -301,10 +356,12 @@ signals:
    void cancelled();
    void started();
    void extDataReceived(QString from, QString type, QString msg);
+   // Emitted when object is returned to the pool, script should reset its own state here
+   void recycled();
 
 private:
-   BSQuoteRequest *quoteReq_;
-   double   expirationInSec_;
+   BSQuoteRequest *quoteReq_ = nullptr;
+   double   expirationInSec_ = 0;
    QString  security_;
    double   indicBid_ = 0;
    double   indicAsk_ = 0;
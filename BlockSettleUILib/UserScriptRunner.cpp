@@ -10,6 +10,7 @@
 */
 
 #include "UserScriptRunner.h"
+#include <algorithm>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QThread>
@@ -126,30 +127,28 @@ void AQScriptHandler::onQuoteReqNotification(const bs::network::QuoteReqNotifica
          return;
       }
       if (aqEnabled_ && aq_ && (itAQObj == aqObjs_.end())) {
+         const auto receivedAt = std::chrono::steady_clock::now();
          QObject *obj = aq_->instantiate(qrn);
+         auto reqReply = qobject_cast<BSQuoteReqReply *>(obj);
+         if (!reqReply) {
+            logger_->error("[AQScriptHandler::onQuoteReqNotification] invalid AQ object instantiated");
+            aq_->release(obj);
+            return;
+         }
          aqObjs_[qrn.quoteRequestId] = obj;
+         aqObjsBySecurity_[qrn.security].insert(qrn.quoteRequestId);
          if (thread_) {
             obj->moveToThread(thread_);
          }
 
+         rfqReceivedAt_[qrn.quoteRequestId] = receivedAt;
+         // indicative prices are notified to script only after start
+         reqReply->start();
          const auto &mdIt = mdInfo_.find(qrn.security);
-         auto reqReply = qobject_cast<BSQuoteReqReply *>(obj);
-         if (!reqReply) {
-            logger_->error("[AQScriptHandler::onQuoteReqNotification] invalid AQ object instantiated");
-            return;
-         }
          if (mdIt != mdInfo_.end()) {
-            if (mdIt->second.bidPrice > 0) {
-               reqReply->setIndicBid(mdIt->second.bidPrice);
-            }
-            if (mdIt->second.askPrice > 0) {
-               reqReply->setIndicAsk(mdIt->second.askPrice);
-            }
-            if (mdIt->second.lastPrice > 0) {
-               reqReply->setLastPrice(mdIt->second.lastPrice);
-            }
+            reqReply->setMDInfo(mdIt->second);
          }
-         reqReply->start();
+         addLatency(objectReadyLatency_, receivedAt);
       }
    }
    else if ((qrn.status == bs::network::QuoteReqNotification::Rejected)
@@ -167,12 +166,28 @@ void AQScriptHandler::onQuoteReqNotification(const bs::network::QuoteReqNotifica
 void AQScriptHandler::stop(const std::string &quoteReqId)
 {
    const auto &itAQObj = aqObjs_.find(quoteReqId);
-   aqQuoteReqs_.erase(quoteReqId);
+   const auto itQRN = aqQuoteReqs_.find(quoteReqId);
+   if (itQRN != aqQuoteReqs_.end()) {
+      const auto itSec = aqObjsBySecurity_.find(itQRN->second.security);
+      if (itSec != aqObjsBySecurity_.end()) {
+         itSec->second.erase(quoteReqId);
+         if (itSec->second.empty()) {
+            aqObjsBySecurity_.erase(itSec);
+         }
+      }
+      aqQuoteReqs_.erase(itQRN);
+   }
    if (itAQObj != aqObjs_.end()) {
-      itAQObj->second->deleteLater();
+      if (aq_) {
+         aq_->release(itAQObj->second);
+      }
+      else {
+         itAQObj->second->deleteLater();
+      }
       aqObjs_.erase(itAQObj);
       bestQPrices_.erase(quoteReqId);
    }
+   rfqReceivedAt_.erase(quoteReqId);
 }
 
 void AQScriptHandler::onQuoteReqCancelled(const QString &reqId, bool userCancelled)
@@ -244,9 +259,12 @@ void AQScriptHandler::clear()
    }
 
    for (auto aqObj : aqObjs_) {
-      aqObj.second->deleteLater();
+      aq_->release(aqObj.second);
    }
    aqObjs_.clear();
+   rfqReceivedAt_.clear();
+   aqObjsBySecurity_.clear();
+   pendingMDSecurities_.clear();
    aqEnabled_ = false;
 
    std::vector<std::string> requests;
@@ -275,26 +293,46 @@ void AQScriptHandler::clear()
 void AQScriptHandler::onMDUpdate(bs::network::Asset::Type, const QString &security,
    bs::network::MDFields mdFields)
 {
-   auto &mdInfo = mdInfo_[security.toStdString()];
+   const auto sec = security.toStdString();
+   auto &mdInfo = mdInfo_[sec];
    mdInfo.merge(bs::network::MDField::get(mdFields));
 
-   for (auto aqObj : aqObjs_) {
-      QString sec = aqObj.second->property("security").toString();
-      if (sec.isEmpty() || (security != sec)) {
+   if (aqObjsBySecurity_.find(sec) == aqObjsBySecurity_.end()) {
+      return;
+   }
+
+   // several updates of the same security within one event loop turn are
+   // delivered to AQ objects as one property write
+   pendingMDSecurities_.insert(sec);
+   if (!mdFlushScheduled_) {
+      mdFlushScheduled_ = true;
+      QMetaObject::invokeMethod(this, [this] { flushMDUpdates(); }, Qt::QueuedConnection);
+   }
+}
+
+void AQScriptHandler::flushMDUpdates()
+{
+   mdFlushScheduled_ = false;
+
+   for (const auto &sec : pendingMDSecurities_) {
+      const auto itSec = aqObjsBySecurity_.find(sec);
+      const auto itMD = mdInfo_.find(sec);
+      if ((itSec == aqObjsBySecurity_.end()) || (itMD == mdInfo_.end())) {
          continue;
       }
 
-      auto *reqReply = qobject_cast<BSQuoteReqReply *>(aqObj.second);
-      if (mdInfo.bidPrice > 0) {
-         reqReply->setIndicBid(mdInfo.bidPrice);
-      }
-      if (mdInfo.askPrice > 0) {
-         reqReply->setIndicAsk(mdInfo.askPrice);
-      }
-      if (mdInfo.lastPrice > 0) {
-         reqReply->setLastPrice(mdInfo.lastPrice);
+      for (const auto &reqId : itSec->second) {
+         const auto itAQObj = aqObjs_.find(reqId);
+         if (itAQObj == aqObjs_.end()) {
+            continue;
+         }
+         auto *reqReply = qobject_cast<BSQuoteReqReply *>(itAQObj->second);
+         if (reqReply) {
+            reqReply->setMDInfo(itMD->second);
+         }
       }
    }
+   pendingMDSecurities_.clear();
 }
 
 void AQScriptHandler::onBestQuotePrice(const QString reqId, double price, bool own)
@@ -314,6 +352,48 @@ void AQScriptHandler::onAQReply(const QString &reqId, double price)
    }
 
    emit sendQuote(itQRN->second, price);
+
+   // only the first reply to RFQ is accounted
+   const auto itReceived = rfqReceivedAt_.find(itQRN->first);
+   if (itReceived != rfqReceivedAt_.end()) {
+      addLatency(replyLatency_, itReceived->second);
+      rfqReceivedAt_.erase(itReceived);
+   }
+}
+
+void AQScriptHandler::addLatency(LatencyHistogram &histogram
+   , std::chrono::steady_clock::time_point since)
+{
+   const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - since).count();
+   std::lock_guard<std::mutex> lock(latencyMutex_);
+   histogram.add(static_cast<uint64_t>(std::max<int64_t>(elapsed, 0)));
+}
+
+std::string AQScriptHandler::latencyReport() const
+{
+   const auto summary = [](const std::string &name, const LatencyHistogram &histogram) {
+      return "# " + name + ": count=" + std::to_string(histogram.count())
+         + " min=" + std::to_string(histogram.min())
+         + " p50=" + std::to_string(histogram.percentile(0.5))
+         + " p90=" + std::to_string(histogram.percentile(0.9))
+         + " p99=" + std::to_string(histogram.percentile(0.99))
+         + " max=" + std::to_string(histogram.max()) + " (us)\n";
+   };
+
+   std::lock_guard<std::mutex> lock(latencyMutex_);
+   return summary("object_ready", objectReadyLatency_)
+      + summary("reply_submitted", replyLatency_)
+      + "histogram,le_us,count\n"
+      + objectReadyLatency_.toCsv("object_ready")
+      + replyLatency_.toCsv("reply_submitted");
+}
+
+void AQScriptHandler::resetLatency()
+{
+   std::lock_guard<std::mutex> lock(latencyMutex_);
+   objectReadyLatency_.clear();
+   replyLatency_.clear();
 }
 
 void AQScriptHandler::onAQPull(const QString &reqId)
@@ -515,6 +595,23 @@ private:
    std::shared_ptr<spdlog::logger>  logger_;
 };
 
+std::string AQScriptRunner::latencyReport() const
+{
+   const auto aqHandler = qobject_cast<AQScriptHandler *>(script_);
+   if (aqHandler) {
+      return aqHandler->latencyReport();
+   }
+   return {};
+}
+
+void AQScriptRunner::resetLatency()
+{
+   const auto aqHandler = qobject_cast<AQScriptHandler *>(script_);
+   if (aqHandler) {
+      aqHandler->resetLatency();
+   }
+}
+
 void AQScriptRunner::setExtConnections(const ExtConnections &conns)
 {
    const auto aqHandler = qobject_cast<AQScriptHandler *>(script_);
@@ -15,12 +15,15 @@
 #include <QObject>
 #include <QTimer>
 
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "LatencyHistogram.h"
 #include "UserScript.h"
 #include "QuoteProvider.h"
 #include "CommonTypes.h"
@@ -98,6 +101,11 @@ public:
    void settled(const std::string &quoteReqId);
    void extMsgReceived(const std::string &data);
 
+   // Latencies from RFQ notification to AQ object start and to first reply
+   // submitted, as CSV histograms. May be called from any thread.
+   std::string latencyReport() const;
+   void resetLatency();
+
 signals:
    void pullQuoteNotif(const std::string& settlementId, const std::string& reqId, const std::string& reqSessToken);
    void sendQuote(const bs::network::QuoteReqNotification &qrn, double price);
@@ -124,6 +132,8 @@ private slots:
 private:
    void clear();
    void stop(const std::string &quoteReqId);
+   void flushMDUpdates();
+   void addLatency(LatencyHistogram &, std::chrono::steady_clock::time_point since);
    void performOnReplyAndStop(const std::string &quoteReqId
       , const std::function<void(BSQuoteReqReply *)> &);
 
@@ -140,6 +150,17 @@ private:
 
    std::unordered_map<std::string, bs::network::MDInfo>  mdInfo_;
 
+   // security -> reqIds of live AQ objects quoting it
+   std::unordered_map<std::string, std::unordered_set<std::string>>  aqObjsBySecurity_;
+   // securities updated during current event loop turn
+   std::unordered_set<std::string>  pendingMDSecurities_;
+   bool mdFlushScheduled_{ false };
+
+   std::unordered_map<std::string, std::chrono::steady_clock::time_point>  rfqReceivedAt_;
+   mutable std::mutex   latencyMutex_;
+   LatencyHistogram     objectReadyLatency_;
+   LatencyHistogram     replyLatency_;
+
    bool aqEnabled_;
    QTimer *aqTimer_;
 }; // class UserScriptHandler
@@ -232,6 +253,9 @@ public:
    std::shared_ptr<DataConnectionListener> getExtConnListener();
    void onExtDataReceived(const std::string &data);
 
+   std::string latencyReport() const;
+   void resetLatency();
+
 signals:
    void pullQuoteNotif(const std::string& settlementId, const std::string& reqId, const std::string& reqSessToken);
    void sendQuote(const bs::network::QuoteReqNotification &qrn, double price);
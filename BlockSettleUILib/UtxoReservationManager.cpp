@@ -20,12 +20,15 @@
 #include "Wallets/SyncHDLeaf.h"
 #include "TradesUtils.h"
 #include "ArmoryObject.h"
-#include "WalletUtils.h"
+#include "FeeEstimateCache.h"
 
 using namespace bs;
 
 namespace {
 
+   // pay-in goes to P2WSH settlement address
+   const size_t kPayinOutputSize = 43;
+
    bool getSpendableTxOutList(const std::vector<std::shared_ptr<bs::sync::Wallet>> &wallets
       , const std::function<void(const UTXOReservationManager::UtxoItemMap &)> &cb)
    {
@@ -88,6 +91,19 @@ namespace {
       return true;
    }
 
+   class FeeCacheACT : public ArmoryCallbackTarget
+   {
+   public:
+      FeeCacheACT(const std::shared_ptr<FeeEstimateCache> &cache)
+         : cache_(cache) {}
+      ~FeeCacheACT() override { cleanup(); }
+      void onNewBlock(unsigned int, unsigned int) override {
+         cache_->refresh();
+      }
+   private:
+      std::shared_ptr<FeeEstimateCache> cache_;
+   };
+
 }
 
 UTXOReservationManager::UTXOReservationManager(const std::shared_ptr<bs::sync::WalletsManager>& walletsManager,
@@ -96,6 +112,13 @@ UTXOReservationManager::UTXOReservationManager(const std::shared_ptr<bs::sync::W
    , armory_(armory)
    , logger_(logger)
 {
+   feeEstimateCache_ = std::make_shared<FeeEstimateCache>([armory = armory_]
+      (unsigned int nbBlocks, const FeeEstimateCache::FeeCb &cb) {
+      return armory->estimateFee(nbBlocks, cb);
+   }, logger_);
+   act_ = std::make_unique<FeeCacheACT>(feeEstimateCache_);
+   act_->init(armory_.get());
+
    connect(walletsManager_.get(), &bs::sync::WalletsManager::walletsSynchronized,
       this, &UTXOReservationManager::refreshAvailableUTXO, Qt::QueuedConnection);
    connect(walletsManager_.get(), &bs::sync::WalletsManager::walletAdded,
@@ -106,17 +129,25 @@ UTXOReservationManager::UTXOReservationManager(const std::shared_ptr<bs::sync::W
       this, &UTXOReservationManager::onWalletsBalanceChanged);
 }
 
-UTXOReservationManager::~UTXOReservationManager() = default;
+UTXOReservationManager::~UTXOReservationManager()
+{
+   act_.reset();
+   feeEstimateCache_->logStats();
+}
 
 bs::UtxoReservationToken UTXOReservationManager::makeNewReservation(const std::vector<UTXO> &utxos, const std::string &reserveId)
 {
-   auto onReleaseCb = [mngr = QPointer<UTXOReservationManager>(this)]() {
+   auto onReleaseCb = [mngr = QPointer<UTXOReservationManager>(this), utxos]() {
       if (!mngr) {
          return;
       }
-      mngr->availableUtxoChanged({});
+      QMetaObject::invokeMethod(mngr, [mngr, utxos] {
+         mngr->xbtIndex_.unreserve(utxos);
+         mngr->availableUtxoChanged({});
+      });
    };
 
+   xbtIndex_.reserve(utxos);
    auto reservation = bs::UtxoReservationToken::makeNewReservation(logger_, utxos, reserveId, onReleaseCb);
    // #ReservationMngr: could be optimized by updating only needed wallet
    availableUtxoChanged({});
@@ -145,77 +176,23 @@ void bs::UTXOReservationManager::reserveBestXbtUtxoSet(const HDWalletId& walletI
 
 BTCNumericTypes::satoshi_type bs::UTXOReservationManager::getAvailableXbtUtxoSum(const HDWalletId& walletId, bool includeZc) const
 {
-   BTCNumericTypes::satoshi_type sum = 0;
-   auto const availableUtxos = getAvailableXbtUTXOs(walletId, includeZc);
-   for (const auto &utxo : availableUtxos) {
-      sum += utxo.getValue();
-   }
-
-   return sum;
+   return xbtIndex_.availableSum(walletId, includeZc);
 }
 
 BTCNumericTypes::satoshi_type bs::UTXOReservationManager::getAvailableXbtUtxoSum(const HDWalletId& walletId, bs::hd::Purpose purpose, bool includeZc) const
 {
-   BTCNumericTypes::satoshi_type sum = 0;
-   auto const availableUtxos = getAvailableXbtUTXOs(walletId, purpose, includeZc);
-   for (const auto &utxo : availableUtxos) {
-      sum += utxo.getValue();
-   }
-
-   return sum;
+   return xbtIndex_.availableSum(walletId, purpose, includeZc);
 }
 
 std::vector<UTXO> bs::UTXOReservationManager::getAvailableXbtUTXOs(const HDWalletId& walletId, bool includeZc) const
 {
-   auto const availableUtxos = availableXbtUTXOs_.find(walletId);
-   if (availableUtxos == availableXbtUTXOs_.end()) {
-      return {};
-   }
-
-   std::vector<UTXO> utxos;
-   for (const auto &utxoItem : availableUtxos->second.utxosLookup_) {
-      if (includeZc || utxoItem.second.second == UtxoType::Normal) {
-         utxos.push_back(utxoItem.first);
-      }
-   }
-   std::vector<UTXO> filtered;
-   UtxoReservation::instance()->filter(utxos, filtered);
-   return utxos;
+   return xbtIndex_.available(walletId, includeZc);
 }
 
 std::vector<UTXO> bs::UTXOReservationManager::getAvailableXbtUTXOs(const HDWalletId& walletId
    , bs::hd::Purpose purpose, bool includeZc) const
 {
-   auto hdWallet = walletsManager_->getHDWalletById(walletId);
-   auto xbtGroup = hdWallet->getGroup(hdWallet->getXBTGroupType());
-   if (xbtGroup == nullptr) {
-      return {};
-   }
-
-   auto leaf = xbtGroup->getLeaf(purpose);
-
-   if (!leaf) {
-      return {};
-   }
-
-   const auto& leafId = leaf->walletId();
-   std::vector<UTXO> utxos = getAvailableXbtUTXOs(walletId, includeZc);
-   if (utxos.empty()) {
-      return utxos;
-   }
-
-   auto const availableUtxos = availableXbtUTXOs_.find(walletId);
-   if (availableUtxos == availableXbtUTXOs_.end()) {
-      return {};
-   }
-
-   auto& leafLookup = availableUtxos->second.utxosLookup_;
-   auto i = std::remove_if(utxos.begin(), utxos.end(), [&leafLookup, &leafId](const UTXO& utxo) -> bool {
-      return leafId != leafLookup.at(utxo).first;
-   });
-   utxos.erase(i, utxos.end());
-
-   return utxos;
+   return xbtIndex_.available(walletId, purpose, includeZc);
 }
 
 void bs::UTXOReservationManager::getBestXbtUtxoSet(const HDWalletId& walletId,
@@ -273,15 +250,13 @@ bs::FixedXbtInputs UTXOReservationManager::convertUtxoToFixedInput(const HDWalle
 
 bs::FixedXbtInputs bs::UTXOReservationManager::convertUtxoToPartialFixedInput(const HDWalletId& walletId, const std::vector<UTXO>& utxos)
 {
-   auto const availableUtxos = availableXbtUTXOs_.find(walletId);
-   if (availableUtxos == availableXbtUTXOs_.end()) {
+   if (!xbtIndex_.hasWallet(walletId)) {
       return {};
    }
 
-   const auto &utxoLookup = availableUtxos->second.utxosLookup_;
    FixedXbtInputs fixedXbtInputs;
    for (auto utxo : utxos) {
-      fixedXbtInputs.inputs.insert({ utxo, utxoLookup.at(utxo).first });
+      fixedXbtInputs.inputs.insert({ utxo, xbtIndex_.leafOf(utxo) });
    }
    return fixedXbtInputs;
 }
@@ -298,7 +273,7 @@ float UTXOReservationManager::feeRatePb() const
 
 void bs::UTXOReservationManager::refreshAvailableUTXO()
 {
-   availableXbtUTXOs_.clear();
+   xbtIndex_.clear();
    for (auto &wallet : walletsManager_->hdWallets()) {
       resetHdWallet(wallet->walletId());
    }
@@ -306,7 +281,11 @@ void bs::UTXOReservationManager::refreshAvailableUTXO()
 
 void bs::UTXOReservationManager::onWalletsDeleted(const std::string& walledId)
 {
-   availableXbtUTXOs_.erase(walledId);
+   for (const auto &leafId : xbtIndex_.removeWallet(walledId)) {
+      xbtLeafRequests_.erase(leafId);
+   }
+   xbtIndex_.removeLeaf(walledId);
+   xbtLeafRequests_.erase(walledId);
    availableCCUTXOs_.erase(walledId);
    if (!walletsManager_->hasPrimaryWallet()) {
       availableCCUTXOs_.clear();
@@ -333,8 +312,10 @@ void bs::UTXOReservationManager::onWalletsAdded(const std::string& walledId)
    case bs::core::wallet::Type::Bitcoin:
    {
       auto hdWallet = walletsManager_->getHDRootForLeaf(walledId);
-      if (hdWallet) {
-         resetSpendableXbt(hdWallet);
+      auto leaf = std::dynamic_pointer_cast<bs::sync::hd::Leaf>(wallet);
+      if (hdWallet && leaf && (leaf->purpose() == bs::hd::Purpose::Native
+         || leaf->purpose() == bs::hd::Purpose::Nested)) {
+         resetSpendableXbtLeaf(hdWallet->walletId(), leaf);
       }
    }
       break;
@@ -345,7 +326,7 @@ void bs::UTXOReservationManager::onWalletsAdded(const std::string& walledId)
 
 void bs::UTXOReservationManager::onWalletsBalanceChanged(const std::string& walledId)
 {
-   onWalletsDeleted(walledId);
+   // Only outputs of the changed wallet are re-read, XBT ones are applied as a difference
    onWalletsAdded(walledId);
 }
 
@@ -374,29 +355,52 @@ void bs::UTXOReservationManager::resetSpendableXbt(const std::shared_ptr<bs::syn
       return ;
    }
 
-   auto leaves = xbtGroup->getLeaves();
-   std::vector<bs::sync::WalletsManager::WalletPtr> wallets;
-   for (const auto &leaf : leaves) {
+   bool hasLeaves = false;
+   for (const auto &leaf : xbtGroup->getLeaves()) {
       auto purpose = leaf->purpose();
       // Filter non-segwit leaves (for HW wallets)
       if (purpose == bs::hd::Purpose::Native || purpose == bs::hd::Purpose::Nested) {
-         wallets.push_back(leaf);
+         resetSpendableXbtLeaf(hdWallet->walletId(), leaf);
+         hasLeaves = true;
       }
    }
+   if (!hasLeaves) {
+      emit availableUtxoChanged(hdWallet->walletId());
+   }
+}
 
-   getSpendableTxOutList(wallets, [mgr = QPointer<bs::UTXOReservationManager>(this)
-      , walletId = hdWallet->walletId(), leaves]
+void bs::UTXOReservationManager::resetSpendableXbtLeaf(const HDWalletId& hdWalletId
+   , const std::shared_ptr<bs::sync::hd::Leaf>& leaf)
+{
+   const auto requestId = ++xbtLeafRequests_[leaf->walletId()];
+   getSpendableTxOutList({ leaf }, [mgr = QPointer<bs::UTXOReservationManager>(this)
+      , hdWalletId, leafId = leaf->walletId(), purpose = leaf->purpose(), requestId]
          (const UtxoItemMap &utxos) {
       if (!mgr) {
          return; // manager thread die, nothing to do
       }
 
-      XBTUtxoContainer utxosContainer;
-      utxosContainer.utxosLookup_ = utxos;
-      QMetaObject::invokeMethod(mgr, [mgr, container = std::move(utxosContainer), id = walletId]{
-         mgr->availableXbtUTXOs_[id] = std::move(container);
-         emit mgr->availableUtxoChanged(id);
-         });
+      std::vector<UTXO> normalUtxos;
+      std::vector<UTXO> zcUtxos;
+      for (const auto &utxo : utxos) {
+         if (utxo.second.second == UtxoType::Zc) {
+            zcUtxos.push_back(utxo.first);
+         }
+         else {
+            normalUtxos.push_back(utxo.first);
+         }
+      }
+      QMetaObject::invokeMethod(mgr, [mgr, hdWalletId, leafId, purpose, requestId
+         , normalUtxos = std::move(normalUtxos), zcUtxos = std::move(zcUtxos)]{
+         const auto itRequest = mgr->xbtLeafRequests_.find(leafId);
+         if ((itRequest == mgr->xbtLeafRequests_.end()) || (itRequest->second != requestId)) {
+            return;  // leaf is removed or re-requested meanwhile
+         }
+         const auto delta = mgr->xbtIndex_.setLeaf(hdWalletId, leafId, purpose, normalUtxos, zcUtxos);
+         if (delta.changed()) {
+            emit mgr->availableUtxoChanged(hdWalletId);
+         }
+      });
    });
 }
 
@@ -441,56 +445,60 @@ void bs::UTXOReservationManager::resetAllSpendableCC(const std::shared_ptr<bs::s
 void bs::UTXOReservationManager::getBestXbtFromUtxos(const std::vector<UTXO> &inputUtxo,
    BTCNumericTypes::satoshi_type quantity, std::function<void(std::vector<UTXO>&&)>&& cb, bool checkPbFeeFloor, CheckAmount checkAmount)
 {
-   std::vector<UTXO> selectedUtxos = bs::selectUtxoForAmount(inputUtxo, quantity);
-
-   if (checkAmount == CheckAmount::Enabled) {
-      uint64_t selectedAmount = 0;
-      for (const auto &utxo : selectedUtxos) {
-         selectedAmount += utxo.getValue();
-      }
-      if (selectedAmount < quantity) {
-         SPDLOG_LOGGER_ERROR(logger_, "not enough UTXO available, requested amount: {}, selected: {}, selected count: {}"
-            , quantity, selectedAmount, selectedUtxos.size());
+   uint64_t availableAmount = 0;
+   for (const auto &utxo : inputUtxo) {
+      availableAmount += utxo.getValue();
+   }
+   if (availableAmount < quantity) {
+      if (checkAmount == CheckAmount::Enabled) {
+         SPDLOG_LOGGER_ERROR(logger_, "not enough UTXO available, requested amount: {}, available: {}, UTXO count: {}"
+            , quantity, availableAmount, inputUtxo.size());
          return;
       }
-   }
-
-   // Here we calculating fee based on chosen utxos, if total price with fee will cover by all utxo sum - then we good and could continue
-   // otherwise let's try to find better set of utxo again till the moment we will cover the difference or use all available utxos from wallet
-   if (selectedUtxos.size() == inputUtxo.size()) {
-      cb(std::move(selectedUtxos));
+      cb(std::vector<UTXO>(inputUtxo));
       return;
    }
 
    auto feeCb = [mgr = QPointer<bs::UTXOReservationManager>(this), inputUtxo, quantity
-      , utxos = std::move(selectedUtxos), cbCopy = std::move(cb), checkPbFeeFloor, checkAmount](float fee) mutable {
+      , cbCopy = std::move(cb), checkPbFeeFloor, checkAmount](float fee) mutable {
       if (!mgr) {
          return; // main thread die, nothing to do
       }
 
       QMetaObject::invokeMethod(mgr, [mgr, quantity, inputUtxo
-         , fee, utxos = std::move(utxos), cb = std::move(cbCopy), checkPbFeeFloor, checkAmount]() mutable
+         , fee, cb = std::move(cbCopy), checkPbFeeFloor, checkAmount]() mutable
       {
          float feePerByte = ArmoryConnection::toFeePerByte(fee);
          if (checkPbFeeFloor) {
             feePerByte = std::max(mgr->feeRatePb(), feePerByte);
          }
-         BTCNumericTypes::satoshi_type total = 0;
-         for (const auto &utxo : utxos) {
-            total += utxo.getValue();
-         }
-         const auto fee = bs::tradeutils::estimatePayinFeeWithoutChange(utxos, feePerByte);
-
-         const BTCNumericTypes::satoshi_type spendableQuantity = quantity + fee;
-         if (spendableQuantity > total) {
-            mgr->getBestXbtFromUtxos(inputUtxo, spendableQuantity, std::move(cb), checkPbFeeFloor, checkAmount);
-         }
-         else {
-            cb(std::move(utxos));
-         }
-      });
+         mgr->selectXbtUtxos(inputUtxo, quantity, feePerByte, std::move(cb), checkAmount);
+      }, Qt::QueuedConnection);  // cached fee is delivered synchronously, result stays async
    };
-   armory_->estimateFee(bs::tradeutils::feeTargetBlockCount(), feeCb);
+   feeEstimateCache_->get(bs::tradeutils::feeTargetBlockCount(), feeCb);
+}
+
+void bs::UTXOReservationManager::selectXbtUtxos(const std::vector<UTXO> &inputUtxo, BTCNumericTypes::satoshi_type quantity
+   , float feePerByte, std::function<void(std::vector<UTXO>&&)>&& cb, CheckAmount checkAmount)
+{
+   CoinSelectionParams params;
+   params.amount = quantity;
+   params.feePerByte = feePerByte;
+   params.outputsSize = kPayinOutputSize;
+   auto result = coinSelector_.select(inputUtxo, params);
+   if (!result.found()) {
+      if (checkAmount == CheckAmount::Enabled) {
+         SPDLOG_LOGGER_ERROR(logger_, "not enough UTXO available, requested amount: {} with fee rate {}, UTXO count: {}"
+            , quantity, feePerByte, inputUtxo.size());
+         return;
+      }
+      cb(std::vector<UTXO>(inputUtxo));
+      return;
+   }
+
+   SPDLOG_LOGGER_DEBUG(logger_, "{} of {} UTXOs selected by {} in {} iterations, amount: {}, fee: {}, change: {}"
+      , result.inputs.size(), inputUtxo.size(), result.strategy, result.iterations, quantity, result.fee, result.change);
+   cb(std::move(result.inputs));
 }
 
 std::function<void(std::vector<UTXO>&&)> bs::UTXOReservationManager::getReservationCb(const HDWalletId& walletId,
@@ -13,7 +13,9 @@
 
 #include <atomic>
 #include <QObject>
+#include "CoinSelector.h"
 #include "CommonTypes.h"
+#include "SpendableUtxoIndex.h"
 #include "UiUtils.h"
 #include "UtxoReservationToken.h"
 
@@ -26,11 +28,14 @@ namespace bs {
       class WalletsManager;
       class Wallet;
       namespace hd {
+         class Leaf;
          class Wallet;
       }
    }
 }
+class ArmoryCallbackTarget;
 class ArmoryObject;
+class FeeEstimateCache;
 
 namespace bs {
 
@@ -105,6 +110,9 @@ namespace bs {
       void setFeeRatePb(float feeRate);
       float feeRatePb() const;
 
+      // Shared by all fee estimates of trading code, refreshed on each new block
+      const std::shared_ptr<FeeEstimateCache> &feeEstimateCache() const { return feeEstimateCache_; }
+
    signals:
       void availableUtxoChanged(const std::string& walledId);
 
@@ -117,21 +125,23 @@ namespace bs {
    private:
       bool resetHdWallet(const std::string& hdWalledId);
       void resetSpendableXbt(const std::shared_ptr<bs::sync::hd::Wallet>& hdWallet);
+      void resetSpendableXbtLeaf(const HDWalletId& hdWalletId, const std::shared_ptr<bs::sync::hd::Leaf>& leaf);
       void resetSpendableCC(const std::shared_ptr<bs::sync::Wallet>& leaf);
       void resetAllSpendableCC(const std::shared_ptr<bs::sync::hd::Wallet>& hdWallet);
       void getBestXbtFromUtxos(const std::vector<UTXO> &selectedUtxo
          , BTCNumericTypes::satoshi_type quantity
          , std::function<void(std::vector<UTXO>&&)>&& cb, bool checkPbFeeFloor, CheckAmount checkAmount);
+      void selectXbtUtxos(const std::vector<UTXO> &inputUtxo, BTCNumericTypes::satoshi_type quantity
+         , float feePerByte, std::function<void(std::vector<UTXO>&&)>&& cb, CheckAmount checkAmount);
 
       std::function<void(std::vector<UTXO>&&)> getReservationCb(const HDWalletId& walletId, bool partial,
          std::function<void(FixedXbtInputs&&)>&& cb);
 
    private:
-      struct XBTUtxoContainer {
-         UtxoItemMap utxosLookup_;
-      };
-
-      std::unordered_map<HDWalletId, XBTUtxoContainer> availableXbtUTXOs_;
+      SpendableUtxoIndex xbtIndex_;
+      CoinSelector       coinSelector_;
+      // latest spendable list request of each XBT leaf, older results are ignored
+      std::unordered_map<std::string, uint64_t> xbtLeafRequests_;
       std::unordered_map<CCWalletId, std::vector<UTXO>> availableCCUTXOs_;
 
       std::shared_ptr<bs::sync::WalletsManager> walletsManager_;
@@ -139,6 +149,9 @@ namespace bs {
       std::shared_ptr<spdlog::logger> logger_;
 
       std::atomic<float> feeRatePb_{};
+
+      std::shared_ptr<FeeEstimateCache>      feeEstimateCache_;
+      std::unique_ptr<ArmoryCallbackTarget>  act_;
    };
 
 }  // namespace bs
@@ -32,9 +32,14 @@ BSQuoteReqReply {		// Class name for Dealer replies. Don't change it!
 //  product()               // Returns opposite product as compared to quoteReq's one
 //  sendQuoteReply(double price)
 //  pullQuoteReply()
+//  onRecycled              // Object is reused for another quote request - reset own properties here
 
     property var prevSendPrice: 0
 
+    onRecycled: {
+        prevSendPrice = 0
+    }
+
     function checkBalance(value, product) {
         var balance = accountBalance(product)
         if (value > balance) {
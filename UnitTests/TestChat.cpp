@@ -10,5 +10,330 @@
 */
 #include <gtest/gtest.h>
 #include <QString>
+#include <algorithm>
+#include <map>
+#include <random>
+#include "ChatUI/ChatMessageHeights.h"
+#include "ChatUI/ChatMessageStore.h"
 #include "TestEnv.h"
 
+TEST(TestChat, ChatMessageHeights)
+{
+   std::mt19937 rng(7);
+   ChatMessageHeights heights;
+   std::vector<int> expected;
+   std::vector<bool> measured;
+   heights.setWidth(500);
+
+   const auto check = [&heights, &expected] {
+      ASSERT_EQ(heights.size(), expected.size());
+      int offset = 0;
+      for (size_t i = 0; i < expected.size(); ++i) {
+         ASSERT_EQ(heights.offset(i), offset);
+         ASSERT_EQ(heights.height(i), expected[i]);
+         if (expected[i] > 0) {
+            ASSERT_EQ(heights.indexAt(offset), i);
+            ASSERT_EQ(heights.indexAt(offset + expected[i] - 1), i);
+         }
+         offset += expected[i];
+      }
+      ASSERT_EQ(heights.totalHeight(), offset);
+      ASSERT_EQ(heights.indexAt(offset), expected.size());
+   };
+
+   for (int i = 0; i < 1000; ++i) {
+      const int estimate = 16 + static_cast<int>(rng() % 3);
+      heights.append(estimate);
+      expected.push_back(estimate);
+      measured.push_back(false);
+   }
+   check();
+   EXPECT_EQ(heights.staleCount(), 1000u);
+
+   for (int i = 0; i < 3000; ++i) {
+      const auto index = rng() % expected.size();
+      switch (rng() % 10) {
+         case 0:
+            heights.erase(index);
+            expected.erase(expected.begin() + index);
+            measured.erase(measured.begin() + index);
+            break;
+         case 1:
+            heights.invalidate(index);
+            measured[index] = false;
+            break;
+         default: {
+            const int height = static_cast<int>(rng() % 200);
+            heights.setHeight(index, height);
+            expected[index] = height;
+            measured[index] = true;
+            break;
+         }
+      }
+   }
+   check();
+   for (size_t i = 0; i < measured.size(); ++i) {
+      EXPECT_EQ(heights.isMeasured(i), measured[i]);
+   }
+   EXPECT_EQ(heights.staleCount(), static_cast<size_t>(std::count(measured.begin(), measured.end(), false)));
+
+   // full history window: the first message is dropped for each new one
+   for (int i = 0; i < 2500; ++i) {
+      const int estimate = 16 + static_cast<int>(rng() % 3);
+      heights.append(estimate);
+      expected.push_back(estimate);
+      measured.push_back(false);
+      heights.erase(0);
+      expected.erase(expected.begin());
+      measured.erase(measured.begin());
+      if (i % 7 == 0) {
+         const auto index = rng() % expected.size();
+         heights.setHeight(index, 30);
+         expected[index] = 30;
+         measured[index] = true;
+      }
+      if (i % 500 == 0) {
+         check();
+      }
+   }
+   check();
+   EXPECT_EQ(heights.staleCount(), static_cast<size_t>(std::count(measured.begin(), measured.end(), false)));
+
+   // background relayout for the new width visits each message once, from the last one
+   heights.setWidth(300);
+   EXPECT_EQ(heights.staleCount(), expected.size());
+   std::vector<size_t> visited;
+   while (heights.staleCount() > 0) {
+      const auto stale = heights.takeStale(64);
+      ASSERT_FALSE(stale.empty());
+      for (const auto index : stale) {
+         visited.push_back(index);
+         heights.setHeight(index, 20);
+      }
+   }
+   ASSERT_EQ(visited.size(), expected.size());
+   for (size_t i = 0; i < visited.size(); ++i) {
+      EXPECT_EQ(visited[i], expected.size() - 1 - i);
+   }
+   EXPECT_EQ(heights.totalHeight(), static_cast<int>(20 * expected.size()));
+   EXPECT_TRUE(heights.takeStale(64).empty());
+
+   heights.clear();
+   EXPECT_TRUE(heights.empty());
+   EXPECT_EQ(heights.indexAt(10), 0u);
+}
+
+namespace {
+   struct TestChatMessage
+   {
+      const std::string &partyId() const { return partyId_; }
+      const std::string &messageId() const { return messageId_; }
+      int timestamp() const { return timestamp_; }
+      void setPartyMessageState(int state) { state_ = state; }
+
+      std::string partyId_;
+      std::string messageId_;
+      int         state_;
+      int         timestamp_;
+   };
+   using TestChatMessagePtr = std::shared_ptr<TestChatMessage>;
+
+   TestChatMessagePtr makeChatMessage(const std::string &partyId, const std::string &messageId
+      , int timestamp = 0)
+   {
+      return std::make_shared<TestChatMessage>(TestChatMessage{ partyId, messageId, 0, timestamp });
+   }
+}
+
+TEST(TestChat, ChatMessageStore)
+{
+   ChatMessageStore<TestChatMessagePtr> store(4);
+   EXPECT_EQ(store.history("alice"), nullptr);
+   EXPECT_EQ(store.size("alice"), 0u);
+
+   for (int i = 0; i < 3; ++i) {
+      const auto result = store.insert(makeChatMessage("alice", "a" + std::to_string(i)));
+      EXPECT_EQ(result.row, static_cast<size_t>(i));
+      EXPECT_FALSE(result.replaced);
+      EXPECT_EQ(result.dropped, nullptr);
+   }
+   store.insert(makeChatMessage("bob", "b0"));
+   EXPECT_EQ(store.size("alice"), 3u);
+   EXPECT_EQ(store.size("bob"), 1u);
+   EXPECT_EQ(store.find("bob", "a1"), nullptr);
+
+   auto message = store.setState("alice", "a1", 2);
+   ASSERT_NE(message, nullptr);
+   EXPECT_EQ(message->state_, 2);
+   EXPECT_EQ(store.find("alice", "a1"), message);
+   EXPECT_EQ(store.setState("alice", "missing", 2), nullptr);
+
+   // duplicate is replaced in place
+   const auto replacement = makeChatMessage("alice", "a1");
+   auto result = store.insert(replacement);
+   EXPECT_TRUE(result.replaced);
+   EXPECT_EQ(result.row, 1u);
+   EXPECT_EQ(store.size("alice"), 3u);
+   EXPECT_EQ(store.find("alice", "a1"), replacement);
+
+   // window is full, the oldest messages go round the ring
+   store.insert(makeChatMessage("alice", "a3"));
+   for (int i = 4; i < 11; ++i) {
+      result = store.insert(makeChatMessage("alice", "a" + std::to_string(i)));
+      EXPECT_EQ(result.row, 3u);
+      ASSERT_NE(result.dropped, nullptr);
+      EXPECT_EQ(result.dropped->messageId(), "a" + std::to_string(i - 4));
+      EXPECT_EQ(store.find("alice", result.dropped->messageId()), nullptr);
+   }
+   const auto history = store.history("alice");
+   ASSERT_NE(history, nullptr);
+   ASSERT_EQ(history->size(), 4u);
+   for (size_t row = 0; row < history->size(); ++row) {
+      EXPECT_EQ(history->at(row)->messageId(), "a" + std::to_string(row + 7));
+      EXPECT_EQ(store.row("alice", "a" + std::to_string(row + 7)), static_cast<int>(row));
+   }
+   EXPECT_EQ(store.row("alice", "a6"), -1);
+   EXPECT_EQ(store.row("bob", "a7"), -1);
+
+   result = store.insert(makeChatMessage("alice", "a8"));
+   EXPECT_TRUE(result.replaced);
+   EXPECT_EQ(result.row, 1u);
+   EXPECT_EQ(store.setState("alice", "a9", 3)->state_, 3);
+
+   store.setWindow(2);
+   EXPECT_EQ(store.size("alice"), 2u);
+   EXPECT_EQ(store.history("alice")->at(0)->messageId(), "a9");
+   EXPECT_EQ(store.find("alice", "a8"), nullptr);
+   EXPECT_EQ(store.size("bob"), 1u);
+
+   store.setWindow(3);
+   result = store.insert(makeChatMessage("alice", "a11"));
+   EXPECT_EQ(result.row, 2u);
+   EXPECT_EQ(result.dropped, nullptr);
+   EXPECT_EQ(store.history("alice")->at(0)->messageId(), "a9");
+   EXPECT_EQ(store.row("alice", "a11"), 2);
+
+   store.clear();
+   EXPECT_EQ(store.history("alice"), nullptr);
+   EXPECT_EQ(store.find("bob", "b0"), nullptr);
+}
+
+TEST(TestChat, ChatMessageStoreHistoryReload)
+{
+   ChatMessageStore<TestChatMessagePtr> store(5);
+   std::vector<TestChatMessagePtr> recent;
+   for (int i = 6; i < 9; ++i) {
+      recent.push_back(makeChatMessage("alice", "a" + std::to_string(i), i));
+   }
+   EXPECT_TRUE(store.isAppendable("alice", recent));
+   for (const auto &message : recent) {
+      store.insert(message);
+   }
+   EXPECT_TRUE(store.isAppendable("alice", { makeChatMessage("alice", "a9", 9) }));
+
+   // full history comes after recent messages, sorted by time
+   std::vector<TestChatMessagePtr> all;
+   for (int i = 0; i < 9; ++i) {
+      all.push_back(makeChatMessage("alice", "a" + std::to_string(i), i));
+   }
+   EXPECT_FALSE(store.isAppendable("alice", all));
+   // a known message also can't be just appended
+   EXPECT_FALSE(store.isAppendable("alice", { makeChatMessage("alice", "a8", 8) }));
+
+   store.merge("alice", all);
+   const auto history = store.history("alice");
+   ASSERT_NE(history, nullptr);
+   // the newest ones which fit the window, oldest first
+   ASSERT_EQ(history->size(), 5u);
+   for (size_t row = 0; row < history->size(); ++row) {
+      const auto id = "a" + std::to_string(row + 4);
+      EXPECT_EQ(history->at(row)->messageId(), id);
+      EXPECT_EQ(store.row("alice", id), static_cast<int>(row));
+   }
+   EXPECT_EQ(store.find("alice", "a8"), all[8]);
+   EXPECT_EQ(store.find("alice", "a3"), nullptr);
+
+   // newer messages are appended after the reload as usual
+   const auto result = store.insert(makeChatMessage("alice", "a9", 9));
+   EXPECT_EQ(result.row, 4u);
+   ASSERT_NE(result.dropped, nullptr);
+   EXPECT_EQ(result.dropped->messageId(), "a4");
+
+   store.clear("alice");
+   EXPECT_EQ(store.history("alice"), nullptr);
+   EXPECT_EQ(store.find("alice", "a9"), nullptr);
+}
+
+TEST(TestChat, DISABLED_ChatMessageStoreBenchmark)
+{  // Not a unit test - status updates for messages spread over many parties,
+   // compared to linear lookup in per-party vectors
+   const size_t nbParties = 1000;
+   const size_t nbMessagesPerParty = 200;
+   const size_t nbUpdates = 1000000;
+   std::mt19937 rng(42);
+
+   ChatMessageStore<TestChatMessagePtr> store;
+   std::map<std::string, std::vector<TestChatMessagePtr>> vectors;
+   std::vector<std::string> partyIds;
+   for (size_t i = 0; i < nbParties; ++i) {
+      partyIds.push_back("party" + std::to_string(i));
+   }
+   Benchmark bench("ChatMessageStoreBenchmark");
+   for (size_t i = 0; i < nbMessagesPerParty; ++i) {
+      for (const auto &partyId : partyIds) {
+         store.insert(makeChatMessage(partyId, partyId + "_" + std::to_string(i)));
+      }
+   }
+   const auto insertUs = bench.elapsedUs();
+   for (const auto &partyId : partyIds) {
+      auto &messages = vectors[partyId];
+      const auto history = store.history(partyId);
+      for (size_t row = 0; row < history->size(); ++row) {
+         messages.push_back(history->at(row));
+      }
+   }
+
+   struct Update
+   {
+      const std::string *partyId;
+      std::string messageId;
+   };
+   std::vector<Update> updates;
+   updates.reserve(nbUpdates);
+   for (size_t i = 0; i < nbUpdates; ++i) {
+      const auto &partyId = partyIds[rng() % nbParties];
+      updates.push_back({ &partyId, partyId + "_" + std::to_string(rng() % nbMessagesPerParty) });
+   }
+
+   // sent -> received -> seen
+   size_t found = 0;
+   bench.start();
+   for (size_t i = 0; i < nbUpdates; ++i) {
+      if (store.setState(*updates[i].partyId, updates[i].messageId, static_cast<int>(i % 3) + 1)) {
+         ++found;
+      }
+   }
+   const auto storeUs = bench.elapsedUs();
+   EXPECT_EQ(found, nbUpdates);
+
+   // the former lookup, on a tenth of updates
+   const size_t nbLinear = nbUpdates / 10;
+   bench.start();
+   for (size_t i = 0; i < nbLinear; ++i) {
+      auto &messages = vectors[*updates[i].partyId];
+      const auto &messageId = updates[i].messageId;
+      const auto it = std::find_if(messages.begin(), messages.end(), [&messageId](const TestChatMessagePtr &message) {
+         return message->messageId() == messageId;
+      });
+      ASSERT_NE(it, messages.end());
+      (*it)->setPartyMessageState(static_cast<int>(i % 3) + 1);
+   }
+   const auto linearUs = bench.elapsedUs();
+
+   const double storeNs = 1000.0 * storeUs / nbUpdates;
+   const double linearNs = 1000.0 * linearUs / nbLinear;
+   EXPECT_LT(storeNs, linearNs);
+   bench.report(fmt::format("{} parties x {} messages inserted in {} us; {} status updates in {} us"
+      " ({:.0f} ns each), linear lookup {:.0f} ns each", nbParties, nbMessagesPerParty, insertUs
+      , nbUpdates, storeUs, storeNs, linearNs));
+}
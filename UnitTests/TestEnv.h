@@ -21,6 +21,7 @@
 #include "Server.h"
 #include "Wallets/SyncWallet.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -37,6 +38,43 @@ struct StaticLogger
    static std::shared_ptr<spdlog::logger> loggerPtr;
 };
 
+// Scaffold of DISABLED_ benchmarks which are not unit tests: wall time of
+// measured steps and result lines in the test log under benchmark name
+class Benchmark
+{
+public:
+   explicit Benchmark(const std::string &name)
+      : name_(name), start_(std::chrono::steady_clock::now())
+   {}
+
+   void start() { start_ = std::chrono::steady_clock::now(); }
+
+   int64_t elapsedUs() const
+   {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - start_).count();
+   }
+   int64_t elapsedMs() const { return elapsedUs() / 1000; }
+
+   // Restarts timer, runs f and returns its wall time
+   template <typename F>
+   int64_t measureUs(F &&f)
+   {
+      start();
+      f();
+      return elapsedUs();
+   }
+
+   void report(const std::string &message) const
+   {
+      StaticLogger::loggerPtr->info("[{}] {}", name_, message);
+   }
+
+private:
+   const std::string name_;
+   std::chrono::steady_clock::time_point  start_;
+};
+
 namespace bs {
    namespace core {
       class WalletsManager;
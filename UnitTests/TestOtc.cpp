@@ -19,6 +19,7 @@
 #include "TradesUtils.h"
 #include "TradesVerification.h"
 #include "Trading/OtcClient.h"
+#include "Trading/OtcPublicList.h"
 #include "Wallets/SyncHDWallet.h"
 #include "Wallets/SyncWalletsManager.h"
 
@@ -404,3 +405,54 @@ TEST_F(TestOtc, Basic12) { doOtcTest(12); }
 TEST_F(TestOtc, Basic13) { doOtcTest(13); }
 TEST_F(TestOtc, Basic14) { doOtcTest(14); }
 TEST_F(TestOtc, Basic15) { doOtcTest(15); }
+
+TEST(TestOtcUi, OtcPublicList)
+{
+   struct Peer
+   {
+      std::string contactId;
+   };
+   using PeerPtr = std::shared_ptr<Peer>;
+   const auto makePeer = [](const std::string &contactId) {
+      return std::make_shared<Peer>(Peer{ contactId });
+   };
+   const auto contactIds = [](const OtcPublicList<std::vector<PeerPtr>> &list) {
+      std::vector<std::string> result;
+      for (const auto &peer : list.peers()) {
+         result.push_back(peer->contactId);
+      }
+      return result;
+   };
+
+   OtcPublicList<std::vector<PeerPtr>> list;
+   EXPECT_EQ(list.pushBack(makePeer("a")), 0);
+   EXPECT_EQ(list.pushBack(makePeer("b")), 1);
+   EXPECT_EQ(list.pushBack(makePeer("c")), 2);
+   EXPECT_EQ(list.pushBack(makePeer("b")), -1);
+   EXPECT_EQ(list.pushFront(makePeer("own")), 0);
+   EXPECT_EQ(contactIds(list), std::vector<std::string>({ "own", "a", "b", "c" }));
+   EXPECT_EQ(list.find("c"), 3);
+   EXPECT_EQ(list.find("d"), -1);
+
+   // replaced peer keeps its row
+   const auto newB = makePeer("b");
+   EXPECT_EQ(list.replace(newB), 2);
+   EXPECT_EQ(list.peers().at(2), newB);
+   EXPECT_EQ(list.replace(makePeer("d")), -1);
+
+   EXPECT_EQ(list.remove("a"), 1);
+   EXPECT_EQ(list.remove("a"), -1);
+   EXPECT_EQ(contactIds(list), std::vector<std::string>({ "own", "b", "c" }));
+   EXPECT_EQ(list.find("b"), 1);
+   EXPECT_EQ(list.find("c"), 2);
+
+   EXPECT_EQ(list.remove("own"), 0);
+   EXPECT_EQ(list.pushBack(makePeer("a")), 2);
+   EXPECT_EQ(contactIds(list), std::vector<std::string>({ "b", "c", "a" }));
+   EXPECT_EQ(list.find("a"), 2);
+
+   list.clear();
+   EXPECT_TRUE(list.empty());
+   EXPECT_EQ(list.find("b"), -1);
+   EXPECT_EQ(list.pushBack(makePeer("b")), 0);
+}
@@ -15,11 +15,13 @@
 #include <QMutexLocker>
 #include <QThread>
 #include <spdlog/spdlog.h>
+#include <random>
 #include "ApplicationSettings.h"
 #include "CoreHDWallet.h"
 #include "CoreWalletsManager.h"
 #include "InprocSigner.h"
 #include "TestEnv.h"
+#include "TimerWheel.h"
 #include "TransactionData.h"
 #include "Wallets/SyncWalletsManager.h"
 #include "Wallets/SyncHDWallet.h"
@@ -527,3 +529,121 @@ TEST_F(TestSettlement, SpotXBT_buy)
    std::this_thread::sleep_for(150ms); // have no idea yet, why it's required
 }
 #endif
+
+TEST(TestSettlementUi, TimerWheel)
+{
+   TimerWheel wheel(1000);
+   std::vector<std::pair<int, uint64_t>> fired;
+   const auto record = [&wheel, &fired](int id) {
+      return [&wheel, &fired, id] { fired.push_back({ id, wheel.currentTick() }); };
+   };
+
+   EXPECT_EQ(wheel.nextEventDistance(), 0u);
+   const auto past = wheel.schedule(10, record(0));
+   wheel.schedule(1010, record(1));
+   wheel.schedule(1000 + 300, record(2));
+   wheel.schedule(1000 + 70000, record(3));
+   // beyond the range of all levels
+   const uint64_t far = 1000 + (uint64_t(1) << 33) + 5;
+   wheel.schedule(far, record(4));
+   const auto cancelled = wheel.schedule(1500, record(5));
+   EXPECT_EQ(wheel.size(), 6u);
+   EXPECT_EQ(wheel.nextEventDistance(), 1u);
+
+   EXPECT_TRUE(wheel.isPending(cancelled));
+   EXPECT_TRUE(wheel.cancel(cancelled));
+   EXPECT_FALSE(wheel.cancel(cancelled));
+   EXPECT_FALSE(wheel.isPending(cancelled));
+   EXPECT_FALSE(wheel.isPending(0));
+
+   // past deadline fires on the next tick
+   EXPECT_EQ(wheel.advance(1000), 0u);
+   EXPECT_EQ(wheel.advance(1001), 1u);
+   EXPECT_FALSE(wheel.isPending(past));
+   EXPECT_EQ(wheel.advance(1009), 0u);
+
+   // timer scheduled from callback for the current tick fires on the next one
+   wheel.schedule(1010, [&wheel, &record] {
+      wheel.schedule(wheel.currentTick(), record(6));
+   });
+   EXPECT_EQ(wheel.advance(1010), 2u);
+   EXPECT_EQ(wheel.advance(1011), 1u);
+
+   EXPECT_EQ(wheel.advance(far - 1), 2u);
+   EXPECT_EQ(wheel.size(), 1u);
+   EXPECT_EQ(wheel.advance(far + 100), 1u);
+   EXPECT_TRUE(wheel.empty());
+
+   const std::vector<std::pair<int, uint64_t>> expected = { { 0, 1001 }, { 1, 1010 }
+      , { 6, 1011 }, { 2, 1300 }, { 3, 71000 }, { 4, far } };
+   EXPECT_EQ(fired, expected);
+}
+
+TEST(TestSettlementUi, TimerWheelStress)
+{
+   const size_t nbTimers = 100000;
+   // up to level 2 and some beyond the top one
+   const uint64_t maxDelay = uint64_t(1) << 20;
+   std::mt19937_64 rng(5);
+
+   TimerWheel wheel;
+   std::vector<uint64_t> deadlines(nbTimers);
+   std::vector<TimerWheel::Handle> handles(nbTimers);
+   std::vector<int> firedCount(nbTimers, 0);
+   std::vector<uint64_t> firedAt(nbTimers, 0);
+   uint64_t lastFired = 0;
+   bool ordered = true;
+
+   const auto schedule = [&](size_t i, uint64_t deadline) {
+      deadlines[i] = deadline;
+      handles[i] = wheel.schedule(deadline, [&, i] {
+         ++firedCount[i];
+         firedAt[i] = wheel.currentTick();
+         ordered = ordered && (wheel.currentTick() >= lastFired);
+         lastFired = wheel.currentTick();
+      });
+   };
+   for (size_t i = 0; i < nbTimers; ++i) {
+      const auto delay = (i % 1000 == 0) ? (uint64_t(1) << 32) + rng() % maxDelay : 1 + rng() % maxDelay;
+      schedule(i, delay);
+   }
+   EXPECT_EQ(wheel.size(), nbTimers);
+
+   std::vector<bool> cancelled(nbTimers, false);
+   for (size_t i = 0; i < nbTimers; i += 3) {
+      EXPECT_TRUE(wheel.cancel(handles[i]));
+      cancelled[i] = true;
+   }
+
+   Benchmark bench("TimerWheelStress");
+   size_t firedTotal = 0;
+   size_t rescheduled = 0;
+   while (!wheel.empty()) {
+      const auto maxStep = (wheel.currentTick() < maxDelay) ? 5000 : (uint64_t(1) << 24);
+      firedTotal += wheel.advance(wheel.currentTick() + 1 + rng() % maxStep);
+      // move some pending timers to other deadlines
+      for (int j = 0; (j < 100) && (wheel.currentTick() < maxDelay / 2); ++j) {
+         const auto i = rng() % nbTimers;
+         if ((deadlines[i] < maxDelay) && wheel.cancel(handles[i])) {
+            schedule(i, wheel.currentTick() + 1 + rng() % maxDelay);
+            ++rescheduled;
+         }
+      }
+   }
+   const auto elapsedMs = bench.elapsedMs();
+
+   EXPECT_TRUE(ordered);
+   size_t expectedFired = 0;
+   for (size_t i = 0; i < nbTimers; ++i) {
+      if (cancelled[i]) {
+         EXPECT_EQ(firedCount[i], 0);
+         continue;
+      }
+      ++expectedFired;
+      ASSERT_EQ(firedCount[i], 1);
+      EXPECT_EQ(firedAt[i], deadlines[i]);
+   }
+   EXPECT_EQ(firedTotal, expectedFired);
+   EXPECT_GT(wheel.currentTick(), uint64_t(1) << 32);
+   bench.report(fmt::format("{} timers, {} rescheduled, fired in {} ms", nbTimers, rescheduled, elapsedMs));
+}
@@ -11,20 +11,55 @@
 #include <gtest/gtest.h>
 
 #include <QApplication>
+#include <QBrush>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QLocale>
 #include <QString>
+#include <QThread>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include "AQNativeStrategy.h"
 #include "ApplicationSettings.h"
+#include "BtcUtils.h"
+#include "CandlePyramid.h"
+#include "Colors.h"
+#include "ChartWidget.h"
+#include "CoinControlInputs.h"
 #include "CommonTypes.h"
 #include "CoreHDWallet.h"
 #include "CoreWalletsManager.h"
 #include "CustomControls/CustomDoubleSpinBox.h"
 #include "CustomControls/CustomDoubleValidator.h"
+#include "IncrementalLedgerLoader.h"
 #include "InprocSigner.h"
+#include "LatencyHistogram.h"
+#include "MockAssetMgr.h"
+#include "OhlcCandleCache.h"
+#include "OrderSnapshotDiff.h"
+#include "ReplotScheduler.h"
+#include "RowDiff.h"
+#include "SpreadQuoteStrategy.h"
+#include "Trading/MarketDataModel.h"
+#include "Trading/QuoteRequestsStore.h"
 #include "Trading/RequestingQuoteWidget.h"
+#include "Trading/RfqExpiryScheduler.h"
 #include "Trading/RFQTicketXBT.h"
 #include "TestEnv.h"
+#include "TransactionDetailsLoader.h"
+#include "TransactionsDecodeWorker.h"
+#include "TransactionsSnapshot.h"
+#include "TransactionsViewModel.h"
 #include "UiUtils.h"
+#include "UserScript.h"
 #include "Wallets/SyncHDWallet.h"
 #include "Wallets/SyncWalletsManager.h"
 
@@ -92,6 +127,1944 @@ TEST(TestUi, Display)
    EXPECT_EQ(UiUtils::displayValue(12.01, "BLK/XBT", "BLK", bs::network::Asset::PrivateMarket), QLocale().toString(12.01, 'f', 6));
 }
 
+static std::unique_ptr<QuoteRequestsStore::RFQ> makeStoreRfq(const std::string &reqId
+   , const std::string &security)
+{
+   std::unique_ptr<QuoteRequestsStore::RFQ> rfq(new QuoteRequestsStore::RFQ());
+   rfq->reqId_ = reqId;
+   rfq->security_ = QString::fromStdString(security);
+   return rfq;
+}
+
+TEST(TestUi, QuoteRequestsStore)
+{
+   QuoteRequestsStore store;
+   auto *market = store.addMarket(QLatin1String("SpotFX"), 5);
+   ASSERT_NE(market, nullptr);
+   EXPECT_EQ(store.findMarket(QLatin1String("SpotFX")), market);
+   EXPECT_EQ(store.row(&market->idx_), 0);
+
+   auto *grpEur = store.addGroup(market, QLatin1String("EUR/USD"));
+   auto *grpGbp = store.addGroup(market, QLatin1String("GBP/USD"));
+   EXPECT_EQ(store.findGroup(market, QLatin1String("GBP/USD")), grpGbp);
+   EXPECT_EQ(store.row(&grpGbp->idx_), 1);
+   EXPECT_EQ(grpGbp->idx_.parent_, &market->idx_);
+
+   for (int i = 0; i < 5; ++i) {
+      store.addRfq(grpEur, makeStoreRfq("eur" + std::to_string(i), "EUR/USD"));
+   }
+   store.addRfq(grpGbp, makeStoreRfq("gbp0", "GBP/USD"));
+   EXPECT_EQ(store.rfqCount(), 6U);
+
+   auto loc = store.findRfq("eur3");
+   ASSERT_TRUE(loc.isValid());
+   EXPECT_EQ(loc.group_, grpEur);
+   EXPECT_EQ(loc.rfq_->row_, 3);
+   EXPECT_EQ(loc.rfq_->idx_.parent_, &grpEur->idx_);
+
+   store.removeRfq(grpEur, 1);
+   EXPECT_FALSE(store.findRfq("eur1").isValid());
+   loc = store.findRfq("eur3");
+   ASSERT_TRUE(loc.isValid());
+   EXPECT_EQ(loc.rfq_->row_, 2);
+   EXPECT_EQ(grpEur->rfqs_[2].get(), loc.rfq_);
+
+   ASSERT_EQ(store.groupsForSecurity("EUR/USD").size(), 1U);
+   EXPECT_TRUE(store.groupsForSecurity("USD/JPY").empty());
+
+   store.removeGroup(market, 0);
+   EXPECT_FALSE(store.findRfq("eur0").isValid());
+   EXPECT_TRUE(store.groupsForSecurity("EUR/USD").empty());
+   EXPECT_EQ(store.row(&grpGbp->idx_), 0);
+   EXPECT_EQ(store.findRfq("gbp0").group_, grpGbp);
+
+   auto *settlMarket = store.addMarket(QLatin1String("Settlements"), -1);
+   EXPECT_EQ(settlMarket->row_, 1);
+   store.addSettlement(settlMarket, makeStoreRfq("settl0", "XBT/EUR"));
+   store.addSettlement(settlMarket, makeStoreRfq("settl1", "XBT/EUR"));
+   const auto settlLoc = store.findSettlement("settl1");
+   ASSERT_TRUE(settlLoc.isValid());
+   EXPECT_EQ(settlLoc.group_, &settlMarket->settl_);
+   EXPECT_EQ(settlLoc.rfq_->idx_.parent_, &settlMarket->idx_);
+   EXPECT_EQ(store.row(&settlLoc.group_->idx_), 1);
+   EXPECT_FALSE(store.findRfq("settl1").isValid());
+
+   store.removeRfq(settlLoc.group_, 0);
+   EXPECT_EQ(store.settlementCount(), 1U);
+   EXPECT_EQ(store.findSettlement("settl1").rfq_->row_, 0);
+
+   store.clear();
+   EXPECT_TRUE(store.markets().empty());
+   EXPECT_EQ(store.rfqCount(), 0U);
+   EXPECT_EQ(store.settlementCount(), 0U);
+}
+
+TEST(TestUi, QuoteRequestsStoreSettlementRows)
+{
+   QuoteRequestsStore store;
+   auto *market = store.addMarket(QLatin1String("SpotXBT"), 5);
+   auto *grpEur = store.addGroup(market, QLatin1String("XBT/EUR"));
+   auto *grpUsd = store.addGroup(market, QLatin1String("XBT/USD"));
+   store.addRfq(grpEur, makeStoreRfq("eur0", "XBT/EUR"));
+   store.addRfq(grpUsd, makeStoreRfq("usd0", "XBT/USD"));
+   store.addRfq(grpUsd, makeStoreRfq("usd1", "XBT/USD"));
+   store.addSettlement(market, makeStoreRfq("settl0", "XBT/EUR"));
+   store.addSettlement(market, makeStoreRfq("settl1", "XBT/EUR"));
+
+   // RFQ rows are under own group
+   EXPECT_EQ(QuoteRequestsStore::parentIndex(grpUsd), &grpUsd->idx_);
+   EXPECT_EQ(QuoteRequestsStore::rowInParent(grpUsd, 1), 1);
+
+   // settlement rows are under market, after both groups
+   const auto loc = store.findSettlement("settl1");
+   ASSERT_TRUE(loc.isValid());
+   EXPECT_EQ(QuoteRequestsStore::parentIndex(loc.group_), &market->idx_);
+   const int row = QuoteRequestsStore::rowInParent(loc.group_, loc.rfq_->row_);
+   EXPECT_EQ(row, 3);
+
+   // removal of that row keeps group rows of the market in place
+   store.removeRfq(loc.group_, loc.rfq_->row_);
+   EXPECT_FALSE(store.findSettlement("settl1").isValid());
+   ASSERT_EQ(market->groups_.size(), 2U);
+   EXPECT_EQ(market->groups_[0].get(), grpEur);
+   EXPECT_EQ(market->groups_[1].get(), grpUsd);
+   EXPECT_EQ(grpUsd->rfqs_.size(), 2U);
+
+   const auto remaining = store.findSettlement("settl0");
+   ASSERT_TRUE(remaining.isValid());
+   EXPECT_EQ(QuoteRequestsStore::rowInParent(remaining.group_, remaining.rfq_->row_), 2);
+}
+
+// Not a unit test - replays RFQ flow of a busy dealer desk
+TEST(TestUi, DISABLED_QuoteRequestsStoreBenchmark)
+{
+   const int nbRfqs = 10000;
+   const int nbUpdates = 100000;
+   const std::vector<std::string> securities = { "EUR/USD", "EUR/GBP", "GBP/USD"
+      , "USD/JPY", "XBT/EUR", "XBT/USD", "BLK/XBT", "EUR/JPY" };
+
+   QuoteRequestsStore store;
+   auto *market = store.addMarket(QLatin1String("SpotFX"), 5);
+   for (const auto &security : securities) {
+      store.addGroup(market, QString::fromStdString(security));
+   }
+
+   std::mt19937 gen(42);
+   std::uniform_int_distribution<std::size_t> secDist(0, securities.size() - 1);
+   std::uniform_int_distribution<int> rfqDist(0, nbRfqs - 1);
+
+   Benchmark bench("QuoteRequestsStoreBenchmark");
+   for (int i = 0; i < nbRfqs; ++i) {
+      const auto &security = securities[secDist(gen)];
+      auto *group = store.findGroup(market, QString::fromStdString(security));
+      ASSERT_NE(group, nullptr);
+      store.addRfq(group, makeStoreRfq(std::to_string(i), security));
+   }
+   const auto insertUs = bench.elapsedUs();
+
+   bench.start();
+   int found = 0;
+   for (int i = 0; i < nbUpdates; ++i) {
+      if (i % 10 == 0) {
+         for (auto *group : store.groupsForSecurity(securities[secDist(gen)])) {
+            for (auto &rfq : group->rfqs_) {
+               rfq->indicativePx_ += 1;
+            }
+         }
+         continue;
+      }
+      const auto loc = store.findRfq(std::to_string(rfqDist(gen)));
+      if (loc.isValid()) {
+         loc.rfq_->status_.timeleft_ = i;
+         ++found;
+      }
+      if (i % 100 == 0) {
+         const auto del = store.findRfq(std::to_string(rfqDist(gen)));
+         if (del.isValid()) {
+            store.removeRfq(del.group_, del.rfq_->row_);
+         }
+      }
+   }
+   const auto updateUs = bench.elapsedUs();
+
+   bench.report(fmt::format("{} RFQs inserted in {} us, {} updates ({} hits) in {} us"
+      , nbRfqs, insertUs, nbUpdates, found, updateUs));
+}
+
+TEST(TestUi, RfqExpiryScheduler)
+{
+   RfqExpiryScheduler scheduler(1000);
+   scheduler.schedule("a", 10000, 0);
+   scheduler.schedule("b", 2500, 0);
+   scheduler.schedule("c", 30000, 0);
+   EXPECT_EQ(scheduler.size(), 3U);
+
+   auto result = scheduler.tick(0);
+   EXPECT_TRUE(result.expired_.empty());
+   EXPECT_TRUE(result.changed_.empty());
+
+   // "a" and "c" leave exact step boundary right after start, "b" crosses 2s at 501ms
+   result = scheduler.tick(600);
+   EXPECT_TRUE(result.expired_.empty());
+   ASSERT_EQ(result.changed_.size(), 3U);
+
+   result = scheduler.tick(700);
+   EXPECT_TRUE(result.changed_.empty());
+
+   scheduler.expireNow("c");
+   result = scheduler.tick(800);
+   ASSERT_EQ(result.expired_.size(), 1U);
+   EXPECT_EQ(result.expired_[0], "c");
+   EXPECT_FALSE(scheduler.contains("c"));
+
+   result = scheduler.tick(2600);
+   ASSERT_EQ(result.expired_.size(), 1U);
+   EXPECT_EQ(result.expired_[0], "b");
+   ASSERT_EQ(result.changed_.size(), 1U);
+   EXPECT_EQ(result.changed_[0].first, "a");
+   EXPECT_EQ(result.changed_[0].second, 7400);
+
+   scheduler.remove("a");
+   result = scheduler.tick(20000);
+   EXPECT_TRUE(result.expired_.empty());
+   EXPECT_TRUE(result.changed_.empty());
+   EXPECT_EQ(scheduler.size(), 0U);
+   EXPECT_EQ(scheduler.pendingEvents(), 0U);
+}
+
+// Not a unit test - compares full-scan ticker with scheduler-driven one
+TEST(TestUi, DISABLED_QuoteRequestsTickerBenchmark)
+{
+   const int tickIntervalMs = 500;
+   const int nbTicks = 60;
+   const std::vector<std::string> securities = { "EUR/USD", "EUR/GBP", "GBP/USD"
+      , "USD/JPY", "XBT/EUR", "XBT/USD", "BLK/XBT", "EUR/JPY" };
+   const auto startTime = QDateTime::currentDateTime();
+   Benchmark bench("QuoteRequestsTickerBenchmark");
+
+   for (const int nbRfqs : { 1000, 5000, 20000 }) {
+      std::mt19937 gen(42);
+      std::uniform_int_distribution<int> expDist(5000, 60000);
+      std::unordered_map<std::string, bs::network::QuoteReqNotification> notifications;
+      std::unordered_map<std::string, std::pair<std::size_t, int>> rows;
+      std::vector<int> groupSizes(securities.size(), 0);
+      RfqExpiryScheduler scheduler;
+
+      for (int i = 0; i < nbRfqs; ++i) {
+         bs::network::QuoteReqNotification qrn;
+         qrn.quoteRequestId = std::to_string(i);
+         const auto secIndex = static_cast<std::size_t>(i) % securities.size();
+         qrn.security = securities[secIndex];
+         qrn.status = bs::network::QuoteReqNotification::PendingAck;
+         qrn.timeSkewMs = 0;
+         qrn.expirationTime = startTime.addMSecs(expDist(gen));
+         scheduler.schedule(qrn.quoteRequestId, qrn.expirationTime.toMSecsSinceEpoch()
+            , startTime.toMSecsSinceEpoch());
+         rows[qrn.quoteRequestId] = { secIndex, groupSizes[secIndex]++ };
+         notifications[qrn.quoteRequestId] = qrn;
+      }
+
+      uint64_t legacyUs = 0, legacySignals = 0, legacyRows = 0;
+      uint64_t schedulerUs = 0, schedulerSignals = 0, schedulerRows = 0;
+
+      for (int tick = 1; tick <= nbTicks; ++tick) {
+         const auto timeNow = startTime.addMSecs(tick * tickIntervalMs);
+
+         // previous behaviour: copy every entry and repaint every group
+         bench.start();
+         std::set<std::string> groupsLeft;
+         for (auto qrn : notifications) {
+            const auto timeDiff = timeNow.msecsTo(qrn.second.expirationTime.addMSecs(qrn.second.timeSkewMs));
+            if (timeDiff >= 0) {
+               groupsLeft.insert(qrn.second.security);
+               ++legacyRows;
+            }
+         }
+         legacySignals += groupsLeft.size();
+         legacyUs += bench.elapsedUs();
+
+         bench.start();
+         const auto result = scheduler.tick(timeNow.toMSecsSinceEpoch());
+         std::map<std::size_t, std::vector<int>> changedRows;
+         for (const auto &changed : result.changed_) {
+            const auto &row = rows[changed.first];
+            changedRows[row.first].push_back(row.second);
+         }
+         for (auto &groupRows : changedRows) {
+            std::sort(groupRows.second.begin(), groupRows.second.end());
+            for (std::size_t i = 0; i < groupRows.second.size(); ++i) {
+               if ((i == 0) || (groupRows.second[i] != groupRows.second[i - 1] + 1)) {
+                  ++schedulerSignals;
+               }
+            }
+         }
+         schedulerRows += result.changed_.size();
+         schedulerUs += bench.elapsedUs();
+      }
+
+      bench.report(fmt::format("{} RFQs per tick: full scan {} us, {} signals, {} rows;"
+         " scheduler {} us, {} signals, {} rows", nbRfqs
+         , legacyUs / nbTicks, legacySignals / nbTicks, legacyRows / nbTicks
+         , schedulerUs / nbTicks, schedulerSignals / nbTicks, schedulerRows / nbTicks));
+   }
+}
+
+TEST(TestUi, LatencyHistogram)
+{
+   EXPECT_EQ(LatencyHistogram::bucketFor(0), 0U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(1), 0U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(2), 1U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(3), 2U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(1024), 10U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(1025), 11U);
+   EXPECT_EQ(LatencyHistogram::bucketFor(UINT64_MAX), LatencyHistogram::kBucketCount - 1);
+
+   LatencyHistogram histogram;
+   EXPECT_EQ(histogram.percentile(0.5), 0U);
+
+   for (uint64_t us = 1; us <= 100; ++us) {
+      histogram.add(us);
+   }
+   histogram.add(5000);
+   EXPECT_EQ(histogram.count(), 101U);
+   EXPECT_EQ(histogram.min(), 1U);
+   EXPECT_EQ(histogram.max(), 5000U);
+   EXPECT_EQ(histogram.mean(), (5050U + 5000U) / 101U);
+   // 51st value is 51us which falls into (32, 64] bucket
+   EXPECT_EQ(histogram.percentile(0.5), 64U);
+   EXPECT_EQ(histogram.percentile(0.99), 128U);
+   EXPECT_EQ(histogram.percentile(1.0), 5000U);
+
+   const auto csv = histogram.toCsv("reply");
+   EXPECT_NE(csv.find("reply,64,32\n"), std::string::npos);
+   EXPECT_NE(csv.find("reply,8192,1\n"), std::string::npos);
+   EXPECT_EQ(csv.find("reply,256,"), std::string::npos);
+
+   histogram.clear();
+   EXPECT_EQ(histogram.count(), 0U);
+   EXPECT_TRUE(histogram.toCsv("reply").empty());
+}
+
+namespace {
+   class TestStrategyContext : public bs::aq::Context
+   {
+   public:
+      double accountBalance(const std::string &product) const override
+      {
+         const auto it = balances_.find(product);
+         return (it == balances_.end()) ? 0 : it->second;
+      }
+      void log(const std::string &) override { ++logged_; }
+
+      std::map<std::string, double> balances_;
+      int logged_ = 0;
+   };
+}
+
+TEST(TestUi, SpreadQuoteStrategy)
+{
+   TestStrategyContext context;
+   context.balances_["EUR"] = 100;
+   context.balances_["USD"] = 500;
+   SpreadQuoteStrategy strategy(&context);
+
+   bs::aq::QuoteRequest sellReq;    // customer sells EUR, dealer pays USD
+   sellReq.reqId = "sell";
+   sellReq.security = "EUR/USD";
+   sellReq.product = "EUR";
+   sellReq.contraProduct = "USD";
+   sellReq.isBuy = false;
+   sellReq.quantity = 500;
+   sellReq.assetType = 1;
+
+   bs::aq::MarketSnapshot md;
+   md.indicBid = 1.5;
+   md.expirationInSec = 20;
+
+   // nothing is sent on start and on own side price updates
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::Started, sellReq, md).action, bs::aq::Reply::Action::None);
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::IndicAskChanged, sellReq, md).action, bs::aq::Reply::Action::None);
+
+   // 500 * 1.485 is above USD balance
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::IndicBidChanged, sellReq, md).action, bs::aq::Reply::Action::None);
+   EXPECT_EQ(context.logged_, 1);
+
+   context.balances_["USD"] = 10000;
+   auto reply = strategy.onEvent(bs::aq::Event::IndicBidChanged, sellReq, md);
+   EXPECT_EQ(reply.action, bs::aq::Reply::Action::Send);
+   EXPECT_DOUBLE_EQ(reply.price, 1.5 * 0.99);
+
+   // previous price is not re-quoted while bid keeps more than 1% above it
+   md.indicBid = 2.0;
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::IndicBidChanged, sellReq, md).action, bs::aq::Reply::Action::None);
+
+   md.bestPrice = 1.6;
+   reply = strategy.onEvent(bs::aq::Event::BestPriceChanged, sellReq, md);
+   EXPECT_EQ(reply.action, bs::aq::Reply::Action::Send);
+   EXPECT_DOUBLE_EQ(reply.price, 1.6 * 1.001);
+
+   bs::aq::QuoteRequest buyReq = sellReq;
+   buyReq.reqId = "buy";
+   buyReq.isBuy = true;
+   buyReq.quantity = 50;
+   md.indicAsk = 1.5;
+   reply = strategy.onEvent(bs::aq::Event::IndicAskChanged, buyReq, md);
+   EXPECT_EQ(reply.action, bs::aq::Reply::Action::Send);
+   EXPECT_DOUBLE_EQ(reply.price, 1.5 * 1.01);
+   EXPECT_EQ(strategy.activeCount(), 2U);
+
+   // random quote close to expiration only if nothing was sent yet
+   bs::aq::QuoteRequest silentReq = sellReq;
+   silentReq.reqId = "silent";
+   md.expirationInSec = 6.5;
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::ExpirationChanged, buyReq, md).action, bs::aq::Reply::Action::None);
+   reply = strategy.onEvent(bs::aq::Event::ExpirationChanged, silentReq, md);
+   EXPECT_EQ(reply.action, bs::aq::Reply::Action::Send);
+   EXPECT_GT(reply.price, 0);
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::ExpirationChanged, silentReq, md).action, bs::aq::Reply::Action::None);
+
+   // CC requests are not quoted
+   bs::aq::QuoteRequest ccReq = sellReq;
+   ccReq.reqId = "cc";
+   ccReq.assetType = 3;
+   EXPECT_EQ(strategy.onEvent(bs::aq::Event::BestPriceChanged, ccReq, md).action, bs::aq::Reply::Action::None);
+
+   for (const auto &reqId : { "sell", "buy", "silent", "cc" }) {
+      strategy.onFinished(reqId);
+   }
+   EXPECT_EQ(strategy.activeCount(), 0U);
+}
+
+TEST(TestUi, DISABLED_AutoQuoteStrategyBenchmark)
+{  // Not a unit test - replays the same RFQ and market data stream through
+   // Scripts/DealerAutoQuote.qml and native SpreadQuoteStrategy
+   const size_t kRfqCount = 2000;
+   const size_t kMDUpdatesPerRfq = 10;
+
+   auto assetMgr = std::make_shared<MockAssetManager>(StaticLogger::loggerPtr);
+   assetMgr->init();
+
+   struct ReplayRfq {
+      bs::network::QuoteReqNotification qrn;
+      std::vector<std::pair<double, double>> prices;
+   };
+   std::vector<ReplayRfq> replay(kRfqCount);
+   std::mt19937 gen(42);
+   std::uniform_real_distribution<double> priceDist(1.1, 1.3);
+   const std::vector<std::string> securities = { "EUR/USD", "EUR/GBP", "GBP/USD" };
+   for (size_t i = 0; i < kRfqCount; ++i) {
+      auto &qrn = replay[i].qrn;
+      qrn.quoteRequestId = "rfq" + std::to_string(i);
+      qrn.security = securities[i % securities.size()];
+      qrn.product = qrn.security.substr(0, 3);
+      qrn.side = (i % 2) ? bs::network::Side::Buy : bs::network::Side::Sell;
+      qrn.quantity = 10;
+      qrn.assetType = bs::network::Asset::SpotFX;
+      for (size_t j = 0; j < kMDUpdatesPerRfq; ++j) {
+         const double bid = priceDist(gen);
+         replay[i].prices.push_back({ bid, bid + 0.001 });
+      }
+   }
+
+   const auto run = [&replay](AutoQuoter &aq, const std::string &name) {
+      LatencyHistogram firstReply;
+      LatencyHistogram mdEvent;
+      size_t replies = 0;
+      bool replied = false;
+      Benchmark bench("AutoQuoteStrategyBenchmark");
+      Benchmark rfqTimer("AutoQuoteStrategyBenchmark");
+      Benchmark mdTimer("AutoQuoteStrategyBenchmark");
+      const auto conn = QObject::connect(&aq, &AutoQuoter::sendingQuoteReply, [&](const QString &, double) {
+         ++replies;
+         if (!replied) {
+            replied = true;
+            firstReply.add(static_cast<uint64_t>(rfqTimer.elapsedUs()));
+         }
+      });
+
+      bench.start();
+      for (size_t i = 0; i < replay.size(); ++i) {
+         rfqTimer.start();
+         replied = false;
+         auto obj = aq.instantiate(replay[i].qrn);
+         auto qrr = qobject_cast<BSQuoteReqReply *>(obj);
+         ASSERT_NE(qrr, nullptr);
+         qrr->start();
+         for (const auto &prices : replay[i].prices) {
+            mdTimer.start();
+            qrr->setIndicBid(prices.first);
+            qrr->setIndicAsk(prices.second);
+            mdEvent.add(static_cast<uint64_t>(mdTimer.elapsedUs()));
+         }
+         aq.release(obj);
+         if ((i % 100) == 0) {
+            QCoreApplication::processEvents();
+         }
+      }
+      const auto total = bench.elapsedUs();
+      QObject::disconnect(conn);
+
+      bench.report(fmt::format("{}: {} RFQs in {} us, {} replies; first reply p50 {} us"
+         ", p99 {} us; MD update p50 {} us, p99 {} us", name
+         , replay.size(), total, replies, firstReply.percentile(0.5), firstReply.percentile(0.99)
+         , mdEvent.percentile(0.5), mdEvent.percentile(0.99)));
+   };
+
+   AutoQuoter qmlAq(StaticLogger::loggerPtr, assetMgr, nullptr, {});
+   ASSERT_TRUE(qmlAq.load(QStringLiteral(TERMINAL_SCRIPTS_DIR "/DealerAutoQuote.qml")));
+   run(qmlAq, "QML");
+
+   AQStrategyContext context(StaticLogger::loggerPtr, assetMgr);
+   AutoQuoter nativeAq(StaticLogger::loggerPtr, assetMgr, nullptr, {});
+   nativeAq.setStrategy(std::make_shared<SpreadQuoteStrategy>(&context));
+   run(nativeAq, "native");
+}
+
+TEST(TestUi, MarketDataModel)
+{
+   MarketDataModel model;
+   model.setMaxFrameRate(1);
+   model.onVisibilityToggled(true);
+
+   int changedSignals = 0;
+   QObject::connect(&model, &QAbstractItemModel::dataChanged, [&changedSignals] { ++changedSignals; });
+
+   const int bidCol = static_cast<int>(MarketDataModel::MarketDataColumns::BidPrice);
+   const int volCol = static_cast<int>(MarketDataModel::MarketDataColumns::DailyVol);
+   model.onMDUpdated(bs::network::Asset::SpotFX, QStringLiteral("EUR/USD")
+      , { { bs::network::MDField::PriceBid, 1.12345678, {} } });
+   model.onMDUpdated(bs::network::Asset::SpotFX, QStringLiteral("EUR/GBP"), {});
+   model.onMDUpdated(bs::network::Asset::SpotXBT, QStringLiteral("XBT/EUR")
+      , { { bs::network::MDField::DailyVolume, 2.5, {} } });
+
+   ASSERT_EQ(model.rowCount(), 2);
+   const auto fxGroup = model.index(0, 0);
+   EXPECT_EQ(model.rowCount(fxGroup), 2);
+   EXPECT_EQ(model.parent(model.index(1, bidCol, fxGroup)), fxGroup);
+
+   // numbers are formatted on request the same way as before
+   const auto eurUsdBid = model.index(0, bidCol, fxGroup);
+   EXPECT_EQ(model.data(eurUsdBid).toString()
+      , UiUtils::displayPriceForAssetType(1.12345678, bs::network::Asset::SpotFX));
+   EXPECT_DOUBLE_EQ(model.data(eurUsdBid, MarketDataModel::PriceRole).toDouble(), 1.12345678);
+   EXPECT_TRUE(model.data(model.index(1, bidCol, fxGroup)).toString().isEmpty());
+   EXPECT_EQ(model.data(model.index(0, volCol, model.index(1, 0))).toString()
+      , UiUtils::displayAmount(2.5));
+
+   // updates are coalesced until flush
+   model.flush();
+   changedSignals = 0;
+   for (int i = 0; i < 100; ++i) {
+      model.onMDUpdated(bs::network::Asset::SpotFX, QStringLiteral("EUR/USD")
+         , { { bs::network::MDField::PriceBid, 1.1 + i * 0.01, {} } });
+      model.onMDUpdated(bs::network::Asset::SpotFX, QStringLiteral("EUR/GBP")
+         , { { bs::network::MDField::PriceOffer, 0.9, {} } });
+   }
+   EXPECT_EQ(changedSignals, 0);
+   model.flush();
+   EXPECT_EQ(changedSignals, 1);
+   EXPECT_EQ(model.data(eurUsdBid, Qt::BackgroundRole).value<QBrush>().color(), c_greenColor);
+
+   // visibility
+   model.onVisibilityToggled(false);
+   EXPECT_TRUE(model.setData(model.index(1, 0, fxGroup), Qt::Unchecked, Qt::CheckStateRole));
+   EXPECT_EQ(model.data(fxGroup, Qt::CheckStateRole).toInt(), Qt::PartiallyChecked);
+   model.onVisibilityToggled(true);
+   EXPECT_EQ(model.rowCount(model.index(0, 0)), 1);
+   const auto settings = model.getVisibilitySettings();
+   EXPECT_TRUE(settings.contains(QStringLiteral("EUR/USD")));
+   EXPECT_FALSE(settings.contains(QStringLiteral("EUR/GBP")));
+
+   model.onMDUpdated(bs::network::Asset::Undefined, {}, {});
+   EXPECT_EQ(model.rowCount(), 0);
+}
+
+TEST(TestUi, DISABLED_MarketDataModelBenchmark)
+{  // Not a unit test - feeds 10k updates per second for a few seconds and
+   // reports cost of model updates and number of view notifications
+   const int kInstruments = 300;
+   const int kUpdatesPerSec = 10000;
+   const int kSeconds = 3;
+   const int kBatch = kUpdatesPerSec / 100;
+
+   MarketDataModel model;
+   model.onVisibilityToggled(true);
+   uint64_t changedSignals = 0;
+   uint64_t changedCells = 0;
+   QObject::connect(&model, &QAbstractItemModel::dataChanged
+      , [&changedSignals, &changedCells](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+      ++changedSignals;
+      changedCells += (bottomRight.row() - topLeft.row() + 1) * (bottomRight.column() - topLeft.column() + 1);
+   });
+
+   std::vector<QString> securities;
+   for (int i = 0; i < kInstruments; ++i) {
+      securities.push_back(QStringLiteral("C%1/USD").arg(i));
+   }
+   std::mt19937 gen(42);
+   std::uniform_int_distribution<int> secDist(0, kInstruments - 1);
+   std::uniform_real_distribution<double> priceDist(1.0, 2.0);
+
+   uint64_t updateUs = 0;
+   Benchmark bench("MarketDataModelBenchmark");
+   Benchmark batchTimer("MarketDataModelBenchmark");
+   for (int i = 0; i < kUpdatesPerSec * kSeconds; i += kBatch) {
+      batchTimer.start();
+      for (int j = 0; j < kBatch; ++j) {
+         const double bid = priceDist(gen);
+         model.onMDUpdated(bs::network::Asset::SpotFX, securities[static_cast<size_t>(secDist(gen))]
+            , { { bs::network::MDField::PriceBid, bid, {} }, { bs::network::MDField::PriceOffer, bid + 0.001, {} } });
+      }
+      updateUs += static_cast<uint64_t>(batchTimer.elapsedUs());
+
+      // keep 10ms pace between batches while serving timers
+      while (batchTimer.elapsedMs() < 10) {
+         QCoreApplication::processEvents();
+      }
+   }
+   const auto totalMs = static_cast<uint64_t>(bench.elapsedMs());
+
+   bench.report(fmt::format("{} updates in {} ms: {} us per update, {} dataChanged/sec, {} cells/sec"
+      " at {} fps", kUpdatesPerSec * kSeconds, totalMs
+      , static_cast<double>(updateUs) / (kUpdatesPerSec * kSeconds), changedSignals * 1000 / totalMs
+      , changedCells * 1000 / totalMs, model.maxFrameRate()));
+}
+
+namespace {
+   // Answers OHLC history requests like MDHS does: newest candles first,
+   // hours without trades have no candles
+   class FakeMdhsResponder
+   {
+   public:
+      struct Response
+      {
+         std::vector<OhlcCandleCache::Candle> candles;
+         int64_t firstInDb;
+      };
+
+      FakeMdhsResponder(int64_t firstInDb, int64_t intervalMs)
+         : firstInDb_(firstInDb), intervalMs_(intervalMs)
+      {}
+
+      void setNow(int64_t now)
+      {
+         for (auto ts = candles_.empty() ? firstInDb_ : candles_.back().timestamp + intervalMs_
+            ; ts <= now; ts += intervalMs_) {
+            if (((ts - firstInDb_) / intervalMs_) % 7 == 3) {
+               continue;
+            }
+            const double price = 100 + static_cast<double>((ts / intervalMs_) % 50);
+            candles_.push_back({ ts, price, price + 1, price - 1, price + 0.5, price * 2 });
+         }
+      }
+
+      Response ohlc(int count, int64_t lesserThan)
+      {
+         Response response{ {}, firstInDb_ };
+         for (auto it = candles_.rbegin(); (it != candles_.rend())
+            && (response.candles.size() < static_cast<size_t>(count)); ++it) {
+            if ((lesserThan < 0) || (it->timestamp < lesserThan)) {
+               response.candles.push_back(*it);
+            }
+         }
+         served_ += response.candles.size();
+         return response;
+      }
+
+      size_t served() const { return served_; }
+      const std::vector<OhlcCandleCache::Candle> &candles() const { return candles_; }
+
+   private:
+      const int64_t  firstInDb_;
+      const int64_t  intervalMs_;
+      std::vector<OhlcCandleCache::Candle>   candles_;
+      size_t   served_ = 0;
+   };
+}
+
+TEST(TestUi, OhlcCandleCache)
+{
+   const std::string product = "XBT/EUR";
+   const int interval = 1;
+   const int64_t hour = 3600 * 1000;
+   const int64_t firstInDb = 444444 * hour;
+   const int requestLimit = 200;
+   const auto dir = QDir::temp().filePath(QStringLiteral("bs_ohlc_cache_test"));
+   QDir(dir).removeRecursively();
+
+   FakeMdhsResponder mdhs(firstInDb, hour);
+   int64_t now = firstInDb + 1000 * hour + 10;
+   mdhs.setNow(now);
+
+   // ChartWidget::StoreInCache passes responses the same way
+   const auto store = [&](OhlcCandleCache &cache, const FakeMdhsResponder::Response &response
+      , int requested, int64_t to) {
+      cache.storeResponse(product, interval, response.candles, requested, to, response.firstInDb);
+   };
+   const auto formingCandle = [hour](int64_t ts) { return ts - ts % hour; };
+   const auto serverCandles = [&mdhs](int64_t from, int64_t to) {
+      std::vector<int64_t> result;
+      for (auto it = mdhs.candles().rbegin(); it != mdhs.candles().rend(); ++it) {
+         if ((it->timestamp >= from) && (it->timestamp <= to)) {
+            result.push_back(it->timestamp);
+         }
+      }
+      return result;
+   };
+   const auto timestamps = [](const std::vector<OhlcCandleCache::Candle> &candles) {
+      std::vector<int64_t> result;
+      for (const auto &candle : candles) {
+         result.push_back(candle.timestamp);
+      }
+      return result;
+   };
+
+   {  // first session - everything comes from server
+      OhlcCandleCache cache(dir);
+      EXPECT_TRUE(cache.newest(product, interval, requestLimit).empty());
+      EXPECT_EQ(OhlcCandleCache::headRequestCount(cache.coverage(product, interval), now, hour, requestLimit)
+         , requestLimit);
+
+      const auto head = mdhs.ohlc(requestLimit, -1);
+      store(cache, head, requestLimit, formingCandle(now) - 1);
+      const auto oldest = head.candles.back().timestamp;
+      EXPECT_TRUE(cache.before(product, interval, oldest, requestLimit).empty());
+
+      const auto page = mdhs.ohlc(requestLimit, oldest);
+      store(cache, page, requestLimit, oldest - 1);
+
+      const auto coverage = cache.coverage(product, interval);
+      EXPECT_EQ(coverage.from, page.candles.back().timestamp);
+      EXPECT_EQ(coverage.to, formingCandle(now) - 1);
+      EXPECT_EQ(coverage.firstInDb, firstInDb);
+      EXPECT_EQ(timestamps(cache.before(product, interval, oldest, requestLimit)), timestamps(page.candles));
+      EXPECT_EQ(mdhs.served(), 2U * requestLimit);
+   }
+
+   {  // next session - cached candles and only the gap from server
+      now += 5 * hour;
+      mdhs.setNow(now);
+      OhlcCandleCache cache(dir);
+      const auto coverage = cache.coverage(product, interval);
+      const auto cached = cache.newest(product, interval, requestLimit);
+      ASSERT_EQ(cached.size(), static_cast<size_t>(requestLimit));
+      const auto expected = serverCandles(coverage.from, coverage.to);
+      ASSERT_GE(expected.size(), static_cast<size_t>(requestLimit));
+      EXPECT_EQ(timestamps(cached), std::vector<int64_t>(expected.begin(), expected.begin() + requestLimit));
+
+      const auto servedBefore = mdhs.served();
+      const int count = OhlcCandleCache::headRequestCount(coverage, now, hour, requestLimit);
+      const auto head = mdhs.ohlc(count, -1);
+      store(cache, head, count, formingCandle(now) - 1);
+      EXPECT_LT(mdhs.served() - servedBefore, 10U);
+
+      const auto newCoverage = cache.coverage(product, interval);
+      EXPECT_EQ(newCoverage.from, coverage.from);
+      EXPECT_EQ(newCoverage.to, formingCandle(now) - 1);
+      EXPECT_EQ(timestamps(cache.newest(product, interval, 1000))
+         , serverCandles(newCoverage.from, newCoverage.to));
+   }
+
+   const auto path = OhlcCandleCache(dir).fileName(product, interval);
+   const auto validCoverage = OhlcCandleCache(dir).coverage(product, interval);
+   const auto validCount = OhlcCandleCache(dir).newest(product, interval, 1000).size();
+   {  // interrupted append - damaged tail is cut off
+      QFile file(path);
+      ASSERT_TRUE(file.open(QIODevice::Append));
+      file.write(QByteArray(30, 'x'));
+   }
+   {
+      OhlcCandleCache cache(dir);
+      const auto coverage = cache.coverage(product, interval);
+      EXPECT_EQ(coverage.from, validCoverage.from);
+      EXPECT_EQ(coverage.to, validCoverage.to);
+      EXPECT_EQ(cache.newest(product, interval, 1000).size(), validCount);
+   }
+   {  // damaged record drops everything
+      QFile file(path);
+      ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+      ASSERT_TRUE(file.seek(QFileInfo(path).size() - 20));
+      file.write("xx");
+   }
+   {
+      OhlcCandleCache cache(dir);
+      EXPECT_TRUE(cache.coverage(product, interval).empty());
+      EXPECT_TRUE(cache.newest(product, interval, 1000).empty());
+      EXPECT_EQ(QFileInfo(path).size(), 64);
+
+      store(cache, mdhs.ohlc(requestLimit, -1), requestLimit, formingCandle(now) - 1);
+      EXPECT_FALSE(cache.coverage(product, interval).empty());
+   }
+   {  // damaged header as well
+      QFile file(path);
+      ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+      ASSERT_TRUE(file.seek(20));
+      file.write("xx");
+   }
+   {
+      OhlcCandleCache cache(dir);
+      EXPECT_TRUE(cache.coverage(product, interval).empty());
+      EXPECT_TRUE(cache.newest(product, interval, 1000).empty());
+   }
+
+   {  // hole between cached and received candles replaces cached ones
+      OhlcCandleCache cache(dir);
+      store(cache, mdhs.ohlc(requestLimit, -1), requestLimit, formingCandle(now) - 1);
+      now += 500 * hour;
+      mdhs.setNow(now);
+      const auto head = mdhs.ohlc(requestLimit, -1);
+      store(cache, head, requestLimit, formingCandle(now) - 1);
+      EXPECT_EQ(cache.coverage(product, interval).from, head.candles.back().timestamp);
+      EXPECT_EQ(timestamps(cache.newest(product, interval, 1000))
+         , serverCandles(head.candles.back().timestamp, formingCandle(now) - 1));
+   }
+
+   {  // least recently used files are evicted
+      OhlcCandleCache cache(dir);
+      const auto head = mdhs.ohlc(requestLimit, -1);
+      store(cache, head, requestLimit, formingCandle(now) - 1);
+      const auto fileSize = QFileInfo(path).size();
+      cache.setMaxSize(static_cast<uint64_t>(fileSize) * 2 + 100);
+
+      QThread::msleep(20);
+      cache.store("EUR/USD", interval, head.candles, head.candles.back().timestamp, formingCandle(now) - 1, firstInDb);
+      QThread::msleep(20);
+      cache.store("EUR/GBP", interval, head.candles, head.candles.back().timestamp, formingCandle(now) - 1, firstInDb);
+      EXPECT_FALSE(QFileInfo::exists(path));
+      EXPECT_TRUE(QFileInfo::exists(cache.fileName("EUR/USD", interval)));
+      EXPECT_TRUE(QFileInfo::exists(cache.fileName("EUR/GBP", interval)));
+      EXPECT_LE(cache.totalSize(), cache.maxSize());
+
+      cache.clear();
+      EXPECT_EQ(cache.totalSize(), 0U);
+   }
+   QDir(dir).removeRecursively();
+}
+
+TEST(TestUi, DISABLED_ChartBenchmark)
+{  // Not a unit test - loads 100k candles into the pyramid the way ChartWidget
+   // does, shows the level picked for the visible range and then streams
+   // 1k trades per second into the last candle, reports replot frame times
+   const int kCandles = 100000;
+   const int kTradesPerSec = 1000;
+   const int kSeconds = 3;
+   const qreal kIntervalMs = 60 * 1000;
+   const int kVisibleCandles = 300;
+
+   QCustomPlot plot;
+   plot.resize(1200, 600);
+   auto candles = new QCPFinancial(plot.xAxis, plot.yAxis);
+   auto volumes = new QCPBars(plot.xAxis, plot.yAxis2);
+   const qreal startStamp = QDateTime::currentMSecsSinceEpoch() - kCandles * kIntervalMs;
+
+   struct Candle {
+      qreal timestamp, open, high, low, close, volume;
+   };
+   std::vector<Candle> series;
+   series.reserve(kCandles);
+   std::mt19937 gen(42);
+   std::normal_distribution<double> stepDist(0, 0.5);
+   double price = 10000;
+   for (int i = 0; i < kCandles; ++i) {
+      const double open = price;
+      price = std::max(1.0, price + stepDist(gen));
+      series.push_back({ startStamp + i * kIntervalMs, open, std::max(open, price) + 1
+         , std::min(open, price) - 1, price, std::abs(stepDist(gen)) * 10 });
+   }
+
+   CandlePyramid pyramid(kIntervalMs / 1000);
+   size_t lod = 0;
+   // picks level for the shown key range and rescales value axes as ChartWidget does
+   const auto showRange = [&](double lower, double upper) {
+      plot.xAxis->setRange(lower, upper);
+      const auto newLod = pyramid.levelFor(plot.xAxis->range().size(), plot.axisRect()->width());
+      if (newLod != lod) {
+         lod = newLod;
+         CandleCharts::setLevel(pyramid, lod, candles, volumes);
+      }
+      const auto range = pyramid.valueRange(lod, lower, upper);
+      if (range.found) {
+         plot.yAxis->setRange(range.low, range.high);
+         plot.yAxis2->setRange(0, range.maxVolume);
+      }
+   };
+
+   // candles come newest first
+   Benchmark bench("ChartBenchmark");
+   CandleBatch batch;
+   batch.reserve(kCandles);
+   for (auto it = series.rbegin(); it != series.rend(); ++it) {
+      batch.add(it->open, it->high, it->low, it->close, it->timestamp, it->volume);
+   }
+   batch.commit(pyramid);
+   CandleCharts::setLevel(pyramid, lod, candles, volumes);
+   const auto commitUs = bench.elapsedUs();
+   ASSERT_EQ(pyramid.size(), static_cast<size_t>(kCandles));
+   ASSERT_EQ(candles->data()->size(), kCandles);
+
+   const double lastKey = series.back().timestamp / 1000;
+   const auto zoomOutUs = bench.measureUs([&] { showRange(series.front().timestamp / 1000, lastKey); });
+   const auto zoomOutLod = lod;
+   EXPECT_GT(zoomOutLod, 0U);
+
+   const auto zoomInUs = bench.measureUs([&] {
+      showRange(series[kCandles - kVisibleCandles].timestamp / 1000, lastKey);
+   });
+
+   bench.report(fmt::format("{} candles: batch commit {} us; zoom out to level {} ({} candles)"
+      " {} us, zoom in to level {} {} us", kCandles, commitUs, zoomOutLod
+      , pyramid.level(zoomOutLod).size(), zoomOutUs, lod, zoomInUs));
+
+   ReplotScheduler scheduler(&plot);
+   const auto stream = [&](bool coalesce, const std::string &name) {
+      scheduler.resetStats();
+      LatencyHistogram tradeTimes;
+      Benchmark tradeTimer("ChartBenchmark");
+      std::uniform_real_distribution<double> tradeDist(-5, 5);
+
+      const auto begin = std::chrono::steady_clock::now();
+      for (int i = 0; i < kTradesPerSec * kSeconds; ++i) {
+         const auto due = begin + std::chrono::microseconds(static_cast<int64_t>(i) * 1000000 / kTradesPerSec);
+         while (std::chrono::steady_clock::now() < due) {
+            QCoreApplication::processEvents();
+         }
+         // same steps as ChartWidget::OnNewTrade
+         tradeTimer.start();
+         auto lastCandle = pyramid.last();
+         const double tradePrice = lastCandle.open + tradeDist(gen);
+         lastCandle.high = qMax(lastCandle.high, tradePrice);
+         lastCandle.low = qMin(lastCandle.low, tradePrice);
+         lastCandle.close = tradePrice;
+         lastCandle.volume += 0.1;
+         pyramid.update(lastCandle);
+         CandleCharts::refreshCandle(pyramid, lod, lastCandle.key, candles, volumes);
+         showRange(plot.xAxis->range().lower, plot.xAxis->range().upper);
+         if (coalesce) {
+            scheduler.request();
+         }
+         else {
+            plot.replot();
+         }
+         tradeTimes.add(static_cast<uint64_t>(tradeTimer.elapsedUs()));
+      }
+      while (scheduler.isPending()) {
+         QCoreApplication::processEvents();
+      }
+      const auto totalMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::steady_clock::now() - begin).count();
+
+      const auto &frames = scheduler.frameTimes();
+      bench.report(fmt::format("{}: {} trades in {} ms, {} replots; frame p50 {} us, p99 {} us"
+         ", max {} us; trade handling p50 {} us, p99 {} us", name
+         , kTradesPerSec * kSeconds, totalMs, scheduler.replots(), frames.percentile(0.5)
+         , frames.percentile(0.99), frames.max(), tradeTimes.percentile(0.5), tradeTimes.percentile(0.99)));
+   };
+
+   stream(false, "replot per trade");
+   stream(true, "scheduled replot");
+}
+
+TEST(TestUi, CandlePyramid)
+{
+   const double width = 60;
+   CandlePyramid pyramid(width, 4, 4);
+   ASSERT_EQ(pyramid.levelCount(), 4U);
+   EXPECT_DOUBLE_EQ(pyramid.levelWidth(2), width * 16);
+
+   // reference candles, received newest first in pages as from MDHS
+   const double start = 1600000000 - 1600000000 % 3840;
+   std::vector<CandlePyramid::Candle> candles;
+   std::mt19937 gen(42);
+   std::uniform_real_distribution<double> dist(-1, 1);
+   double price = 100;
+   for (int i = 0; i < 1000; ++i) {
+      if (i % 13 == 5) {
+         continue;
+      }
+      const double open = price;
+      price += dist(gen);
+      candles.push_back({ start + i * width, open, std::max(open, price) + 0.5
+         , std::min(open, price) - 0.5, price, std::abs(dist(gen)) * 10 });
+   }
+   for (size_t end = candles.size(); end > 0; end = (end > 200) ? end - 200 : 0) {
+      pyramid.insert({ candles.begin() + static_cast<std::ptrdiff_t>((end > 200) ? end - 200 : 0)
+         , candles.begin() + static_cast<std::ptrdiff_t>(end) });
+   }
+   ASSERT_EQ(pyramid.size(), candles.size());
+   EXPECT_DOUBLE_EQ(pyramid.first().key, candles.front().key);
+
+   const auto checkLevels = [&pyramid, &candles] {
+      for (size_t level = 1; level < pyramid.levelCount(); ++level) {
+         const double bucketWidth = pyramid.levelWidth(level);
+         std::map<double, CandlePyramid::Candle> expected;
+         for (const auto &candle : candles) {
+            const double bucket = std::floor(candle.key / bucketWidth) * bucketWidth;
+            auto it = expected.find(bucket);
+            if (it == expected.end()) {
+               expected[bucket] = { bucket, candle.open, candle.high, candle.low, candle.close, candle.volume };
+            }
+            else {
+               it->second.high = std::max(it->second.high, candle.high);
+               it->second.low = std::min(it->second.low, candle.low);
+               it->second.close = candle.close;
+               it->second.volume += candle.volume;
+            }
+         }
+         const auto &actual = pyramid.level(level);
+         ASSERT_EQ(actual.size(), expected.size());
+         size_t i = 0;
+         for (const auto &bucket : expected) {
+            EXPECT_DOUBLE_EQ(actual[i].key, bucket.second.key);
+            EXPECT_DOUBLE_EQ(actual[i].open, bucket.second.open);
+            EXPECT_DOUBLE_EQ(actual[i].high, bucket.second.high);
+            EXPECT_DOUBLE_EQ(actual[i].low, bucket.second.low);
+            EXPECT_DOUBLE_EQ(actual[i].close, bucket.second.close);
+            EXPECT_NEAR(actual[i].volume, bucket.second.volume, 1e-9);
+            ++i;
+         }
+      }
+   };
+   checkLevels();
+
+   const auto checkRange = [&pyramid, &candles](double from, double to) {
+      CandlePyramid::Range expected{ std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(), 0, false };
+      for (const auto &candle : candles) {
+         if ((candle.key >= from) && (candle.key <= to)) {
+            expected.found = true;
+            expected.low = std::min(expected.low, candle.low);
+            expected.high = std::max(expected.high, candle.high);
+            expected.maxVolume = std::max(expected.maxVolume, candle.volume);
+         }
+      }
+      const auto actual = pyramid.valueRange(0, from, to);
+      ASSERT_EQ(actual.found, expected.found);
+      if (expected.found) {
+         EXPECT_DOUBLE_EQ(actual.low, expected.low);
+         EXPECT_DOUBLE_EQ(actual.high, expected.high);
+         EXPECT_DOUBLE_EQ(actual.maxVolume, expected.maxVolume);
+      }
+   };
+   for (int i = 0; i < 100; ++i) {
+      const double from = start + (gen() % 1100) * width - width / 2;
+      checkRange(from, from + (gen() % 300) * width);
+   }
+   checkRange(start - 10 * width, start - width);
+
+   // trades update the last candle, new candles are appended
+   auto last = candles.back();
+   last.high += 5;
+   last.volume += 100;
+   candles.back() = last;
+   pyramid.update(last);
+   candles.push_back({ last.key + width, last.close, last.close, last.close, last.close, 0 });
+   pyramid.update(candles.back());
+   checkLevels();
+   checkRange(start, last.key + width);
+   // aggregated levels keep extremes
+   const auto coarse = pyramid.valueRange(pyramid.levelCount() - 1, start, last.key + width);
+   const auto exact = pyramid.valueRange(0, start, last.key + width);
+   EXPECT_DOUBLE_EQ(coarse.high, exact.high);
+   EXPECT_DOUBLE_EQ(coarse.low, exact.low);
+
+   // one candle per pixel column at least
+   EXPECT_EQ(pyramid.levelFor(1000 * width, 2000), 0U);
+   EXPECT_EQ(pyramid.levelFor(1000 * width, 1000), 0U);
+   EXPECT_EQ(pyramid.levelFor(1000 * width, 250), 1U);
+   EXPECT_EQ(pyramid.levelFor(1000 * width, 10), 3U);
+
+   pyramid.reset(width * 2);
+   EXPECT_TRUE(pyramid.empty());
+   EXPECT_TRUE(pyramid.level(3).empty());
+   EXPECT_FALSE(pyramid.valueRange(0, start, last.key).found);
+}
+
+namespace {
+   TXNode *makeTxNode(const BinaryData &txHash, const std::set<std::string> &walletIds)
+   {
+      auto item = std::make_shared<TransactionsViewItem>();
+      item->txEntry.txHash = txHash;
+      item->txEntry.walletIds = walletIds;
+      return new TXNode(item);
+   }
+}
+
+TEST(TestUi, TXNodeIndex)
+{
+   TXNode root;
+   TXNodeIndex index;
+   const auto txHash1 = CryptoPRNG::generateRandom(32);
+   const auto txHash2 = CryptoPRNG::generateRandom(32);
+   const auto node1 = makeTxNode(txHash1, { "wallet1", "wallet2" });
+   const auto node2 = makeTxNode(txHash1, { "wallet3" });
+   const auto node3 = makeTxNode(txHash2, { "wallet1" });
+   for (const auto &node : { node1, node2, node3 }) {
+      root.add(node);
+      index.add(node);
+   }
+   EXPECT_EQ(index.size(), 3U);
+
+   // matches the same nodes as walking the tree
+   bs::TXEntry entry;
+   entry.txHash = txHash1;
+   entry.walletIds = { "wallet2", "wallet4" };
+   EXPECT_EQ(index.find(entry), node1);
+   EXPECT_EQ(index.find(entry), root.find(entry));
+   entry.walletIds = { "wallet3" };
+   EXPECT_EQ(index.find(entry), node2);
+   EXPECT_EQ(index.find(entry), root.find(entry));
+   entry.walletIds = { "wallet4" };
+   EXPECT_EQ(index.find(entry), nullptr);
+   EXPECT_EQ(root.find(entry), nullptr);
+   entry.txHash = txHash2;
+   entry.walletIds = { "wallet1" };
+   EXPECT_EQ(index.find(entry), node3);
+
+   EXPECT_EQ(index.nodesByTxHash(txHash1), (std::vector<TXNode *>{ node1, node2 }));
+   EXPECT_EQ(index.nodesByTxHash(txHash1), root.nodesByTxHash(txHash1));
+   EXPECT_TRUE(index.nodesByTxHash(CryptoPRNG::generateRandom(32)).empty());
+
+   // wallet of removed node is taken over by other node of the same TX
+   const auto node4 = makeTxNode(txHash1, { "wallet2", "wallet3" });
+   root.add(node4);
+   index.add(node4);
+   entry.txHash = txHash1;
+   entry.walletIds = { "wallet2" };
+   EXPECT_EQ(index.find(entry), node1);
+   index.remove(node1);
+   root.del(node1->row());
+   delete node1;
+   EXPECT_EQ(index.size(), 3U);
+   EXPECT_EQ(index.find(entry), node4);
+   entry.walletIds = { "wallet3" };
+   EXPECT_EQ(index.find(entry), node2);
+   entry.walletIds = { "wallet1" };
+   EXPECT_EQ(index.find(entry), nullptr);
+   EXPECT_EQ(index.nodesByTxHash(txHash1), (std::vector<TXNode *>{ node2, node4 }));
+
+   // re-added after merge with more wallets
+   index.remove(node3);
+   node3->item()->txEntry.walletIds.insert("wallet5");
+   index.add(node3);
+   entry.txHash = txHash2;
+   entry.walletIds = { "wallet5" };
+   EXPECT_EQ(index.find(entry), node3);
+   EXPECT_EQ(index.size(), 3U);
+
+   index.clear();
+   EXPECT_EQ(index.size(), 0U);
+   EXPECT_EQ(index.find(entry), nullptr);
+   EXPECT_TRUE(index.nodesByTxHash(txHash1).empty());
+}
+
+TEST(TestUi, DISABLED_TransactionsMergeBenchmark)
+{  // Not a unit test - merges 100k synthetic ledger entries into the tree as
+   // TransactionsViewModel does and compares indexed lookup with tree walk
+   const int kEntries = 100000;
+   const int kTreeSamples = 1000;
+
+   std::vector<bs::TXEntry> entries;
+   entries.reserve(kEntries);
+   for (int i = 0; i < kEntries; ++i) {
+      bs::TXEntry entry;
+      entry.txHash = CryptoPRNG::generateRandom(32);
+      entry.walletIds = { "wallet" + std::to_string(i % 8) };
+      entry.value = i;
+      entry.blockNum = static_cast<uint32_t>(i);
+      entries.push_back(entry);
+   }
+
+   TXNode root;
+   TXNodeIndex index;
+   const auto mergePage = [&root, &index](const std::vector<bs::TXEntry> &page) {
+      size_t added = 0;
+      for (const auto &entry : page) {
+         if (index.find(entry)) {
+            continue;
+         }
+         auto item = std::make_shared<TransactionsViewItem>();
+         item->txEntry = entry;
+         const auto node = new TXNode(item);
+         root.add(node);
+         index.add(node);
+         ++added;
+      }
+      return added;
+   };
+   Benchmark bench("TransactionsMergeBenchmark");
+   EXPECT_EQ(mergePage(entries), static_cast<size_t>(kEntries));
+   const auto loadMs = bench.elapsedMs();
+
+   // each refresh merges the whole ledger again
+   bench.start();
+   EXPECT_EQ(mergePage(entries), 0U);
+   const auto remergeMs = bench.elapsedMs();
+
+   // walking the tree is too slow to be done for every entry
+   int found = 0;
+   bench.start();
+   for (int i = 0; i < kTreeSamples; ++i) {
+      if (root.find(entries[static_cast<size_t>((i * 97) % kEntries)])) {
+         ++found;
+      }
+   }
+   const auto treeMs = bench.elapsedMs();
+   EXPECT_EQ(found, kTreeSamples);
+
+   bench.report(fmt::format("{} entries: load {} ms, re-merge {} ms with index;"
+      " tree walk {} us per entry, ~{} s per re-merge", kEntries
+      , loadMs, remergeMs, treeMs * 1000.0 / kTreeSamples
+      , treeMs / 1000.0 * kEntries / kTreeSamples));
+}
+
+namespace {
+   // Serves ledger pages synchronously in place of Armory ledger delegate
+   class MockLedgerPageSource : public LedgerPageSource
+   {
+   public:
+      void getPageCount(const PageCountCb &cb) override
+      {
+         cb(!fail, fail ? 0 : pages.size());
+      }
+
+      void getHistoryPage(uint32_t pageId, const PageCb &cb) override
+      {
+         ++pagesRequested;
+         if (fail || (pageId >= pages.size())) {
+            cb(false, {});
+            return;
+         }
+         cb(true, pages[pageId]);
+      }
+
+      std::vector<std::vector<bs::TXEntry>>  pages;
+      bool  fail = false;
+      int   pagesRequested = 0;
+   };
+
+   bs::TXEntry ledgerEntry(const BinaryData &txHash, uint32_t blockNum)
+   {
+      bs::TXEntry entry;
+      entry.txHash = txHash;
+      entry.walletIds = { "wallet" };
+      entry.blockNum = blockNum;
+      return entry;
+   }
+}
+
+TEST(TestUi, IncrementalLedgerLoader)
+{
+   using Result = IncrementalLedgerLoader::Result;
+   const unsigned int knownTop = 100;
+   std::vector<BinaryData> hashes;
+   for (int i = 0; i < 8; ++i) {
+      hashes.push_back(CryptoPRNG::generateRandom(32));
+   }
+
+   // entries loaded before the new block
+   const std::map<BinaryData, uint32_t> known = { { hashes[2], 100 }, { hashes[3], 99 }
+      , { hashes[4], UINT32_MAX } };
+   const auto knownBlock = [&known](const bs::TXEntry &entry, uint32_t &blockNum) {
+      const auto it = known.find(entry.txHash);
+      if (it == known.end()) {
+         return false;
+      }
+      blockNum = it->second;
+      return true;
+   };
+
+   auto source = std::make_shared<MockLedgerPageSource>();
+   source->pages = {
+      { ledgerEntry(hashes[0], UINT32_MAX), ledgerEntry(hashes[1], 101), ledgerEntry(hashes[4], 101) },
+      { ledgerEntry(hashes[5], 101), ledgerEntry(hashes[2], 100) },
+      { ledgerEntry(hashes[3], 99), ledgerEntry(hashes[6], 98) } };
+
+   Result result = Result::Failed;
+   std::vector<bs::TXEntry> entries;
+   uint32_t pagesLoaded = 0;
+   const auto cbResult = [&result, &entries, &pagesLoaded](Result res, std::vector<bs::TXEntry> loaded
+      , uint32_t pages) {
+      result = res;
+      entries = std::move(loaded);
+      pagesLoaded = pages;
+   };
+
+   // stops at the first page reaching known blocks
+   IncrementalLedgerLoader::load(source, knownTop, 101, 0, cbResult);
+   EXPECT_EQ(result, Result::Loaded);
+   EXPECT_EQ(pagesLoaded, 2U);
+   EXPECT_EQ(source->pagesRequested, 2);
+   ASSERT_EQ(entries.size(), 5U);
+   EXPECT_EQ(entries[1].txHash, hashes[1]);
+   EXPECT_EQ(entries[4].txHash, hashes[2]);
+   // unconfirmed entry got mined
+   EXPECT_FALSE(IncrementalLedgerLoader::isReorg(entries, knownBlock));
+
+   // reorg reported with new block - nothing is requested
+   source->pagesRequested = 0;
+   IncrementalLedgerLoader::load(source, knownTop, knownTop, 0, cbResult);
+   EXPECT_EQ(result, Result::Reorg);
+   IncrementalLedgerLoader::load(source, knownTop, 102, 98, cbResult);
+   EXPECT_EQ(result, Result::Reorg);
+   EXPECT_EQ(source->pagesRequested, 0);
+   EXPECT_FALSE(IncrementalLedgerLoader::isReorg(knownTop, 101, 100));
+   EXPECT_FALSE(IncrementalLedgerLoader::isReorg(knownTop, 101, 0));
+
+   // reorg found in loaded data: mined entry moved to other block
+   source->pages[1][1].blockNum = 99;
+   IncrementalLedgerLoader::load(source, knownTop, 101, 0, cbResult);
+   EXPECT_EQ(result, Result::Loaded);
+   EXPECT_TRUE(IncrementalLedgerLoader::isReorg(entries, knownBlock));
+   // or became unconfirmed again
+   EXPECT_TRUE(IncrementalLedgerLoader::isReorg({ ledgerEntry(hashes[3], UINT32_MAX) }, knownBlock));
+   // entries not loaded before are just new
+   EXPECT_FALSE(IncrementalLedgerLoader::isReorg({ ledgerEntry(hashes[7], 50) }, knownBlock));
+
+   // all pages are above known top
+   source->pages = { { ledgerEntry(hashes[0], 102), ledgerEntry(hashes[1], 101) } };
+   IncrementalLedgerLoader::load(source, knownTop, 102, 0, cbResult);
+   EXPECT_EQ(result, Result::Loaded);
+   EXPECT_EQ(pagesLoaded, 1U);
+   EXPECT_EQ(entries.size(), 2U);
+
+   source->fail = true;
+   IncrementalLedgerLoader::load(source, knownTop, 101, 0, cbResult);
+   EXPECT_EQ(result, Result::Failed);
+
+   EXPECT_EQ(IncrementalLedgerLoader::confirmations(101, 101), 1);
+   EXPECT_EQ(IncrementalLedgerLoader::confirmations(101, 99), 3);
+   EXPECT_EQ(IncrementalLedgerLoader::confirmations(101, 102), 0);
+   EXPECT_EQ(IncrementalLedgerLoader::confirmations(101, UINT32_MAX), 0);
+}
+
+TEST(TestUi, TransactionsDecodeWorker)
+{
+   const auto mainThreadId = std::this_thread::get_id();
+   std::mutex mutex;
+   std::condition_variable cv;
+   bool gateOpen = true;
+   int started = 0;
+   bool sawCancel = false;
+   bool offMainThread = true;
+   std::vector<std::pair<uint64_t, size_t>> results;
+
+   const auto decode = [&](const std::vector<bs::TXEntry> &entries
+      , const TransactionsDecodeWorker::IsCancelledFunc &isCancelled)
+   {
+      TransactionsDecodeWorker::Batch batch;
+      std::unique_lock<std::mutex> lock(mutex);
+      offMainThread = offMainThread && (std::this_thread::get_id() != mainThreadId);
+      ++started;
+      cv.notify_all();
+      cv.wait(lock, [&gateOpen] { return gateOpen; });
+      if (isCancelled()) {
+         sawCancel = true;
+         return batch;
+      }
+      for (const auto &entry : entries) {
+         batch.newNodes.push_back(makeTxNode(entry.txHash, entry.walletIds));
+      }
+      return batch;
+   };
+   const auto cbResult = [&](uint64_t generation, TransactionsDecodeWorker::Batch batch) {
+      std::lock_guard<std::mutex> lock(mutex);
+      results.emplace_back(generation, batch.newNodes.size());
+      qDeleteAll(batch.newNodes);
+      cv.notify_all();
+   };
+   const auto waitResults = [&](size_t count) {
+      std::unique_lock<std::mutex> lock(mutex);
+      return cv.wait_for(lock, std::chrono::seconds(5), [&results, count] {
+         return results.size() >= count;
+      });
+   };
+   const auto setGate = [&](bool open) {
+      std::lock_guard<std::mutex> lock(mutex);
+      gateOpen = open;
+      cv.notify_all();
+   };
+   const auto page = [](size_t size) {
+      std::vector<bs::TXEntry> entries(size);
+      for (auto &entry : entries) {
+         entry.txHash = CryptoPRNG::generateRandom(32);
+         entry.walletIds = { "wallet" };
+      }
+      return entries;
+   };
+
+   TransactionsDecodeWorker worker(decode, cbResult, 2);
+   EXPECT_EQ(worker.maxQueued(), 2U);
+
+   // batches are decoded in order on worker thread
+   ASSERT_TRUE(worker.submit(page(3)));
+   ASSERT_TRUE(waitResults(1));
+   ASSERT_TRUE(worker.submit(page(1)));
+   ASSERT_TRUE(waitResults(2));
+   EXPECT_TRUE(offMainThread);
+   EXPECT_EQ(results[0], std::make_pair(uint64_t(0), size_t(3)));
+   EXPECT_EQ(results[1], std::make_pair(uint64_t(0), size_t(1)));
+
+   // queue is bounded
+   setGate(false);
+   ASSERT_TRUE(worker.submit(page(1)));
+   ASSERT_TRUE(worker.submit(page(1)));
+   EXPECT_FALSE(worker.submit(page(1)));
+   EXPECT_EQ(worker.queued(), 2U);
+
+   // cancelled batches are dropped, running one is reported with old generation
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&started] { return started == 3; }));
+   }
+   worker.cancel();
+   EXPECT_EQ(worker.generation(), 1U);
+   setGate(true);
+   ASSERT_TRUE(waitResults(3));
+   EXPECT_TRUE(sawCancel);
+   EXPECT_EQ(results[2], std::make_pair(uint64_t(0), size_t(0)));
+
+   ASSERT_TRUE(worker.submit(page(2)));
+   ASSERT_TRUE(waitResults(4));
+   EXPECT_EQ(results[3], std::make_pair(uint64_t(1), size_t(2)));
+   EXPECT_EQ(results.size(), 4U);
+   EXPECT_EQ(worker.queued(), 0U);
+}
+
+TEST(TestUi, TransactionsSnapshot)
+{
+   const auto path = QDir::temp().filePath(QStringLiteral("bs_transactions_snapshot_test"));
+   QFile::remove(path);
+   const auto readFile = [&path] {
+      QFile file(path);
+      file.open(QIODevice::ReadOnly);
+      return file.readAll();
+   };
+   const auto writeFile = [&path](const QByteArray &data) {
+      QFile file(path);
+      file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+      file.write(data);
+   };
+
+   TransactionsSnapshot snapshot(path);
+   TransactionsSnapshot::Content content;
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Missing);
+
+   TransactionsSnapshot::Content saved;
+   saved.topBlock = 1234;
+   for (int i = 0; i < 3; ++i) {
+      TransactionsSnapshot::Row row;
+      row.txHash = CryptoPRNG::generateRandom(32);
+      row.walletIds = { "wallet" + std::to_string(i), "wallet" + std::to_string(i + 1) };
+      row.walletId = QStringLiteral("wallet%1").arg(i);
+      row.walletName = QStringLiteral("Wallet %1").arg(i);
+      row.mainAddress = QStringLiteral("tb1qaddress%1").arg(i);
+      row.dirStr = QStringLiteral("Received");
+      row.amountStr = QStringLiteral("0.0000%1").arg(i + 1);
+      row.comment = QString::fromUtf8("\xD0\xBA\xD0\xBE\xD0\xBC\xD0\xBC\xD0\xB5\xD0\xBD\xD1\x82 %1").arg(i);
+      row.amount = 0.00001 * (i + 1);
+      row.value = 1000 * (i + 1);
+      row.blockNum = (i == 0) ? UINT32_MAX : 1230 + i;
+      row.txTime = 1580000000 + i;
+      row.direction = i;
+      row.isRBF = (i == 0);
+      saved.rows.push_back(row);
+   }
+   ASSERT_TRUE(snapshot.save(saved));
+   ASSERT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Loaded);
+   EXPECT_EQ(content.topBlock, saved.topBlock);
+   EXPECT_EQ(content.rows, saved.rows);
+
+   const auto good = readFile();
+
+   // any damaged byte drops the file
+   for (const int pos : { 0, 10, 39, 40, good.size() / 2, good.size() - 1 }) {
+      auto damaged = good;
+      damaged[pos] = static_cast<char>(damaged[pos] ^ 0x5A);
+      writeFile(damaged);
+      EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Corrupted) << "at " << pos;
+      EXPECT_FALSE(QFile::exists(path));
+   }
+
+   // as well as missing or extra bytes
+   writeFile(good.left(good.size() - 5));
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Corrupted);
+   writeFile(good.left(20));
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Corrupted);
+   writeFile(good + QByteArray(3, 0));
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Corrupted);
+   EXPECT_FALSE(QFile::exists(path));
+
+   // other format version
+   auto otherVersion = good;
+   otherVersion[4] = static_cast<char>(TransactionsSnapshot::kVersion + 1);
+   writeFile(otherVersion);
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::VersionMismatch);
+   EXPECT_FALSE(QFile::exists(path));
+
+   // content from previous load is not touched by failed one
+   EXPECT_EQ(content.rows, saved.rows);
+
+   // newer save replaces older one
+   ASSERT_TRUE(snapshot.save(saved));
+   TransactionsSnapshot::Content empty;
+   empty.topBlock = 1235;
+   ASSERT_TRUE(snapshot.save(empty));
+   ASSERT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Loaded);
+   EXPECT_EQ(content.topBlock, 1235U);
+   EXPECT_TRUE(content.rows.empty());
+
+   snapshot.remove();
+   EXPECT_EQ(snapshot.load(content), TransactionsSnapshot::Status::Missing);
+}
+
+TEST(TestUi, TransactionDetailsLoader)
+{
+   using Item = TransactionDetailsLoader::Item;
+   std::vector<Item> items;
+   for (int i = 0; i < 10; ++i) {
+      items.push_back(std::make_shared<TransactionsViewItem>());
+   }
+   const auto pos = [&items](const Item &item) {
+      return static_cast<int>(std::find(items.cbegin(), items.cend(), item) - items.cbegin());
+   };
+
+   std::vector<int> fetchOrder;
+   std::map<int, TransactionDetailsLoader::DoneCb> pending;
+   TransactionDetailsLoader loader([&](const Item &item, const TransactionDetailsLoader::DoneCb &cb) {
+      fetchOrder.push_back(pos(item));
+      pending[pos(item)] = cb;
+   }, 2);
+   const auto complete = [&pending](int i, bool loaded = true) {
+      const auto cb = pending.at(i);
+      pending.erase(i);
+      cb(loaded);
+   };
+   const auto wanted = [&items](const std::vector<int> &indices) {
+      std::vector<Item> result;
+      for (const int i : indices) {
+         result.push_back(items[i]);
+      }
+      return result;
+   };
+
+   // viewport, in order of priority
+   loader.setWanted(wanted({ 0, 1, 2, 3, 4, 5 }));
+   EXPECT_EQ(fetchOrder, std::vector<int>({ 0, 1 }));
+   EXPECT_EQ(loader.inFlight(), 2U);
+   EXPECT_EQ(loader.queued(), 4U);
+
+   // scrolled away before 2 and 5 got their turn
+   loader.setWanted(wanted({ 4, 3, 1 }));
+   EXPECT_EQ(loader.stats().dropped, 2U);
+   EXPECT_EQ(loader.queued(), 2U);
+   complete(0);
+   EXPECT_EQ(fetchOrder.back(), 4);
+   EXPECT_TRUE(loader.isLoaded(items[0]));
+
+   // explicit request and background ones
+   loader.requestBackground(wanted({ 8, 9 }));
+   loader.request(items[7]);
+   complete(1);
+   EXPECT_EQ(fetchOrder.back(), 7);
+   complete(4, false);
+   EXPECT_EQ(fetchOrder.back(), 3);
+   complete(7);
+   EXPECT_EQ(fetchOrder.back(), 8);
+   EXPECT_EQ(loader.stats().failed, 1U);
+
+   // loaded items are not fetched again, failed ones are
+   loader.setWanted(wanted({ 0, 4 }));
+   complete(3);
+   EXPECT_EQ(fetchOrder.back(), 4);
+   // background ones go after wanted
+   complete(8);
+   EXPECT_EQ(fetchOrder.back(), 9);
+
+   // removed item frees its slot, its result is ignored
+   const auto cbRemoved = pending.at(4);
+   pending.erase(4);
+   loader.remove(items[4]);
+   EXPECT_EQ(loader.inFlight(), 1U);
+   cbRemoved(true);
+   EXPECT_FALSE(loader.isLoaded(items[4]));
+
+   // results of loads started before clear() are ignored
+   loader.setWanted(wanted({ 5, 6 }));
+   EXPECT_EQ(loader.inFlight(), 2U);
+   const auto stalePending = pending;
+   pending.clear();
+   loader.clear();
+   EXPECT_EQ(loader.inFlight(), 0U);
+   EXPECT_EQ(loader.queued(), 0U);
+   for (const auto &cb : stalePending) {
+      cb.second(true);
+   }
+   EXPECT_FALSE(loader.isLoaded(items[5]));
+   EXPECT_EQ(loader.inFlight(), 0U);
+
+   const std::vector<int> expectedOrder = { 0, 1, 4, 7, 3, 8, 4, 9, 5 };
+   EXPECT_EQ(std::vector<int>(fetchOrder.begin(), fetchOrder.begin() + expectedOrder.size()), expectedOrder);
+
+   {  // typical session: long history, user looks at the top and scrolls a bit
+      const int nbRows = 2000;
+      const int pageSize = 30;
+      std::vector<Item> rows;
+      for (int i = 0; i < nbRows; ++i) {
+         rows.push_back(std::make_shared<TransactionsViewItem>());
+      }
+      size_t fetched = 0;
+      // completed synchronously, as if all details were at hand
+      TransactionDetailsLoader syncLoader([&fetched](const Item &, const TransactionDetailsLoader::DoneCb &cb) {
+         fetched++;
+         cb(true);
+      });
+      for (int top = 0; top <= 5 * pageSize; top += pageSize / 3) {
+         std::vector<Item> shown;
+         for (int row = std::max(0, top - pageSize); row < top + 2 * pageSize; ++row) {
+            shown.push_back(rows[row]);
+         }
+         syncLoader.setWanted(shown);
+      }
+      EXPECT_EQ(syncLoader.inFlight(), 0U);
+      EXPECT_EQ(fetched, syncLoader.stats().fetched);
+      EXPECT_EQ(fetched, size_t(7 * pageSize));
+      StaticLogger::loggerPtr->info("[{}] details loaded for {} of {} rows, {} getTXsByHash calls avoided"
+         , "TransactionDetailsLoader", fetched, nbRows, nbRows - fetched);
+   }
+}
+
+namespace {
+   UTXO coinControlUtxo(uint64_t value, uint32_t txOutIndex, const BinaryData &script)
+   {
+      return UTXO(value, 100, 0, txOutIndex, CryptoPRNG::generateRandom(32), script);
+   }
+
+   // order of inputs before sort keys were cached
+   std::vector<std::pair<BinaryData, int>> legacyCoinControlOrder(const std::vector<std::pair<UTXO, int>> &utxos)
+   {
+      struct InputKey {
+         UTXO  utxo;
+         int   index;
+
+         bool operator<(const InputKey &other) const
+         {
+            const auto aw1 = CoinControlInputs::addressWeight(bs::Address::fromUTXO(utxo));
+            const auto aw2 = CoinControlInputs::addressWeight(bs::Address::fromUTXO(other.utxo));
+            if (aw1 != aw2) {
+               return aw1 < aw2;
+            }
+            if (index != other.index) {
+               return (index < other.index);
+            }
+            return (utxo < other.utxo);
+         }
+      };
+      std::map<InputKey, bool> inputs;
+      for (const auto &utxo : utxos) {
+         inputs[{ utxo.first, utxo.second }] = true;
+      }
+      std::vector<std::pair<BinaryData, int>> result;
+      for (const auto &input : inputs) {
+         result.push_back({ input.first.utxo.getTxHash(), input.first.index });
+      }
+      return result;
+   }
+}
+
+TEST(TestUi, CoinControlInputs)
+{
+   const auto hashA = CryptoPRNG::generateRandom(20);
+   const auto hashB = CryptoPRNG::generateRandom(20);
+   const auto nativeA = BtcUtils::getP2WPKHOutputScript(hashA);
+   const auto nativeB = BtcUtils::getP2WPKHOutputScript(hashB);
+   const auto nested = BtcUtils::getP2SHScript(CryptoPRNG::generateRandom(20));
+   const auto legacy = BtcUtils::getP2PKHScript(CryptoPRNG::generateRandom(20));
+
+   CoinControlInputs inputs;
+   inputs.add(coinControlUtxo(1000, 0, legacy), 0, false);
+   inputs.add(coinControlUtxo(2000, 1, nativeA), 1, true);
+   inputs.add(coinControlUtxo(3000, 2, nested), 2, false);
+   inputs.add(coinControlUtxo(4000, 3, nativeA), 3, false);
+   inputs.add(coinControlUtxo(5000, 4, nativeB), 4, true);
+   inputs.add(coinControlUtxo(6000, 5, nativeB), -1, false);
+   ASSERT_EQ(inputs.size(), 6U);
+   EXPECT_EQ(inputs.at(1).addressWeight, 0);
+   EXPECT_EQ(inputs.at(2).addressWeight, 1);
+   EXPECT_EQ(inputs.at(0).addressWeight, 2);
+   EXPECT_EQ(inputs.at(1).amount, 2000U);
+   EXPECT_EQ(inputs.at(1).address, bs::Address::fromHash(inputs.at(1).scrAddr));
+
+   // native first, incomplete before the rest of the same weight
+   inputs.sort();
+   std::vector<int> indices;
+   for (const auto &input : inputs.inputs()) {
+      indices.push_back(input.index);
+   }
+   EXPECT_EQ(indices, (std::vector<int>{ -1, 1, 3, 4, 2, 0 }));
+
+   const auto groups = inputs.groupByAddress();
+   ASSERT_EQ(groups.size(), 4U);
+   EXPECT_EQ(groups[0].first, 0U);
+   EXPECT_EQ(groups[0].inputs, (std::vector<size_t>{ 0, 3 }));
+   EXPECT_EQ(inputs.at(groups[0].first).address, inputs.at(3).address);
+   EXPECT_EQ(groups[1].inputs, (std::vector<size_t>{ 1, 2 }));
+   EXPECT_EQ(groups[2].inputs, (std::vector<size_t>{ 4 }));
+   EXPECT_EQ(groups[3].inputs, (std::vector<size_t>{ 5 }));
+
+   // same order as with keys computed on each comparison
+   std::vector<std::pair<UTXO, int>> utxos;
+   for (int i = 0; i < 200; ++i) {
+      const auto &script = (i % 3 == 0) ? nativeA : ((i % 3 == 1) ? nested : legacy);
+      utxos.push_back({ coinControlUtxo(1000 + i, i, script), (i % 10 == 0) ? -1 : i });
+   }
+   CoinControlInputs many;
+   for (auto it = utxos.rbegin(); it != utxos.rend(); ++it) {
+      many.add(it->first, it->second, false);
+   }
+   many.sort();
+   std::vector<std::pair<BinaryData, int>> order;
+   for (const auto &input : many.inputs()) {
+      order.push_back({ input.utxo.getTxHash(), input.index });
+   }
+   EXPECT_EQ(order, legacyCoinControlOrder(utxos));
+}
+
+TEST(TestUi, DISABLED_CoinControlBenchmark)
+{  // Not a unit test - orders inputs of coin control over a wallet with
+   // 50k UTXOs spread over 5k addresses of all types
+   const size_t nbUtxos = 50000;
+   const size_t nbAddresses = 5000;
+   std::vector<BinaryData> scripts;
+   for (size_t i = 0; i < nbAddresses; ++i) {
+      const auto hash = CryptoPRNG::generateRandom(20);
+      switch (i % 3) {
+      case 0:  scripts.push_back(BtcUtils::getP2WPKHOutputScript(hash));   break;
+      case 1:  scripts.push_back(BtcUtils::getP2SHScript(hash));           break;
+      default: scripts.push_back(BtcUtils::getP2PKHScript(hash));          break;
+      }
+   }
+   std::mt19937 rng(42);
+   std::uniform_int_distribution<size_t> addrDist(0, nbAddresses - 1);
+   std::vector<std::pair<UTXO, int>> utxos;
+   utxos.reserve(nbUtxos);
+   for (size_t i = 0; i < nbUtxos; ++i) {
+      utxos.push_back({ coinControlUtxo(1000 + i, static_cast<uint32_t>(i), scripts[addrDist(rng)])
+         , (i % 100 == 0) ? -1 : static_cast<int>(i) });
+   }
+
+   Benchmark bench("CoinControlBenchmark");
+   const auto legacyOrder = legacyCoinControlOrder(utxos);
+   const auto legacyMs = bench.elapsedMs();
+
+   bench.start();
+   CoinControlInputs inputs;
+   inputs.reserve(utxos.size());
+   for (const auto &utxo : utxos) {
+      inputs.add(utxo.first, utxo.second, false);
+   }
+   const auto addMs = bench.elapsedMs();
+   inputs.sort();
+   const auto groups = inputs.groupByAddress();
+   const auto totalMs = bench.elapsedMs();
+
+   std::vector<std::pair<BinaryData, int>> order;
+   for (const auto &input : inputs.inputs()) {
+      order.push_back({ input.utxo.getTxHash(), input.index });
+   }
+   EXPECT_EQ(order, legacyOrder);
+   EXPECT_LE(groups.size(), nbAddresses);
+   bench.report(fmt::format("{} UTXOs: legacy map {} ms, cached keys {} ms ({} ms computing keys)"
+      ", {} address groups", nbUtxos, legacyMs, totalMs, addMs, groups.size()));
+}
+
+namespace {
+   using DiffRow = std::pair<std::string, int>;
+
+   std::string diffRowKey(const DiffRow &row)
+   {
+      return row.first;
+   }
+
+   // applies diff the same way as models do with begin/end row signals
+   std::vector<DiffRow> applyRowDiff(std::vector<DiffRow> rows, const std::vector<DiffRow> &newRows
+      , const RowDiff &diff)
+   {
+      for (const auto &range : diff.removed) {
+         rows.erase(rows.begin() + range.first, rows.begin() + range.second + 1);
+      }
+      for (const auto &range : diff.inserted) {
+         rows.insert(rows.begin() + range.first, newRows.begin() + range.first
+            , newRows.begin() + range.second + 1);
+      }
+      for (const auto &range : diff.changed) {
+         std::copy(newRows.begin() + range.first, newRows.begin() + range.second + 1
+            , rows.begin() + range.first);
+      }
+      return rows;
+   }
+}
+
+TEST(TestUi, RowDiff)
+{
+   EXPECT_EQ(RowDiff::ranges({ 1, 2, 3, 5, 7, 8 })
+      , (std::vector<RowDiff::Range>{ { 1, 3 }, { 5, 5 }, { 7, 8 } }));
+   EXPECT_TRUE(RowDiff::ranges({}).empty());
+
+   const std::vector<DiffRow> oldRows = { { "a", 1 }, { "b", 2 }, { "c", 3 }, { "d", 4 }, { "e", 5 }, { "f", 6 } };
+   auto diff = RowDiff::compute(oldRows, oldRows, diffRowKey);
+   EXPECT_TRUE(diff.empty());
+
+   // b and c removed, x inserted between d and e, y appended, e changed
+   const std::vector<DiffRow> newRows = { { "a", 1 }, { "d", 4 }, { "x", 0 }, { "e", 50 }, { "f", 6 }, { "y", 0 } };
+   diff = RowDiff::compute(oldRows, newRows, diffRowKey);
+   EXPECT_FALSE(diff.reordered);
+   EXPECT_EQ(diff.removed, (std::vector<RowDiff::Range>{ { 1, 2 } }));
+   EXPECT_EQ(diff.inserted, (std::vector<RowDiff::Range>{ { 2, 2 }, { 5, 5 } }));
+   EXPECT_EQ(diff.changed, (std::vector<RowDiff::Range>{ { 3, 3 } }));
+   EXPECT_EQ(applyRowDiff(oldRows, newRows, diff), newRows);
+
+   // removed ranges go from the end
+   const std::vector<DiffRow> sparse = { { "b", 2 }, { "d", 4 } };
+   diff = RowDiff::compute(oldRows, sparse, diffRowKey);
+   EXPECT_EQ(diff.removed, (std::vector<RowDiff::Range>{ { 4, 5 }, { 2, 2 }, { 0, 0 } }));
+   EXPECT_EQ(applyRowDiff(oldRows, sparse, diff), sparse);
+
+   diff = RowDiff::compute({}, oldRows, diffRowKey);
+   EXPECT_EQ(diff.inserted, (std::vector<RowDiff::Range>{ { 0, 5 } }));
+   diff = RowDiff::compute(oldRows, {}, diffRowKey);
+   EXPECT_EQ(diff.removed, (std::vector<RowDiff::Range>{ { 0, 5 } }));
+
+   // kept rows in other order can't be expressed with insertions and removals
+   const std::vector<DiffRow> swapped = { { "a", 1 }, { "c", 3 }, { "b", 2 } };
+   diff = RowDiff::compute(oldRows, swapped, diffRowKey);
+   EXPECT_TRUE(diff.reordered);
+   EXPECT_FALSE(diff.empty());
+
+   // random edits
+   std::mt19937 rng(7);
+   for (int iter = 0; iter < 100; ++iter) {
+      std::vector<DiffRow> before, after;
+      for (int i = 0; i < 50; ++i) {
+         const auto key = std::to_string(i);
+         const auto r = rng() % 4;
+         if (r != 0) {
+            before.push_back({ key, i });
+         }
+         if (r != 1) {
+            after.push_back({ key, (r == 2) ? i : i + 1 });
+         }
+      }
+      diff = RowDiff::compute(before, after, diffRowKey);
+      ASSERT_FALSE(diff.reordered);
+      EXPECT_EQ(applyRowDiff(before, after, diff), after);
+   }
+}
+
+TEST(TestUi, OrderSnapshotDiff)
+{
+   OrderSnapshotDiff::IdMaker makeId;
+   const auto fields1 = OrderSnapshotDiff::hashCombine(1000, OrderSnapshotDiff::hash(std::string("XBT/EUR")));
+   const auto fields2 = OrderSnapshotDiff::hashCombine(1001, OrderSnapshotDiff::hash(std::string("XBT/EUR")));
+   EXPECT_NE(fields1, fields2);
+   EXPECT_NE(OrderSnapshotDiff::hash(0.1), OrderSnapshotDiff::hash(0.2));
+   EXPECT_EQ(makeId(fields1), fields1);
+   EXPECT_EQ(makeId(fields1), fields1 + 1);
+   EXPECT_EQ(makeId(fields2), fields2);
+   EXPECT_EQ(makeId(fields1), fields1 + 2);
+
+   enum Container { Unsettled, Settled, UnsettledFx };
+   enum State { Pending, PayIn, Filled };
+   const std::vector<OrderSnapshotDiff::Entry> snapshot1 = {
+      { 1, Unsettled, Pending },
+      { 2, Unsettled, Pending },
+      { 3, UnsettledFx, Pending },
+      { 4, Settled, Filled },
+   };
+   auto diff = OrderSnapshotDiff::compute({}, snapshot1);
+   EXPECT_EQ(diff.inserted, (std::vector<size_t>{ 0, 1, 2, 3 }));
+   EXPECT_TRUE(diff.removed.empty());
+   EXPECT_TRUE(OrderSnapshotDiff::compute(snapshot1, snapshot1).empty());
+
+   // 1 is settled, 2 got new pending status, 4 is gone, 5 is new
+   const std::vector<OrderSnapshotDiff::Entry> snapshot2 = {
+      { 5, Unsettled, Pending },
+      { 1, Settled, Filled },
+      { 2, Unsettled, PayIn },
+      { 3, UnsettledFx, Pending },
+   };
+   diff = OrderSnapshotDiff::compute(snapshot1, snapshot2);
+   EXPECT_EQ(diff.removed, (std::vector<size_t>{ 3 }));
+   EXPECT_EQ(diff.moved, (std::vector<std::pair<size_t, size_t>>{ { 0, 1 } }));
+   EXPECT_EQ(diff.updated, (std::vector<size_t>{ 2 }));
+   EXPECT_EQ(diff.inserted, (std::vector<size_t>{ 0 }));
+
+   diff = OrderSnapshotDiff::compute(snapshot2, {});
+   EXPECT_EQ(diff.removed, (std::vector<size_t>{ 0, 1, 2, 3 }));
+}
+
+TEST(TestUi, DISABLED_OrderSnapshotBenchmark)
+{  // Not a unit test - applies snapshots of 50k orders arriving at 10 Hz,
+   // each with a few orders added, settled and removed
+   const size_t nbOrders = 50000;
+   const int nbSnapshots = 100;
+   const auto period = std::chrono::milliseconds(100);
+   std::mt19937 rng(42);
+
+   struct TestOrder
+   {
+      int64_t     timestamp;
+      std::string security;
+      double      quantity;
+      bool        settled;
+   };
+   const std::vector<std::string> securities = { "XBT/EUR", "XBT/USD", "EUR/USD", "EUR/GBP", "BLK/XBT" };
+   std::deque<TestOrder> orders;
+   int64_t timestamp = 1500000000000;
+   const auto newOrder = [&] {
+      return TestOrder{ ++timestamp, securities[rng() % securities.size()], double(rng() % 1000) / 100, false };
+   };
+   for (size_t i = 0; i < nbOrders; ++i) {
+      orders.push_back(newOrder());
+   }
+
+   std::vector<OrderSnapshotDiff::Entry> snapshot;
+   Benchmark bench("OrderSnapshotBenchmark");
+   std::chrono::microseconds total{}, worst{};
+   size_t changes = 0;
+   for (int i = 0; i < nbSnapshots; ++i) {
+      for (int j = 0; j < 5; ++j) {
+         orders.pop_front();
+         orders.push_back(newOrder());
+         orders[rng() % orders.size()].settled = true;
+      }
+
+      // the same hashing as in OrderListModel
+      bench.start();
+      std::vector<OrderSnapshotDiff::Entry> newSnapshot;
+      newSnapshot.reserve(orders.size());
+      OrderSnapshotDiff::IdMaker makeId(orders.size());
+      for (const auto &order : orders) {
+         const auto securityHash = OrderSnapshotDiff::hash(order.security);
+         auto idHash = OrderSnapshotDiff::hashCombine(static_cast<uint64_t>(order.timestamp), securityHash);
+         idHash = OrderSnapshotDiff::hashCombine(idHash, OrderSnapshotDiff::hash(order.quantity));
+         newSnapshot.push_back({ makeId(idHash), OrderSnapshotDiff::hashCombine(order.settled, securityHash)
+            , order.settled ? 2U : 1U });
+      }
+      const auto diff = OrderSnapshotDiff::compute(snapshot, newSnapshot);
+      snapshot = std::move(newSnapshot);
+      const std::chrono::microseconds elapsed(bench.elapsedUs());
+      if (i > 0) {
+         total += elapsed;
+         worst = std::max(worst, elapsed);
+         changes += diff.removed.size() + diff.moved.size() + diff.updated.size() + diff.inserted.size();
+      }
+   }
+   const auto mean = total / (nbSnapshots - 1);
+   EXPECT_LT(mean, period);
+   bench.report(fmt::format("{} orders, {} snapshots: mean {} us, max {} us, {:.1f} changes per snapshot"
+      ", {:.1f}% of 10 Hz period", nbOrders, nbSnapshots, mean.count(), worst.count()
+      , double(changes) / (nbSnapshots - 1), 100.0 * mean.count() / std::chrono::microseconds(period).count()));
+}
+
 #if 0    // it now doesn't compile
 TEST(TestUi, DISABLED_RFQ_entry_CC_sell)
 {
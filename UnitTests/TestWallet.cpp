@@ -12,14 +12,19 @@
 #include <QComboBox>
 #include <QLocale>
 #include <QString>
+#include <cmath>
+#include <random>
 
 #include "ApplicationSettings.h"
 #include "BIP32_Node.h"
+#include "CoinSelector.h"
 #include "CoreHDLeaf.h"
 #include "CoreHDWallet.h"
 #include "CoreWallet.h"
 #include "CoreWalletsManager.h"
+#include "FeeEstimateCache.h"
 #include "InprocSigner.h"
+#include "SpendableUtxoIndex.h"
 #include "SystemFileUtils.h"
 #include "TestEnv.h"
 #include "UiUtils.h"
@@ -2064,3 +2069,354 @@ TEST_F(TestWallet, WalletMeta)
       }
    }
 }
+
+namespace {
+   // Stands for ArmoryConnection::estimateFee: counts calls and keeps
+   // callbacks until the test delivers the estimate
+   class FakeFeeArmory
+   {
+   public:
+      bool estimateFee(unsigned int nbBlocks, const FeeEstimateCache::FeeCb &cb)
+      {
+         calls[nbBlocks]++;
+         if (offline) {
+            return false;
+         }
+         pending[nbBlocks].push_back(cb);
+         return true;
+      }
+
+      void deliver(unsigned int nbBlocks, float fee)
+      {
+         auto cbs = std::move(pending[nbBlocks]);
+         pending.erase(nbBlocks);
+         for (const auto &cb : cbs) {
+            cb(fee);
+         }
+      }
+
+      std::map<unsigned int, int> calls;
+      std::map<unsigned int, std::vector<FeeEstimateCache::FeeCb>>  pending;
+      bool offline = false;
+   };
+}
+
+TEST(TestWalletUtils, FeeEstimateCache)
+{
+   FakeFeeArmory armory;
+   auto current = FeeEstimateCache::Clock::now();
+   FeeEstimateCache cache([&armory](unsigned int nbBlocks, const FeeEstimateCache::FeeCb &cb) {
+      return armory.estimateFee(nbBlocks, cb);
+   }, StaticLogger::loggerPtr, std::chrono::seconds(60), [&current] { return current; });
+
+   std::vector<float> received;
+   const auto cb = [&received](float fee) { received.push_back(fee); };
+
+   // concurrent requests for the same target share one estimate
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_TRUE(cache.get(6, cb));
+   EXPECT_EQ(armory.calls[2], 1);
+   EXPECT_EQ(armory.calls[6], 1);
+   EXPECT_TRUE(received.empty());
+   current += std::chrono::milliseconds(250);
+   armory.deliver(2, 0.0002f);
+   EXPECT_EQ(received, std::vector<float>({ 0.0002f, 0.0002f }));
+   armory.deliver(6, 0.0001f);
+   EXPECT_EQ(received.size(), 3U);
+
+   // fresh value is returned at once
+   received.clear();
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_EQ(received, std::vector<float>({ 0.0002f }));
+   EXPECT_EQ(armory.calls[2], 1);
+
+   // expired value is requested again
+   received.clear();
+   current += std::chrono::seconds(61);
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_TRUE(received.empty());
+   EXPECT_EQ(armory.calls[2], 2);
+   armory.deliver(2, 0.0003f);
+   EXPECT_EQ(received, std::vector<float>({ 0.0003f }));
+
+   // new block: known targets are refreshed, old value is still served meanwhile
+   received.clear();
+   current += std::chrono::seconds(30);
+   cache.refresh();
+   EXPECT_EQ(armory.calls[2], 3);
+   EXPECT_EQ(armory.calls[6], 2);
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_EQ(received, std::vector<float>({ 0.0003f }));
+   armory.deliver(2, 0.0004f);
+   armory.deliver(6, 0.0001f);
+   EXPECT_EQ(received.size(), 1U);
+   current += std::chrono::seconds(45);   // refreshed value is not expired yet
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_EQ(received.back(), 0.0004f);
+   EXPECT_EQ(armory.calls[2], 3);
+
+   // invalid estimate is not cached, last known value is used instead
+   received.clear();
+   current += std::chrono::seconds(61);
+   EXPECT_TRUE(cache.get(2, cb));
+   armory.deliver(2, -1.0f);
+   EXPECT_EQ(received, std::vector<float>({ 0.0004f }));
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_EQ(armory.calls[2], 5);
+   armory.deliver(2, 0.0005f);
+   EXPECT_EQ(received.back(), 0.0005f);
+
+   // request failed to be sent: last known value if any
+   armory.offline = true;
+   received.clear();
+   current += std::chrono::seconds(61);
+   EXPECT_TRUE(cache.get(2, cb));
+   EXPECT_EQ(received, std::vector<float>({ 0.0005f }));
+   EXPECT_FALSE(cache.get(12, cb));
+   EXPECT_EQ(received.size(), 1U);
+   armory.offline = false;
+
+   const auto stats = cache.stats();
+   EXPECT_EQ(stats.hits, 3U);
+   EXPECT_EQ(stats.joined, 1U);
+   EXPECT_EQ(stats.misses, 7U);
+   EXPECT_EQ(stats.refreshes, 2U);
+   EXPECT_EQ(stats.failures, 3U);
+   EXPECT_EQ(stats.latency.count(), 7U);
+   EXPECT_EQ(stats.latency.max(), 250000U);
+   cache.logStats();
+
+   // estimate arriving after the cache is gone is ignored
+   FakeFeeArmory lateArmory;
+   {
+      FeeEstimateCache shortLived([&lateArmory](unsigned int nbBlocks, const FeeEstimateCache::FeeCb &cb) {
+         return lateArmory.estimateFee(nbBlocks, cb);
+      });
+      shortLived.get(2, cb);
+   }
+   received.clear();
+   lateArmory.deliver(2, 0.0002f);
+   EXPECT_TRUE(received.empty());
+
+   // a dealer quoting repeatedly: one estimate per TTL instead of one per quote
+   FakeFeeArmory dealerArmory;
+   FeeEstimateCache dealerCache([&dealerArmory](unsigned int nbBlocks, const FeeEstimateCache::FeeCb &cb) {
+      const bool result = dealerArmory.estimateFee(nbBlocks, cb);
+      dealerArmory.deliver(nbBlocks, 0.0002f);
+      return result;
+   }, nullptr, std::chrono::seconds(60), [&current] { return current; });
+   const int nbQuotes = 600;
+   for (int i = 0; i < nbQuotes; ++i) {
+      current += std::chrono::seconds(1);
+      dealerCache.get(2, [](float) {});
+   }
+   EXPECT_EQ(dealerArmory.calls[2], nbQuotes / 60);
+}
+
+TEST(TestWalletUtils, SpendableUtxoIndex)
+{
+   using UtxoType = bs::SpendableUtxoIndex::UtxoType;
+   const auto native = bs::hd::Purpose::Native;
+   const auto nested = bs::hd::Purpose::Nested;
+   std::vector<UTXO> utxos;
+   for (uint32_t i = 0; i < 8; ++i) {
+      utxos.emplace_back((i + 1) * 1000, 100, 0, i, CryptoPRNG::generateRandom(32), BinaryData());
+   }
+   const auto sorted = [](std::vector<UTXO> v) {
+      std::sort(v.begin(), v.end());
+      return v;
+   };
+
+   bs::SpendableUtxoIndex index;
+   auto delta = index.setLeaf("hd", "native", native, { utxos[0], utxos[1], utxos[2] }, { utxos[3] });
+   EXPECT_TRUE(delta.newLeaf);
+   EXPECT_EQ(delta.added, 4U);
+   index.setLeaf("hd", "nested", nested, { utxos[4] }, {});
+   index.setLeaf("other", "otherLeaf", native, { utxos[5] }, {});
+
+   EXPECT_EQ(index.availableSum("hd", false), 1000U + 2000 + 3000 + 5000);
+   EXPECT_EQ(index.availableSum("hd", true), 1000U + 2000 + 3000 + 4000 + 5000);
+   EXPECT_EQ(index.availableSum("hd", native, false), 6000U);
+   EXPECT_EQ(index.availableSum("hd", nested, true), 5000U);
+   EXPECT_EQ(index.available("hd", nested, true), std::vector<UTXO>({ utxos[4] }));
+   EXPECT_EQ(index.available("hd", true), sorted({ utxos[0], utxos[1], utxos[2], utxos[3], utxos[4] }));
+   EXPECT_EQ(index.utxos("hd", native, UtxoType::Zc), std::vector<UTXO>({ utxos[3] }));
+   EXPECT_TRUE(index.utxos("hd", nested, UtxoType::Zc).empty());
+   EXPECT_EQ(index.leafOf(utxos[4]), "nested");
+   EXPECT_EQ(index.availableSum("other", true), 6000U);
+
+   // ZC got mined, one output spent, new ZC arrived - only the difference is applied
+   delta = index.setLeaf("hd", "native", native, { utxos[0], utxos[2], utxos[3] }, { utxos[6] });
+   EXPECT_FALSE(delta.newLeaf);
+   EXPECT_EQ(delta.added, 2U);
+   EXPECT_EQ(delta.removed, 2U);
+   EXPECT_EQ(index.availableSum("hd", native, false), 1000U + 3000 + 4000);
+   EXPECT_EQ(index.availableSum("hd", native, true), 1000U + 3000 + 4000 + 7000);
+   EXPECT_EQ(index.leafOf(utxos[1]), "");
+   delta = index.setLeaf("hd", "native", native, { utxos[0], utxos[2], utxos[3] }, { utxos[6] });
+   EXPECT_FALSE(delta.changed());
+
+   // reserved outputs are excluded, including ones reserved before being added
+   index.reserve({ utxos[0], utxos[7] });
+   index.reserve({ utxos[0] });
+   EXPECT_TRUE(index.isReserved(utxos[0]));
+   EXPECT_EQ(index.availableSum("hd", native, false), 3000U + 4000);
+   EXPECT_EQ(index.available("hd", native, false), sorted({ utxos[2], utxos[3] }));
+   index.setLeaf("hd", "nested", nested, { utxos[4], utxos[7] }, {});
+   EXPECT_EQ(index.availableSum("hd", nested, false), 5000U);
+   EXPECT_EQ(index.utxos("hd", nested, UtxoType::Normal).size(), 2U);
+   index.unreserve({ utxos[0], utxos[7] });
+   EXPECT_TRUE(index.isReserved(utxos[0]));
+   EXPECT_EQ(index.availableSum("hd", false), 3000U + 4000 + 5000 + 8000);
+   index.unreserve({ utxos[0] });
+   EXPECT_FALSE(index.isReserved(utxos[0]));
+   EXPECT_EQ(index.availableSum("hd", false), 1000U + 3000 + 4000 + 5000 + 8000);
+
+   // reserved output removed and added back
+   index.reserve({ utxos[2] });
+   index.setLeaf("hd", "native", native, { utxos[0], utxos[3] }, { utxos[6] });
+   EXPECT_EQ(index.availableSum("hd", native, true), 1000U + 4000 + 7000);
+   index.setLeaf("hd", "native", native, { utxos[0], utxos[2], utxos[3] }, { utxos[6] });
+   EXPECT_EQ(index.availableSum("hd", native, true), 1000U + 4000 + 7000);
+   index.unreserve({ utxos[2] });
+   EXPECT_EQ(index.availableSum("hd", native, true), 1000U + 3000 + 4000 + 7000);
+
+   EXPECT_EQ(index.removeLeaf("nested"), "hd");
+   EXPECT_EQ(index.availableSum("hd", nested, true), 0U);
+   EXPECT_EQ(index.removeWallet("hd"), std::vector<std::string>({ "native" }));
+   EXPECT_FALSE(index.hasWallet("hd"));
+   EXPECT_TRUE(index.available("hd", true).empty());
+   EXPECT_EQ(index.availableSum("other", true), 6000U);
+
+   index.clear();
+   EXPECT_FALSE(index.hasLeaf("otherLeaf"));
+   EXPECT_EQ(index.leafOf(utxos[5]), "");
+}
+
+namespace {
+   UTXO testUtxo(uint64_t value, uint32_t txOutIndex)
+   {
+      return UTXO(value, 100, 0, txOutIndex, CryptoPRNG::generateRandom(32), BinaryData());
+   }
+
+   bs::CoinSelectionParams coinSelectionParams(uint64_t amount)
+   {
+      bs::CoinSelectionParams params;
+      params.amount = amount;
+      params.feePerByte = 1;
+      params.inputSize = [](const UTXO &) { return size_t(68); };
+      return params;
+   }
+}
+
+TEST(TestWalletUtils, CoinSelector)
+{
+   const bs::CoinSelector selector;
+   const std::vector<UTXO> utxos = { testUtxo(10000, 0), testUtxo(20000, 1), testUtxo(30000, 2)
+      , testUtxo(50, 3) };
+
+   // 20000 + 30000 less fee of 2 inputs (136) and of the rest of TX (42)
+   auto result = selector.select(utxos, coinSelectionParams(49822));
+   ASSERT_TRUE(result.found());
+   EXPECT_EQ(result.strategy, "BnB");
+   EXPECT_EQ(result.inputs.size(), 2U);
+   EXPECT_EQ(result.total, 50000U);
+   EXPECT_EQ(result.fee, 178U);
+   EXPECT_EQ(result.change, 0U);
+
+   // small excess is left as fee instead of making change
+   result = selector.select(utxos, coinSelectionParams(49800));
+   EXPECT_EQ(result.strategy, "BnB");
+   EXPECT_EQ(result.total, 50000U);
+   EXPECT_EQ(result.fee, 200U);
+   EXPECT_EQ(result.change, 0U);
+
+   // no selection without change - the smallest sufficient input is used
+   const std::vector<UTXO> utxos2 = { testUtxo(100000, 0), testUtxo(50000, 1), testUtxo(7000, 2) };
+   result = selector.select(utxos2, coinSelectionParams(60000));
+   ASSERT_TRUE(result.found());
+   EXPECT_EQ(result.strategy, "Knapsack");
+   EXPECT_EQ(result.inputs, std::vector<UTXO>({ utxos2[0] }));
+   EXPECT_EQ(result.fee, 42U + 68 + 31);
+   EXPECT_EQ(result.change, 100000U - 60000 - 141);
+
+   // knapsack combines smaller inputs with change
+   const std::vector<UTXO> utxos3 = { testUtxo(40000, 0), testUtxo(30000, 1), testUtxo(20000, 2)
+      , testUtxo(5000, 3) };
+   result = selector.select(utxos3, coinSelectionParams(55000));
+   ASSERT_TRUE(result.found());
+   EXPECT_EQ(result.strategy, "Knapsack");
+   EXPECT_EQ(result.total, 60000U);
+   EXPECT_EQ(result.total, result.fee + result.change + 55000);
+   EXPECT_GE(result.change, 546U);
+
+   // dust inputs are not used, insufficient amount gives nothing
+   result = selector.select(utxos, coinSelectionParams(59900));
+   EXPECT_FALSE(result.found());
+   EXPECT_GT(result.iterations, 0U);
+   EXPECT_FALSE(selector.select(utxos, coinSelectionParams(0)).found());
+
+   // largest first
+   const bs::CoinSelector largestFirst({ std::make_shared<bs::LargestFirstStrategy>() });
+   result = largestFirst.select(utxos3, coinSelectionParams(50000));
+   EXPECT_EQ(result.inputs, std::vector<UTXO>({ utxos3[0], utxos3[1] }));
+   EXPECT_EQ(result.fee, 42U + 2 * 68 + 31);
+   EXPECT_EQ(result.change, 70000U - 50000 - 209);
+   result = largestFirst.select(utxos3, coinSelectionParams(94680));
+   EXPECT_EQ(result.inputs.size(), 4U);
+   EXPECT_EQ(result.fee, 320U);
+   EXPECT_EQ(result.change, 0U);
+
+   // search stops at iteration limit, result is the same for the same input
+   std::vector<UTXO> many;
+   for (uint32_t i = 0; i < 200; ++i) {
+      many.push_back(testUtxo(100000 + 7919 * i, i));
+   }
+   const bs::CoinSelector bnb({ std::make_shared<bs::BranchAndBoundStrategy>() });
+   auto params = coinSelectionParams(1234567);
+   params.maxIterations = 1000;
+   result = bnb.select(many, params);
+   EXPECT_LE(result.iterations, params.maxIterations);
+   const auto knapsack = bs::CoinSelector({ std::make_shared<bs::KnapsackStrategy>() }).select(many, params);
+   ASSERT_TRUE(knapsack.found());
+   EXPECT_LE(knapsack.iterations, params.maxIterations + many.size() * 2);
+   EXPECT_GE(knapsack.total, knapsack.fee + 1234567);
+   const auto knapsack2 = bs::CoinSelector({ std::make_shared<bs::KnapsackStrategy>() }).select(many, params);
+   EXPECT_EQ(knapsack.inputs, knapsack2.inputs);
+}
+
+TEST(TestWalletUtils, DISABLED_CoinSelectionBenchmark)
+{  // Not a unit test - runs coin selection strategies over UTXO sets with
+   // log-normal values (median ~0.005 BTC) as in a busy dealer wallet
+   std::mt19937 rng(42);
+   std::lognormal_distribution<double> valueDist(std::log(500000.0), 1.5);
+
+   Benchmark bench("CoinSelectionBenchmark");
+   const std::vector<std::pair<std::string, bs::CoinSelector>> selectors = {
+      { "BnB", bs::CoinSelector({ std::make_shared<bs::BranchAndBoundStrategy>() }) },
+      { "Knapsack", bs::CoinSelector({ std::make_shared<bs::KnapsackStrategy>() }) },
+      { "LargestFirst", bs::CoinSelector({ std::make_shared<bs::LargestFirstStrategy>() }) },
+      { "Default", bs::CoinSelector() },
+   };
+
+   for (const size_t nbUtxos : { 1000, 10000, 100000 }) {
+      std::vector<UTXO> utxos;
+      utxos.reserve(nbUtxos);
+      for (size_t i = 0; i < nbUtxos; ++i) {
+         utxos.push_back(testUtxo(static_cast<uint64_t>(valueDist(rng)) + 1000, static_cast<uint32_t>(i)));
+      }
+      for (const uint64_t amount : { 1000000ULL, 50000000ULL, 500000000ULL }) {
+         auto params = coinSelectionParams(amount);
+         params.feePerByte = 20;
+         for (const auto &selector : selectors) {
+            bs::CoinSelectionResult result;
+            const auto us = bench.measureUs([&] { result = selector.second.select(utxos, params); });
+            bench.report(fmt::format("{} UTXOs, amount {}: {} ({}) {} us, {} inputs, {} iterations"
+               ", fee {}, change {}", nbUtxos, amount, selector.first
+               , result.found() ? result.strategy : "not found", us, result.inputs.size()
+               , result.iterations, result.fee, result.change));
+         }
+      }
+   }
+}